@@ -0,0 +1,63 @@
+/*
+    This file is part of the Nepomuk KDE project.
+    Copyright (C) 2013  Nepomuk Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "allocationcounter.h"
+
+#include <QtCore/QAtomicInt>
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+    QAtomicInt s_allocations;
+}
+
+Nepomuk2::Test::AllocationCounter::AllocationCounter()
+    : m_start( s_allocations )
+{
+}
+
+int Nepomuk2::Test::AllocationCounter::count() const
+{
+    return int( s_allocations ) - m_start;
+}
+
+void* operator new( std::size_t size ) throw(std::bad_alloc)
+{
+    s_allocations.ref();
+    void* p = std::malloc( size ? size : 1 );
+    if( !p )
+        throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[]( std::size_t size ) throw(std::bad_alloc)
+{
+    return operator new( size );
+}
+
+void operator delete( void* p ) throw()
+{
+    std::free( p );
+}
+
+void operator delete[]( void* p ) throw()
+{
+    std::free( p );
+}
@@ -41,6 +41,7 @@
 #include <Soprano/NRLModel>
 
 #include <ktempdir.h>
+#include <KUrl>
 #include <KDebug>
 #include <KJob>
 
@@ -140,6 +141,31 @@ void AsyncClientApiTest::testRemoveResources()
 
 
 
+void AsyncClientApiTest::testStoreLargeResources()
+{
+    // enough property values to pass the graph through a file descriptor
+    SimpleResourceGraph graph;
+    for(int i = 0; i < 2000; ++i) {
+        SimpleResource res;
+        res.addType(NFO::FileDataObject());
+        // KUrl values are not streamable by the DMS and need to be converted
+        res.addProperty(NIE::url(), KUrl(QString::fromLatin1("file:///tmp/largegraph/file%1").arg(i)));
+        res.addProperty(NIE::title(), QString::fromLatin1("title %1").arg(i));
+        graph << res;
+    }
+
+    StoreResourcesJob* job = graph.save();
+    QVERIFY(QTest::kWaitForSignal(job, SIGNAL(result(KJob*)), 60000));
+    QVERIFY(!job->error());
+    QCOMPARE(job->mappings().count(), graph.count());
+
+    Soprano::Model *m_model = Nepomuk2::ResourceManager::instance()->mainModel();
+    const QUrl uri = job->mappings().value(graph.toList().first().uri());
+    QVERIFY(!uri.isEmpty());
+    QVERIFY(m_model->containsAnyStatement(uri, NIE::url(), Node()));
+    QVERIFY(m_model->containsAnyStatement(uri, NIE::title(), Node()));
+}
+
 QTEST_KDEMAIN_CORE(AsyncClientApiTest)
 
 #include "asyncclientapitest.moc"
@@ -35,6 +35,7 @@ private slots:
     void testCreateResource();
     void testRemoveProperty();
     void testRemoveResources();
+    void testStoreLargeResources();
 private:
 };
 
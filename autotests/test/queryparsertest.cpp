@@ -207,6 +207,67 @@ void QueryParserTest::testQueryParserDetectFilenamePattern()
     QCOMPARE( q, query );
 }
 
+
+void QueryParserTest::testIncrementalParsing_data()
+{
+    QTest::addColumn<QString>( "queryString" );
+
+    QTest::newRow( "literals" ) << QString( "Hello World" );
+    QTest::newRow( "or" ) << QString( "Hello OR World" );
+    QTest::newRow( "field" ) << QString( "hasrag:nepomuk label:foo" );
+    QTest::newRow( "negation" ) << QString( "-label:nepomuk Hello" );
+    QTest::newRow( "not" ) << QString( "not Hello" );
+    QTest::newRow( "exclusion prefix" ) << QString( "foo ! Hello + World" );
+    QTest::newRow( "quotes" ) << QString( "'Hello World' foo" );
+    QTest::newRow( "nested" ) << QString( "hasrag:(label:nepomuk) bar" );
+    QTest::newRow( "property" ) << QString( "<onto:/hasRag>:nepomuk Hello" );
+}
+
+
+void QueryParserTest::testIncrementalParsing()
+{
+    QFETCH( QString, queryString );
+
+    // simulate typing the query, the result has to match a full parse at each step
+    QueryParser p;
+    for( int i = 1; i <= queryString.length(); ++i ) {
+        const QString s = queryString.left( i );
+        QCOMPARE( p.parseIncremental( s ), QueryParser::parseQuery( s ) );
+    }
+
+    // simulate deleting the query again
+    for( int i = queryString.length() - 1; i >= 0; --i ) {
+        const QString s = queryString.left( i );
+        QCOMPARE( p.parseIncremental( s ), QueryParser::parseQuery( s ) );
+    }
+
+    // an edit in the middle
+    const QString s = queryString.left( 1 ) + QLatin1String( "x " ) + queryString.mid( 1 );
+    QCOMPARE( p.parseIncremental( queryString ), QueryParser::parseQuery( queryString ) );
+    QCOMPARE( p.parseIncremental( s ), QueryParser::parseQuery( s ) );
+}
+
+
+void QueryParserTest::testIncrementalParsingChangedTerm()
+{
+    QueryParser p;
+    int changed = -2;
+
+    p.parseIncremental( QLatin1String( "label:foo Hello" ), QueryParser::NoParserFlags, &changed );
+    QCOMPARE( changed, 0 );
+
+    p.parseIncremental( QLatin1String( "label:foo Hello" ), QueryParser::NoParserFlags, &changed );
+    QCOMPARE( changed, -1 );
+
+    // the literal is the second top-level term
+    p.parseIncremental( QLatin1String( "label:foo Hello World" ), QueryParser::NoParserFlags, &changed );
+    QCOMPARE( changed, 1 );
+
+    p.resetIncrementalState();
+    p.parseIncremental( QLatin1String( "label:foo Hello World" ), QueryParser::NoParserFlags, &changed );
+    QCOMPARE( changed, 0 );
+}
+
 QTEST_KDEMAIN_CORE( QueryParserTest )
 
 #include "queryparsertest.moc"
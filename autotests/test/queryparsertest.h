@@ -40,6 +40,9 @@ private Q_SLOTS:
     void testQueryParserWithGlobbing();
     void testQueryParserDetectFilenamePattern_data();
     void testQueryParserDetectFilenamePattern();
+    void testIncrementalParsing_data();
+    void testIncrementalParsing();
+    void testIncrementalParsingChangedTerm();
 
 private:
     KTempDir* m_storageDir;
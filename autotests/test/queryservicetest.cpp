@@ -172,6 +172,73 @@ void QueryServiceTest::sparqlQueries()
     QCOMPARE( reqProp[NCO::fullname()].literal().toString(), QLatin1String("Peter Parker") );
 }
 
+void QueryServiceTest::facets()
+{
+    KTemporaryFile file1;
+    QVERIFY(file1.open());
+    KTemporaryFile file2;
+    QVERIFY(file2.open());
+
+    Tag tagA("TagA");
+    Tag tagB("TagB");
+
+    Resource fileRes1(file1.fileName());
+    fileRes1.addTag( tagA );
+    fileRes1.setRating( 5 );
+
+    Resource fileRes2(file2.fileName());
+    fileRes2.addTag( tagA );
+    fileRes2.addTag( tagB );
+
+    Query::Query query( Query::ComparisonTerm(NAO::hasTag(), Query::ResourceTerm(tagA)) );
+    const QList<Types::Property> facets = QList<Types::Property>() << NAO::hasTag() << NAO::numericRating();
+
+    bool ok = false;
+    Query::FacetCounts counts = Query::QueryServiceClient::syncFacetQuery( query, facets, &ok );
+    QVERIFY( ok );
+    QCOMPARE( counts.size(), 2 );
+
+    Query::FacetValueCounts tagCounts = counts.value( NAO::hasTag() );
+    QCOMPARE( tagCounts.size(), 2 );
+    QCOMPARE( tagCounts.value( KUrl(tagA.uri()).url() ), 2 );
+    QCOMPARE( tagCounts.value( KUrl(tagB.uri()).url() ), 1 );
+
+    Query::FacetValueCounts ratingCounts = counts.value( NAO::numericRating() );
+    QCOMPARE( ratingCounts.size(), 1 );
+    QCOMPARE( ratingCounts.value( QLatin1String("5") ), 1 );
+
+    // with the query open the counts are cached and kept up to date
+    Query::QueryServiceClient client;
+    queryAndWaitTillFinishedListing( &client, query );
+
+    QEventLoop loop;
+    QObject::connect( &client, SIGNAL(facetCounts(Nepomuk2::Query::FacetCounts)), &loop, SLOT(quit()) );
+    QObject::connect( &client, SIGNAL(error(QString)), &loop, SLOT(quit()) );
+    QVERIFY( client.facetQuery( query, facets ) );
+    loop.exec();
+    QVERIFY( client.errorMessage().isEmpty() );
+
+    fileRes2.setRating( 5 );
+
+    KTemporaryFile file3;
+    QVERIFY(file3.open());
+    Resource fileRes3(file3.fileName());
+    fileRes3.addTag( tagA );
+
+    // We need a wait a minimum of 2000 msecs, cause the QueryService waits that long
+    QTest::qWait( 5000 );
+
+    counts = Query::QueryServiceClient::syncFacetQuery( query, facets, &ok );
+    QVERIFY( ok );
+    QCOMPARE( counts.value( NAO::hasTag() ).value( KUrl(tagA.uri()).url() ), 3 );
+    QCOMPARE( counts.value( NAO::numericRating() ).value( QLatin1String("5") ), 2 );
+
+    // an invalid query counts all resources
+    counts = Query::QueryServiceClient::syncFacetQuery( Query::Query(), QList<Types::Property>() << NAO::hasTag(), &ok );
+    QVERIFY( ok );
+    QCOMPARE( counts.value( NAO::hasTag() ).value( KUrl(tagB.uri()).url() ), 1 );
+}
+
 }
 
 QTEST_KDEMAIN(Nepomuk2::QueryServiceTest, NoGUI)
\ No newline at end of file
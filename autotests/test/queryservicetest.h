@@ -28,6 +28,7 @@ namespace Nepomuk2 {
     private Q_SLOTS:
         void tagsUpdates();
         void sparqlQueries();
+        void facets();
     };
 }
 
@@ -0,0 +1,137 @@
+/*
+    This file is part of the Nepomuk KDE project.
+    Copyright (C) 2013  Nepomuk Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include "resourcemanagerbenchmark.h"
+
+#include <QtCore/QThread>
+#include <QtCore/QUuid>
+#include <QtCore/QUrl>
+
+#include <qtest_kde.h>
+
+#include "resource.h"
+
+namespace {
+    const int s_threadCount = 8;
+    const int s_iterations = 10000;
+
+    QList<QUrl> createUris( int count ) {
+        QList<QUrl> uris;
+        for( int i = 0; i < count; ++i )
+            uris << QUrl( QLatin1String("nepomuk:/res/") + QUuid::createUuid().toString().mid( 1, 36 ) );
+        return uris;
+    }
+
+    class ResourceThread : public QThread
+    {
+    public:
+        enum Mode {
+            Construct,
+            Copy
+        };
+
+        ResourceThread( Mode mode, const QList<QUrl>& uris, const Nepomuk2::Resource& res = Nepomuk2::Resource() )
+            : m_mode( mode ),
+              m_uris( uris ),
+              m_res( res ) {
+        }
+
+    protected:
+        void run() {
+            for( int i = 0; i < s_iterations; ++i ) {
+                if( m_mode == Construct ) {
+                    Nepomuk2::Resource res( m_uris[ i % m_uris.count() ] );
+                    Nepomuk2::Resource copy( res );
+                    Q_UNUSED( copy );
+                }
+                else {
+                    Nepomuk2::Resource copy( m_res );
+                    Nepomuk2::Resource other;
+                    other = copy;
+                }
+            }
+        }
+
+    private:
+        Mode m_mode;
+        QList<QUrl> m_uris;
+        Nepomuk2::Resource m_res;
+    };
+
+    void runThreads( QList<ResourceThread*> threads ) {
+        foreach( ResourceThread* thread, threads )
+            thread->start();
+        foreach( ResourceThread* thread, threads )
+            thread->wait();
+    }
+}
+
+namespace Nepomuk2 {
+namespace Test {
+
+void ResourceManagerBenchmark::constructDestroy()
+{
+    // every thread works on its own resources
+    QList<ResourceThread*> threads;
+    for( int i = 0; i < s_threadCount; ++i )
+        threads << new ResourceThread( ResourceThread::Construct, createUris( 100 ) );
+
+    QBENCHMARK {
+        runThreads( threads );
+    }
+
+    qDeleteAll( threads );
+}
+
+void ResourceManagerBenchmark::constructDestroySameResources()
+{
+    // all threads look up the same resources which forces them to share the data
+    const QList<QUrl> uris = createUris( 100 );
+
+    QList<ResourceThread*> threads;
+    for( int i = 0; i < s_threadCount; ++i )
+        threads << new ResourceThread( ResourceThread::Construct, uris );
+
+    QBENCHMARK {
+        runThreads( threads );
+    }
+
+    qDeleteAll( threads );
+}
+
+void ResourceManagerBenchmark::copyDestroy()
+{
+    Resource res( createUris( 1 ).first() );
+
+    QList<ResourceThread*> threads;
+    for( int i = 0; i < s_threadCount; ++i )
+        threads << new ResourceThread( ResourceThread::Copy, QList<QUrl>(), res );
+
+    QBENCHMARK {
+        runThreads( threads );
+    }
+
+    qDeleteAll( threads );
+}
+
+}
+}
+
+QTEST_KDEMAIN(Nepomuk2::Test::ResourceManagerBenchmark, NoGUI)
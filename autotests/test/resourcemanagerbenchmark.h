@@ -0,0 +1,46 @@
+/*
+    This file is part of the Nepomuk KDE project.
+    Copyright (C) 2013  Nepomuk Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#ifndef RESOURCEMANAGERBENCHMARK_H
+#define RESOURCEMANAGERBENCHMARK_H
+
+#include <QtCore/QObject>
+#include "../lib/testbase.h"
+
+namespace Nepomuk2 {
+namespace Test {
+
+/**
+ * Measures how well Resource objects can be created, copied and destroyed
+ * from several threads at the same time.
+ */
+class ResourceManagerBenchmark : public TestBase
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void constructDestroy();
+    void constructDestroySameResources();
+    void copyDestroy();
+};
+
+}
+}
+#endif // RESOURCEMANAGERBENCHMARK_H
@@ -29,6 +29,8 @@
 #include "tag.h"
 #include "datamanagement.h"
 #include "resourcemanager.h"
+#include "resourcejob.h"
+#include "resourcebatch.h"
 
 #include <KDebug>
 #include <KTemporaryFile>
@@ -36,11 +38,15 @@
 #include <KTempDir>
 #include <qtest_kde.h>
 
+#include <QtCore/QTimer>
+#include <QtTest/QSignalSpy>
+
 #include <Soprano/Vocabulary/RDF>
 #include <Soprano/Vocabulary/NAO>
 #include <Soprano/Statement>
 #include <Soprano/Model>
 #include <Soprano/StatementIterator>
+#include <Soprano/QueryResultIterator>
 
 
 using namespace Soprano::Vocabulary;
@@ -643,6 +649,398 @@ void ResourceTests::resourceDeletion2()
     QVERIFY(!model->containsAnyStatement(QUrl(), QUrl(), tagUri));
 }
 
+void ResourceTests::prefetch()
+{
+    QList<QUrl> uris;
+    {
+        for( int i = 0; i < 3; ++i ) {
+            Tag tag( QString::fromLatin1("PrefetchTag%1").arg(i) );
+            tag.setDescription( QString::fromLatin1("Description %1").arg(i) );
+            uris << tag.uri();
+        }
+    }
+
+    QList<Resource> resources;
+    foreach( const QUrl& uri, uris )
+        resources << Resource::fromResourceUri( uri );
+
+    ResourceManager::instance()->prefetch( resources );
+
+    for( int i = 0; i < resources.size(); ++i ) {
+        const Resource& res = resources[i];
+        QCOMPARE( res.property( NAO::identifier() ).toString(), QString::fromLatin1("PrefetchTag%1").arg(i) );
+        QCOMPARE( res.description(), QString::fromLatin1("Description %1").arg(i) );
+        QVERIFY( res.hasType( NAO::Tag() ) );
+    }
+}
+
+void ResourceTests::prefetchProperties()
+{
+    QList<QUrl> uris;
+    {
+        for( int i = 0; i < 3; ++i ) {
+            Tag tag( QString::fromLatin1("PrefetchTag%1").arg(i) );
+            tag.setDescription( QString::fromLatin1("Description %1").arg(i) );
+            uris << tag.uri();
+        }
+    }
+
+    QList<Resource> resources;
+    foreach( const QUrl& uri, uris )
+        resources << Resource::fromResourceUri( uri );
+
+    ResourceManager::instance()->prefetch( resources, QList<QUrl>() << NAO::description() << NAO::numericRating() );
+
+    for( int i = 0; i < resources.size(); ++i ) {
+        Resource res = resources[i];
+        QCOMPARE( res.description(), QString::fromLatin1("Description %1").arg(i) );
+        QVERIFY( !res.hasProperty( NAO::numericRating() ) );
+
+        // the other properties are loaded on demand
+        QCOMPARE( res.property( NAO::identifier() ).toString(), QString::fromLatin1("PrefetchTag%1").arg(i) );
+    }
+
+    // changes to the prefetched properties are not hidden by the cache
+    Resource res = resources.first();
+    res.setRating( 4 );
+    QCOMPARE( res.rating(), quint32(4) );
+}
+
+void ResourceTests::cacheBudget()
+{
+    ResourceManager* rm = ResourceManager::instance();
+
+    QList<Resource> resources;
+    for( int i = 0; i < 20; ++i ) {
+        Tag tag( QString::fromLatin1("BudgetTag%1").arg(i) );
+        tag.setDescription( QString( 1000, QLatin1Char('a' + i) ) );
+        resources << Resource::fromResourceUri( tag.uri() );
+    }
+
+    rm->prefetch( resources );
+    const qint64 size = rm->cacheSize();
+    QVERIFY( size > 20 * 1000 );
+
+    const int evictions = rm->cacheEvictionCount();
+    const int reloads = rm->cacheReloadCount();
+
+    rm->setCacheBudget( size / 2 );
+    QVERIFY( rm->cacheSize() <= size / 2 );
+    QVERIFY( rm->cacheEvictionCount() > evictions );
+
+    // the handles stay valid and reload their properties on access
+    for( int i = 0; i < resources.size(); ++i ) {
+        QCOMPARE( resources[i].description(), QString( 1000, QLatin1Char('a' + i) ) );
+    }
+    QVERIFY( rm->cacheReloadCount() > reloads );
+    QVERIFY( rm->cacheSize() <= size / 2 );
+
+    // the data which was just loaded is never evicted under its reader and
+    // evicted data is still found by its identifier
+    rm->setCacheBudget( 1 );
+    for( int i = 0; i < resources.size(); ++i ) {
+        QCOMPARE( resources[i].description(), QString( 1000, QLatin1Char('a' + i) ) );
+        QCOMPARE( Tag( QString::fromLatin1("BudgetTag%1").arg(i) ).uri(), resources[i].uri() );
+    }
+
+    rm->setCacheBudget( 0 );
+}
+
+void ResourceTests::heavyProperties()
+{
+    ResourceManager* rm = ResourceManager::instance();
+    QVERIFY( rm->heavyProperties().contains( NIE::plainTextContent() ) );
+
+    const QString content( 100000, QLatin1Char('x') );
+    QUrl uri;
+    {
+        Resource res( QUrl(), NFO::FileDataObject() );
+        res.setProperty( NIE::plainTextContent(), content );
+        res.setRating( 3 );
+        uri = res.uri();
+    }
+
+    // all instances are gone, thus the cache is gone as well
+    Resource res = Resource::fromResourceUri( uri );
+
+    qint64 size = rm->cacheSize();
+    QCOMPARE( res.rating(), quint32(3) );
+    QVERIFY( rm->cacheSize() - size < qint64( content.size() ) );
+
+    // the heavy property is loaded on its own
+    size = rm->cacheSize();
+    QCOMPARE( res.property( NIE::plainTextContent() ).toString(), content );
+    QVERIFY( rm->cacheSize() - size >= qint64( content.size() ) );
+    QCOMPARE( res.rating(), quint32(3) );
+
+    // properties() includes it
+    Resource res2;
+    {
+        Resource tmp( QUrl(), NFO::FileDataObject() );
+        tmp.setProperty( NIE::plainTextContent(), content );
+        uri = tmp.uri();
+    }
+    res2 = Resource::fromResourceUri( uri );
+    QCOMPARE( res2.properties().value( NIE::plainTextContent() ).toString(), content );
+}
+
+void ResourceTests::tick()
+{
+    m_maxTickGap = qMax( m_maxTickGap, m_tickTimer.restart() );
+}
+
+bool ResourceTests::waitForJob(KJob* job)
+{
+    QTimer timer;
+    connect( &timer, SIGNAL(timeout()), this, SLOT(tick()) );
+
+    m_maxTickGap = 0;
+    m_tickTimer.start();
+    timer.start( 10 );
+    const bool done = QTest::kWaitForSignal( job, SIGNAL(result(KJob*)), 10000 );
+    timer.stop();
+    return done;
+}
+
+// The calling thread is considered blocked if the event loop stalls for this long
+static const qint64 s_maxBlockTime = 200;
+
+void ResourceTests::asyncLoad()
+{
+    QList<QUrl> uris;
+    for( int i = 0; i < 50; ++i ) {
+        Tag tag( QString::fromLatin1("AsyncTag%1").arg(i) );
+        tag.setDescription( QString::fromLatin1("Description %1").arg(i) );
+        uris << tag.uri();
+    }
+
+    QList<Resource> resources;
+    foreach( const QUrl& uri, uris )
+        resources << Resource::fromResourceUri( uri );
+
+    ResourceJob* job = ResourceJob::loadProperties( resources );
+    QSignalSpy spy( job, SIGNAL(result(KJob*)) );
+
+    // the result is never delivered before control returns to the event loop
+    QCOMPARE( spy.count(), 0 );
+
+    QVERIFY( waitForJob( job ) );
+    QCOMPARE( spy.count(), 1 );
+    QVERIFY( !job->error() );
+    QVERIFY( m_maxTickGap < s_maxBlockTime );
+
+    for( int i = 0; i < resources.size(); ++i ) {
+        QCOMPARE( resources[i].description(), QString::fromLatin1("Description %1").arg(i) );
+    }
+}
+
+void ResourceTests::asyncSetProperty()
+{
+    Resource res( QUrl(), NCO::Contact() );
+    Resource other( QUrl(), NCO::Contact() );
+
+    ResourceJob* job = ResourceJob::setProperty( QList<Resource>() << res << other,
+                                                 NAO::prefLabel(), QString::fromLatin1("Async") );
+    QVERIFY( waitForJob( job ) );
+    QVERIFY( !job->error() );
+    QVERIFY( m_maxTickGap < s_maxBlockTime );
+
+    // the resources have been created
+    QVERIFY( res.exists() );
+    QVERIFY( other.exists() );
+    QCOMPARE( res.property( NAO::prefLabel() ).toString(), QString::fromLatin1("Async") );
+
+    QString query = QString::fromLatin1("ask where { %1 %2 %3 . }")
+                    .arg( Soprano::Node::resourceToN3( other.uri() ),
+                          Soprano::Node::resourceToN3( NAO::prefLabel() ),
+                          Soprano::Node::literalToN3( QString::fromLatin1("Async") ) );
+    QVERIFY( ResourceManager::instance()->mainModel()->executeQuery( query, Soprano::Query::QueryLanguageSparql ).boolValue() );
+
+    // the cache of other instances is updated, too
+    Resource res2( res.uri() );
+    job = ResourceJob::setProperty( QList<Resource>() << res, NAO::prefLabel(), QString::fromLatin1("Async2") );
+    QVERIFY( waitForJob( job ) );
+    QCOMPARE( res2.property( NAO::prefLabel() ).toString(), QString::fromLatin1("Async2") );
+}
+
+void ResourceTests::asyncAddProperty()
+{
+    Tag tag1( QLatin1String("AsyncAddTag1") );
+    Tag tag2( QLatin1String("AsyncAddTag2") );
+    Resource res( QUrl(), NCO::Contact() );
+
+    ResourceJob* job = ResourceJob::addProperty( QList<Resource>() << res, NAO::hasTag(), tag1 );
+    QVERIFY( waitForJob( job ) );
+    QVERIFY( !job->error() );
+
+    job = ResourceJob::addProperty( QList<Resource>() << res, NAO::hasTag(), tag2 );
+    QVERIFY( waitForJob( job ) );
+    QVERIFY( !job->error() );
+    QVERIFY( m_maxTickGap < s_maxBlockTime );
+
+    QList<Tag> tags = res.tags();
+    QCOMPARE( tags.size(), 2 );
+    QVERIFY( tags.contains( tag1 ) );
+    QVERIFY( tags.contains( tag2 ) );
+}
+
+void ResourceTests::asyncRemoveProperty()
+{
+    Resource res( QUrl(), NCO::Contact() );
+    res.setProperty( NAO::prefLabel(), QString::fromLatin1("Async") );
+    QVERIFY( res.hasProperty( NAO::prefLabel() ) );
+
+    ResourceJob* job = ResourceJob::removeProperty( QList<Resource>() << res, NAO::prefLabel() );
+    QVERIFY( waitForJob( job ) );
+    QVERIFY( !job->error() );
+    QVERIFY( m_maxTickGap < s_maxBlockTime );
+
+    QVERIFY( !res.hasProperty( NAO::prefLabel() ) );
+
+    QString query = QString::fromLatin1("ask where { %1 %2 ?o . }")
+                    .arg( Soprano::Node::resourceToN3( res.uri() ),
+                          Soprano::Node::resourceToN3( NAO::prefLabel() ) );
+    QVERIFY( !ResourceManager::instance()->mainModel()->executeQuery( query, Soprano::Query::QueryLanguageSparql ).boolValue() );
+}
+
+
+namespace {
+    bool storeHasProperty( const Resource& res, const QUrl& property ) {
+        QString query = QString::fromLatin1("ask where { %1 %2 ?o . }")
+                        .arg( Soprano::Node::resourceToN3( res.uri() ),
+                              Soprano::Node::resourceToN3( property ) );
+        return ResourceManager::instance()->mainModel()->executeQuery( query, Soprano::Query::QueryLanguageSparql ).boolValue();
+    }
+}
+
+void ResourceTests::batchCommit()
+{
+    QList<Resource> resources;
+    for( int i = 0; i < 10; ++i ) {
+        Resource res( QUrl(), NCO::Contact() );
+        res.setProperty( NAO::description(), QString::fromLatin1("old") );
+        resources << res;
+    }
+
+    ResourceBatch batch;
+    for( int i = 0; i < resources.count(); ++i ) {
+        Resource& res = resources[i];
+        res.setProperty( NAO::prefLabel(), QString::fromLatin1("Batch %1").arg( i ) );
+        res.addProperty( NAO::hasTag(), Tag(QLatin1String("batch")) );
+        res.setRating( 4 );
+        res.removeProperty( NAO::description() );
+    }
+    QCOMPARE( batch.pendingChanges(), resources.count() * 4 );
+
+    // the cache already reflects the changes, the store does not
+    foreach( const Resource& res, resources ) {
+        QCOMPARE( res.rating(), quint32(4) );
+        QVERIFY( !res.hasProperty( NAO::description() ) );
+        QVERIFY( !storeHasProperty( res, NAO::prefLabel() ) );
+        QVERIFY( storeHasProperty( res, NAO::description() ) );
+    }
+
+    QVERIFY( batch.commit() );
+    QVERIFY( batch.errors().isEmpty() );
+    QCOMPARE( batch.pendingChanges(), 0 );
+
+    foreach( const Resource& res, resources ) {
+        QVERIFY( storeHasProperty( res, NAO::prefLabel() ) );
+        QVERIFY( storeHasProperty( res, NAO::hasTag() ) );
+        QVERIFY( storeHasProperty( res, NAO::numericRating() ) );
+        QVERIFY( !storeHasProperty( res, NAO::description() ) );
+    }
+
+    // changes after the commit are written right away again
+    resources.first().setRating( 2 );
+    QCOMPARE( ResourceManager::instance()->mainModel()->listStatements( resources.first().uri(), NAO::numericRating(), Soprano::Node() )
+              .allStatements().first().object().literal().toInt(), 2 );
+}
+
+void ResourceTests::batchRollback()
+{
+    Resource res( QUrl(), NCO::Contact() );
+    res.setProperty( NAO::prefLabel(), QString::fromLatin1("Before") );
+
+    {
+        ResourceBatch batch;
+        res.setProperty( NAO::prefLabel(), QString::fromLatin1("After") );
+        res.setRating( 3 );
+        QCOMPARE( res.property( NAO::prefLabel() ).toString(), QString::fromLatin1("After") );
+        batch.rollback();
+    }
+
+    QCOMPARE( res.property( NAO::prefLabel() ).toString(), QString::fromLatin1("Before") );
+    QVERIFY( !res.hasProperty( NAO::numericRating() ) );
+    QVERIFY( !storeHasProperty( res, NAO::numericRating() ) );
+}
+
+void ResourceTests::batchErrors()
+{
+    Resource good( QUrl(), NCO::Contact() );
+    Resource bad( QUrl(), NCO::Contact() );
+    good.setRating( 1 );
+    bad.setRating( 1 );
+
+    ResourceBatch batch;
+    good.setRating( 5 );
+    // nao:numericRating has a cardinality of 1
+    bad.setProperty( NAO::numericRating(), Variant( QList<int>() << 2 << 3 ) );
+    QVERIFY( !batch.commit() );
+
+    QCOMPARE( batch.errors().count(), 1 );
+    QVERIFY( batch.errors().contains( bad.uri() ) );
+
+    QCOMPARE( good.rating(), quint32(5) );
+    QCOMPARE( bad.rating(), quint32(1) );
+}
+
+void ResourceTests::batchExistingResource()
+{
+    ResourceManager* rm = ResourceManager::instance();
+
+    QUrl uri;
+    {
+        Resource res( QUrl(), NCO::Contact() );
+        res.setProperty( NAO::prefLabel(), QString::fromLatin1("Before") );
+        res.setDescription( QLatin1String("Description") );
+        uri = res.uri();
+    }
+
+    // drop the cache so the batch has to start with values which were never loaded
+    rm->setCacheBudget( 1 );
+    Resource res = Resource::fromResourceUri( uri );
+
+    {
+        ResourceBatch batch;
+        res.setProperty( NAO::prefLabel(), QString::fromLatin1("After") );
+        res.removeProperty( NAO::description() );
+
+        // the changes only live in the cache, which may not be evicted
+        rm->setCacheBudget( 1 );
+        QCOMPARE( res.property( NAO::prefLabel() ).toString(), QString::fromLatin1("After") );
+        QVERIFY( !res.hasProperty( NAO::description() ) );
+        QVERIFY( res.hasType( NCO::Contact() ) );
+
+        batch.rollback();
+    }
+
+    QCOMPARE( res.property( NAO::prefLabel() ).toString(), QString::fromLatin1("Before") );
+    QCOMPARE( res.description(), QString::fromLatin1("Description") );
+
+    {
+        ResourceBatch batch;
+        Resource::fromResourceUri( uri ).setProperty( NAO::prefLabel(), QString::fromLatin1("After") );
+        rm->setCacheBudget( 1 );
+        QVERIFY( batch.commit() );
+    }
+
+    rm->setCacheBudget( 0 );
+    QVERIFY( storeHasProperty( res, NAO::prefLabel() ) );
+    QCOMPARE( Resource::fromResourceUri( uri ).property( NAO::prefLabel() ).toString(), QString::fromLatin1("After") );
+    QCOMPARE( Resource::fromResourceUri( uri ).description(), QString::fromLatin1("Description") );
+}
+
 }
 
 QTEST_KDEMAIN(Nepomuk2::ResourceTests, NoGUI)
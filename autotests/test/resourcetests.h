@@ -21,8 +21,11 @@
 #define RESOURCETESTS_H
 
 #include <QtCore/QObject>
+#include <QtCore/QElapsedTimer>
 #include "../lib/testbase.h"
 
+class KJob;
+
 namespace Nepomuk2 {
 
 class ResourceTests : public Nepomuk2::TestBase
@@ -91,6 +94,50 @@ private Q_SLOTS:
     //
     void resourceDeletion();
     void resourceDeletion2();
+
+    // 8. Prefetching
+    //    a. Make sure all properties are loaded
+    //    b. Make sure loading a subset of the properties does not hide the others
+
+    void prefetch();
+    void prefetchProperties();
+
+    // 9. Cache budget
+    //    a. Make sure caches are dropped once the budget is exceeded
+    //    b. Make sure dropped caches are reloaded transparently
+    //    c. Make sure heavy properties are only loaded on request
+
+    void cacheBudget();
+    void heavyProperties();
+
+    // 10. Asynchronous API
+    //    a. Make sure the jobs do what their blocking counterparts do
+    //    b. Make sure the calling thread is never blocked
+
+    void asyncLoad();
+    void asyncSetProperty();
+    void asyncAddProperty();
+    void asyncRemoveProperty();
+
+    // 11. Batched writes
+    //    a. Make sure nothing is written before the commit
+    //    b. Make sure a rollback restores the cache
+    //    c. Make sure a failing resource does not affect the others
+
+    void batchCommit();
+    void batchRollback();
+    void batchErrors();
+    void batchExistingResource();
+
+protected Q_SLOTS:
+    void tick();
+
+private:
+    /// Runs the event loop until \p job is done and records the longest pause between ticks
+    bool waitForJob( KJob* job );
+
+    QElapsedTimer m_tickTimer;
+    qint64 m_maxTickGap;
 };
 
 }
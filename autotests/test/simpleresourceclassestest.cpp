@@ -96,4 +96,49 @@ void SimpleResourceSubsystemTest::testSimpleResourceGraphAdd()
 
     QCOMPARE(graph2,refGraph);
 }
+
+void SimpleResourceSubsystemTest::testSimpleResourceGraphIterators()
+{
+    SimpleResourceGraph refGraph;
+    refGraph.insert(resource1);
+    refGraph.insert(resource2);
+
+    // iterating does not copy anything and finds all resources
+    QList<QUrl> uris;
+    for(SimpleResourceGraph::const_iterator it = refGraph.constBegin(); it != refGraph.constEnd(); ++it)
+        uris << it->uri();
+    QCOMPARE(uris.count(), 2);
+    QVERIFY(uris.contains(resource1.uri()));
+    QVERIFY(uris.contains(resource2.uri()));
+
+    // modifying in place detaches from the copy
+    SimpleResourceGraph graph = refGraph;
+    SimpleResourceGraph::iterator it = graph.find(resource2.uri());
+    QVERIFY(it != graph.end());
+    it->addProperty(QUrl("prop4"), QString("foo"));
+    QVERIFY(graph[resource2.uri()].contains(QUrl("prop4")));
+    QVERIFY(!refGraph[resource2.uri()].contains(QUrl("prop4")));
+
+    // erase and take
+    it = graph.find(resource2.uri());
+    graph.erase(it);
+    QCOMPARE(graph.count(), 1);
+    QCOMPARE(graph.take(resource1.uri()), resource1);
+    QVERIFY(graph.isEmpty());
+    QVERIFY(graph.constFind(resource1.uri()) == graph.constEnd());
+
+    // swap
+    SimpleResourceGraph other;
+    other.swap(graph);
+    QVERIFY(other.isEmpty());
+    other.swap(refGraph);
+    QCOMPARE(other.count(), 2);
+    QVERIFY(refGraph.isEmpty());
+
+    SimpleResource res1(resource1);
+    SimpleResource res2(resource2);
+    res1.swap(res2);
+    QCOMPARE(res1, resource2);
+    QCOMPARE(res2, resource1);
+}
 QTEST_MAIN(SimpleResourceSubsystemTest)
@@ -34,6 +34,7 @@ class SimpleResourceSubsystemTest : public QObject
        void testSimpleResourceStream();
        void testSimpleResourceGraphStream();
        void testSimpleResourceGraphAdd();
+       void testSimpleResourceGraphIterators();
        void initTestCase();
     private:
        Nepomuk2::SimpleResource resource1,resource2;
@@ -20,6 +20,7 @@
 
 #include "storeresourcesbenchmark.h"
 #include "../lib/datagenerator.h"
+#include "../lib/allocationcounter.h"
 
 #include <KDebug>
 #include <KTemporaryFile>
@@ -29,6 +30,40 @@
 
 #include "datamanagement.h"
 #include "storeresourcesjob.h"
+#include "simpleresource.h"
+#include "simpleresourcegraph.h"
+
+#include <Soprano/Vocabulary/NAO>
+#include <Soprano/Vocabulary/RDF>
+
+namespace {
+    // Only the graph handling of the client is measured here, the allocations
+    // of the storage service are measured by the DataManagementModelBenchmark.
+
+    /// The kind of graphs the file indexer gets from its extractors
+    QList<Nepomuk2::SimpleResourceGraph> extractorGraphs() {
+        QList<Nepomuk2::SimpleResourceGraph> graphs;
+        const QUrl fileUri( QLatin1String("nepomuk:/res/file") );
+        for( int g = 0; g < 4; ++g ) {
+            Nepomuk2::SimpleResourceGraph graph;
+
+            Nepomuk2::SimpleResource file( fileUri );
+            for( int i = 0; i < 10; ++i ) {
+                file.addProperty( QUrl( QString::fromLatin1("prop:/%1/%2").arg( g ).arg( i ) ), i );
+            }
+            graph << file;
+
+            for( int i = 0; i < 5; ++i ) {
+                Nepomuk2::SimpleResource res;
+                res.addType( Soprano::Vocabulary::NAO::Tag() );
+                res.setProperty( Soprano::Vocabulary::NAO::prefLabel(), QString::fromLatin1("label %1 %2").arg( g ).arg( i ) );
+                graph << res;
+            }
+            graphs << graph;
+        }
+        return graphs;
+    }
+}
 
 namespace Nepomuk2 {
 namespace Test {
@@ -36,6 +71,7 @@ namespace Test {
 void StoreResourcesBenchmark::musicPiece()
 {
     DataGenerator gen;
+
     QBENCHMARK {
         QString title = QUuid::createUuid().toString();
         QString artist = QUuid::createUuid().toString();
@@ -45,6 +81,67 @@ void StoreResourcesBenchmark::musicPiece()
     }
 }
 
+void StoreResourcesBenchmark::graphConcatenation()
+{
+    const QList<SimpleResourceGraph> graphs = extractorGraphs();
+
+    {
+        AllocationCounter counter;
+        SimpleResourceGraph graph;
+        foreach( const SimpleResourceGraph& g, graphs )
+            graph += g;
+        kDebug() << "Allocations for concatenating" << graphs.count() << "graphs:" << counter.count();
+    }
+
+    QBENCHMARK {
+        SimpleResourceGraph graph;
+        foreach( const SimpleResourceGraph& g, graphs )
+            graph += g;
+    }
+}
+
+void StoreResourcesBenchmark::graphIteration()
+{
+    SimpleResourceGraph graph;
+    foreach( const SimpleResourceGraph& g, extractorGraphs() )
+        graph += g;
+
+    {
+        AllocationCounter counter;
+        int count = 0;
+        for( SimpleResourceGraph::const_iterator it = graph.constBegin(); it != graph.constEnd(); ++it )
+            count += it->properties().count();
+        kDebug() << "Allocations for iterating" << count << "properties:" << counter.count();
+    }
+    {
+        AllocationCounter counter;
+        int count = 0;
+        foreach( const SimpleResource& res, graph.toList() )
+            count += res.properties().count();
+        kDebug() << "Allocations for iterating" << count << "properties through toList():" << counter.count();
+    }
+
+    QBENCHMARK {
+        int count = 0;
+        for( SimpleResourceGraph::const_iterator it = graph.constBegin(); it != graph.constEnd(); ++it )
+            count += it->properties().count();
+        Q_UNUSED( count );
+    }
+}
+
+void StoreResourcesBenchmark::storeGraph()
+{
+    const QList<SimpleResourceGraph> graphs = extractorGraphs();
+    SimpleResourceGraph graph;
+    foreach( const SimpleResourceGraph& g, graphs )
+        graph += g;
+
+    QBENCHMARK {
+        KJob* job = Nepomuk2::storeResources( graph );
+        job->exec();
+    }
+}
+
 }
 }
 
@@ -33,6 +33,9 @@ class StoreResourcesBenchmark : public TestBase
 
 private Q_SLOTS:
     void musicPiece();
+    void graphConcatenation();
+    void graphIteration();
+    void storeGraph();
 };
 
 }
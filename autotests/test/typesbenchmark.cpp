@@ -0,0 +1,137 @@
+/*
+    This file is part of the Nepomuk KDE project.
+    Copyright (C) 2013  Nepomuk Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+
+#include "typesbenchmark.h"
+#include "class.h"
+#include "property.h"
+
+#include <QtCore/QRunnable>
+#include <QtCore/QThreadPool>
+
+#include <qtest_kde.h>
+
+using namespace Nepomuk2;
+
+namespace {
+    const int s_entityCount = 2000;
+    const int s_rounds = 20;
+
+    enum Operation {
+        Lookup,
+        Access
+    };
+
+    /// Runs the operation on all entities s_rounds times
+    class Runner : public QRunnable
+    {
+    public:
+        Runner( Operation op, const QList<QUrl>& classes, const QList<QUrl>& properties )
+            : m_op( op ),
+              m_classes( classes ),
+              m_properties( properties ) {
+        }
+
+        void run() {
+            for( int round = 0; round < s_rounds; ++round ) {
+                for( int i = 0; i < m_classes.count(); ++i ) {
+                    Types::Class c( m_classes[i] );
+                    if( m_op == Access ) {
+                        c.isAvailable();
+                        c.userVisible();
+                    }
+                }
+                for( int i = 0; i < m_properties.count(); ++i ) {
+                    Types::Property p( m_properties[i] );
+                    if( m_op == Access ) {
+                        p.isAvailable();
+                        p.userVisible();
+                    }
+                }
+            }
+        }
+
+    private:
+        Operation m_op;
+        QList<QUrl> m_classes;
+        QList<QUrl> m_properties;
+    };
+
+    void runThreads( Operation op, int threads, const QList<QUrl>& classes, const QList<QUrl>& properties ) {
+        QThreadPool pool;
+        pool.setMaxThreadCount( threads );
+        for( int i = 0; i < threads; ++i ) {
+            pool.start( new Runner( op, classes, properties ) );
+        }
+        pool.waitForDone();
+    }
+
+    void addThreadRows() {
+        QTest::addColumn<int>( "threads" );
+        QTest::newRow( "1 thread" ) << 1;
+        QTest::newRow( "2 threads" ) << 2;
+        QTest::newRow( "4 threads" ) << 4;
+        QTest::newRow( "8 threads" ) << 8;
+    }
+}
+
+void TypesBenchmark::initTestCase()
+{
+    for( int i = 0; i < s_entityCount; ++i ) {
+        m_classes << QUrl( QString::fromLatin1("onto:/class%1").arg( i ) );
+        m_properties << QUrl( QString::fromLatin1("onto:/property%1").arg( i ) );
+    }
+
+    // Load all entities once so the benchmarks only measure the cached case.
+    // Without a running storage service loading fails, which is cached as well.
+    runThreads( Access, 1, m_classes, m_properties );
+}
+
+void TypesBenchmark::lookup_data()
+{
+    addThreadRows();
+}
+
+void TypesBenchmark::lookup()
+{
+    QFETCH( int, threads );
+
+    QBENCHMARK {
+        runThreads( Lookup, threads, m_classes, m_properties );
+    }
+}
+
+void TypesBenchmark::access_data()
+{
+    addThreadRows();
+}
+
+void TypesBenchmark::access()
+{
+    QFETCH( int, threads );
+
+    QBENCHMARK {
+        runThreads( Access, threads, m_classes, m_properties );
+    }
+}
+
+QTEST_KDEMAIN_CORE(Nepomuk2::TypesBenchmark)
+
+#include "typesbenchmark.moc"
@@ -0,0 +1,54 @@
+/*
+    This file is part of the Nepomuk KDE project.
+    Copyright (C) 2013  Nepomuk Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+
+#ifndef TYPESBENCHMARK_H
+#define TYPESBENCHMARK_H
+
+#include <QtCore/QObject>
+#include <QtCore/QList>
+#include <QtCore/QUrl>
+
+namespace Nepomuk2 {
+
+/**
+ * Measures how well the Types API scales over several threads. Creating a
+ * Types::Class or Types::Property looks up the shared entity in the
+ * EntityManager and accessing an already loaded entity should not need to
+ * lock anything.
+ */
+class TypesBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void lookup();
+    void lookup_data();
+    void access();
+    void access_data();
+
+private:
+    QList<QUrl> m_classes;
+    QList<QUrl> m_properties;
+};
+
+}
+#endif // TYPESBENCHMARK_H
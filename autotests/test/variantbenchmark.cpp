@@ -0,0 +1,184 @@
+/*
+    This file is part of the Nepomuk KDE project.
+    Copyright (C) 2013  Nepomuk Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include "variantbenchmark.h"
+#include "variant.h"
+
+#include <QtCore/QDateTime>
+#include <QtCore/QStringList>
+#include <QtCore/QUrl>
+
+#include <Soprano/Node>
+#include <Soprano/LiteralValue>
+
+#include <qtest_kde.h>
+
+using namespace Nepomuk2;
+
+Q_DECLARE_METATYPE(Nepomuk2::Variant)
+
+namespace {
+    const int s_listSize = 50;
+
+    QStringList stringValues( int count ) {
+        QStringList l;
+        for( int i = 0; i < count; ++i )
+            l << QString::fromLatin1("value %1").arg( i );
+        return l;
+    }
+
+    QList<int> intValues( int count ) {
+        QList<int> l;
+        for( int i = 0; i < count; ++i )
+            l << i;
+        return l;
+    }
+
+    QList<QUrl> urlValues( int count ) {
+        QList<QUrl> l;
+        for( int i = 0; i < count; ++i )
+            l << QUrl( QString::fromLatin1("nepomuk:/res/%1").arg( i ) );
+        return l;
+    }
+
+    /// The kind of values found in a typical resource cache
+    void addValueRows() {
+        QTest::newRow( "int" ) << Variant( 5 );
+        QTest::newRow( "string" ) << Variant( QString::fromLatin1("Nepomuk") );
+        QTest::newRow( "dateTime" ) << Variant( QDateTime::currentDateTime() );
+        QTest::newRow( "url" ) << Variant( QUrl("nepomuk:/res/1") );
+        QTest::newRow( "intList" ) << Variant( intValues( s_listSize ) );
+        QTest::newRow( "stringList" ) << Variant( stringValues( s_listSize ) );
+        QTest::newRow( "urlList" ) << Variant( urlValues( s_listSize ) );
+    }
+}
+
+void VariantBenchmark::copy_data()
+{
+    QTest::addColumn<Variant>( "value" );
+    addValueRows();
+}
+
+void VariantBenchmark::copy()
+{
+    QFETCH( Variant, value );
+
+    QBENCHMARK {
+        Variant v( value );
+        Variant other;
+        other = v;
+    }
+}
+
+void VariantBenchmark::toVariantList_data()
+{
+    QTest::addColumn<Variant>( "value" );
+    addValueRows();
+}
+
+void VariantBenchmark::toVariantList()
+{
+    QFETCH( Variant, value );
+
+    QBENCHMARK {
+        QList<Variant> l = value.toVariantList();
+        Q_UNUSED( l );
+    }
+}
+
+void VariantBenchmark::compare_data()
+{
+    QTest::addColumn<Variant>( "value1" );
+    QTest::addColumn<Variant>( "value2" );
+
+    QTest::newRow( "int" ) << Variant( 5 ) << Variant( 5 );
+    QTest::newRow( "intAndList" ) << Variant( 5 ) << Variant( QList<int>() << 5 );
+    QTest::newRow( "string" ) << Variant( QString::fromLatin1("Nepomuk") ) << Variant( QString::fromLatin1("Nepomuk") );
+    QTest::newRow( "stringList" ) << Variant( stringValues( s_listSize ) ) << Variant( stringValues( s_listSize ) );
+    QTest::newRow( "url" ) << Variant( QUrl("nepomuk:/res/1") ) << Variant( QUrl("nepomuk:/res/1") );
+    QTest::newRow( "urlList" ) << Variant( urlValues( s_listSize ) ) << Variant( urlValues( s_listSize ) );
+}
+
+void VariantBenchmark::compare()
+{
+    QFETCH( Variant, value1 );
+    QFETCH( Variant, value2 );
+
+    bool equal = false;
+    QBENCHMARK {
+        equal = ( value1 == value2 );
+    }
+    QVERIFY( equal );
+}
+
+void VariantBenchmark::typedAccess()
+{
+    const Variant intList( intValues( s_listSize ) );
+    const Variant stringList( stringValues( s_listSize ) );
+    const Variant urlList( urlValues( s_listSize ) );
+
+    QBENCHMARK {
+        intList.toInt();
+        intList.toIntList();
+        stringList.toStringList();
+        urlList.toUrl();
+        urlList.toUrlList();
+        intList.isList();
+        stringList.simpleType();
+    }
+}
+
+void VariantBenchmark::append()
+{
+    QList<Variant> values;
+    foreach( const QString& s, stringValues( 1000 ) )
+        values << Variant( s );
+
+    QBENCHMARK {
+        Variant v( values );
+        QCOMPARE( v.toStringList().count(), values.count() );
+    }
+}
+
+void VariantBenchmark::fromNodeList()
+{
+    QList<Soprano::Node> nodes;
+    foreach( const QString& s, stringValues( 1000 ) )
+        nodes << Soprano::Node( Soprano::LiteralValue( s ) );
+
+    QBENCHMARK {
+        Variant v = Variant::fromNodeList( nodes );
+        Q_UNUSED( v );
+    }
+}
+
+void VariantBenchmark::toNodeList()
+{
+    const Variant v( intValues( 1000 ) );
+
+    QBENCHMARK {
+        QList<Soprano::Node> nodes = v.toNodeList();
+        Q_UNUSED( nodes );
+    }
+}
+
+QTEST_KDEMAIN_CORE(Nepomuk2::VariantBenchmark)
+
+#include "variantbenchmark.moc"
@@ -23,6 +23,7 @@
 #include "genericdatamanagementjob_p.h"
 #include "createresourcejob.h"
 #include "describeresourcesjob.h"
+#include "labelcompletionjob.h"
 #include "storeresourcesjob.h"
 #include "dbustypes.h"
 #include "simpleresourcegraph.h"
@@ -174,3 +175,10 @@ Nepomuk2::DescribeResourcesJob* Nepomuk2::describeResources(const QList<QUrl>& r
 {
     return new DescribeResourcesJob(resources, flags, targetParties);
 }
+
+Nepomuk2::LabelCompletionJob* Nepomuk2::completeLabels(const QUrl& type,
+                                                      const QString& prefix,
+                                                      int limit)
+{
+    return new LabelCompletionJob(type, prefix, limit);
+}
@@ -37,6 +37,7 @@ class KUrl;
 
 namespace Nepomuk2 {
     class DescribeResourcesJob;
+    class LabelCompletionJob;
     class StoreResourcesJob;
     class CreateResourceJob;
     class SimpleResourceGraph;
@@ -554,6 +555,31 @@ namespace Nepomuk2 {
     NEPOMUK_EXPORT DescribeResourcesJob* describeResources(const QList<QUrl>& resources,
                                                                            DescribeResourcesFlags flags = NoDescribeResourcesFlags,
                                                                            const QList<QUrl>& targetParties = QList<QUrl>() );
+
+    /**
+     * \brief Complete a label prefix to resources of a certain type.
+     *
+     * The storage service keeps an in-memory index of the labels of resources of
+     * the most commonly completed types. Currently these are \c nao:Tag with
+     * \c nao:prefLabel and \c nao:identifier and \c nco:Contact with \c nco:fullname,
+     * \c nco:nickname and \c nao:prefLabel. Completing any other type results in an error.
+     *
+     * The prefix is matched case-insensitively against the start of the labels as well as
+     * against the start of each word in them.
+     *
+     * \param type The type of the resources to complete, for example \c nao:Tag.
+     * \param prefix The prefix the user entered so far.
+     * \param limit The maximum number of resources to return. A value smaller than 1
+     * means no limit.
+     *
+     * \return A job which provides the matching resources through LabelCompletionJob::resources().
+     * Each returned resource contains its type and the label which matched.
+     *
+     * \since 4.13
+     */
+    NEPOMUK_EXPORT LabelCompletionJob* completeLabels(const QUrl& type,
+                                                      const QString& prefix,
+                                                      int limit = 10);
     //@}
     //@}
 }
@@ -72,6 +72,13 @@ public Q_SLOTS: // METHODS
         return asyncCallWithArgumentList(QLatin1String("createResource"), argumentList, s_defaultTimeout);
     }
 
+    inline QDBusPendingReply<QList<Nepomuk2::SimpleResource> > complete(const QString &type, const QString &prefix, int limit)
+    {
+        QList<QVariant> argumentList;
+        argumentList << qVariantFromValue(type) << qVariantFromValue(prefix) << qVariantFromValue(limit);
+        return asyncCallWithArgumentList(QLatin1String("complete"), argumentList, s_defaultTimeout);
+    }
+
     inline QDBusPendingReply<QList<Nepomuk2::SimpleResource> > describeResources(const QStringList &resources, int flags, const QStringList &targetParties)
     {
         QList<QVariant> argumentList;
@@ -184,6 +191,13 @@ public Q_SLOTS: // METHODS
         return asyncCallWithArgumentList(QLatin1String("storeResources"), argumentList, s_defaultTimeout);
     }
 
+    inline QDBusPendingReply<> storeResourcesFromFile(const QDBusUnixFileDescriptor &fd, int identificationMode, int flags, Nepomuk2::PropertyHash additionalMetadata, const QString &app)
+    {
+        QList<QVariant> argumentList;
+        argumentList << qVariantFromValue(fd) << qVariantFromValue(identificationMode) << qVariantFromValue(flags) << qVariantFromValue(additionalMetadata) << qVariantFromValue(app);
+        return asyncCallWithArgumentList(QLatin1String("storeResourcesFromFile"), argumentList, s_defaultTimeout);
+    }
+
 Q_SIGNALS: // SIGNALS
 };
 
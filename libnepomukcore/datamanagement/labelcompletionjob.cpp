@@ -0,0 +1,89 @@
+/*
+   This file is part of the Nepomuk KDE project.
+   Copyright (C) 2013  Nepomuk Developers
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) version 3, or any
+   later version accepted by the membership of KDE e.V. (or its
+   successor approved by the membership of KDE e.V.), which shall
+   act as a proxy defined in Section 6 of version 3 of the license.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "labelcompletionjob.h"
+#include "datamanagementinterface.h"
+#include "simpleresource.h"
+#include "dbustypes.h"
+#include "genericdatamanagementjob_p.h"
+
+#include <QtDBus/QDBusConnection>
+#include <QtDBus/QDBusPendingReply>
+#include <QtDBus/QDBusPendingCallWatcher>
+
+#include <QtCore/QVariant>
+#include <QtCore/QUrl>
+
+#include <KDebug>
+
+
+class Nepomuk2::LabelCompletionJob::Private
+{
+public:
+    QList<SimpleResource> m_resources;
+};
+
+Nepomuk2::LabelCompletionJob::LabelCompletionJob(const QUrl& type,
+                                                const QString& prefix,
+                                                int limit)
+    : KJob(0),
+      d(new Private)
+{
+    org::kde::nepomuk::DataManagement* dms = Nepomuk2::dataManagementDBusInterface();
+    QDBusPendingCallWatcher* dbusCallWatcher
+           = new QDBusPendingCallWatcher(dms->complete(Nepomuk2::DBus::convertUri(type),
+                                                       prefix,
+                                                       limit));
+    connect(dbusCallWatcher, SIGNAL(finished(QDBusPendingCallWatcher*)),
+            this, SLOT(slotDBusCallFinished(QDBusPendingCallWatcher*)));
+}
+
+Nepomuk2::LabelCompletionJob::~LabelCompletionJob()
+{
+    delete d;
+}
+
+void Nepomuk2::LabelCompletionJob::start()
+{
+    // do nothing, we do everything in the constructor
+}
+
+void Nepomuk2::LabelCompletionJob::slotDBusCallFinished(QDBusPendingCallWatcher *watcher)
+{
+    QDBusPendingReply<QList<Nepomuk2::SimpleResource> > reply = *watcher;
+    if (reply.isError()) {
+        QDBusError error = reply.error();
+        setError(1);
+        setErrorText(error.message());
+    }
+    else {
+        d->m_resources = reply.value();
+    }
+    watcher->deleteLater();
+    emitResult();
+}
+
+QList<Nepomuk2::SimpleResource> Nepomuk2::LabelCompletionJob::resources() const
+{
+    return d->m_resources;
+}
+
+#include "labelcompletionjob.moc"
@@ -87,6 +87,11 @@ Nepomuk2::SimpleResource & Nepomuk2::SimpleResource::operator=(const Nepomuk2::S
     return *this;
 }
 
+void Nepomuk2::SimpleResource::swap(Nepomuk2::SimpleResource &other)
+{
+    qSwap(d, other.d);
+}
+
 QUrl Nepomuk2::SimpleResource::uri() const
 {
     return d->m_uri;
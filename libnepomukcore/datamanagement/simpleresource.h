@@ -53,6 +53,14 @@ public:
 
     SimpleResource& operator=(const SimpleResource& other);
 
+    /**
+     * Swaps this resource with \p other. This operation is very fast and
+     * never copies any properties.
+     *
+     * \since 4.13
+     */
+    void swap(SimpleResource& other);
+
     bool operator==(const SimpleResource& other) const;
 
     QUrl uri() const;
@@ -56,6 +56,7 @@ Nepomuk2::SimpleResourceGraph::SimpleResourceGraph(const SimpleResource& resourc
 Nepomuk2::SimpleResourceGraph::SimpleResourceGraph(const QList<SimpleResource>& resources)
     : d(new Private)
 {
+    d->resources.reserve(resources.count());
     Q_FOREACH(const SimpleResource& res, resources) {
         insert(res);
     }
@@ -64,6 +65,7 @@ Nepomuk2::SimpleResourceGraph::SimpleResourceGraph(const QList<SimpleResource>&
 Nepomuk2::SimpleResourceGraph::SimpleResourceGraph(const QSet<SimpleResource>& resources)
     : d(new Private)
 {
+    d->resources.reserve(resources.count());
     Q_FOREACH(const SimpleResource& res, resources) {
         insert(res);
     }
@@ -84,6 +86,66 @@ Nepomuk2::SimpleResourceGraph & Nepomuk2::SimpleResourceGraph::operator=(const N
     return *this;
 }
 
+void Nepomuk2::SimpleResourceGraph::swap(Nepomuk2::SimpleResourceGraph &other)
+{
+    qSwap(d, other.d);
+}
+
+Nepomuk2::SimpleResourceGraph::iterator Nepomuk2::SimpleResourceGraph::begin()
+{
+    return d->resources.begin();
+}
+
+Nepomuk2::SimpleResourceGraph::iterator Nepomuk2::SimpleResourceGraph::end()
+{
+    return d->resources.end();
+}
+
+Nepomuk2::SimpleResourceGraph::const_iterator Nepomuk2::SimpleResourceGraph::begin() const
+{
+    return d->resources.constBegin();
+}
+
+Nepomuk2::SimpleResourceGraph::const_iterator Nepomuk2::SimpleResourceGraph::end() const
+{
+    return d->resources.constEnd();
+}
+
+Nepomuk2::SimpleResourceGraph::const_iterator Nepomuk2::SimpleResourceGraph::constBegin() const
+{
+    return d->resources.constBegin();
+}
+
+Nepomuk2::SimpleResourceGraph::const_iterator Nepomuk2::SimpleResourceGraph::constEnd() const
+{
+    return d->resources.constEnd();
+}
+
+Nepomuk2::SimpleResourceGraph::iterator Nepomuk2::SimpleResourceGraph::find(const QUrl &uri)
+{
+    return d->resources.find(uri);
+}
+
+Nepomuk2::SimpleResourceGraph::const_iterator Nepomuk2::SimpleResourceGraph::constFind(const QUrl &uri) const
+{
+    return d->resources.constFind(uri);
+}
+
+Nepomuk2::SimpleResourceGraph::iterator Nepomuk2::SimpleResourceGraph::erase(iterator it)
+{
+    return d->resources.erase(it);
+}
+
+Nepomuk2::SimpleResource Nepomuk2::SimpleResourceGraph::take(const QUrl &uri)
+{
+    return d->resources.take(uri);
+}
+
+void Nepomuk2::SimpleResourceGraph::reserve(int size)
+{
+    d->resources.reserve(size);
+}
+
 void Nepomuk2::SimpleResourceGraph::insert(const SimpleResource &res)
 {
     d->resources.insert(res.uri(), res);
@@ -234,18 +296,20 @@ Nepomuk2::SimpleResourceGraph::operator+=( const SimpleResourceGraph & graph )
     if ( d->resources.size() == 0 ) {
         d->resources = graph.d->resources;
     }
-    else {
+    else if ( graph.d->resources.size() != 0 ) {
+        d->resources.reserve(d->resources.size() + graph.d->resources.size());
+
         QHash<QUrl, SimpleResource>::const_iterator it;
         QHash<QUrl, SimpleResource>::iterator fit;
-        for (it = graph.d->resources.begin();
-              it!= graph.d->resources.end();
+        for (it = graph.d->resources.constBegin();
+              it!= graph.d->resources.constEnd();
             ++it
             )
         {
             fit = d->resources.find(it.key());
             if ( fit == d->resources.end() ) {
-                // Not found
-                d->resources[it.key()] = it.value();
+                // Not found. The resource is shared, not copied.
+                d->resources.insert(it.key(), it.value());
             }
             else {
                 // Found. Should merge
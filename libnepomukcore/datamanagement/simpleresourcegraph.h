@@ -23,6 +23,7 @@
 #define SIMPLERESOURCEGRAPH_H
 
 #include <QtCore/QSharedDataPointer>
+#include <QtCore/QHash>
 #include <QtCore/QList>
 #include <QtCore/QSet>
 #include <QtCore/QUrl>
@@ -32,6 +33,7 @@
 #include <KGlobal>
 
 #include "nepomuk_export.h"
+#include "simpleresource.h"
 
 class QDataStream;
 
@@ -42,7 +44,6 @@ class Node;
 class Graph;
 }
 namespace Nepomuk2 {
-class SimpleResource;
 class StoreResourcesJob;
 
 class NEPOMUK_EXPORT SimpleResourceGraph
@@ -57,6 +58,70 @@ public:
 
     SimpleResourceGraph& operator=(const SimpleResourceGraph& other);
 
+    /**
+     * Swaps this graph with \p other. This operation is very fast and
+     * never copies any resources.
+     *
+     * \since 4.13
+     */
+    void swap(SimpleResourceGraph& other);
+
+    /**
+     * Iterators over the resources in the graph. They allow to read and
+     * modify the resources in place without converting the graph into a
+     * list first. The URI of a resource must not be changed through an
+     * iterator, use take() and insert() instead.
+     *
+     * \since 4.13
+     */
+    typedef QHash<QUrl, SimpleResource>::iterator iterator;
+    typedef QHash<QUrl, SimpleResource>::const_iterator const_iterator;
+
+    /// \since 4.13
+    iterator begin();
+    /// \since 4.13
+    iterator end();
+    /// \since 4.13
+    const_iterator begin() const;
+    /// \since 4.13
+    const_iterator end() const;
+    /// \since 4.13
+    const_iterator constBegin() const;
+    /// \since 4.13
+    const_iterator constEnd() const;
+
+    /**
+     * \return An iterator to the resource with \p uri or end() if there is none.
+     * \since 4.13
+     */
+    iterator find(const QUrl& uri);
+
+    /**
+     * \return An iterator to the resource with \p uri or constEnd() if there is none.
+     * \since 4.13
+     */
+    const_iterator constFind(const QUrl& uri) const;
+
+    /**
+     * Removes the resource \p it points to.
+     * \return An iterator to the next resource.
+     * \since 4.13
+     */
+    iterator erase(iterator it);
+
+    /**
+     * Removes the resource with \p uri from the graph and returns it.
+     * \since 4.13
+     */
+    SimpleResource take(const QUrl& uri);
+
+    /**
+     * Reserves space for \p size resources. Use this before inserting
+     * many resources to avoid rehashing.
+     * \since 4.13
+     */
+    void reserve(int size);
+
     /**
      * Adds a resource to the graph. An invalid resource will get a
      * new blank node as resource URI.
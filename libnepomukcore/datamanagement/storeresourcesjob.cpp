@@ -29,14 +29,64 @@
 #include <QtDBus/QDBusConnection>
 #include <QtDBus/QDBusPendingReply>
 #include <QtDBus/QDBusPendingCallWatcher>
+#include <QtDBus/QDBusUnixFileDescriptor>
 
 #include <QtCore/QHash>
 #include <QtCore/QUrl>
+#include <QtCore/QDataStream>
+#include <QtCore/QFile>
 
 #include <KComponentData>
+#include <KTemporaryFile>
 #include <KUrl>
 #include <KDebug>
 
+namespace {
+    /**
+     * Graphs with more property values than this are not marshalled as D-Bus
+     * structures but written to a temporary file which is passed to the DMS as a
+     * file descriptor. Marshalling dominates the CPU time of large imports and
+     * D-Bus messages are limited in size.
+     */
+    const int s_fileTransportThreshold = 5000;
+
+    int propertyValueCount(const Nepomuk2::SimpleResourceGraph& graph) {
+        int count = 0;
+        for(Nepomuk2::SimpleResourceGraph::const_iterator it = graph.constBegin();
+            it != graph.constEnd(); ++it) {
+            count += it.value().properties().size();
+        }
+        return count;
+    }
+
+    bool canPassFileDescriptors(const QDBusConnection& connection) {
+        return QDBusUnixFileDescriptor::isSupported() &&
+               (connection.connectionCapabilities() & QDBusConnection::UnixFileDescriptorPassing);
+    }
+
+    /**
+     * Writes \p graph in the format of QDataStream << SimpleResourceGraph. Like the
+     * D-Bus marshalling of PropertyHash, KUrl values are replaced with QUrl since the
+     * DMS cannot rely on KUrl being streamable.
+     */
+    void writeGraph(QDataStream& stream, const Nepomuk2::SimpleResourceGraph& graph) {
+        stream << quint32(graph.count());
+        for(Nepomuk2::SimpleResourceGraph::const_iterator it = graph.constBegin();
+            it != graph.constEnd(); ++it) {
+            const Nepomuk2::PropertyHash properties = it.value().properties();
+            Nepomuk2::PropertyHash normalized;
+            for(Nepomuk2::PropertyHash::const_iterator pit = properties.constBegin();
+                pit != properties.constEnd(); ++pit) {
+                if(pit.value().userType() == qMetaTypeId<KUrl>())
+                    normalized.insertMulti(pit.key(), QUrl(pit.value().value<KUrl>()));
+                else
+                    normalized.insertMulti(pit.key(), pit.value());
+            }
+            stream << it.value().uri() << normalized;
+        }
+    }
+}
+
 class Nepomuk2::StoreResourcesJob::Private {
 public:
     Nepomuk2::StoreResourcesJob *q;
@@ -56,10 +106,41 @@ Nepomuk2::StoreResourcesJob::StoreResourcesJob(const Nepomuk2::SimpleResourceGra
     d->q = this;
 
     org::kde::nepomuk::DataManagement* dms = Nepomuk2::dataManagementDBusInterface();
-    QDBusPendingCallWatcher* dbusCallWatcher
-    = new QDBusPendingCallWatcher(dms->storeResources( resources.toList(), identificationMode,
-                                                       flags, additionalMetadata,
-                                                       component.componentName() ));
+
+    QDBusPendingReply<> call;
+    bool callStarted = false;
+    if( propertyValueCount(resources) > s_fileTransportThreshold &&
+        canPassFileDescriptors(dms->connection()) ) {
+        // The DMS reads the file through its own copy of the descriptor. Thus, the
+        // file is unlinked right away and vanishes with the last descriptor.
+        KTemporaryFile file;
+        file.setAutoRemove( false );
+        if( file.open() ) {
+            QFile::remove( file.fileName() );
+
+            QDataStream stream( &file );
+            stream.setVersion( QDataStream::Qt_4_6 );
+            writeGraph( stream, resources );
+            if( stream.status() == QDataStream::Ok && file.flush() ) {
+                call = dms->storeResourcesFromFile( QDBusUnixFileDescriptor(file.handle()),
+                                                    identificationMode, flags,
+                                                    additionalMetadata,
+                                                    component.componentName() );
+                callStarted = true;
+            }
+        }
+        if( !callStarted ) {
+            kDebug() << "Failed to write resources to temporary file. Falling back to D-Bus marshalling.";
+        }
+    }
+
+    if( !callStarted ) {
+        call = dms->storeResources( resources.toList(), identificationMode,
+                                    flags, additionalMetadata,
+                                    component.componentName() );
+    }
+
+    QDBusPendingCallWatcher* dbusCallWatcher = new QDBusPendingCallWatcher(call);
 
     connect(dbusCallWatcher, SIGNAL(finished(QDBusPendingCallWatcher*)),
             this, SLOT(_k_slotDBusCallFinished(QDBusPendingCallWatcher*)));
@@ -37,6 +37,10 @@ void Nepomuk2::Query::registerDBusTypes()
 
     qRegisterMetaType<RequestPropertyMapDBus>("RequestPropertyMapDBus");
     qDBusRegisterMetaType<RequestPropertyMapDBus>();
+
+    qRegisterMetaType<FacetCountsDBus>("FacetCountsDBus");
+    qDBusRegisterMetaType<FacetValueCountsDBus>();
+    qDBusRegisterMetaType<FacetCountsDBus>();
 }
 
 
@@ -33,6 +33,10 @@ Q_DECLARE_METATYPE(Soprano::Node)
 Q_DECLARE_METATYPE(QList<Nepomuk2::Query::Result>)
 typedef QHash<QString, QString> RequestPropertyMapDBus;
 Q_DECLARE_METATYPE( RequestPropertyMapDBus )
+typedef QHash<QString, int> FacetValueCountsDBus;
+Q_DECLARE_METATYPE( FacetValueCountsDBus )
+typedef QHash<QString, FacetValueCountsDBus> FacetCountsDBus;
+Q_DECLARE_METATYPE( FacetCountsDBus )
 
 namespace Nepomuk2 {
     namespace Query {
@@ -34,6 +34,12 @@
 #include <QtCore/QSet>
 #include <QtCore/QMutex>
 #include <QtCore/QMutexLocker>
+#include <QtCore/QVector>
+#include <QtCore/QPair>
+#include <QtCore/QtAlgorithms>
+#include <QtCore/QDateTime>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFileInfo>
 
 #include <kdebug.h>
 #include <klocale.h>
@@ -41,6 +47,7 @@
 #include "resourcemanager.h"
 #include "property.h"
 #include "literal.h"
+#include "ontologysnapshot_p.h"
 
 #include <Soprano/Node>
 #include <Soprano/Model>
@@ -447,6 +454,174 @@ namespace {
 
     // the one global instance used for the statis QueryParser methods
     K_GLOBAL_STATIC( QueryParserRegExpPool, s_regExpPool )
+
+
+    /**
+     * An in-memory index of the labels and local names of all properties
+     * which is used to match field names in user queries. It is built once
+     * with a single query from the ontologies stored in the database. Lookups
+     * are binary searches on a sorted list of keys which allows us to match
+     * field names on each key press without touching the database.
+     *
+     * Keys are lower-case and do not contain white space. In addition to the
+     * full label each word suffix of the label is indexed so "tag" will still
+     * match the label "has tag".
+     *
+     * The storage service rewrites the ontology snapshot after each ontology
+     * update. The index is rebuilt once the snapshot changed. The snapshot is
+     * checked at most every few seconds to keep the stat out of the lookups.
+     */
+    class PropertyLabelIndex
+    {
+    public:
+        PropertyLabelIndex()
+            : m_built( false ),
+              m_generation( 0 ),
+              m_snapshotPath( Nepomuk2::Types::OntologySnapshot::defaultPath() ) {
+        }
+
+        QList<Nepomuk2::Types::Property> match( const QString& fieldName );
+
+        /**
+         * Increased each time the ontologies changed since the index was built.
+         * Matches from an older generation are outdated.
+         */
+        int generation();
+
+    private:
+        typedef QPair<QString, QUrl> Entry;
+
+        void build();
+        void addKeys( const QStringList& words, const QUrl& property );
+
+        static bool entryLessThan( const Entry& e1, const Entry& e2 ) {
+            return e1.first < e2.first;
+        }
+
+        static bool keyLengthLessThan( const Entry& e1, const Entry& e2 ) {
+            return e1.first.length() < e2.first.length();
+        }
+
+        QMutex m_mutex;
+        bool m_built;
+        int m_generation;
+
+        QString m_snapshotPath;
+
+        /// the mtime of the ontology snapshot when the index was built
+        QDateTime m_snapshotTime;
+
+        /// started each time the snapshot is checked
+        QElapsedTimer m_snapshotCheckTimer;
+
+        /// sorted by key
+        QVector<Entry> m_entries;
+    };
+
+    K_GLOBAL_STATIC( PropertyLabelIndex, s_propertyLabelIndex )
+
+    /// in msecs
+    const qint64 s_snapshotCheckInterval = 5000;
+
+    void PropertyLabelIndex::addKeys( const QStringList& words, const QUrl& property )
+    {
+        for( int i = 0; i < words.count(); ++i ) {
+            const QString key = QStringList( words.mid( i ) ).join( QString() ).toLower();
+            if( !key.isEmpty() )
+                m_entries.append( qMakePair( key, property ) );
+        }
+    }
+
+    void PropertyLabelIndex::build()
+    {
+        Soprano::Model* model = Nepomuk2::ResourceManager::instance()->mainModel();
+        if( !model )
+            return;
+
+        m_snapshotTime = QFileInfo( m_snapshotPath ).lastModified();
+        m_snapshotCheckTimer.start();
+
+        const QString query = QString::fromLatin1( "select distinct ?p ?l where { "
+                                                   "graph ?g { ?p a %1 . "
+                                                   "OPTIONAL { ?p %2 ?l . } } }" )
+                              .arg( Soprano::Node::resourceToN3( Soprano::Vocabulary::RDF::Property() ),
+                                    Soprano::Node::resourceToN3( Soprano::Vocabulary::RDFS::label() ) );
+
+        // split camel case local names like "hasTag" into words
+        QRegExp camelCaseRx( QLatin1String( "([a-z0-9])([A-Z])" ) );
+
+        QSet<QUrl> properties;
+        Soprano::QueryResultIterator it = model->executeQuery( query, Soprano::Query::QueryLanguageSparql );
+        while( it.next() ) {
+            const QUrl property = it.binding( "p" ).uri();
+            if( !properties.contains( property ) ) {
+                properties.insert( property );
+                QString localName = property.fragment();
+                if( localName.isEmpty() )
+                    localName = property.toString().section( QLatin1Char( '/' ), -1 );
+                localName.replace( camelCaseRx, QLatin1String( "\\1 \\2" ) );
+                addKeys( localName.split( QLatin1Char( ' ' ), QString::SkipEmptyParts ), property );
+            }
+
+            const QString label = it.binding( "l" ).toString();
+            if( !label.isEmpty() )
+                addKeys( label.simplified().split( QLatin1Char( ' ' ), QString::SkipEmptyParts ), property );
+        }
+
+        qSort( m_entries );
+        m_entries.squeeze();
+
+        // an empty index means that the storage was not available. Try again next time.
+        m_built = !m_entries.isEmpty();
+        kDebug() << "Built property label index with" << m_entries.count() << "keys for" << properties.count() << "properties";
+    }
+
+    int PropertyLabelIndex::generation()
+    {
+        QMutexLocker lock( &m_mutex );
+        if( !m_built || m_snapshotCheckTimer.elapsed() < s_snapshotCheckInterval )
+            return m_generation;
+
+        m_snapshotCheckTimer.start();
+        if( QFileInfo( m_snapshotPath ).lastModified() != m_snapshotTime ) {
+            kDebug() << "The ontologies changed, rebuilding the property label index";
+            m_built = false;
+            m_entries.clear();
+            ++m_generation;
+        }
+        return m_generation;
+    }
+
+    QList<Nepomuk2::Types::Property> PropertyLabelIndex::match( const QString& fieldName )
+    {
+        QMutexLocker lock( &m_mutex );
+        if( !m_built )
+            build();
+
+        const QString prefix = fieldName.simplified().remove( QLatin1Char( ' ' ) ).toLower();
+        if( prefix.isEmpty() )
+            return QList<Nepomuk2::Types::Property>();
+
+        QList<Entry> matches;
+        QVector<Entry>::const_iterator it = qLowerBound( m_entries.constBegin(), m_entries.constEnd(),
+                                                         qMakePair( prefix, QUrl() ), entryLessThan );
+        for( ; it != m_entries.constEnd() && it->first.startsWith( prefix ); ++it ) {
+            matches << *it;
+        }
+
+        // exact matches come first, followed by the remaining matches, shortest key first
+        qStableSort( matches.begin(), matches.end(), keyLengthLessThan );
+
+        QList<Nepomuk2::Types::Property> results;
+        QSet<QUrl> seen;
+        Q_FOREACH( const Entry& entry, matches ) {
+            if( !seen.contains( entry.second ) ) {
+                seen.insert( entry.second );
+                results << Nepomuk2::Types::Property( entry.second );
+            }
+        }
+        return results;
+    }
 }
 
 
@@ -460,6 +635,12 @@ public:
     mutable QHash<QString, QList<Types::Property> > fieldMatchCache;
     QMutex fieldMatchCacheMutex;
 
+    /// the PropertyLabelIndex generation the cached field matches are based on
+    int fieldMatchGeneration;
+
+    /// Clear fieldMatchCache except for the built-in matches
+    void resetFieldMatchCache();
+
     /// set by resolveFields if the query is in fact invalid
     bool m_invalidQuery;
 
@@ -470,9 +651,113 @@ public:
      * no property can be matched.
      */
     Nepomuk2::Query::Term resolveFields( const Nepomuk2::Query::Term& term );
+
+    /**
+     * The state of the parser after handling one token of the query string.
+     * All members are implicitly shared which makes it cheap to keep one
+     * state per token.
+     */
+    struct ParserState {
+        ParserState()
+            : inOrBlock( false ),
+              inAndBlock( false ),
+              invalid( false ) {
+        }
+
+        /// the top-level terms with already resolved fields
+        QList<Term> terms;
+
+        /// the query that collects the include and exclude folders
+        Query final;
+
+        bool inOrBlock;
+        bool inAndBlock;
+
+        /// true if one of the fields could not be resolved
+        bool invalid;
+    };
+
+    struct ParsedToken {
+        int start;
+        int end;
+
+        /**
+         * false if the token could be matched differently once more text is
+         * appended, for example an unterminated quote or nested term.
+         */
+        bool stable;
+
+        ParserState state;
+    };
+
+    /**
+     * Parse the tokens in \p query starting at \p pos and continuing from \p state.
+     * Each handled token is appended to \p tokens.
+     *
+     * \return \p false if the query string cannot be parsed.
+     */
+    bool parseTokens( const QString& query, int pos, ParserFlags flags,
+                      ParserState& state, QList<ParsedToken>& tokens );
+
+    /**
+     * Build the final query from the top-level terms in \p state.
+     */
+    Query buildQuery( const ParserState& state ) const;
+
+    // the state of parseIncremental()
+    QString m_lastQueryString;
+    ParserFlags m_lastFlags;
+    QList<ParsedToken> m_lastTokens;
+    bool m_lastParseFailed;
+    Query m_lastQuery;
+
+    /// the tokens contain resolved fields which are outdated in a new PropertyLabelIndex generation
+    int m_lastGeneration;
 };
 
 
+namespace {
+    /**
+     * A token can only be reused by QueryParser::parseIncremental() if appending
+     * text can not change the way it is matched. This is not the case for tokens
+     * which open a quote, a nested term or a URI without closing it, nor for a
+     * lone exclusion prefix.
+     */
+    bool isStableToken( const QString& token )
+    {
+        // "not", "+", "-" and "!" on their own are literals but negate or require
+        // the following term once it is typed
+        const QString trimmed = token.trimmed();
+        if( ( trimmed.length() == 1 && QString::fromLatin1( "+-!" ).contains( trimmed[0] ) ) ||
+            trimmed.compare( QLatin1String( "not" ), Qt::CaseInsensitive ) == 0 ) {
+            return false;
+        }
+
+        for( int i = 0; i < token.length(); ++i ) {
+            const QChar c = token[i];
+            if( c == QLatin1Char('\'') || c == QLatin1Char('"') ||
+                c == QLatin1Char('(') || c == QLatin1Char('<') ) {
+                const QChar last = token[token.length()-1];
+                return( token.length() > 1 &&
+                        ( last == QLatin1Char('\'') || last == QLatin1Char('"') ||
+                          last == QLatin1Char(')') || last == QLatin1Char('>') ) );
+            }
+        }
+        return true;
+    }
+
+    QList<Nepomuk2::Query::Term> topLevelTerms( const Nepomuk2::Query::Query& query )
+    {
+        if( query.term().isAndTerm() )
+            return query.term().toAndTerm().subTerms();
+        else if( query.term().isValid() )
+            return QList<Nepomuk2::Query::Term>() << query.term();
+        else
+            return QList<Nepomuk2::Query::Term>();
+    }
+}
+
+
 
 Term QueryParser::Private::resolveFields(const Term &term)
 {
@@ -539,6 +824,10 @@ Nepomuk2::Query::QueryParser::QueryParser()
     : d( new Private() )
 {
     d->q = this;
+    d->m_invalidQuery = false;
+    d->m_lastParseFailed = false;
+    d->m_lastGeneration = 0;
+    d->fieldMatchGeneration = 0;
 
     QString andListStr = i18nc( "Boolean AND keyword in desktop search strings. "
                                 "You can add several variants separated by spaces, "
@@ -559,13 +848,21 @@ Nepomuk2::Query::QueryParser::QueryParser()
         d->orKeywords.insert( orKeyword.toLower() );
     }
 
+    d->resetFieldMatchCache();
+}
+
+
+void Nepomuk2::Query::QueryParser::Private::resetFieldMatchCache()
+{
+    fieldMatchCache.clear();
+
     // These are going to be the most frequently matched
     // We are including them so as to speed up the queries as otherwise each of these keywords
     // maps to multiple properties
-    d->fieldMatchCache.insert( QLatin1String("hastag"), QList<Types::Property>() << Types::Property(NAO::hasTag()) );
-    d->fieldMatchCache.insert( QLatin1String("rating"), QList<Types::Property>() << Types::Property(NAO::numericRating()) );
-    d->fieldMatchCache.insert( QLatin1String("comment"), QList<Types::Property>() << Types::Property(NAO::description()) );
-    d->fieldMatchCache.insert( QLatin1String("mimetype"), QList<Types::Property>() << Types::Property(NIE::mimeType()) );
+    fieldMatchCache.insert( QLatin1String("hastag"), QList<Types::Property>() << Types::Property(NAO::hasTag()) );
+    fieldMatchCache.insert( QLatin1String("rating"), QList<Types::Property>() << Types::Property(NAO::numericRating()) );
+    fieldMatchCache.insert( QLatin1String("comment"), QList<Types::Property>() << Types::Property(NAO::description()) );
+    fieldMatchCache.insert( QLatin1String("mimetype"), QList<Types::Property>() << Types::Property(NIE::mimeType()) );
 }
 
 
@@ -579,7 +876,13 @@ QList<Nepomuk2::Types::Property> Nepomuk2::Query::QueryParser::matchProperty( co
 {
     kDebug() << fieldName;
 
+    const int generation = s_propertyLabelIndex->generation();
+
     QMutexLocker lock( &d->fieldMatchCacheMutex );
+    if( generation != d->fieldMatchGeneration ) {
+        d->resetFieldMatchCache();
+        d->fieldMatchGeneration = generation;
+    }
 
     QHash<QString, QList<Types::Property> >::ConstIterator it = d->fieldMatchCache.constFind( fieldName );
     if( it != d->fieldMatchCache.constEnd() ) {
@@ -588,33 +891,10 @@ QList<Nepomuk2::Types::Property> Nepomuk2::Query::QueryParser::matchProperty( co
     else {
         lock.unlock();
 
-        QList<Nepomuk2::Types::Property> results;
-
-        //
-        // Due to the limited number of properties in the database a REGEX filter
-        // is actually faster than a fulltext query via bif:contains (this is what
-        // experiments showed).
-        //
-        QString query = QString( "select distinct ?p where { "
-                                 "graph ?g { "
-                                 "?p a %1 . "
-                                 "?p %2 ?l . "
-                                 "FILTER(REGEX(STR(?l),'%3*','i') || REGEX(STR(?p),'%3*','i')) . "
-                                 "} "
-                                 "}" )
-                        .arg( Soprano::Node::resourceToN3( Soprano::Vocabulary::RDF::Property() ) )
-                        .arg( Soprano::Node::resourceToN3( Soprano::Vocabulary::RDFS::label() ) )
-                        .arg( fieldName );
-        kDebug() << "Match query:" << query;
-
-        Soprano::QueryResultIterator labelHits
-            = Nepomuk2::ResourceManager::instance()->mainModel()->executeQuery( query, Soprano::Query::QueryLanguageSparql );
-
-        while ( labelHits.next() ) {
-            QUrl property = labelHits.binding( "p" ).uri();
-            results << property;
-            kDebug() << "Found property match" << property;
-        }
+        // The index is built once from the ontologies. Thus, a cache miss does not
+        // result in a database query.
+        const QList<Nepomuk2::Types::Property> results = s_propertyLabelIndex->match( fieldName );
+        kDebug() << "Found" << results.count() << "property matches";
 
         lock.relock();
         d->fieldMatchCache.insert( fieldName, results );
@@ -629,19 +909,12 @@ Nepomuk2::Query::Query Nepomuk2::Query::QueryParser::parse( const QString& query
 }
 
 
-Nepomuk2::Query::Query Nepomuk2::Query::QueryParser::parse( const QString& query, ParserFlags flags ) const
+bool Nepomuk2::Query::QueryParser::Private::parseTokens( const QString& query, int pos, ParserFlags flags,
+                                                        ParserState& state, QList<ParsedToken>& tokens )
 {
     // TODO: a "real" parser which can handle all of the Xesam user language
     //       This one for example does not handle nesting at all.
 
-    Nepomuk2::Query::Query final;
-    QList<Term> terms;
-
-    bool inOrBlock = false;
-    bool inAndBlock = false;
-
-    int pos = 0;
-
     // create local copies of the regexps for thread safety purposes
     const QRegExp resourceRx = s_regExpPool->resourceRx;
     const QRegExp propertyRx = s_regExpPool->propertyRx;
@@ -657,6 +930,7 @@ Nepomuk2::Query::Query Nepomuk2::Query::QueryParser::parse( const QString& query
         }
 
         Term term;
+        const int start = pos;
 
         if ( pos < query.length() ) {
             if ( resourceRx.indexIn( query, pos ) == pos ) {
@@ -717,12 +991,12 @@ Nepomuk2::Query::Query Nepomuk2::Query::QueryParser::parse( const QString& query
                 if( stripQuotes ( fieldRx.cap( 2 ) ).compare( QString( "inFolder" ), Qt::CaseInsensitive ) == 0 ) {
                     KUrl url( fieldRx.cap( 5 ) );
                     kDebug() << "found include path" << url;
-                    FileQuery fileQuery(final);
+                    FileQuery fileQuery(state.final);
                     if ( positiveTerm( fieldRx.cap( 1 ) ) )
                         fileQuery.addIncludeFolder(url);
                     else
                         fileQuery.addExcludeFolder(url);
-                    final = fileQuery;
+                    state.final = fileQuery;
                     pos += fieldRx.matchedLength();
                 }
                 else {
@@ -745,11 +1019,11 @@ Nepomuk2::Query::Query Nepomuk2::Query::QueryParser::parse( const QString& query
 
             else if ( plainTermRx.indexIn( query, pos ) == pos ) {
                 QString value = plainTermRx.cap( 2 );
-                if ( d->orKeywords.contains( value.toLower() ) ) {
-                    inOrBlock = true;
+                if ( orKeywords.contains( value.toLower() ) ) {
+                    state.inOrBlock = true;
                 }
-                else if ( d->andKeywords.contains( value.toLower() ) ) {
-                    inAndBlock = true;
+                else if ( andKeywords.contains( value.toLower() ) ) {
+                    state.inAndBlock = true;
                 }
                 else {
                     kDebug() << "matched literal at" << pos << value;
@@ -768,46 +1042,152 @@ Nepomuk2::Query::Query Nepomuk2::Query::QueryParser::parse( const QString& query
 
             else {
                 kDebug() << "Invalid query at" << pos << query;
-                return Query();
+                return false;
             }
 
             if ( term.isValid() ) {
-                if ( inOrBlock && !terms.isEmpty() ) {
+                // Resolving the fields of each term on its own is equivalent to resolving the
+                // combined term since resolveFields() handles AND and OR terms recursively.
+                // This way the terms can be reused by parseIncremental().
+                m_invalidQuery = false;
+                term = resolveFields( term );
+                if( m_invalidQuery || !term.isValid() ) {
+                    state.invalid = true;
+                }
+
+                if ( state.inOrBlock && !state.terms.isEmpty() ) {
                     OrTerm orTerm;
-                    orTerm.addSubTerm( terms.takeLast() );
+                    orTerm.addSubTerm( state.terms.takeLast() );
                     orTerm.addSubTerm( term );
-                    terms.append( orTerm );
+                    state.terms.append( orTerm );
                 }
-                else if ( inAndBlock && !terms.isEmpty() ) {
+                else if ( state.inAndBlock && !state.terms.isEmpty() ) {
                     AndTerm andTerm;
-                    andTerm.addSubTerm( terms.takeLast() );
+                    andTerm.addSubTerm( state.terms.takeLast() );
                     andTerm.addSubTerm( term );
-                    terms.append( andTerm );
+                    state.terms.append( andTerm );
                 }
                 else {
-                    terms.append( term );
+                    state.terms.append( term );
                 }
             }
+
+            ParsedToken token;
+            token.start = start;
+            token.end = pos;
+            token.stable = isStableToken( query.mid( start, pos - start ) );
+            token.state = state;
+            tokens.append( token );
         }
     }
 
-    if ( terms.count() == 1 ) {
-        final.setTerm( terms[0] );
+    return true;
+}
+
+
+Nepomuk2::Query::Query Nepomuk2::Query::QueryParser::Private::buildQuery( const ParserState& state ) const
+{
+    if( state.invalid ) {
+        return Query();
+    }
+
+    Query final( state.final );
+    if ( state.terms.count() == 1 ) {
+        final.setTerm( state.terms[0] );
     }
-    else if ( terms.count() > 0 ) {
+    else if ( state.terms.count() > 0 ) {
         AndTerm t;
-        t.setSubTerms( terms );
+        t.setSubTerms( state.terms );
         final.setTerm( t );
     }
 
-    d->m_invalidQuery = false;
-    final.setTerm( mergeLiteralTerms( d->resolveFields( final.term() ) ) );
-    if(d->m_invalidQuery) {
+    final.setTerm( mergeLiteralTerms( final.term() ) );
+    return final;
+}
+
+
+Nepomuk2::Query::Query Nepomuk2::Query::QueryParser::parse( const QString& query, ParserFlags flags ) const
+{
+    Private::ParserState state;
+    QList<Private::ParsedToken> tokens;
+    if( !d->parseTokens( query, 0, flags, state, tokens ) ) {
         return Query();
     }
-    else {
-        return final;
+    return d->buildQuery( state );
+}
+
+
+Nepomuk2::Query::Query Nepomuk2::Query::QueryParser::parseIncremental( const QString& query, ParserFlags flags, int* firstChangedTerm )
+{
+    if( firstChangedTerm )
+        *firstChangedTerm = -1;
+
+    // the resolved fields of the previous tokens are based on outdated ontologies
+    const int generation = s_propertyLabelIndex->generation();
+    if( generation != d->m_lastGeneration ) {
+        d->m_lastGeneration = generation;
+        d->m_lastQueryString.clear();
+        d->m_lastTokens.clear();
+    }
+
+    if( flags == d->m_lastFlags && query == d->m_lastQueryString ) {
+        return d->m_lastQuery;
+    }
+
+    // find the last token which is not affected by the edit. The character following a
+    // reused token needs to be unchanged, too, since it ends the token.
+    int commonPrefix = 0;
+    if( flags == d->m_lastFlags ) {
+        const int maxPrefix = qMin( query.length(), d->m_lastQueryString.length() );
+        while( commonPrefix < maxPrefix && query[commonPrefix] == d->m_lastQueryString[commonPrefix] )
+            ++commonPrefix;
+    }
+
+    int reusedTokens = 0;
+    while( reusedTokens < d->m_lastTokens.count() &&
+           d->m_lastTokens[reusedTokens].stable &&
+           d->m_lastTokens[reusedTokens].end < commonPrefix ) {
+        ++reusedTokens;
+    }
+    d->m_lastTokens.erase( d->m_lastTokens.begin() + reusedTokens, d->m_lastTokens.end() );
+    kDebug() << "Reusing" << reusedTokens << "tokens of" << d->m_lastQueryString;
+
+    Private::ParserState state;
+    int pos = 0;
+    if( reusedTokens > 0 ) {
+        state = d->m_lastTokens.last().state;
+        pos = d->m_lastTokens.last().end;
     }
+
+    const Query lastQuery = d->m_lastParseFailed ? Query() : d->m_lastQuery;
+    d->m_lastQueryString = query;
+    d->m_lastFlags = flags;
+    d->m_lastParseFailed = !d->parseTokens( query, pos, flags, state, d->m_lastTokens );
+    d->m_lastQuery = d->m_lastParseFailed ? Query() : d->buildQuery( state );
+
+    if( firstChangedTerm && d->m_lastQuery != lastQuery ) {
+        const QList<Term> oldTerms = topLevelTerms( lastQuery );
+        const QList<Term> newTerms = topLevelTerms( d->m_lastQuery );
+        int i = 0;
+        while( i < oldTerms.count() && i < newTerms.count() && oldTerms[i] == newTerms[i] )
+            ++i;
+        // a change which only affects the folder restrictions is reported as a change of the first term
+        if( i == oldTerms.count() && i == newTerms.count() )
+            i = 0;
+        *firstChangedTerm = i;
+    }
+
+    return d->m_lastQuery;
+}
+
+
+void Nepomuk2::Query::QueryParser::resetIncrementalState()
+{
+    d->m_lastQueryString.clear();
+    d->m_lastFlags = NoParserFlags;
+    d->m_lastTokens.clear();
+    d->m_lastParseFailed = false;
+    d->m_lastQuery = Query();
 }
 
 
@@ -156,11 +156,47 @@ namespace Nepomuk2 {
              */
             Query parse( const QString& query, ParserFlags flags ) const;
 
+            /**
+             * Parse a user query incrementally.
+             *
+             * This method is intended for search interfaces which parse the query
+             * string on each key press. The parser keeps the state of the previous
+             * call and only parses the part of \p query which follows the last
+             * term that is not affected by the edit.
+             *
+             * \param query The query string to parse
+             * \param flags a set of flags influencing the parsing process. Changing
+             * the flags between two calls results in a full parse.
+             * \param firstChangedTerm If not 0 it is set to the index of the first
+             * top-level term of the parsed query which differs from the result of
+             * the previous call or to -1 if the parsed query did not change at all.
+             * A change which only affects the folders of a FileQuery is reported as
+             * a change of the first term.
+             *
+             * \return The parsed query or an invalid Query object
+             * in case the parsing failed.
+             *
+             * \sa resetIncrementalState()
+             *
+             * \since 4.13
+             */
+            Query parseIncremental( const QString& query, ParserFlags flags = NoParserFlags, int* firstChangedTerm = 0 );
+
+            /**
+             * Forget the state kept by parseIncremental(). The next call to
+             * parseIncremental() will parse the whole query string.
+             *
+             * \since 4.13
+             */
+            void resetIncrementalState();
+
             /**
              * Try to match a field name as used in a query string to actual
              * properties.
              *
-             * The matching is cached inside the Query instance for fast
+             * Field names are matched against the labels and names of all properties
+             * via an in-memory prefix index which is built once from the ontologies.
+             * In addition the matching is cached inside the parser for fast
              * subsequent lookups.
              *
              * Example:
@@ -62,6 +62,25 @@ namespace {
         return encodedRps;
     }
 
+    QStringList encodeFacetProperties( const QList<Nepomuk2::Types::Property>& facets )
+    {
+        QStringList encodedFacets;
+        foreach( const Nepomuk2::Types::Property& prop, facets ) {
+            encodedFacets << KUrl( prop.uri() ).url();
+        }
+        return encodedFacets;
+    }
+
+    Nepomuk2::Query::FacetCounts decodeFacetCounts( const FacetCountsDBus& counts )
+    {
+        Nepomuk2::Query::FacetCounts facetCounts;
+        for( FacetCountsDBus::const_iterator it = counts.constBegin();
+             it != counts.constEnd(); ++it ) {
+            facetCounts.insert( Nepomuk2::Types::Property( KUrl( it.key() ) ), it.value() );
+        }
+        return facetCounts;
+    }
+
     NepomukResultListEventLoop::NepomukResultListEventLoop(Nepomuk2::Query::QueryServiceClient* parent)
         : QEventLoop(parent)
     {
@@ -100,6 +119,7 @@ public:
     void _k_entriesRemoved( const QStringList& );
     void _k_finishedListing();
     void _k_handleQueryReply(QDBusPendingCallWatcher*);
+    void _k_handleFacetReply(QDBusPendingCallWatcher*);
     void _k_serviceRegistered( const QString& );
     void _k_serviceUnregistered( const QString& );
 
@@ -110,6 +130,7 @@ public:
     QueryServiceClient* q;
 
     QPointer<QDBusPendingCallWatcher> m_pendingCallWatcher;
+    QPointer<QDBusPendingCallWatcher> m_facetCallWatcher;
 
     QDBusConnection dbusConnection;
 
@@ -172,6 +193,22 @@ void Nepomuk2::Query::QueryServiceClient::Private::_k_handleQueryReply(QDBusPend
 }
 
 
+void Nepomuk2::Query::QueryServiceClient::Private::_k_handleFacetReply(QDBusPendingCallWatcher* watcher)
+{
+    QDBusPendingReply<FacetCountsDBus> reply = *watcher;
+    if(reply.isError()) {
+        kDebug() << reply.error();
+        m_errorMessage = reply.error().message();
+        emit q->error(m_errorMessage);
+    }
+    else {
+        emit q->facetCounts( decodeFacetCounts( reply.value() ) );
+    }
+
+    delete watcher;
+}
+
+
 void Nepomuk2::Query::QueryServiceClient::Private::_k_serviceRegistered(const QString &service)
 {
     if (service == "org.kde.nepomuk.services.nepomukqueryservice") {
@@ -401,6 +438,50 @@ QList< Nepomuk2::Query::Result > Nepomuk2::Query::QueryServiceClient::syncDeskto
 }
 
 
+bool Nepomuk2::Query::QueryServiceClient::facetQuery( const Query& query, const QList<Types::Property>& facets )
+{
+    // only the last request is of interest
+    delete d->m_facetCallWatcher;
+
+    if ( d->queryServiceInterface->isValid() ) {
+        d->m_facetCallWatcher = new QDBusPendingCallWatcher(d->queryServiceInterface->facets(query.isValid() ? query.toString() : QString(),
+                                                                                             encodeFacetProperties( facets )),
+                                                            this);
+        connect(d->m_facetCallWatcher, SIGNAL(finished(QDBusPendingCallWatcher*)),
+                this, SLOT(_k_handleFacetReply(QDBusPendingCallWatcher*)));
+        return true;
+    }
+    else {
+        kDebug() << "Could not contact nepomuk query service.";
+        return false;
+    }
+}
+
+
+Nepomuk2::Query::FacetCounts Nepomuk2::Query::QueryServiceClient::syncFacetQuery( const Query& query,
+                                                                                const QList<Types::Property>& facets,
+                                                                                bool* ok )
+{
+    QueryServiceClient qsc;
+    if( qsc.d->queryServiceInterface->isValid() ) {
+        QDBusPendingReply<FacetCountsDBus> reply = qsc.d->queryServiceInterface->facets( query.isValid() ? query.toString() : QString(),
+                                                                                       encodeFacetProperties( facets ) );
+        reply.waitForFinished();
+        if (ok) {
+            *ok = !reply.isError();
+        }
+        if( !reply.isError() ) {
+            return decodeFacetCounts( reply.value() );
+        }
+        kDebug() << reply.error();
+    }
+    else if (ok) {
+        *ok = false;
+    }
+    return FacetCounts();
+}
+
+
 void Nepomuk2::Query::QueryServiceClient::close()
 {
     // drop pending query calls
@@ -22,6 +22,7 @@
 #define _NEPOMUK2_QUERY_SERVICE_CLIENT_H_
 
 #include <QtCore/QObject>
+#include <QtCore/QHash>
 
 #include "property.h"
 #include "query.h"
@@ -35,6 +36,24 @@ namespace Nepomuk2 {
 
         class Result;
 
+        /**
+         * The number of results per value of a facet property. Resource values are
+         * identified by their URI, literal values by their lexical form. Date and
+         * date time values are grouped by month in the form \c "yyyy-MM".
+         *
+         * \sa QueryServiceClient::facetQuery()
+         *
+         * \since 4.13
+         */
+        typedef QHash<QString, int> FacetValueCounts;
+
+        /**
+         * The FacetValueCounts of each requested facet property.
+         *
+         * \since 4.13
+         */
+        typedef QHash<Types::Property, FacetValueCounts> FacetCounts;
+
         /**
          * \class QueryServiceClient queryserviceclient.h Nepomuk2/Query/QueryServiceClient
          *
@@ -133,6 +152,27 @@ namespace Nepomuk2 {
              */
             static QList<Nepomuk2::Query::Result> syncDesktopQuery( const QString& query, bool *ok = 0 );
 
+            /**
+             * Count the results of a query per value of facet properties.
+             *
+             * A local event loop will be started to block the method call until
+             * the counts have been calculated.
+             *
+             * \param query The query whose results should be counted. An invalid query
+             * counts all resources.
+             * \param facets The facet properties, for example \c nao:hasTag or \c nao:numericRating.
+             * \param ok a valid boolean pointer, which will be set to \p true
+             * if the counts could be retrieved, \p false otherwise.
+             * If you don't want to track errors, you can pass a null pointer instead.
+             *
+             * \sa facetQuery()
+             *
+             * \since 4.13
+             */
+            static Nepomuk2::Query::FacetCounts syncFacetQuery( const Query& query,
+                                                                const QList<Types::Property>& facets,
+                                                                bool *ok = 0 );
+
         public Q_SLOTS:
             /**
              * Start a query using the Nepomuk query service.
@@ -247,6 +287,28 @@ namespace Nepomuk2 {
              */
             bool blockingDesktopQuery( const QString& query );
 
+            /**
+             * Count the results of \p query per value of each of the \p facets.
+             *
+             * All counts are calculated in one grouped query. While a client has
+             * \p query open via query() the counts are cached by the query service
+             * and kept up to date with the changes to the results. Thus, repeated
+             * calls are cheap.
+             *
+             * The counts are reported via facetCounts(). Errors are reported via
+             * error().
+             *
+             * \param query The query whose results should be counted. An invalid query
+             * counts all resources.
+             * \param facets The facet properties, for example \c nao:hasTag or \c nao:numericRating.
+             *
+             * \return \p true if the query service was found and the counting
+             * was started. \p false otherwise.
+             *
+             * \since 4.13
+             */
+            bool facetQuery( const Query& query, const QList<Types::Property>& facets );
+
             /**
              * Close the client, thus stop to monitor the query
              * for changes. Without closing the client it will continue
@@ -327,6 +389,13 @@ namespace Nepomuk2 {
              */
             void serviceAvailabilityChanged( bool running );
 
+            /**
+             * Emitted once the counts requested via facetQuery() are available.
+             *
+             * \since 4.13
+             */
+            void facetCounts( const Nepomuk2::Query::FacetCounts& counts );
+
         private:
             class Private;
             Private* const d;
@@ -334,6 +403,7 @@ namespace Nepomuk2 {
             Q_PRIVATE_SLOT( d, void _k_entriesRemoved( const QStringList& ) )
             Q_PRIVATE_SLOT( d, void _k_finishedListing() )
             Q_PRIVATE_SLOT( d, void _k_handleQueryReply(QDBusPendingCallWatcher*) )
+            Q_PRIVATE_SLOT( d, void _k_handleFacetReply(QDBusPendingCallWatcher*) )
             Q_PRIVATE_SLOT( d, void _k_serviceRegistered( const QString& ) )
             Q_PRIVATE_SLOT( d, void _k_serviceUnregistered( const QString& ) )
         };
@@ -27,30 +27,85 @@
 
 #include <Soprano/Model>
 #include <Soprano/QueryResultIterator>
+#include <Soprano/BindingSet>
+
+namespace {
+    /// the number of results which are read ahead to prefetch their request properties
+    const int s_prefetchSize = 100;
+}
 
 namespace Nepomuk2 {
     namespace Query {
         class ResultIterator::Private {
         public:
+            struct Row {
+                Soprano::BindingSet bindings;
+                Resource resource;
+            };
+
+            void fillBuffer();
+
+            /// sets the request properties, which are also the ones prefetched
+            void setRequestMap( const RequestPropertyMap& map );
+
             RequestPropertyMap m_requestMap;
             Soprano::QueryResultIterator m_it;
+
+            /// the properties which are loaded for all results at once
+            QList<QUrl> m_prefetchProperties;
+
+            /// rows which have been read ahead, the first one is the current row
+            QList<Row> m_buffer;
         };
     }
 }
 
+void Nepomuk2::Query::ResultIterator::Private::fillBuffer()
+{
+    // Without request properties there is nothing to prefetch and no need to read ahead
+    const int count = m_prefetchProperties.isEmpty() ? 1 : s_prefetchSize;
+
+    QList<Resource> resources;
+    while( m_buffer.count() < count && m_it.next() ) {
+        Row row;
+        row.bindings = m_it.current();
+        row.resource = Resource::fromResourceUri( row.bindings[0].uri() );
+        m_buffer << row;
+        if( !row.resource.uri().isEmpty() )
+            resources << row.resource;
+    }
+
+    // Load the request properties of all results with one query rather than
+    // one query per result when the application accesses them
+    if( !m_prefetchProperties.isEmpty() && !resources.isEmpty() )
+        ResourceManager::instance()->prefetch( resources, m_prefetchProperties );
+}
+
+void Nepomuk2::Query::ResultIterator::Private::setRequestMap( const RequestPropertyMap& map )
+{
+    m_requestMap = map;
+
+    m_prefetchProperties.clear();
+    for( RequestPropertyMap::const_iterator it = map.constBegin(); it != map.constEnd(); ++it ) {
+        const QUrl property = it.value().uri();
+        if( !m_prefetchProperties.contains( property ) )
+            m_prefetchProperties << property;
+    }
+}
+
 Nepomuk2::Query::ResultIterator::ResultIterator(const Nepomuk2::Query::Query& query)
     : d( new Nepomuk2::Query::ResultIterator::Private() )
 {
     Soprano::Model* model = ResourceManager::instance()->mainModel();
 
-    d->m_requestMap = query.requestPropertyMap();
+    d->setRequestMap( query.requestPropertyMap() );
     d->m_it = model->executeQuery( query.toSparqlQuery(), Soprano::Query::QueryLanguageSparql );
 }
 
 Nepomuk2::Query::ResultIterator::ResultIterator(const QString& sparql, const Nepomuk2::Query::RequestPropertyMap& map)
     : d( new Nepomuk2::Query::ResultIterator::Private() )
 {
-    d->m_requestMap = map;
+    d->setRequestMap( map );
 
     if( !sparql.isEmpty() ) {
         Soprano::Model* model = ResourceManager::instance()->mainModel();
@@ -66,15 +121,20 @@ Nepomuk2::Query::ResultIterator::~ResultIterator()
 
 Nepomuk2::Query::Result Nepomuk2::Query::ResultIterator::current() const
 {
-    Result result( Resource::fromResourceUri( d->m_it[0].uri() ) );
+    if( d->m_buffer.isEmpty() )
+        return Result();
+
+    const Private::Row& row = d->m_buffer.first();
+    const Soprano::BindingSet& bindings = row.bindings;
+    Result result( row.resource );
 
     // make sure we do not store values twice
-    QStringList names = d->m_it.bindingNames();
+    QStringList names = bindings.bindingNames();
     names.removeAll( QLatin1String( "r" ) );
 
     RequestPropertyMap::const_iterator rpIt = d->m_requestMap.constBegin();
     for (  ; rpIt != d->m_requestMap.constEnd(); ++rpIt ) {
-        result.addRequestProperty( rpIt.value(), d->m_it.binding( rpIt.key() ) );
+        result.addRequestProperty( rpIt.value(), bindings[rpIt.key()] );
     }
 
     static const char* s_scoreVarName = "_n_f_t_m_s_";
@@ -84,11 +144,11 @@ Nepomuk2::Query::Result Nepomuk2::Query::ResultIterator::current() const
     int score = 0;
     Q_FOREACH( const QString& var, names ) {
         if ( var == QLatin1String( s_scoreVarName ) )
-            score = d->m_it[var].literal().toInt();
+            score = bindings[var].literal().toInt();
         else if ( var == QLatin1String( s_excerptVarName ) )
-            result.setExcerpt( d->m_it[var].toString() );
+            result.setExcerpt( bindings[var].toString() );
         else
-            set.insert( var, d->m_it[var] );
+            set.insert( var, bindings[var] );
     }
 
     result.setAdditionalBindings( set );
@@ -99,7 +159,11 @@ Nepomuk2::Query::Result Nepomuk2::Query::ResultIterator::current() const
 
 bool Nepomuk2::Query::ResultIterator::next()
 {
-    return d->m_it.next();
+    if( !d->m_buffer.isEmpty() )
+        d->m_buffer.removeFirst();
+    if( d->m_buffer.isEmpty() )
+        d->fillBuffer();
+    return !d->m_buffer.isEmpty();
 }
 
 bool Nepomuk2::Query::ResultIterator::isValid() const
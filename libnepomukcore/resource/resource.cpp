@@ -53,10 +53,7 @@ Nepomuk2::Resource::Resource()
 {
     ResourceManager* rm = ResourceManager::instance();
     if( rm ) {
-        QMutexLocker lock( &rm->d->mutex );
         m_data = rm->d->data( QUrl(), QUrl() );
-        if ( m_data )
-            m_data->ref( this );
     }
     else {
         kError() << "QCoreApplication does not exist. Resource cannot be initalialized";
@@ -68,10 +65,11 @@ Nepomuk2::Resource::Resource( const Nepomuk2::Resource& res )
 {
     ResourceManager* rm = ResourceManager::instance();
     if( rm ) {
-        QMutexLocker lock( &rm->d->mutex );
+        // No need to look up anything or to lock. res keeps its data for its whole
+        // life, determineUri() only ever sets a proxy on it.
         m_data = res.m_data;
         if ( m_data )
-            m_data->ref( this );
+            m_data->ref();
     }
     else {
         kError() << "QCoreApplication does not exist. Resource cannot be initalialized";
@@ -83,10 +81,7 @@ Nepomuk2::Resource::Resource( const QString& uri, const QUrl& type )
 {
     ResourceManager* rm = ResourceManager::instance();
     if( rm ) {
-        QMutexLocker lock( &rm->d->mutex );
         m_data = rm->d->data( uri, type );
-        if ( m_data )
-            m_data->ref( this );
     }
     else {
         kError() << "QCoreApplication does not exist. Resource cannot be initalialized";
@@ -98,10 +93,7 @@ Nepomuk2::Resource::Resource( const QUrl& uri, const QUrl& type )
 {
     ResourceManager* rm = ResourceManager::instance();
     if( rm ) {
-        QMutexLocker lock( &rm->d->mutex );
         m_data = rm->d->data( uri, type );
-        if ( m_data )
-            m_data->ref( this );
     }
     else {
         kError() << "QCoreApplication does not exist. Resource cannot be initalialized";
@@ -114,10 +106,9 @@ Nepomuk2::Resource::Resource( Nepomuk2::ResourceData* data )
 {
     ResourceManager* rm = ResourceManager::instance();
     if( rm ) {
-        QMutexLocker lock( &rm->d->mutex );
         m_data = data;
         if ( m_data )
-            m_data->ref( this );
+            m_data->ref();
     }
 }
 
@@ -129,10 +120,7 @@ Nepomuk2::Resource::~Resource()
         if ( rm ) {
             // It is possible that this resource is hanging around
             // after the ResourceManager has been deleted
-            QMutexLocker lock( &rm->d->mutex );
-            m_data->deref( this );
-            if ( m_data->rm()->shouldBeDeleted( m_data ) )
-                delete m_data;
+            rm->d->release( m_data );
         }
     }
 }
@@ -143,13 +131,12 @@ Nepomuk2::Resource& Nepomuk2::Resource::operator=( const Resource& res )
     if( m_data != res.m_data ) {
         ResourceManager* rm = ResourceManager::instance();
         if ( rm ) {
-            QMutexLocker lock( &rm->d->mutex );
-            if ( m_data && !m_data->deref( this ) && m_data->rm()->shouldBeDeleted( m_data ) ) {
-                delete m_data;
-            }
+            ResourceData* oldData = m_data;
             m_data = res.m_data;
             if ( m_data )
-                m_data->ref( this );
+                m_data->ref();
+            if ( oldData )
+                rm->d->release( oldData );
         }
     }
 
@@ -167,7 +154,7 @@ QUrl Nepomuk2::Resource::uri() const
 {
     if ( m_data ) {
         determineFinalResourceData();
-        return m_data->uri();
+        return data()->uri();
     }
     else {
         return QUrl();
@@ -179,7 +166,7 @@ QUrl Nepomuk2::Resource::type() const
 {
     determineFinalResourceData();
     if ( m_data ) {
-        return m_data->type();
+        return data()->type();
     }
     else {
         return QUrl();
@@ -191,7 +178,7 @@ QList<QUrl> Nepomuk2::Resource::types() const
 {
     determineFinalResourceData();
     if ( m_data ) {
-        return m_data->property( RDF::type() ).toUrlList();
+        return data()->property( RDF::type() ).toUrlList();
     }
     return QList<QUrl>();
 }
@@ -201,7 +188,7 @@ void Nepomuk2::Resource::setTypes( const QList<QUrl>& types )
 {
     determineFinalResourceData();
     if ( m_data ) {
-        m_data->setProperty( RDF::type(), types );
+        data()->setProperty( RDF::type(), types );
     }
 }
 
@@ -210,7 +197,7 @@ void Nepomuk2::Resource::addType( const QUrl& type )
 {
     determineFinalResourceData();
     if ( m_data ) {
-        m_data->addProperty( RDF::type(), type );
+        data()->addProperty( RDF::type(), type );
     }
 }
 
@@ -219,7 +206,7 @@ bool Nepomuk2::Resource::hasType( const QUrl& typeUri ) const
 {
     determineFinalResourceData();
     if ( m_data ) {
-        return m_data->hasProperty( RDF::type(), typeUri );
+        return data()->hasProperty( RDF::type(), typeUri );
     }
     else {
         return false;
@@ -231,7 +218,7 @@ QHash<QUrl, Nepomuk2::Variant> Nepomuk2::Resource::properties() const
 {
     determineFinalResourceData();
     if ( m_data ) {
-        return m_data->allProperties();
+        return data()->allProperties();
     }
     return QHash<QUrl, Nepomuk2::Variant> ();
 }
@@ -241,7 +228,7 @@ bool Nepomuk2::Resource::hasProperty( const QUrl& uri ) const
 {
     determineFinalResourceData();
     if ( m_data ) {
-        return m_data->hasProperty( uri );
+        return data()->hasProperty( uri );
     }
     else {
         return false;
@@ -253,7 +240,7 @@ bool Nepomuk2::Resource::hasProperty( const Types::Property& p, const Variant& v
 {
     determineFinalResourceData();
     if ( m_data ) {
-        return m_data->hasProperty( p.uri(), v );
+        return data()->hasProperty( p.uri(), v );
     }
     else {
         return false;
@@ -265,7 +252,7 @@ Nepomuk2::Variant Nepomuk2::Resource::property( const QUrl& uri ) const
 {
     determineFinalResourceData();
     if ( m_data ) {
-        return m_data->property( uri );
+        return data()->property( uri );
     }
     else {
         return Nepomuk2::Variant();
@@ -277,7 +264,7 @@ void Nepomuk2::Resource::addProperty( const QUrl& uri, const Variant& value )
 {
     determineFinalResourceData();
     if ( m_data ) {
-        m_data->addProperty( uri, value );
+        data()->addProperty( uri, value );
     }
 }
 
@@ -286,7 +273,7 @@ void Nepomuk2::Resource::setProperty( const QUrl& uri, const Nepomuk2::Variant&
 {
     determineFinalResourceData();
     if ( m_data ) {
-        m_data->setProperty( uri, value );
+        data()->setProperty( uri, value );
     }
 }
 
@@ -295,7 +282,7 @@ void Nepomuk2::Resource::removeProperty( const QUrl& uri )
 {
     determineFinalResourceData();
     if ( m_data ) {
-        m_data->removeProperty( uri );
+        data()->removeProperty( uri );
     }
 }
 
@@ -314,7 +301,7 @@ void Nepomuk2::Resource::remove()
 {
     determineFinalResourceData();
     if ( m_data ) {
-        m_data->remove();
+        data()->remove();
     }
 }
 
@@ -323,7 +310,7 @@ bool Nepomuk2::Resource::exists() const
 {
     determineFinalResourceData();
     if ( m_data ) {
-        return m_data->exists();
+        return data()->exists();
     }
     else {
         return false;
@@ -333,7 +320,7 @@ bool Nepomuk2::Resource::exists() const
 
 bool Nepomuk2::Resource::isValid() const
 {
-    return m_data ? m_data->isValid() : false;
+    return m_data ? data()->isValid() : false;
 }
 
 
@@ -473,8 +460,8 @@ bool Nepomuk2::Resource::operator==( const Resource& other ) const
     determineFinalResourceData();
     other.determineFinalResourceData();
 
-    if( m_data->uri().isEmpty() )
-        return *m_data == *other.m_data;
+    if( data()->uri().isEmpty() )
+        return *data() == *other.data();
     else
         return uri() == other.uri();
 }
@@ -708,8 +695,8 @@ bool Nepomuk2::Resource::isFile() const
 {
     if( m_data ) {
         determineFinalResourceData();
-        m_data->load();
-        return m_data->isFile();
+        data()->load();
+        return data()->isFile();
     }
     else {
         return false;
@@ -726,14 +713,14 @@ void Nepomuk2::Resource::setWatchEnabled(bool status)
 {
     determineFinalResourceData();
     if( m_data )
-        return m_data->setWatchEnabled( status );
+        return data()->setWatchEnabled( status );
 }
 
 bool Nepomuk2::Resource::watchEnabled()
 {
     determineFinalResourceData();
     if( m_data )
-        return m_data->watchEnabled();
+        return data()->watchEnabled();
 
     return false;
 }
@@ -743,8 +730,10 @@ bool Nepomuk2::Resource::watchEnabled()
 Nepomuk2::Resource Nepomuk2::Resource::fromResourceUri( const KUrl& uri, const Nepomuk2::Types::Class& type )
 {
     ResourceManager* manager = ResourceManager::instance();
-    QMutexLocker lock( &manager->d->mutex );
-    return Resource( manager->d->dataForResourceUri( uri, type.uri() ) );
+    ResourceData* data = manager->d->dataForResourceUri( uri, type.uri() );
+    Resource res( data );
+    manager->d->release( data );
+    return res;
 }
 
 
@@ -754,13 +743,21 @@ void Nepomuk2::Resource::determineFinalResourceData() const
         return;
     }
 
-    // Get an initialized ResourceData instance
-    ResourceData* oldData = m_data;
+    // this might give m_data a proxy which data() follows from then on
+    m_data->determineUri();
+}
 
-    m_data->determineUri(); // note that this can change the value of m_data
 
-    if ( !oldData->cnt() )
-        delete oldData;
+Nepomuk2::ResourceData* Nepomuk2::Resource::data() const
+{
+    ResourceData* data = m_data;
+    while ( data ) {
+        ResourceData* proxy = data->proxyData();
+        if ( !proxy )
+            break;
+        data = proxy;
+    }
+    return data;
 }
 
 
@@ -34,6 +34,7 @@ namespace Nepomuk2 {
 
     class ResourceData;
     class ResourceManager;
+    class ResourceJob;
     class Variant;
     class Tag;
     class File;
@@ -530,13 +531,19 @@ namespace Nepomuk2 {
 
     private:
         /**
-         * Determines the final ResourceData and updates m_data if
-         * necessary. This will call ResourceData::determineUri()
-         * and optionally merge with already loaded ResourceData
-         * instances representing the same resource.
+         * Determines the final ResourceData. This will call
+         * ResourceData::determineUri() which sets a proxy on m_data
+         * if another ResourceData already represents the same resource.
          */
         void determineFinalResourceData() const;
 
+        /**
+         * The ResourceData holding the values, m_data or the proxy it got
+         * from determineUri(). m_data itself never changes, that way copies
+         * only need its reference count.
+         */
+        ResourceData* data() const;
+
         ResourceData* m_data;
 
         class Private;
@@ -544,6 +551,7 @@ namespace Nepomuk2 {
 
         friend class ResourceData;
         friend class ResourceManager;
+        friend class ResourceJob;
     };
 
     NEPOMUK_EXPORT uint qHash( const Resource& res );
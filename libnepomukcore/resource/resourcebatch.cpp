@@ -0,0 +1,318 @@
+/*
+    This file is part of the Nepomuk KDE project.
+    Copyright (C) 2013  Nepomuk Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "resourcebatch.h"
+#include "resourcebatch_p.h"
+#include "resourcedata.h"
+#include "datamanagement.h"
+#include "datamanagementinterface.h"
+#include "genericdatamanagementjob_p.h"
+#include "simpleresource.h"
+#include "dbustypes.h"
+
+#include <QtCore/QThreadStorage>
+#include <QtDBus/QDBusPendingReply>
+
+#include <KGlobal>
+#include <KComponentData>
+#include <KDebug>
+
+using namespace Nepomuk2;
+
+namespace {
+    class BatchStack {
+    public:
+        QList<ResourceBatchPrivate*> batches;
+    };
+
+    QThreadStorage<BatchStack*> s_batches;
+
+    QString storeResources( const QList<SimpleResource>& resources, int flags )
+    {
+        QDBusPendingReply<> reply = dataManagementDBusInterface()->storeResources( resources,
+                                                                                 IdentifyNew,
+                                                                                 flags,
+                                                                                 PropertyHash(),
+                                                                                 KGlobal::mainComponent().componentName() );
+        reply.waitForFinished();
+        return reply.isError() ? reply.error().message() : QString();
+    }
+
+    QString removeProperties( const QList<QUrl>& resources, const QUrl& property )
+    {
+        QDBusPendingReply<> reply = dataManagementDBusInterface()->removeProperties( DBus::convertUriList( resources ),
+                                                                                   QStringList() << DBus::convertUri( property ),
+                                                                                   KGlobal::mainComponent().componentName() );
+        reply.waitForFinished();
+        return reply.isError() ? reply.error().message() : QString();
+    }
+}
+
+
+ResourceBatchPrivate::ResourceBatchPrivate()
+    : m_active( false ),
+      m_done( false )
+{
+}
+
+
+// static
+ResourceBatchPrivate* ResourceBatchPrivate::current()
+{
+    if( !s_batches.hasLocalData() || s_batches.localData()->batches.isEmpty() )
+        return 0;
+    return s_batches.localData()->batches.last();
+}
+
+
+void ResourceBatchPrivate::activate()
+{
+    if( !s_batches.hasLocalData() )
+        s_batches.setLocalData( new BatchStack() );
+    s_batches.localData()->batches.append( this );
+    m_active = true;
+}
+
+
+void ResourceBatchPrivate::deactivate()
+{
+    // The batch can only be activated in the thread which created it which is
+    // also the one committing it.
+    if( m_active && s_batches.hasLocalData() )
+        s_batches.localData()->batches.removeAll( this );
+    m_active = false;
+}
+
+
+void ResourceBatchPrivate::pin( ResourceData* rd )
+{
+    const QUrl uri = rd->uri();
+    if( m_entries.contains( uri ) )
+        return;
+
+    Entry entry;
+    entry.data = rd;
+    rd->ref();
+    rd->pin();
+    m_entries.insert( uri, entry );
+}
+
+
+void ResourceBatchPrivate::record( ResourceData* rd, const QUrl& uri, const QUrl& property,
+                                   Operation operation, const QVariantList& values, const Variant& cachedValue )
+{
+    QHash<QUrl, Entry>::iterator it = m_entries.find( uri );
+    if( it == m_entries.end() ) {
+        Entry entry;
+        entry.data = rd;
+        rd->ref();
+        rd->pin();
+        it = m_entries.insert( uri, entry );
+    }
+
+    QHash<QUrl, Change>::iterator changeIt = it->changes.find( property );
+    if( changeIt == it->changes.end() ) {
+        Change change;
+        change.operation = operation;
+        change.values = values;
+        change.oldValue = cachedValue;
+        it->changes.insert( property, change );
+    }
+    else if( operation == Replace ) {
+        changeIt->operation = Replace;
+        changeIt->values = values;
+    }
+    else {
+        // Adding to replaced values still replaces, just with more values
+        changeIt->values += values;
+    }
+}
+
+
+// static
+void ResourceBatchPrivate::restore( ResourceData* rd, const QHash<QUrl, Change>& changes )
+{
+    QHash<QUrl, Change>::const_iterator end = changes.constEnd();
+    for( QHash<QUrl, Change>::const_iterator it = changes.constBegin(); it != end; ++it ) {
+        rd->updateCachedProperty( it.key(), it->oldValue, false );
+    }
+}
+
+
+void ResourceBatchPrivate::clear()
+{
+    foreach( const Entry& entry, m_entries ) {
+        entry.data->unpin();
+        if( !entry.data->deref() )
+            delete entry.data;
+    }
+    m_entries.clear();
+}
+
+
+void ResourceBatchPrivate::failed( const QUrl& uri, const QList<QUrl>& properties, const QString& error )
+{
+    kWarning() << uri << error;
+
+    const Entry& entry = m_entries[uri];
+    QHash<QUrl, Change> changes;
+    foreach( const QUrl& property, properties ) {
+        changes.insert( property, entry.changes[property] );
+    }
+    restore( entry.data, changes );
+
+    QString& message = m_errors[uri];
+    if( !message.isEmpty() )
+        message += QLatin1Char('\n');
+    message += error;
+}
+
+
+void ResourceBatchPrivate::flushStore( const QList<SimpleResource>& resources, int flags )
+{
+    if( resources.isEmpty() )
+        return;
+
+    const QString error = storeResources( resources, flags );
+    if( error.isEmpty() )
+        return;
+
+    // storeResources() is all or nothing. Write the resources one by one to find
+    // out which of them were responsible.
+    foreach( const SimpleResource& res, resources ) {
+        const QString resError = resources.count() == 1 ? error : storeResources( QList<SimpleResource>() << res, flags );
+        if( !resError.isEmpty() )
+            failed( res.uri(), res.properties().uniqueKeys(), resError );
+    }
+}
+
+
+void ResourceBatchPrivate::flushRemove( const QList<QUrl>& resources, const QUrl& property )
+{
+    const QString error = removeProperties( resources, property );
+    if( error.isEmpty() )
+        return;
+
+    foreach( const QUrl& uri, resources ) {
+        const QString resError = resources.count() == 1 ? error : removeProperties( QList<QUrl>() << uri, property );
+        if( !resError.isEmpty() )
+            failed( uri, QList<QUrl>() << property, resError );
+    }
+}
+
+
+ResourceBatch::ResourceBatch()
+    : d( new ResourceBatchPrivate() )
+{
+    d->activate();
+}
+
+
+ResourceBatch::~ResourceBatch()
+{
+    if( !d->m_done )
+        commit();
+    delete d;
+}
+
+
+bool ResourceBatch::commit()
+{
+    if( d->m_done )
+        return d->m_errors.isEmpty();
+
+    d->deactivate();
+    d->m_done = true;
+    d->m_errors.clear();
+
+    // Group the changes by the call which writes them: one storeResources call
+    // replacing values, one adding values and one removeProperties call per property.
+    QList<SimpleResource> replaced;
+    QList<SimpleResource> added;
+    QHash<QUrl, QList<QUrl> > removed;
+
+    QHash<QUrl, ResourceBatchPrivate::Entry>::const_iterator end = d->m_entries.constEnd();
+    for( QHash<QUrl, ResourceBatchPrivate::Entry>::const_iterator it = d->m_entries.constBegin(); it != end; ++it ) {
+        SimpleResource replacedRes( it.key() );
+        SimpleResource addedRes( it.key() );
+
+        QHash<QUrl, ResourceBatchPrivate::Change>::const_iterator changeEnd = it->changes.constEnd();
+        for( QHash<QUrl, ResourceBatchPrivate::Change>::const_iterator changeIt = it->changes.constBegin();
+             changeIt != changeEnd; ++changeIt ) {
+            const QUrl& property = changeIt.key();
+            if( changeIt->operation == ResourceBatchPrivate::Add ) {
+                foreach( const QVariant& value, changeIt->values )
+                    addedRes.addProperty( property, value );
+            }
+            else if( changeIt->values.isEmpty() ) {
+                removed[property] << it.key();
+            }
+            else {
+                foreach( const QVariant& value, changeIt->values )
+                    replacedRes.addProperty( property, value );
+            }
+        }
+
+        if( !replacedRes.properties().isEmpty() )
+            replaced << replacedRes;
+        if( !addedRes.properties().isEmpty() )
+            added << addedRes;
+    }
+
+    d->flushStore( replaced, OverwriteAllProperties );
+    d->flushStore( added, NoStoreResourcesFlags );
+    QHash<QUrl, QList<QUrl> >::const_iterator removedEnd = removed.constEnd();
+    for( QHash<QUrl, QList<QUrl> >::const_iterator it = removed.constBegin(); it != removedEnd; ++it ) {
+        d->flushRemove( it.value(), it.key() );
+    }
+
+    d->clear();
+    return d->m_errors.isEmpty();
+}
+
+
+void ResourceBatch::rollback()
+{
+    if( d->m_done )
+        return;
+
+    d->deactivate();
+    d->m_done = true;
+
+    foreach( const ResourceBatchPrivate::Entry& entry, d->m_entries ) {
+        ResourceBatchPrivate::restore( entry.data, entry.changes );
+    }
+    d->clear();
+}
+
+
+int ResourceBatch::pendingChanges() const
+{
+    int count = 0;
+    foreach( const ResourceBatchPrivate::Entry& entry, d->m_entries ) {
+        count += entry.changes.count();
+    }
+    return count;
+}
+
+
+QHash<QUrl, QString> ResourceBatch::errors() const
+{
+    return d->m_errors;
+}
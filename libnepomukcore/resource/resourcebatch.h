@@ -0,0 +1,110 @@
+/*
+    This file is part of the Nepomuk KDE project.
+    Copyright (C) 2013  Nepomuk Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef NEPOMUK2_RESOURCEBATCH_H
+#define NEPOMUK2_RESOURCEBATCH_H
+
+#include <QtCore/QHash>
+#include <QtCore/QUrl>
+#include <QtCore/QString>
+
+#include "nepomuk_export.h"
+
+namespace Nepomuk2 {
+
+class ResourceBatchPrivate;
+
+/**
+ * \class ResourceBatch resourcebatch.h Nepomuk2/ResourceBatch
+ *
+ * \brief Collects property changes and writes them in one go.
+ *
+ * Normally each call to Resource::setProperty(), Resource::addProperty() or
+ * Resource::removeProperty() results in one blocking call to the storage service.
+ * While a ResourceBatch exists in the current thread these changes are only
+ * reflected in the cache of the Resource objects. They are written once the batch
+ * is committed using a few bulk calls instead of one call per change.
+ *
+ * \code
+ * Nepomuk2::ResourceBatch batch;
+ * foreach( Nepomuk2::Resource res, resources ) {
+ *     res.setRating( 5 );
+ *     res.addTag( tag );
+ * }
+ * if( !batch.commit() )
+ *     kDebug() << batch.errors();
+ * \endcode
+ *
+ * Resources which do not exist yet are still created right away, only the changes
+ * of their properties are delayed. Changes made in other threads are not affected.
+ *
+ * Batches can be nested in which case the innermost one collects the changes.
+ *
+ * \since 4.13
+ */
+class NEPOMUK_EXPORT ResourceBatch
+{
+public:
+    /**
+     * Creates a new batch and makes it the active one in the current thread.
+     */
+    ResourceBatch();
+
+    /**
+     * Commits the batch unless commit() or rollback() has been called before.
+     */
+    ~ResourceBatch();
+
+    /**
+     * Writes all collected changes to the storage. Afterwards the batch is
+     * no longer active.
+     *
+     * If writing the changes of a resource fails they are removed from the
+     * cache again and the error is available via errors(). The changes of the
+     * other resources are not affected.
+     *
+     * \return \p true if all changes were written successfully.
+     */
+    bool commit();
+
+    /**
+     * Discards all collected changes and restores the cached values they
+     * replaced. Afterwards the batch is no longer active.
+     */
+    void rollback();
+
+    /**
+     * \return The number of property changes waiting to be written.
+     */
+    int pendingChanges() const;
+
+    /**
+     * \return The error messages of the last commit() keyed by the URI of the
+     * resource they occurred on.
+     */
+    QHash<QUrl, QString> errors() const;
+
+private:
+    Q_DISABLE_COPY( ResourceBatch )
+
+    ResourceBatchPrivate* const d;
+};
+}
+
+#endif
@@ -0,0 +1,123 @@
+/*
+    This file is part of the Nepomuk KDE project.
+    Copyright (C) 2013  Nepomuk Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef NEPOMUK2_RESOURCEBATCH_P_H
+#define NEPOMUK2_RESOURCEBATCH_P_H
+
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QUrl>
+#include <QtCore/QVariant>
+#include <QtCore/QString>
+
+#include "variant.h"
+
+namespace Nepomuk2 {
+
+class ResourceData;
+class SimpleResource;
+
+class ResourceBatchPrivate
+{
+public:
+    enum Operation {
+        /// replace all values, an empty value list removes the property
+        Replace,
+        /// append to the existing values
+        Add
+    };
+
+    struct Change {
+        Change()
+            : operation( Replace ) {
+        }
+
+        Operation operation;
+        QVariantList values;
+
+        /// the cached value before the batch touched the property
+        Variant oldValue;
+    };
+
+    struct Entry {
+        Entry()
+            : data( 0 ) {
+        }
+
+        /// pinned until the batch is done to keep the cache alive for the rollback
+        ResourceData* data;
+        QHash<QUrl, Change> changes;
+    };
+
+    ResourceBatchPrivate();
+
+    /**
+     * \return The active batch of the current thread or 0 if there is none.
+     */
+    static ResourceBatchPrivate* current();
+
+    void activate();
+    void deactivate();
+
+    /**
+     * Adds an entry for \p rd, which pins its cache until the batch is done.
+     * Called by ResourceData before it loads the cache for a change.
+     */
+    void pin( ResourceData* rd );
+
+    /**
+     * Called by ResourceData instead of writing a change to the storage.
+     * Needs to be called before the cache is updated since the current cache
+     * value is remembered for the rollback.
+     *
+     * \param values The new values with resources already converted to their URIs.
+     */
+    void record( ResourceData* rd, const QUrl& uri, const QUrl& property,
+                 Operation operation, const QVariantList& values, const Variant& cachedValue );
+
+    /**
+     * Restores the cached values of \p changes in \p rd.
+     */
+    static void restore( ResourceData* rd, const QHash<QUrl, Change>& changes );
+
+    /**
+     * Drops the references and pins of all entries.
+     */
+    void clear();
+
+    /**
+     * Write \p resources with one storeResources call. If that fails the resources
+     * are written one by one to find the ones which caused the error.
+     */
+    void flushStore( const QList<SimpleResource>& resources, int flags );
+    void flushRemove( const QList<QUrl>& resources, const QUrl& property );
+
+    /**
+     * Records \p error for \p uri and restores the cached values of \p properties.
+     */
+    void failed( const QUrl& uri, const QList<QUrl>& properties, const QString& error );
+
+    QHash<QUrl, Entry> m_entries;
+    QHash<QUrl, QString> m_errors;
+    bool m_active;
+    bool m_done;
+};
+}
+
+#endif
@@ -22,6 +22,7 @@
 #include "resourcedata.h"
 #include "resourcemanager.h"
 #include "resourcemanager_p.h"
+#include "resourcebatch_p.h"
 #include "resource.h"
 #include "tools.h"
 #include "nie.h"
@@ -46,6 +47,7 @@
 #include <QtCore/QDateTime>
 #include <QtCore/QMutexLocker>
 #include <QtCore/QFileInfo>
+#include <QtCore/QStringList>
 
 #include <kdebug.h>
 #include <kurl.h>
@@ -61,29 +63,41 @@ using namespace Soprano;
 using namespace Soprano::Vocabulary;
 using namespace Nepomuk2::Vocabulary;
 
+namespace {
+    /// A SPARQL filter which restricts ?p to \p properties or, if \p exclude is true, excludes them
+    QString propertyFilter( const QList<QUrl>& properties, bool exclude ) {
+        if( properties.isEmpty() )
+            return QString();
+
+        QStringList n3;
+        foreach( const QUrl& p, properties )
+            n3 << Soprano::Node::resourceToN3( p );
+        return QString::fromLatin1("FILTER(?p %1 (%2)) . ")
+               .arg( exclude ? QLatin1String("not in") : QLatin1String("in"),
+                     n3.join(QLatin1String(",")) );
+    }
+}
+
 Nepomuk2::ResourceData::ResourceData( const QUrl& uri, const QUrl& kickOffUri, const QUrl& type, ResourceManagerPrivate* rm )
     : m_uri(uri),
       m_type(type.isEmpty() ? RDFS::Resource() : type),
       m_dataMutex(QMutex::Recursive),
+      m_cacheSize(0),
       m_cacheDirty(false),
+      m_evicted(false),
       m_addedToWatcher(false),
       m_watchEnabled(false),
       m_rm(rm)
 {
+    // ResourceManagerPrivate adds us to its caches once we are referenced
     if( !uri.isEmpty() ) {
         m_cacheDirty = true;
-
-        QMutexLocker locker(&m_rm->mutex);
-        m_rm->m_initializedData.insert( uri, this );
     }
 
     if( !kickOffUri.isEmpty() ) {
         if( kickOffUri.scheme().isEmpty() ) {
             m_naoIdentifier = kickOffUri.toString();
             m_cache.insert( NAO::identifier(), m_naoIdentifier );
-
-            QMutexLocker locker(&m_rm->mutex);
-            m_rm->m_identifierKickOff.insert(m_naoIdentifier, this);
         }
         else {
             m_nieUrl = kickOffUri;
@@ -94,9 +108,6 @@ Nepomuk2::ResourceData::ResourceData( const QUrl& uri, const QUrl& kickOffUri, c
                     m_nieUrl = KUrl::fromLocalFile( fileInfo.canonicalFilePath() );
             }
             m_cache.insert( NIE::url(), m_nieUrl );
-
-            QMutexLocker locker(&m_rm->mutex);
-            m_rm->m_urlKickOff.insert(m_nieUrl, this);
         }
     }
 }
@@ -105,6 +116,9 @@ Nepomuk2::ResourceData::ResourceData( const QUrl& uri, const QUrl& kickOffUri, c
 Nepomuk2::ResourceData::~ResourceData()
 {
     resetAll();
+
+    if( ResourceData* proxy = m_proxyData )
+        m_rm->release( proxy );
 }
 
 
@@ -163,7 +177,7 @@ QUrl Nepomuk2::ResourceData::type()
 
 void Nepomuk2::ResourceData::resetAll()
 {
-    QMutexLocker rmMutexLocker(&m_rm->mutex);
+    QMutexLocker rmMutexLocker(&m_rm->mutex); // for the watcher. Must be locked first
     QMutexLocker locker(&m_dataMutex);
     // remove us from all caches (store() will re-insert us later if necessary)
 
@@ -173,12 +187,12 @@ void Nepomuk2::ResourceData::resetAll()
     // resource which is correctly identified to the ResourceData (this), and it is
     // then deleted, which calls resetAll and this cycle continues.
     const QString nao = m_cache.value(NAO::identifier()).toString();
-    m_rm->m_identifierKickOff.remove( nao );
+    m_rm->m_identifierKickOff.remove( nao, this );
     const QUrl nieUrl = m_cache.value(NIE::url()).toUrl();
-    m_rm->m_urlKickOff.remove( nieUrl );
+    m_rm->m_urlKickOff.remove( nieUrl, this );
 
     if( !m_uri.isEmpty() ) {
-        m_rm->m_initializedData.remove( m_uri );
+        m_rm->m_initializedData.remove( m_uri, this );
         removeFromWatcher();
     }
 
@@ -187,8 +201,12 @@ void Nepomuk2::ResourceData::resetAll()
     m_nieUrl.clear();
     m_naoIdentifier.clear();
     m_cache.clear();
+    m_loadedProperties.clear();
+    m_excludedProperties.clear();
     m_cacheDirty = false;
+    m_evicted = false;
     m_type = RDFS::Resource();
+    updateCacheSize();
 }
 
 
@@ -196,19 +214,32 @@ QHash<QUrl, Nepomuk2::Variant> Nepomuk2::ResourceData::allProperties()
 {
     if( !load() )
         return QHash<QUrl, Nepomuk2::Variant>();
-    else {
+
+    // The heavy properties are not part of the normal load
+    QList<QUrl> missing;
+    {
         QMutexLocker lock(&m_dataMutex);
-        return m_cache;
+        foreach( const QUrl& p, m_excludedProperties ) {
+            if( !m_loadedProperties.contains( p ) )
+                missing << p;
+        }
     }
+    if( !missing.isEmpty() )
+        loadMultiple( m_rm, QList<ResourceData*>() << this, missing );
+
+    QMutexLocker lock(&m_dataMutex);
+    m_recentlyUsed = 1;
+    return m_cache;
 }
 
 
 bool Nepomuk2::ResourceData::hasProperty( const QUrl& uri )
 {
-    if( !load() )
+    if( !ensureLoaded( uri ) )
         return false;
 
     QMutexLocker lock(&m_dataMutex);
+    m_recentlyUsed = 1;
     QHash<QUrl, Variant>::const_iterator it = m_cache.constFind( uri );
     if( it == m_cache.constEnd() )
         return false;
@@ -219,14 +250,19 @@ bool Nepomuk2::ResourceData::hasProperty( const QUrl& uri )
 
 bool Nepomuk2::ResourceData::hasProperty( const QUrl& p, const Variant& v )
 {
-    if( !load() )
+    if( !ensureLoaded( p ) )
         return false;
 
     QMutexLocker lock(&m_dataMutex);
+    m_recentlyUsed = 1;
     QHash<QUrl, Variant>::const_iterator it = m_cache.constFind( p );
     if( it == m_cache.constEnd() )
         return false;
 
+    // the common case of comparing single values does not need any lists
+    if( !v.isList() && !it.value().isList() )
+        return it.value() == v;
+
     QList<Variant> thisVals = it.value().toVariantList();
     QList<Variant> vals = v.toVariantList();
     Q_FOREACH( const Variant& val, vals ) {
@@ -239,12 +275,13 @@ bool Nepomuk2::ResourceData::hasProperty( const QUrl& p, const Variant& v )
 
 Nepomuk2::Variant Nepomuk2::ResourceData::property( const QUrl& uri )
 {
-    if( !load() )
+    if( !ensureLoaded( uri ) )
         return Variant();
 
     // we need to protect the reading, too. load my be triggered from another thread's
     // connection to a Soprano statement signal
     QMutexLocker lock(&m_dataMutex);
+    m_recentlyUsed = 1;
 
     QHash<QUrl, Variant>::const_iterator it = m_cache.constFind( uri );
     if ( it == m_cache.constEnd() ) {
@@ -307,8 +344,6 @@ bool Nepomuk2::ResourceData::store()
         }
 
         addToWatcher();
-        lock.unlock();
-        QMutexLocker rmlock(&m_rm->mutex);
         // Add us to the initialized data, i.e. make us "valid"
         //Note: once m_uri is non-empty, it doesn't change
         m_rm->m_initializedData.insert( m_uri, this );
@@ -354,35 +389,153 @@ bool Nepomuk2::ResourceData::load()
     if ( !m_uri.isValid() )
         return false;
 
-    const QString oldNaoIdentifier = m_cache[NAO::identifier()].toString();
-    const QUrl oldNieUrl = m_cache[NIE::url()].toUrl();
-
-    m_cache.clear();
     addToWatcher();
 
+    // The heavy properties like the plain text content of files are only loaded on request
+    const QList<QUrl> excluded = m_rm->heavyProperties();
+
     //
     // We exclude properties that are part of the inference graph
     // It would only pollute the user interface
     //
+    QHash<QUrl, Variant> values;
     Soprano::QueryResultIterator it = MAINMODEL->executeQuery(QString("select distinct ?p ?o where { "
-                                                                      "%1 ?p ?o . }").arg(Soprano::Node::resourceToN3(m_uri)),
+                                                                      "%1 ?p ?o . %2}").arg(Soprano::Node::resourceToN3(m_uri),
+                                                                                            propertyFilter(excluded, true)),
                                                               Soprano::Query::QueryLanguageSparqlNoInference);
     while ( it.next() ) {
         QUrl p = it["p"].uri();
-        m_cache[p].append( Variant::fromNode( it["o"] ) );
+        values[p].append( Variant::fromNode( it["o"] ) );
+    }
+
+    lock.unlock();
+    updateCache( values, QList<QUrl>(), excluded );
+    m_rm->evictCaches( QSet<ResourceData*>() << this );
+
+    return true;
+}
+
+
+bool Nepomuk2::ResourceData::ensureLoaded( const QUrl& uri )
+{
+    if( isLoaded( uri ) )
+        return true;
+
+    // Only fetch the one heavy property which was asked for
+    if( m_rm->isHeavyProperty( uri ) ) {
+        {
+            QMutexLocker lock(&m_dataMutex);
+            if( !m_uri.isValid() )
+                return false;
+        }
+        loadMultiple( m_rm, QList<ResourceData*>() << this, QList<QUrl>() << uri );
+        m_rm->evictCaches( QSet<ResourceData*>() << this );
+        return true;
+    }
+
+    return load();
+}
+
+
+// static
+void Nepomuk2::ResourceData::loadMultiple( ResourceManagerPrivate* rm,
+                                           const QList<ResourceData*>& data,
+                                           const QList<QUrl>& properties )
+{
+    // Keep the queries at a reasonable size
+    const int chunkSize = 100;
+
+    // see load() for why we exclude the heavy properties
+    QList<QUrl> excluded;
+    QString filter;
+    if( !properties.isEmpty() ) {
+        filter = propertyFilter( properties, false );
+    }
+    else {
+        excluded = rm->heavyProperties();
+        filter = propertyFilter( excluded, true );
+    }
+
+    for( int i = 0; i < data.count(); i += chunkSize ) {
+        const QList<ResourceData*> chunk = data.mid( i, chunkSize );
+
+        QHash<QUrl, ResourceData*> dataHash;
+        QStringList n3;
+        foreach( ResourceData* rd, chunk ) {
+            QMutexLocker lock( &rd->m_dataMutex );
+            rd->addToWatcher();
+            dataHash.insert( rd->m_uri, rd );
+            n3 << Soprano::Node::resourceToN3( rd->m_uri );
+        }
+
+        // see load() for why we exclude the inference graph
+        QHash<QUrl, QHash<QUrl, Variant> > values;
+        const QString query = QString::fromLatin1("select distinct ?r ?p ?o where { ?r ?p ?o . "
+                                                  "FILTER(?r in (%1)) . %2}")
+                              .arg( n3.join(QLatin1String(",")), filter );
+        Soprano::QueryResultIterator it = rm->m_manager->mainModel()->executeQuery( query,
+                                                                                    Soprano::Query::QueryLanguageSparqlNoInference );
+        while ( it.next() ) {
+            values[it[0].uri()][it[1].uri()].append( Variant::fromNode( it[2] ) );
+        }
+
+        for( QHash<QUrl, ResourceData*>::const_iterator dit = dataHash.constBegin();
+             dit != dataHash.constEnd(); ++dit ) {
+            dit.value()->updateCache( values.value( dit.key() ), properties, excluded );
+        }
+    }
+}
+
+
+bool Nepomuk2::ResourceData::isLoaded( const QUrl& uri ) const
+{
+    QMutexLocker lock(&m_dataMutex);
+    if( !uri.isEmpty() && m_loadedProperties.contains( uri ) )
+        return true;
+    return !m_cacheDirty && !m_excludedProperties.contains( uri );
+}
+
+
+void Nepomuk2::ResourceData::updateCache( const QHash<QUrl, Variant>& values, const QList<QUrl>& properties,
+                                          const QList<QUrl>& excluded )
+{
+    QMutexLocker lock(&m_dataMutex);
+
+    const QString oldNaoIdentifier = m_cache.value(NAO::identifier()).toString();
+    const QUrl oldNieUrl = m_cache.value(NIE::url()).toUrl();
+
+    if( properties.isEmpty() ) {
+        m_cache = values;
+        m_loadedProperties.clear();
+        m_excludedProperties = excluded.toSet();
+        m_cacheDirty = false;
+    }
+    else {
+        foreach( const QUrl& p, properties ) {
+            QHash<QUrl, Variant>::const_iterator it = values.constFind( p );
+            if( it != values.constEnd() )
+                m_cache.insert( p, it.value() );
+            else
+                m_cache.remove( p );
+            m_loadedProperties.insert( p );
+        }
+    }
+
+    // without watching the resource the cached values would become outdated
+    addToWatcher();
+
+    if( m_evicted ) {
+        m_evicted = false;
+        m_rm->m_cacheReloads.ref();
     }
+    m_recentlyUsed = 1;
+    updateCacheSize();
 
     const QString newNaoIdentifier = m_cache.value(NAO::identifier()).toString();
     const QUrl newNieUrl = m_cache.value(NIE::url()).toUrl();
-    m_cacheDirty = false;
 
-    lock.unlock();
-
-    QMutexLocker rmlock(&m_rm->mutex); // for updating the lists. Must be locked first
     updateIdentifierLists( oldNaoIdentifier, newNaoIdentifier );
     updateUrlLists( oldNieUrl, newNieUrl );
-
-    return true;
 }
 
 
@@ -400,7 +553,7 @@ void Nepomuk2::ResourceData::setProperty( const QUrl& uri, const Nepomuk2::Varia
             if( var.simpleType() == qMetaTypeId<Resource>() ) {
                 Resource res = var.toResource();
                 res.determineFinalResourceData();
-                res.m_data->store();
+                res.data()->store();
 
                 varList << res.uri();
             }
@@ -409,33 +562,49 @@ void Nepomuk2::ResourceData::setProperty( const QUrl& uri, const Nepomuk2::Varia
             }
         }
 
-        QMutexLocker lock(&m_dataMutex);
-        // update the store
-        QDBusMessage msg = QDBusMessage::createMethodCall( QLatin1String("org.kde.NepomukStorage"),
-                                                           QLatin1String("/datamanagement"),
-                                                           QLatin1String("org.kde.nepomuk.DataManagement"),
-                                                           QLatin1String("setProperty") );
+        ResourceBatchPrivate* batch = ResourceBatchPrivate::current();
+        if( batch ) {
+            // The change is only applied to the cache. It has to be loaded first since
+            // the next load() would drop the change and the rollback needs the old value.
+            batch->pin( this );
+            ensureLoaded( uri );
+        }
 
-        msg.setArguments( QVariantList()
-                          << DBus::convertUriList(QList<QUrl>() << m_uri)
-                          << DBus::convertUri(uri)
-                          << QVariant(DBus::normalizeVariantList(varList))
-                          << KGlobal::mainComponent().componentName() );
+        QMutexLocker lock(&m_dataMutex);
+        const Nepomuk2::Variant oldvalue = m_cache.value(uri);
 
-        QDBusConnection bus = KDBusConnectionPool::threadConnection();
-        QDBusMessage reply = bus.call( msg );
-        if( reply.type() == QDBusMessage::ErrorMessage ) {
-            //TODO: Set the error somehow
-            kWarning() << reply.errorMessage();
-            return;
+        if( batch ) {
+            // the batch writes the change once it is committed
+            batch->record( this, m_uri, uri, ResourceBatchPrivate::Replace, varList, oldvalue );
+        }
+        else {
+            // update the store
+            QDBusMessage msg = QDBusMessage::createMethodCall( QLatin1String("org.kde.NepomukStorage"),
+                                                               QLatin1String("/datamanagement"),
+                                                               QLatin1String("org.kde.nepomuk.DataManagement"),
+                                                               QLatin1String("setProperty") );
+
+            msg.setArguments( QVariantList()
+                              << DBus::convertUriList(QList<QUrl>() << m_uri)
+                              << DBus::convertUri(uri)
+                              << QVariant(DBus::normalizeVariantList(varList))
+                              << KGlobal::mainComponent().componentName() );
+
+            QDBusConnection bus = KDBusConnectionPool::threadConnection();
+            QDBusMessage reply = bus.call( msg );
+            if( reply.type() == QDBusMessage::ErrorMessage ) {
+                //TODO: Set the error somehow
+                kWarning() << reply.errorMessage();
+                return;
+            }
         }
 
-        const Nepomuk2::Variant oldvalue = m_cache.value(uri);
         // update the cache for now
         if( value.isValid() )
             m_cache[uri] = value;
         else
             m_cache.remove(uri);
+        updateCacheSize();
         lock.unlock();
         // update the kickofflists
         updateKickOffLists( uri, oldvalue, value );
@@ -457,7 +626,7 @@ void Nepomuk2::ResourceData::addProperty( const QUrl& uri, const Nepomuk2::Varia
             if( var.simpleType() == qMetaTypeId<Resource>() ) {
                 Resource res = var.toResource();
                 res.determineFinalResourceData();
-                res.m_data->store();
+                res.data()->store();
 
                 varList << res.uri();
             }
@@ -466,29 +635,45 @@ void Nepomuk2::ResourceData::addProperty( const QUrl& uri, const Nepomuk2::Varia
             }
         }
 
+        ResourceBatchPrivate* batch = ResourceBatchPrivate::current();
+        if( batch ) {
+            // The change is only applied to the cache. It has to be loaded first since
+            // the next load() would drop the change and the rollback needs the old value.
+            batch->pin( this );
+            ensureLoaded( uri );
+        }
+
         QMutexLocker lock(&m_dataMutex);
-        QDBusMessage msg = QDBusMessage::createMethodCall( QLatin1String("org.kde.NepomukStorage"),
-                                                           QLatin1String("/datamanagement"),
-                                                           QLatin1String("org.kde.nepomuk.DataManagement"),
-                                                           QLatin1String("addProperty") );
-        msg.setArguments( QVariantList()
-                          << DBus::convertUriList(QList<QUrl>() << m_uri)
-                          << DBus::convertUri(uri)
-                          << QVariant(DBus::normalizeVariantList(varList))
-                          << KGlobal::mainComponent().componentName() );
+        const Nepomuk2::Variant oldvalue = m_cache.value(uri);
 
-        QDBusConnection bus = KDBusConnectionPool::threadConnection();
-        QDBusMessage reply = bus.call( msg );
-        if( reply.type() == QDBusMessage::ErrorMessage ) {
-            //TODO: Set the error somehow
-            kWarning() << reply.errorMessage();
-            return;
+        if( batch ) {
+            // the batch writes the change once it is committed
+            batch->record( this, m_uri, uri, ResourceBatchPrivate::Add, varList, oldvalue );
+        }
+        else {
+            QDBusMessage msg = QDBusMessage::createMethodCall( QLatin1String("org.kde.NepomukStorage"),
+                                                               QLatin1String("/datamanagement"),
+                                                               QLatin1String("org.kde.nepomuk.DataManagement"),
+                                                               QLatin1String("addProperty") );
+            msg.setArguments( QVariantList()
+                              << DBus::convertUriList(QList<QUrl>() << m_uri)
+                              << DBus::convertUri(uri)
+                              << QVariant(DBus::normalizeVariantList(varList))
+                              << KGlobal::mainComponent().componentName() );
+
+            QDBusConnection bus = KDBusConnectionPool::threadConnection();
+            QDBusMessage reply = bus.call( msg );
+            if( reply.type() == QDBusMessage::ErrorMessage ) {
+                //TODO: Set the error somehow
+                kWarning() << reply.errorMessage();
+                return;
+            }
         }
 
-        const Nepomuk2::Variant oldvalue = m_cache.value(uri);
         // update the cache for now
         if( value.isValid() )
             m_cache[uri].append(value);
+        updateCacheSize();
         lock.unlock();
         // update the kickofflists
         updateKickOffLists( uri, oldvalue, value );
@@ -499,29 +684,45 @@ void Nepomuk2::ResourceData::addProperty( const QUrl& uri, const Nepomuk2::Varia
 void Nepomuk2::ResourceData::removeProperty( const QUrl& uri )
 {
     Q_ASSERT( uri.isValid() );
+
+    // see setProperty()
+    ResourceBatchPrivate* batch = ResourceBatchPrivate::current();
+    if( batch && !this->uri().isEmpty() ) {
+        batch->pin( this );
+        ensureLoaded( uri );
+    }
+
     QMutexLocker lock(&m_dataMutex);
 
     if( !m_uri.isEmpty() ) {
-        QDBusMessage msg = QDBusMessage::createMethodCall( QLatin1String("org.kde.NepomukStorage"),
-                                                           QLatin1String("/datamanagement"),
-                                                           QLatin1String("org.kde.nepomuk.DataManagement"),
-                                                           QLatin1String("removeProperties") );
-        msg.setArguments( QVariantList()
-                          << DBus::convertUri(m_uri)
-                          << DBus::convertUri(uri)
-                          << KGlobal::mainComponent().componentName() );
+        const Nepomuk2::Variant oldvalue = m_cache.value(uri);
 
-        QDBusConnection bus = KDBusConnectionPool::threadConnection();
-        QDBusMessage reply = bus.call( msg );
-        if( reply.type() == QDBusMessage::ErrorMessage ) {
-            //TODO: Set the error somehow
-            kWarning() << reply.errorMessage();
-            return;
+        if( batch ) {
+            // the batch writes the change once it is committed
+            batch->record( this, m_uri, uri, ResourceBatchPrivate::Replace, QVariantList(), oldvalue );
+        }
+        else {
+            QDBusMessage msg = QDBusMessage::createMethodCall( QLatin1String("org.kde.NepomukStorage"),
+                                                               QLatin1String("/datamanagement"),
+                                                               QLatin1String("org.kde.nepomuk.DataManagement"),
+                                                               QLatin1String("removeProperties") );
+            msg.setArguments( QVariantList()
+                              << DBus::convertUri(m_uri)
+                              << DBus::convertUri(uri)
+                              << KGlobal::mainComponent().componentName() );
+
+            QDBusConnection bus = KDBusConnectionPool::threadConnection();
+            QDBusMessage reply = bus.call( msg );
+            if( reply.type() == QDBusMessage::ErrorMessage ) {
+                //TODO: Set the error somehow
+                kWarning() << reply.errorMessage();
+                return;
+            }
         }
 
-        const Nepomuk2::Variant oldvalue = m_cache.value(uri);
         // Update the cache
         m_cache.remove( uri );
+        updateCacheSize();
         // update the kickofflists
         lock.unlock();
         updateKickOffLists( uri, oldvalue, Variant() );
@@ -529,6 +730,27 @@ void Nepomuk2::ResourceData::removeProperty( const QUrl& uri )
 }
 
 
+void Nepomuk2::ResourceData::updateCachedProperty( const QUrl& uri, const Nepomuk2::Variant& value, bool add )
+{
+    QMutexLocker lock(&m_dataMutex);
+
+    const Nepomuk2::Variant oldvalue = m_cache.value(uri);
+    Nepomuk2::Variant newvalue = value;
+    if( add && oldvalue.isValid() ) {
+        newvalue = oldvalue;
+        newvalue.append( value );
+    }
+
+    if( newvalue.isValid() )
+        m_cache[uri] = newvalue;
+    else
+        m_cache.remove(uri);
+    updateCacheSize();
+
+    updateKickOffLists( uri, oldvalue, newvalue );
+}
+
+
 void Nepomuk2::ResourceData::remove( bool recursive )
 {
     Q_UNUSED(recursive)
@@ -653,25 +875,14 @@ void Nepomuk2::ResourceData::determineUri()
     // Move us to the final data hash now that the URI is known
     //
     if( !m_uri.isEmpty() ) {
-        lock.unlock(); // respect mutex order
-        QMutexLocker locker(&m_rm->mutex);
-        lock.relock();
         m_cacheDirty = true;
-        ResourceDataHash::iterator it = m_rm->m_initializedData.find(m_uri);
-        if( it == m_rm->m_initializedData.end() ) {
-            m_rm->m_initializedData.insert( m_uri, this );
-        }
-        else {
-            ResourceData* foundData = it.value();
-
-            // in case we get an already existing one we update all instances
-            // using the old ResourceData to avoid the overhead of calling
-            // determineUri over and over
-            Q_FOREACH (Resource* res, m_resources) {
-                res->m_data = foundData; // this can include our caller
-                this->deref( res );
-                foundData->ref( res );
-            }
+        ResourceData* foundData = m_rm->m_initializedData.insertOrAcquire( m_uri, this );
+        if( foundData != this ) {
+            // Another ResourceData already represents the resource. Instead of moving the
+            // Resources which use us over to it, which would mean locking each of them on
+            // every copy, they keep us and are served by the proxy. The reference acquired
+            // above is released in our destructor.
+            m_proxyData = foundData;
         }
     }
 }
@@ -681,6 +892,78 @@ void Nepomuk2::ResourceData::invalidateCache()
 {
     QMutexLocker lock(&m_dataMutex);
     m_cacheDirty = true;
+    m_loadedProperties.clear();
+}
+
+
+bool Nepomuk2::ResourceData::evictCache()
+{
+    // Never block. The eviction may be triggered from a thread which holds the
+    // mutex of another ResourceData (see isFile()) and would violate the locking order.
+    // The rm mutex is for the watcher and has to be locked first.
+    if( !m_rm->mutex.tryLock() )
+        return false;
+    if( !m_dataMutex.tryLock() ) {
+        m_rm->mutex.unlock();
+        return false;
+    }
+
+    // A pinned cache holds the changes of a ResourceBatch which are not written yet
+    bool evicted = false;
+    if( !m_pins && !m_uri.isEmpty() && ( !m_cacheDirty || !m_loadedProperties.isEmpty() ) ) {
+        // The kickoff lists are updated based on the cached values. Without them we
+        // are found through m_initializedData once determineUri() ran for the url or
+        // identifier, and updateCache() adds us again.
+        updateIdentifierLists( m_cache.value( NAO::identifier() ).toString(), QString() );
+        updateUrlLists( m_cache.value( NIE::url() ).toUrl(), QUrl() );
+
+        m_cache.clear();
+        m_loadedProperties.clear();
+        m_cacheDirty = true;
+        m_evicted = true;
+
+        // Watching a resource which is not cached is a waste. load() will add it again.
+        removeFromWatcher();
+        updateCacheSize();
+        evicted = true;
+    }
+
+    m_dataMutex.unlock();
+    m_rm->mutex.unlock();
+    return evicted;
+}
+
+
+namespace {
+    /// A rough estimate of the memory used for one cached property
+    qint64 estimateSize( const QUrl& property, const Nepomuk2::Variant& value ) {
+        qint64 size = 64 + property.toEncoded().size();
+        if( value.isString() || value.isStringList() ) {
+            foreach( const QString& s, value.toStringList() )
+                size += sizeof(QString) + s.size() * sizeof(QChar);
+        }
+        else if( value.isList() ) {
+            size += 64 * value.toVariantList().count();
+        }
+        else {
+            size += 64;
+        }
+        return size;
+    }
+}
+
+void Nepomuk2::ResourceData::updateCacheSize()
+{
+    qint64 size = 0;
+    QHash<QUrl, Variant>::const_iterator end = m_cache.constEnd();
+    for( QHash<QUrl, Variant>::const_iterator it = m_cache.constBegin(); it != end; ++it ) {
+        size += estimateSize( it.key(), it.value() );
+    }
+
+    if( size != m_cacheSize ) {
+        m_rm->cacheSizeChanged( this, m_cacheSize, size );
+        m_cacheSize = size;
+    }
 }
 
 
@@ -716,7 +999,7 @@ QDebug operator<<( QDebug dbg, const Nepomuk2::ResourceData& data )
 void Nepomuk2::ResourceData::updateUrlLists(const QUrl& oldUrl, const QUrl& newUrl)
 {
     if ( !oldUrl.isEmpty() ) {
-        m_rm->m_urlKickOff.remove( oldUrl );
+        m_rm->m_urlKickOff.remove( oldUrl, this );
     }
 
     if( !newUrl.isEmpty() ) {
@@ -727,7 +1010,7 @@ void Nepomuk2::ResourceData::updateUrlLists(const QUrl& oldUrl, const QUrl& newU
 void Nepomuk2::ResourceData::updateIdentifierLists(const QString& oldIdentifier, const QString& newIdentifier)
 {
     if ( !oldIdentifier.isEmpty() ) {
-        m_rm->m_identifierKickOff.remove( oldIdentifier );
+        m_rm->m_identifierKickOff.remove( oldIdentifier, this );
     }
 
     if( !newIdentifier.isEmpty() ) {
@@ -735,13 +1018,10 @@ void Nepomuk2::ResourceData::updateIdentifierLists(const QString& oldIdentifier,
     }
 }
 
-// Be very careful never to call this when m_dataMutex is held,
-// unless the RM mutex was taken first, because the RM mutex must be taken
-// before the dataMutex.
+// The kickoff lists have their own locking which may be used with m_dataMutex held.
 void Nepomuk2::ResourceData::updateKickOffLists(const QUrl& uri, const Nepomuk2::Variant &oldvalue, const Nepomuk2::Variant& newvalue)
 {
     if( uri == NIE::url() || uri == NAO::identifier() ){
-        QMutexLocker rmlock(&m_rm->mutex);
         if( uri == NIE::url() )
             updateUrlLists( oldvalue.toUrl(), newvalue.toUrl() );
         else if( uri == NAO::identifier() )
@@ -763,8 +1043,6 @@ namespace {
         return modified;
     }
 }
-// Since propertyRemoved and propertyAdded are called from the ResourceManager with the RM mutex already locked, 
-// it is ok for them to call updateKickOffLists while the dataMutex is locked.
 void Nepomuk2::ResourceData::propertyRemoved( const Types::Property &prop, const QVariant &value_ )
 {
     QMutexLocker lock(&m_dataMutex);
@@ -798,6 +1076,7 @@ void Nepomuk2::ResourceData::propertyRemoved( const Types::Property &prop, const
                 updateKickOffLists(prop.uri(), m_cache.value(prop.uri()), vl.first());
             m_cache[prop.uri()] = vl;
         }
+        updateCacheSize();
     }
 }
 
@@ -808,6 +1087,7 @@ void Nepomuk2::ResourceData::propertyAdded( const Types::Property &prop, const Q
     const Variant oldvalue = m_cache.value(prop.uri());
     if( !oldvalue.toVariantList().contains(var) ) {
         m_cache[prop.uri()].append(var);
+        updateCacheSize();
     }
     updateKickOffLists(prop.uri(), oldvalue, var);
 }
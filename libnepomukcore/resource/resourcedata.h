@@ -25,7 +25,9 @@
 #include <QtCore/QList>
 #include <QtCore/QHash>
 #include <QtCore/QMutex>
+#include <QtCore/QMutexLocker>
 #include <QtCore/QAtomicInt>
+#include <QtCore/QAtomicPointer>
 #include <QtCore/QSet>
 
 #include "variant.h"
@@ -45,21 +47,56 @@ namespace Nepomuk2 {
         explicit ResourceData( const QUrl& uri, const QUrl& kickOffUri, const QUrl& type_, ResourceManagerPrivate* rm );
         ~ResourceData();
 
-        inline bool ref(Nepomuk2::Resource* res) {
-            // Caller must lock ResourceManager mutex
-            m_resources.push_back( res );
+        /**
+         * Adds a reference. Copying a Resource does nothing else, no lock is taken.
+         */
+        inline bool ref() {
             return m_ref.ref();
         }
 
-        inline bool deref(Nepomuk2::Resource* res) {
-            // Caller must lock ResourceManager mutex
-            m_resources.removeAll( res );
+        /**
+         * Like ref() but fails if the reference count already dropped to zero.
+         * Such a ResourceData is about to be deleted and must not be used anymore.
+         * Used for all lookups in the ResourceManager caches.
+         */
+        inline bool tryRef() {
+            while( true ) {
+                const int count = m_ref;
+                if( !count )
+                    return false;
+                if( m_ref.testAndSetOrdered( count, count + 1 ) )
+                    return true;
+            }
+        }
+
+        /**
+         * \return \p false if this was the last reference. The caller is then
+         * responsible for deleting the ResourceData.
+         */
+        inline bool deref() {
             return m_ref.deref();
         }
 
-        QList<Resource*> resources() const {
-            // Caller must lock ResourceManager mutex
-            return m_resources;
+        /**
+         * Keeps evictCache() from dropping the cache while a ResourceBatch
+         * holds uncommitted changes in it. Balanced by unpin().
+         */
+        inline void pin() {
+            m_pins.ref();
+        }
+
+        inline void unpin() {
+            m_pins.deref();
+        }
+
+        /**
+         * The ResourceData which was already used for the resource when
+         * determineUri() found its URI, or 0. The Resources using this
+         * ResourceData keep it and use the proxy for everything from then on,
+         * see Resource::data().
+         */
+        ResourceData* proxyData() const {
+            return m_proxyData;
         }
 
         inline int cnt() const {
@@ -101,6 +138,13 @@ namespace Nepomuk2 {
 
         void removeProperty( const QUrl& uri );
 
+        /**
+         * Update the cache after \p uri has been changed in the store by someone else
+         * (see ResourceJob). An invalid \p value removes the property from the cache.
+         * \param add If \p true \p value is appended to the cached values instead of replacing them.
+         */
+        void updateCachedProperty( const QUrl& uri, const Variant& value, bool add );
+
         /**
          * Makes sure the resource is present in the RDF store. This means that if it does
          * not exist the type and the identifier (if one has been used to create the instance)
@@ -113,8 +157,34 @@ namespace Nepomuk2 {
          */
         bool store();
 
+        /**
+         * Load all properties of the resource except the heavy ones.
+         *
+         * \sa ResourceManager::setHeavyProperties()
+         */
         bool load();
 
+        /**
+         * Load the properties of all \p data with one query per chunk of resources
+         * instead of one query per resource.
+         *
+         * \param properties If not empty only these properties are loaded and the
+         * caches are only considered complete for them.
+         *
+         * \sa ResourceManager::prefetch()
+         */
+        static void loadMultiple( ResourceManagerPrivate* rm,
+                                  const QList<ResourceData*>& data,
+                                  const QList<QUrl>& properties );
+
+        /**
+         * \return true if the values of \p uri are cached, either since the whole
+         * resource has been loaded or since it was part of a partial loadMultiple().
+         * An empty \p uri checks if the whole resource apart from the heavy
+         * properties has been loaded.
+         */
+        bool isLoaded( const QUrl& uri = QUrl() ) const;
+
         /**
          * Remove this resource data from the store completely.
          * \param recursive If true all statements that contain this
@@ -137,13 +207,30 @@ namespace Nepomuk2 {
          * This will either get the actual resource URI from the database
          * and add m_data into ResourceManagerPrivate::m_initializedData
          * or it will find another ResourceData instance in m_initializedData
-         * which represents the same resource. The ResourceData that should be
-         * used is set in all the associated resources.
+         * which represents the same resource. That one becomes the proxyData().
          */
         void determineUri();
 
         void invalidateCache();
 
+        /**
+         * Drop the cached properties to save memory. In contrast to invalidateCache()
+         * the resource is also removed from the watcher. The properties are loaded
+         * again on the next access.
+         *
+         * \return \p false if there was nothing to drop.
+         *
+         * \sa ResourceManager::setCacheBudget()
+         */
+        bool evictCache();
+
+        /**
+         * \return \p true if the cache has been used since the last call.
+         */
+        inline bool takeRecentlyUsed() {
+            return m_recentlyUsed.fetchAndStoreOrdered( 0 );
+        }
+
         /**
          * Compares the properties of two ResourceData objects taking into account the Deleted flag
          */
@@ -156,7 +243,7 @@ namespace Nepomuk2 {
         /// Updates ResourceManagerPrivate's list
         void updateKickOffLists( const QUrl& uri, const Variant& oldvariant, const Variant& newvariant );
 
-        /// Called by ResourceManager (with the RM mutex locked)
+        /// Called by ResourceManager (with a reference held)
         void propertyRemoved( const Types::Property &prop, const QVariant &value );
         void propertyAdded( const Types::Property &prop, const QVariant &value );
 
@@ -167,6 +254,8 @@ namespace Nepomuk2 {
         /// Used by remove() and deleteData()
         void resetAll();
     private:
+        friend class ResourceManagerPrivate;
+
         ResourceData(const ResourceData&); // = delete
         ResourceData& operator = (const ResourceData&); // = delete
         void updateUrlLists( const QUrl& oldUrl, const QUrl& newUrl );
@@ -175,8 +264,21 @@ namespace Nepomuk2 {
         void addToWatcher();
         void removeFromWatcher();
 
-        /// Contains a list of resources which use this ResourceData
-        QList<Resource*> m_resources;
+        /**
+         * Replace the cached values of \p properties with \p values. An empty
+         * list of properties replaces the whole cache.
+         */
+        void updateCache( const QHash<QUrl, Variant>& values, const QList<QUrl>& properties,
+                          const QList<QUrl>& excluded = QList<QUrl>() );
+
+        /**
+         * Make sure \p uri is cached. Heavy properties are loaded on their own,
+         * everything else via load().
+         */
+        bool ensureLoaded( const QUrl& uri );
+
+        /// Re-estimates m_cacheSize and reports it to the ResourceManager. Caller must hold m_dataMutex.
+        void updateCacheSize();
 
         /// final resource URI created by determineUri
         KUrl m_uri;
@@ -194,13 +296,33 @@ namespace Nepomuk2 {
 
         QAtomicInt m_ref;
 
+        /// the number of ResourceBatch objects with changes in the cache
+        QAtomicInt m_pins;
+
+        /// set once by determineUri(), holds a reference on the proxy
+        QAtomicPointer<ResourceData> m_proxyData;
+
         // Protect m_cache, m_cacheDirty but also m_uri, m_nieUrl, m_naoIdentifier, m_addedToWatcher.
         // Never lock the ResourceManager mutex after locking this one. Always before (or not at all).
+        // The cache shard mutexes may be locked while holding it.
         mutable QMutex m_dataMutex;
 
         QHash<QUrl, Variant> m_cache;
 
+        /// The properties which are cached even though m_cacheDirty is true
+        QSet<QUrl> m_loadedProperties;
+
+        /// The heavy properties which were left out of the last full load
+        QSet<QUrl> m_excludedProperties;
+
+        /// The estimated memory used by m_cache in bytes
+        qint64 m_cacheSize;
+
+        /// Set on each access of the cache. Used to determine which caches to evict.
+        QAtomicInt m_recentlyUsed;
+
         bool m_cacheDirty;
+        bool m_evicted;
         bool m_addedToWatcher;
         bool m_watchEnabled;
 
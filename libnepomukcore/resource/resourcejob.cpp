@@ -0,0 +1,281 @@
+/*
+    This file is part of the Nepomuk KDE project.
+    Copyright (C) 2013  Nepomuk Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "resourcejob.h"
+#include "resourcedata.h"
+#include "resourcemanager.h"
+#include "datamanagement.h"
+
+#include <QtCore/QRunnable>
+#include <QtCore/QThreadPool>
+#include <QtCore/QMetaObject>
+
+#include <KDebug>
+#include <KLocale>
+
+
+class Nepomuk2::ResourceJob::Private : public QRunnable
+{
+public:
+    enum Operation {
+        Load,
+        Set,
+        Add,
+        Remove
+    };
+
+    Private() {
+        setAutoDelete( false );
+    }
+
+    /**
+     * Runs in the thread pool and does everything which might block: determining
+     * the resource URIs, creating resources and loading properties.
+     */
+    void run();
+    void prepare();
+
+    void _k_prepared();
+    void _k_storeJobFinished( KJob* job );
+
+    Operation m_operation;
+    QList<Resource> m_resources;
+    QList<QUrl> m_properties;
+    QUrl m_property;
+    Variant m_value;
+
+    // filled by prepare()
+    QList<QUrl> m_uris;
+    QVariantList m_values;
+    QString m_errorText;
+
+    ResourceJob* q;
+};
+
+
+void Nepomuk2::ResourceJob::Private::run()
+{
+    prepare();
+    QMetaObject::invokeMethod( q, "_k_prepared", Qt::QueuedConnection );
+}
+
+
+void Nepomuk2::ResourceJob::Private::prepare()
+{
+    if( m_operation == Load ) {
+        // identify the resources which have been created from a file URL or an identifier
+        foreach( const Resource& res, m_resources )
+            res.uri();
+        ResourceManager::instance()->prefetch( m_resources, m_properties );
+        return;
+    }
+
+    for( QList<Resource>::iterator it = m_resources.begin(); it != m_resources.end(); ++it ) {
+        const QUrl uri = ResourceJob::storedUri( *it );
+        if( uri.isEmpty() ) {
+            m_errorText = i18n( "Failed to create the resource." );
+            return;
+        }
+        m_uris << uri;
+    }
+
+    // make sure resource values are identified and in the store
+    foreach( const Variant& var, m_value.toVariantList() ) {
+        if( var.simpleType() == qMetaTypeId<Resource>() ) {
+            Resource res = var.toResource();
+            const QUrl uri = ResourceJob::storedUri( res );
+            if( uri.isEmpty() ) {
+                m_errorText = i18n( "Failed to create the resource." );
+                return;
+            }
+            m_values << uri;
+        }
+        else {
+            m_values << var.variant();
+        }
+    }
+}
+
+
+void Nepomuk2::ResourceJob::Private::_k_prepared()
+{
+    if( !m_errorText.isEmpty() ) {
+        q->setError( 1 );
+        q->setErrorText( m_errorText );
+        q->emitResult();
+        return;
+    }
+
+    if( m_resources.isEmpty() ) {
+        q->emitResult();
+        return;
+    }
+
+    // The actual change is done through the asynchronous DMS API. No ResourceData
+    // lock is held while waiting for the storage service.
+    KJob* job = 0;
+    switch( m_operation ) {
+    case Load:
+        q->emitResult();
+        return;
+    case Set:
+        job = Nepomuk2::setProperty( m_uris, m_property, m_values );
+        break;
+    case Add:
+        job = Nepomuk2::addProperty( m_uris, m_property, m_values );
+        break;
+    case Remove:
+        job = Nepomuk2::removeProperties( m_uris, QList<QUrl>() << m_property );
+        break;
+    }
+
+    q->connect( job, SIGNAL(result(KJob*)), q, SLOT(_k_storeJobFinished(KJob*)) );
+}
+
+
+void Nepomuk2::ResourceJob::Private::_k_storeJobFinished( KJob* job )
+{
+    if( job->error() ) {
+        kDebug() << job->errorString();
+        q->setError( job->error() );
+        q->setErrorText( job->errorText() );
+    }
+    else {
+        foreach( const Resource& res, m_resources ) {
+            switch( m_operation ) {
+            case Set:
+                ResourceJob::updateCachedProperty( res, m_property, m_value, false );
+                break;
+            case Add:
+                ResourceJob::updateCachedProperty( res, m_property, m_value, true );
+                break;
+            case Remove:
+                ResourceJob::updateCachedProperty( res, m_property, Variant(), false );
+                break;
+            case Load:
+                break;
+            }
+        }
+    }
+
+    q->emitResult();
+}
+
+
+Nepomuk2::ResourceJob::ResourceJob()
+    : KJob( 0 ),
+      d( new Private )
+{
+    d->q = this;
+}
+
+
+Nepomuk2::ResourceJob::~ResourceJob()
+{
+    delete d;
+}
+
+
+void Nepomuk2::ResourceJob::start()
+{
+    QThreadPool::globalInstance()->start( d );
+}
+
+
+QList<Nepomuk2::Resource> Nepomuk2::ResourceJob::resources() const
+{
+    return d->m_resources;
+}
+
+
+// static
+QUrl Nepomuk2::ResourceJob::storedUri( Resource& res )
+{
+    res.determineFinalResourceData();
+    if( !res.m_data || !res.data()->store() )
+        return QUrl();
+    return res.data()->uri();
+}
+
+
+// static
+void Nepomuk2::ResourceJob::updateCachedProperty( const Resource& res, const QUrl& property,
+                                                  const Variant& value, bool add )
+{
+    if( res.m_data )
+        res.data()->updateCachedProperty( property, value, add );
+}
+
+
+// static
+Nepomuk2::ResourceJob* Nepomuk2::ResourceJob::loadProperties( const QList<Resource>& resources,
+                                                             const QList<QUrl>& properties )
+{
+    ResourceJob* job = new ResourceJob();
+    job->d->m_operation = Private::Load;
+    job->d->m_resources = resources;
+    job->d->m_properties = properties;
+    job->start();
+    return job;
+}
+
+
+// static
+Nepomuk2::ResourceJob* Nepomuk2::ResourceJob::setProperty( const QList<Resource>& resources,
+                                                          const QUrl& property,
+                                                          const Variant& value )
+{
+    ResourceJob* job = new ResourceJob();
+    job->d->m_operation = Private::Set;
+    job->d->m_resources = resources;
+    job->d->m_property = property;
+    job->d->m_value = value;
+    job->start();
+    return job;
+}
+
+
+// static
+Nepomuk2::ResourceJob* Nepomuk2::ResourceJob::addProperty( const QList<Resource>& resources,
+                                                          const QUrl& property,
+                                                          const Variant& value )
+{
+    ResourceJob* job = new ResourceJob();
+    job->d->m_operation = Private::Add;
+    job->d->m_resources = resources;
+    job->d->m_property = property;
+    job->d->m_value = value;
+    job->start();
+    return job;
+}
+
+
+// static
+Nepomuk2::ResourceJob* Nepomuk2::ResourceJob::removeProperty( const QList<Resource>& resources,
+                                                             const QUrl& property )
+{
+    ResourceJob* job = new ResourceJob();
+    job->d->m_operation = Private::Remove;
+    job->d->m_resources = resources;
+    job->d->m_property = property;
+    job->start();
+    return job;
+}
+
+#include "resourcejob.moc"
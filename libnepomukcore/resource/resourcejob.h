@@ -0,0 +1,114 @@
+/*
+    This file is part of the Nepomuk KDE project.
+    Copyright (C) 2013  Nepomuk Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef NEPOMUK2_RESOURCEJOB_H
+#define NEPOMUK2_RESOURCEJOB_H
+
+#include <KJob>
+
+#include <QtCore/QList>
+#include <QtCore/QUrl>
+
+#include "resource.h"
+#include "variant.h"
+#include "nepomuk_export.h"
+
+namespace Nepomuk2 {
+
+/**
+ * \class ResourceJob resourcejob.h Nepomuk2/ResourceJob
+ *
+ * \brief Asynchronous counterpart of the blocking property methods of Resource.
+ *
+ * Resource::property(), Resource::setProperty() and friends block until the
+ * storage service has answered which freezes the user interface whenever the
+ * service is busy. A ResourceJob does the same work without blocking the calling
+ * thread. The KJob::result() signal is emitted in the thread which created the job.
+ *
+ * Once the job is done the changes are reflected in the Resource objects.
+ * Loading fills their caches so that subsequent calls to Resource::property()
+ * do not block anymore.
+ *
+ * The job starts by itself and deletes itself once it is done.
+ *
+ * \since 4.13
+ */
+class NEPOMUK_EXPORT ResourceJob : public KJob
+{
+    Q_OBJECT
+
+public:
+    /**
+     * Destructor. The job does delete itself as soon
+     * as it is done.
+     */
+    ~ResourceJob();
+
+    /**
+     * Load the properties of \p resources.
+     *
+     * \param properties If not empty only these properties are loaded. See ResourceManager::prefetch().
+     */
+    static ResourceJob* loadProperties( const QList<Resource>& resources,
+                                        const QList<QUrl>& properties = QList<QUrl>() );
+
+    /**
+     * Set \p property to \p value on all \p resources replacing the existing values.
+     * Resources which do not exist yet are created.
+     */
+    static ResourceJob* setProperty( const QList<Resource>& resources,
+                                     const QUrl& property,
+                                     const Variant& value );
+
+    /**
+     * Add \p value to the values of \p property on all \p resources.
+     * Resources which do not exist yet are created.
+     */
+    static ResourceJob* addProperty( const QList<Resource>& resources,
+                                     const QUrl& property,
+                                     const Variant& value );
+
+    /**
+     * Remove all values of \p property from all \p resources.
+     */
+    static ResourceJob* removeProperty( const QList<Resource>& resources,
+                                        const QUrl& property );
+
+    /**
+     * The resources the job works on.
+     */
+    QList<Resource> resources() const;
+
+private:
+    ResourceJob();
+    void start();
+
+    static QUrl storedUri( Resource& res );
+    static void updateCachedProperty( const Resource& res, const QUrl& property,
+                                      const Variant& value, bool add );
+
+    class Private;
+    Private* const d;
+
+    Q_PRIVATE_SLOT( d, void _k_prepared() )
+    Q_PRIVATE_SLOT( d, void _k_storeJobFinished(KJob*) )
+};
+}
+
+#endif
@@ -61,10 +61,15 @@ Nepomuk2::ResourceManagerPrivate::ResourceManagerPrivate( ResourceManager* manag
     : mainModel( 0 ),
       overrideModel( 0 ),
       mutex(QMutex::Recursive),
+      m_cacheSize( 0 ),
+      m_cacheBudget( 0 ),
       m_manager( manager ),
       m_watcher( 0 )
 {
     Nepomuk2::DBus::registerDBusTypes();
+
+    // the indexer stores the full text of documents in there
+    m_heavyProperties.insert( NIE::plainTextContent() );
 }
 
 
@@ -72,7 +77,7 @@ Nepomuk2::ResourceData* Nepomuk2::ResourceManagerPrivate::data( const QUrl& uri,
 {
     if ( uri.isEmpty() ) {
         // return an invalid resource which may be activated by calling setProperty
-        return new ResourceData( QUrl(), QUrl(), type, this );
+        return createData( QUrl(), QUrl(), type );
     }
 
     QUrl newUri = uri;
@@ -88,9 +93,9 @@ Nepomuk2::ResourceData* Nepomuk2::ResourceManagerPrivate::data( const QUrl& uri,
     }
     else {
         if( uri.scheme() != QLatin1String("nepomuk") )
-            return new ResourceData( QUrl(), newUri, type, this );
+            return createData( QUrl(), newUri, type );
         else
-            return new ResourceData( newUri, QUrl(), type, this );
+            return createData( newUri, QUrl(), type );
     }
 }
 
@@ -105,7 +110,7 @@ Nepomuk2::ResourceData* Nepomuk2::ResourceManagerPrivate::data( const QString& u
         return data( url, type );
     }
 
-    return new ResourceData( QUrl(), QUrl(), type, this );
+    return createData( QUrl(), QUrl(), type );
 }
 
 
@@ -114,27 +119,144 @@ Nepomuk2::ResourceData* Nepomuk2::ResourceManagerPrivate::dataForResourceUri( co
 {
     if ( uri.isEmpty() ) {
         // return an invalid resource which may be activated by calling setProperty
-        return new ResourceData( QUrl(), QUrl(), type, this );
+        return createData( QUrl(), QUrl(), type );
     }
 
     if( ResourceData* data = findData( uri ) ) {
         return data;
     }
     else {
-        return new ResourceData( uri, QUrl(), type, this );
+        return createData( uri, QUrl(), type );
+    }
+}
+
+
+Nepomuk2::ResourceData* Nepomuk2::ResourceManagerPrivate::createData( const QUrl& uri, const QUrl& kickOffUri,
+                                                                      const QUrl& type )
+{
+    ResourceData* data = new ResourceData( uri, kickOffUri, type, this );
+    data->ref();
+
+    // The new data is only published with a reference. Another thread might have
+    // published one for the same resource in the meantime in which case we use that one.
+    ResourceData* existing = 0;
+    if( !uri.isEmpty() ) {
+        existing = m_initializedData.insertOrAcquire( uri, data );
+    }
+    else if( !data->m_naoIdentifier.isEmpty() ) {
+        existing = m_identifierKickOff.insertOrAcquire( data->m_naoIdentifier, data );
+    }
+    else if( !data->m_nieUrl.isEmpty() ) {
+        existing = m_urlKickOff.insertOrAcquire( data->m_nieUrl, data );
+    }
+
+    if( existing && existing != data ) {
+        // never published, thus nobody else can hold a reference
+        data->deref();
+        delete data;
+        return existing;
+    }
+
+    return data;
+}
+
+
+void Nepomuk2::ResourceManagerPrivate::release( ResourceData* rd )
+{
+    if( !rd->deref() )
+        delete rd;
+}
+
+
+QSet<Nepomuk2::ResourceData*> Nepomuk2::ResourceManagerPrivate::acquireAllResourceData()
+{
+    QSet<ResourceData*> all;
+    QList<ResourceData*> acquired = m_identifierKickOff.acquireAll() + m_urlKickOff.acquireAll() + m_initializedData.acquireAll();
+    foreach( ResourceData* rd, acquired ) {
+        // the same data can be in more than one hash
+        if( all.contains( rd ) )
+            release( rd );
+        else
+            all.insert( rd );
     }
+    return all;
+}
+
+
+QList<QUrl> Nepomuk2::ResourceManagerPrivate::heavyProperties()
+{
+    QMutexLocker lock( &cacheMutex );
+    return m_heavyProperties.toList();
 }
 
 
-QSet<Nepomuk2::ResourceData*> Nepomuk2::ResourceManagerPrivate::allResourceData()
+bool Nepomuk2::ResourceManagerPrivate::isHeavyProperty( const QUrl& property )
 {
-    return m_identifierKickOff.values().toSet() + m_urlKickOff.values().toSet() + m_initializedData.values().toSet();
+    QMutexLocker lock( &cacheMutex );
+    return m_heavyProperties.contains( property );
 }
 
-bool Nepomuk2::ResourceManagerPrivate::shouldBeDeleted( ResourceData * rd ) const
+
+void Nepomuk2::ResourceManagerPrivate::cacheSizeChanged( ResourceData* rd, qint64 oldSize, qint64 newSize )
 {
-    // We only delete ResourceData objects if no other Resource is accessing them
-    return !rd->cnt();
+    QMutexLocker lock( &cacheMutex );
+    m_cacheSize += newSize - oldSize;
+    if( newSize )
+        m_cachedData.insert( rd );
+    else
+        m_cachedData.remove( rd );
+}
+
+
+void Nepomuk2::ResourceManagerPrivate::evictCaches( const QSet<ResourceData*>& keep )
+{
+    qint64 target = 0;
+    QList<ResourceData*> cold;
+    QList<ResourceData*> warm;
+    {
+        QMutexLocker lock( &cacheMutex );
+        if( !m_cacheBudget || m_cacheSize <= m_cacheBudget )
+            return;
+
+        // Only one thread does the work. The others simply continue.
+        if( !m_evicting.testAndSetOrdered( 0, 1 ) )
+            return;
+
+        // Evict a bit more than necessary to not run again on the next load
+        target = m_cacheBudget * 3 / 4;
+
+        // The reference makes sure that the data is not deleted while we work
+        // on it without the lock
+        foreach( ResourceData* rd, m_cachedData ) {
+            if( keep.contains( rd ) )
+                continue;
+            if( rd->tryRef() ) {
+                if( rd->takeRecentlyUsed() )
+                    warm << rd;
+                else
+                    cold << rd;
+            }
+        }
+    }
+
+    // Data used since the last run gets a second chance unless evicting
+    // the cold data is not enough.
+    int evicted = 0;
+    foreach( ResourceData* rd, cold + warm ) {
+        bool done = false;
+        {
+            QMutexLocker lock( &cacheMutex );
+            done = ( m_cacheSize <= target );
+        }
+        if( !done && rd->evictCache() )
+            ++evicted;
+        release( rd );
+    }
+
+    m_cacheEvictions.fetchAndAddOrdered( evicted );
+    kDebug() << "Evicted" << evicted << "resource caches";
+
+    m_evicting = 0;
 }
 
 
@@ -167,23 +289,14 @@ void Nepomuk2::ResourceManagerPrivate::_k_dbusServiceUnregistered( const QString
 Nepomuk2::ResourceData* Nepomuk2::ResourceManagerPrivate::findData( const QUrl& uri )
 {
     if ( !uri.isEmpty() ) {
-        QMutexLocker lock( &mutex );
-
         if( uri.scheme() == QLatin1String("nepomuk") ) {
-            ResourceDataHash::iterator it = m_initializedData.find( uri );
-            if( it != m_initializedData.end() )
-                return it.value();
+            return m_initializedData.acquire( uri );
         }
         else if( uri.scheme().isEmpty() ) {
-            QString identifier = uri.toString();
-            QHash<QString, ResourceData*>::iterator it = m_identifierKickOff.find( identifier );
-            if( it != m_identifierKickOff.end() )
-                return it.value();
+            return m_identifierKickOff.acquire( uri.toString() );
         }
         else {
-            QHash<QUrl, ResourceData*>::iterator it = m_urlKickOff.find( uri );
-            if( it != m_urlKickOff.end() )
-                return it.value();
+            return m_urlKickOff.acquire( uri );
         }
     }
 
@@ -237,17 +350,17 @@ void Nepomuk2::ResourceManager::cleanupResources()
     // Ideally, all three caches should be empty when the ResourceManager is being destroyed
     // But that isn't always the case. There could be a Resource in a static object which gets
     // deleted after the ResourceManager.
-    // In order to counter that case, we mark all Resource classes as invalid.
+    // In order to counter that case, we empty all remaining ResourceData objects and
+    // keep them alive with an additional reference. The Resources using them do not
+    // know about it and would otherwise delete them with the ResourceManager gone.
     // The cache should be empty when the ResourceManager is getting destroyed
     // See bug 292996 - https://bugs.kde.org/show_bug.cgi?id=292996
     //
-    QMutexLocker lock( &d->mutex );
     QList<ResourceData*> rdList = d->m_identifierKickOff.values() + d->m_urlKickOff.values() +
                                   d->m_initializedData.values();
-    foreach( const ResourceData* rd, rdList.toSet() ) {
-        foreach(Resource* res, rd->resources())
-            res->m_data = 0;
-        delete rd;
+    foreach( ResourceData* rd, rdList.toSet() ) {
+        rd->ref();
+        rd->resetAll();
     }
 }
 
@@ -319,6 +432,87 @@ void Nepomuk2::ResourceManager::removeResource( const QString& uri )
     res.remove();
 }
 
+void Nepomuk2::ResourceManager::prefetch( const QList<Resource>& resources, const QList<QUrl>& properties )
+{
+    QList<ResourceData*> data;
+    QSet<ResourceData*> seen;
+    foreach( const Resource& res, resources ) {
+        ResourceData* rd = res.data();
+        if( !rd || rd->uri().isEmpty() || seen.contains( rd ) )
+            continue;
+        seen.insert( rd );
+
+        bool loaded = rd->isLoaded();
+        if( !loaded && !properties.isEmpty() ) {
+            loaded = true;
+            foreach( const QUrl& prop, properties ) {
+                if( !rd->isLoaded( prop ) ) {
+                    loaded = false;
+                    break;
+                }
+            }
+        }
+
+        if( !loaded )
+            data << rd;
+    }
+
+    if( !data.isEmpty() ) {
+        ResourceData::loadMultiple( d, data, properties );
+        d->evictCaches( data.toSet() );
+    }
+}
+
+
+void Nepomuk2::ResourceManager::setCacheBudget( qint64 bytes )
+{
+    {
+        QMutexLocker lock( &d->cacheMutex );
+        d->m_cacheBudget = qMax( qint64( 0 ), bytes );
+    }
+    d->evictCaches();
+}
+
+
+qint64 Nepomuk2::ResourceManager::cacheBudget() const
+{
+    QMutexLocker lock( &d->cacheMutex );
+    return d->m_cacheBudget;
+}
+
+
+qint64 Nepomuk2::ResourceManager::cacheSize() const
+{
+    QMutexLocker lock( &d->cacheMutex );
+    return d->m_cacheSize;
+}
+
+
+int Nepomuk2::ResourceManager::cacheEvictionCount() const
+{
+    return d->m_cacheEvictions;
+}
+
+
+int Nepomuk2::ResourceManager::cacheReloadCount() const
+{
+    return d->m_cacheReloads;
+}
+
+
+void Nepomuk2::ResourceManager::setHeavyProperties( const QList<QUrl>& properties )
+{
+    QMutexLocker lock( &d->cacheMutex );
+    d->m_heavyProperties = properties.toSet();
+}
+
+
+QList<QUrl> Nepomuk2::ResourceManager::heavyProperties() const
+{
+    return d->heavyProperties();
+}
+
+
 void Nepomuk2::ResourceManager::notifyError( const QString& uri, int errorCode )
 {
     kDebug() << "(Nepomuk2::ResourceManager) error: " << uri << " " << errorCode;
@@ -376,33 +570,27 @@ Soprano::Model* Nepomuk2::ResourceManager::mainModel()
 
 void Nepomuk2::ResourceManager::slotPropertyAdded(const Resource &res, const Types::Property &prop, const QVariant &value)
 {
-    QMutexLocker lock( &d->mutex );
-    ResourceDataHash::iterator it = d->m_initializedData.find(res.uri());
-    if(it != d->m_initializedData.end()) {
-        ResourceData* data = *it;
+    if( ResourceData* data = d->m_initializedData.acquire( res.uri() ) ) {
         data->propertyAdded(prop, value);
+        d->release( data );
     }
 }
 
 void Nepomuk2::ResourceManager::slotPropertyRemoved(const Resource &res, const Types::Property &prop, const QVariant &value_)
 {
-    QMutexLocker lock( &d->mutex );
-    ResourceDataHash::iterator it = d->m_initializedData.find(res.uri());
-    if(it != d->m_initializedData.end()) {
-        ResourceData* data = *it;
+    if( ResourceData* data = d->m_initializedData.acquire( res.uri() ) ) {
         data->propertyRemoved(prop, value_);
+        d->release( data );
     }
 }
 
 void Nepomuk2::ResourceManager::slotResourceRemoved(const QUrl& uri, const QList<QUrl>& )
 {
-    QMutexLocker lock( &d->mutex );
-    ResourceDataHash::iterator it = d->m_initializedData.find(uri);
-    if(it != d->m_initializedData.end()) {
-        ResourceData* data = *it;
+    if( ResourceData* data = d->m_initializedData.acquire( uri ) ) {
+        // resetAll() also removes the data from m_initializedData
         data->resetAll();
+        d->release( data );
     }
-    d->m_initializedData.remove(uri);
 }
 
 
@@ -414,8 +602,9 @@ void Nepomuk2::ResourceManager::setOverrideMainModel( Soprano::Model* model )
         d->overrideModel = model;
 
         // clear cache to make sure we do not mix data
-        Q_FOREACH( ResourceData* data, d->allResourceData()) {
+        Q_FOREACH( ResourceData* data, d->acquireAllResourceData()) {
             data->invalidateCache();
+            d->release( data );
         }
     }
 }
@@ -425,9 +614,7 @@ void Nepomuk2::ResourceManagerPrivate::addToWatcher( const QUrl& uri )
     if( uri.isEmpty() )
         return;
     // Lock the mutex, because the ResourceWatcher is not thread-safe.
-    // This should have a small impact, because a) it is not taking it for very long.
-    // b) the calling function in ResourceData will have to lock the mutex soon after this routine returns 
-    // to edit m_initializedData, so there is limited opportunities for parallelism.
+    // This should have a small impact, because it is not taking it for very long.
     QMutexLocker lock( &mutex );
     if( !m_watcher ) {
         m_watcher = new ResourceWatcher(m_manager);
@@ -25,6 +25,7 @@
 
 #include <QtCore/QObject>
 #include <QtCore/QUrl>
+#include <QtCore/QList>
 
 
 namespace Soprano {
@@ -113,6 +114,103 @@ namespace Nepomuk2 {
          */
         QUrl generateUniqueUri( const QString& label );
 
+        /**
+         * Load the properties of many resources at once.
+         *
+         * A Resource loads all its properties with one query on first access.
+         * When working with many resources, for example the results of a query,
+         * this adds up to one query per resource. Prefetching fills the caches of
+         * all \p resources with a few queries instead.
+         *
+         * Resources which have not been identified yet (for example those created
+         * from a file URL) and resources which are already cached are skipped.
+         *
+         * \param resources The resources to load.
+         * \param properties If not empty only these properties are loaded. Accessing
+         * any other property will load the resource as usual.
+         *
+         * \sa Query::ResultIterator
+         *
+         * \since 4.13
+         */
+        void prefetch( const QList<Resource>& resources, const QList<QUrl>& properties = QList<QUrl>() );
+
+        /**
+         * Limit the memory used to cache the properties of resources.
+         *
+         * Each Resource caches all its properties once they have been loaded and keeps
+         * them up to date until the last Resource instance referring to it is deleted.
+         * Applications which keep many resources around can limit the memory used
+         * by the caches. Once the budget is exceeded the caches of the resources which
+         * have not been used recently are dropped. The Resource objects stay valid and
+         * reload their properties on the next access.
+         *
+         * \param bytes The budget in bytes or 0 for no limit, the default.
+         *
+         * The size of the caches is an estimate.
+         *
+         * \sa cacheSize()
+         *
+         * \since 4.13
+         */
+        void setCacheBudget( qint64 bytes );
+
+        /**
+         * \return The budget set via setCacheBudget().
+         *
+         * \since 4.13
+         */
+        qint64 cacheBudget() const;
+
+        /**
+         * \return The estimated number of bytes used to cache resource properties.
+         *
+         * \since 4.13
+         */
+        qint64 cacheSize() const;
+
+        /**
+         * \return The number of resource caches which have been dropped to stay
+         * within the cache budget.
+         *
+         * \since 4.13
+         */
+        int cacheEvictionCount() const;
+
+        /**
+         * \return The number of resource caches which had to be reloaded after
+         * being dropped.
+         *
+         * \since 4.13
+         */
+        int cacheReloadCount() const;
+
+        /**
+         * Set the properties which are not loaded together with the other properties
+         * of a resource.
+         *
+         * Accessing any property of a Resource loads all its properties at once. Some
+         * properties can get huge, the most prominent example being the plain text
+         * content which the file indexer extracts from documents. Loading those only makes
+         * sense if they are actually needed. Heavy properties are thus only loaded when
+         * they are requested explicitly via Resource::property() or when all properties
+         * are requested via Resource::properties().
+         *
+         * By default nie:plainTextContent is the only heavy property.
+         *
+         * The change only affects resources loaded afterwards.
+         *
+         * \since 4.13
+         */
+        void setHeavyProperties( const QList<QUrl>& properties );
+
+        /**
+         * \return The properties set via setHeavyProperties().
+         *
+         * \since 4.13
+         */
+        QList<QUrl> heavyProperties() const;
+
         /**
          * \internal Non-public API. Used by Resource to signalize errors.
          */
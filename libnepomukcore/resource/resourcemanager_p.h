@@ -22,6 +22,10 @@
 #define _NEPOMUK2_RESOURCE_MANAGER_P_H_
 
 #include <QtCore/QMutex>
+#include <QtCore/QAtomicInt>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QHash>
+#include <QtCore/QSet>
 
 #include <kurl.h>
 
@@ -41,7 +45,115 @@ namespace Nepomuk2 {
     class MainModel;
     class ResourceWatcher;
 
-    typedef QHash<KUrl, ResourceData*> ResourceDataHash;
+    /**
+     * A hash of ResourceData objects which is split into several shards, each
+     * protected by its own mutex. This way threads which create, copy and destroy
+     * Resource objects for different resources hardly ever block each other.
+     *
+     * Lookups only return ResourceData objects which can still be referenced. An
+     * object whose reference count dropped to zero is about to be deleted and
+     * is treated as if it was not in the hash anymore.
+     *
+     * Nothing but the hash operations and the reference counting is done with a
+     * shard locked. Thus the shards may be locked with ResourceData::m_dataMutex held.
+     */
+    template<typename Key>
+    class ResourceDataShards
+    {
+    public:
+        /**
+         * \return The ResourceData stored for \p key with a reference added or 0
+         * if there is none.
+         */
+        ResourceData* acquire( const Key& key ) {
+            Shard& s = shard( key );
+            QMutexLocker lock( &s.mutex );
+            typename QHash<Key, ResourceData*>::const_iterator it = s.hash.constFind( key );
+            if( it != s.hash.constEnd() && it.value()->tryRef() )
+                return it.value();
+            return 0;
+        }
+
+        /**
+         * Inserts \p data unless another ResourceData is already stored for \p key.
+         * In that case the other one is returned with a reference added.
+         */
+        ResourceData* insertOrAcquire( const Key& key, ResourceData* data ) {
+            Shard& s = shard( key );
+            QMutexLocker lock( &s.mutex );
+            typename QHash<Key, ResourceData*>::const_iterator it = s.hash.constFind( key );
+            if( it != s.hash.constEnd() && it.value() != data && it.value()->tryRef() )
+                return it.value();
+            s.hash.insert( key, data );
+            return data;
+        }
+
+        void insert( const Key& key, ResourceData* data ) {
+            Shard& s = shard( key );
+            QMutexLocker lock( &s.mutex );
+            s.hash.insert( key, data );
+        }
+
+        /**
+         * Removes \p key only if it still maps to \p data. It might have been replaced
+         * by a new ResourceData while \p data was being deleted.
+         */
+        void remove( const Key& key, ResourceData* data ) {
+            Shard& s = shard( key );
+            QMutexLocker lock( &s.mutex );
+            typename QHash<Key, ResourceData*>::iterator it = s.hash.find( key );
+            if( it != s.hash.end() && it.value() == data )
+                s.hash.erase( it );
+        }
+
+        /**
+         * \return All stored ResourceData objects with a reference added for each.
+         */
+        QList<ResourceData*> acquireAll() {
+            QList<ResourceData*> list;
+            for( int i = 0; i < ShardCount; ++i ) {
+                QMutexLocker lock( &m_shards[i].mutex );
+                foreach( ResourceData* data, m_shards[i].hash ) {
+                    if( data->tryRef() )
+                        list << data;
+                }
+            }
+            return list;
+        }
+
+        /// Only safe to use if no other thread accesses the hash anymore
+        QList<ResourceData*> values() const {
+            QList<ResourceData*> list;
+            for( int i = 0; i < ShardCount; ++i ) {
+                QMutexLocker lock( &m_shards[i].mutex );
+                list << m_shards[i].hash.values();
+            }
+            return list;
+        }
+
+        bool isEmpty() const {
+            for( int i = 0; i < ShardCount; ++i ) {
+                QMutexLocker lock( &m_shards[i].mutex );
+                if( !m_shards[i].hash.isEmpty() )
+                    return false;
+            }
+            return true;
+        }
+
+    private:
+        enum { ShardCount = 16 };
+
+        struct Shard {
+            mutable QMutex mutex;
+            QHash<Key, ResourceData*> hash;
+        };
+
+        Shard& shard( const Key& key ) {
+            return m_shards[ qHash( key ) % ShardCount ];
+        }
+
+        Shard m_shards[ShardCount];
+    };
 
     class ResourceManagerPrivate
     {
@@ -54,17 +166,39 @@ namespace Nepomuk2 {
         /// used to protect the initialization
         QMutex initMutex;
 
-        /// used to protect all data in ResourceManager
+        /// used to protect the watcher and the model override. The ResourceData
+        /// caches below have their own locking.
         QMutex mutex;
 
         /// contains all initialized ResourceData object, i.e. all those which
         /// successfully ran determineUri()
-        ResourceDataHash m_initializedData;
+        ResourceDataShards<KUrl> m_initializedData;
 
         /// Maps the nie:url -> ResourceData*
-        QHash<QUrl, ResourceData*> m_urlKickOff;
+        ResourceDataShards<QUrl> m_urlKickOff;
         /// Maps the nao:identifier -> ResourceData* (Used in tags)
-        QHash<QString, ResourceData*> m_identifierKickOff;
+        ResourceDataShards<QString> m_identifierKickOff;
+
+        /// protects the cache accounting and configuration below. May be locked with ResourceData::m_dataMutex held.
+        QMutex cacheMutex;
+
+        /// the properties which are not part of a full ResourceData::load()
+        QSet<QUrl> m_heavyProperties;
+
+        /// all ResourceData objects which currently cache property values
+        QSet<ResourceData*> m_cachedData;
+
+        /// the estimated memory used by all ResourceData caches in bytes
+        qint64 m_cacheSize;
+
+        /// 0 for no limit
+        qint64 m_cacheBudget;
+
+        QAtomicInt m_cacheEvictions;
+        QAtomicInt m_cacheReloads;
+
+        /// set while one thread runs evictCaches()
+        QAtomicInt m_evicting;
 
         ResourceManager* m_manager;
 
@@ -76,7 +210,9 @@ namespace Nepomuk2 {
          * \param uriOrId The URI or identifier of the resource is question.
          * \type The type of the resource.
          *
-         * The Resource constructors use this method in combination with ref()
+         * \return The data with a reference added which is handed over to the caller.
+         *
+         * The Resource constructors use this method.
          */
         ResourceData* data( const QString& uriOrId, const QUrl& type );
 
@@ -89,7 +225,9 @@ namespace Nepomuk2 {
          * a QUrl object.
          * \type The type of the resource.
          *
-         * The Resource constructors use this method in combination with ref()
+         * \return The data with a reference added which is handed over to the caller.
+         *
+         * The Resource constructors use this method.
          */
         ResourceData* data( const QUrl& uri, const QUrl& type );
 
@@ -99,9 +237,33 @@ namespace Nepomuk2 {
          */
         ResourceData* dataForResourceUri( const QUrl& uri, const QUrl& type );
 
-        bool shouldBeDeleted( ResourceData* rd ) const;
+        /**
+         * Drops a reference and deletes \p rd if it was the last one.
+         */
+        void release( ResourceData* rd );
+
+        /**
+         * \return All ResourceData objects, each with a reference which needs to be
+         * dropped via release().
+         */
+        QSet<ResourceData*> acquireAllResourceData();
+
+        QList<QUrl> heavyProperties();
+        bool isHeavyProperty( const QUrl& property );
 
-        QSet<ResourceData*> allResourceData();
+        /**
+         * Called by ResourceData whenever the estimated size of its cache changed.
+         */
+        void cacheSizeChanged( ResourceData* rd, qint64 oldSize, qint64 newSize );
+
+        /**
+         * Drops the property caches of ResourceData objects which have not been
+         * used recently until the cache is well below m_cacheBudget again.
+         * The data in \p keep, typically the one which has just been loaded
+         * for the caller, is left alone.
+         * Must not be called with any ResourceData mutex held.
+         */
+        void evictCaches( const QSet<ResourceData*>& keep = QSet<ResourceData*>() );
 
         void _k_storageServiceInitialized( bool );
         void _k_dbusServiceUnregistered( const QString& serviceName );
@@ -111,6 +273,7 @@ namespace Nepomuk2 {
 
     private:
         ResourceData* findData( const QUrl& uri );
+        ResourceData* createData( const QUrl& uri, const QUrl& kickOffUri, const QUrl& type );
         ResourceWatcher* m_watcher;
     };
 }
@@ -28,256 +28,360 @@
 #include <kdebug.h>
 
 #include <QtCore/QVariant>
+#include <QtCore/QSharedData>
 
 
 namespace {
     template<typename T1, typename T2> QList<T2> convertList( const QList<T1>& l ) {
         QList<T2> il;
+        il.reserve( l.count() );
         for( int i = 0; i < l.count(); ++i ) {
             il.append( static_cast<T2>( l[i] ) );
         }
         return il;
     }
+
+    /// QStringList is the only list type which is not registered as QList<T>
+    template<typename T> int listTypeId() {
+        return qMetaTypeId<QList<T> >();
+    }
+    template<> int listTypeId<QString>() {
+        return QVariant::StringList;
+    }
+
+    /// Direct access to a scalar stored in \p v which needs to be of type T
+    template<typename T> const T& scalarValue( const QVariant& v ) {
+        return *static_cast<const T*>( v.constData() );
+    }
+
+    /// Direct access to a list stored in \p v which needs to be of type QList<T>
+    template<typename T> const QList<T>& listValue( const QVariant& v ) {
+        return *static_cast<const QList<T>*>( v.constData() );
+    }
+
+    /// Copies the first value of the list in \p v into \p result
+    template<typename T, typename ListT> bool firstValue( const QVariant& v, T& result ) {
+        const QList<ListT>& l = listValue<ListT>( v );
+        if( l.isEmpty() )
+            return false;
+        result = static_cast<T>( l.first() );
+        return true;
+    }
+
+    /**
+     * Compares two values of the same simple type T, each of which is
+     * either a single value or a list. A single value equals a list with only
+     * that value.
+     */
+    template<typename T> bool valuesEqual( const QVariant& v1, bool list1, const QVariant& v2, bool list2 ) {
+        if( !list1 && !list2 )
+            return scalarValue<T>( v1 ) == scalarValue<T>( v2 );
+        else if( list1 && list2 )
+            return listValue<T>( v1 ) == listValue<T>( v2 );
+
+        const QList<T>& l = listValue<T>( list1 ? v1 : v2 );
+        return l.count() == 1 && l.first() == scalarValue<T>( list1 ? v2 : v1 );
+    }
+
+    /// Copies the first value of an integer list in \p v into \p result
+    template<typename T> bool firstNumber( const QVariant& v, int simpleType, T& result ) {
+        switch( simpleType ) {
+        case QVariant::Int:
+            return firstValue<T, int>( v, result );
+        case QVariant::LongLong:
+            return firstValue<T, qlonglong>( v, result );
+        case QVariant::UInt:
+            return firstValue<T, uint>( v, result );
+        case QVariant::ULongLong:
+            return firstValue<T, qulonglong>( v, result );
+        default:
+            return false;
+        }
+    }
+
+    template<typename T> QList<Nepomuk2::Variant> toVariants( const QList<T>& l ) {
+        QList<Nepomuk2::Variant> vl;
+        vl.reserve( l.count() );
+        for( int i = 0; i < l.count(); ++i ) {
+            vl.append( Nepomuk2::Variant( l[i] ) );
+        }
+        return vl;
+    }
+
+    /// \return The type of the values in a list of type \p type or QVariant::Invalid if \p type is no list
+    int listValueType( int type ) {
+        if( type == QVariant::StringList )
+            return QVariant::String;
+        else if( type == qMetaTypeId<QList<int> >() )
+            return QVariant::Int;
+        else if( type == qMetaTypeId<QList<qlonglong> >() )
+            return QVariant::LongLong;
+        else if( type == qMetaTypeId<QList<uint> >() )
+            return QVariant::UInt;
+        else if( type == qMetaTypeId<QList<qulonglong> >() )
+            return QVariant::ULongLong;
+        else if( type == qMetaTypeId<QList<bool> >() )
+            return QVariant::Bool;
+        else if( type == qMetaTypeId<QList<double> >() )
+            return QVariant::Double;
+        else if( type == qMetaTypeId<QList<QDate> >() )
+            return QVariant::Date;
+        else if( type == qMetaTypeId<QList<QTime> >() )
+            return QVariant::Time;
+        else if( type == qMetaTypeId<QList<QDateTime> >() )
+            return QVariant::DateTime;
+        else if( type == qMetaTypeId<QList<QUrl> >() )
+            return QVariant::Url;
+        else if( type == qMetaTypeId<QList<Nepomuk2::Resource> >() )
+            return qMetaTypeId<Nepomuk2::Resource>();
+        else
+            return QVariant::Invalid;
+    }
+
+    bool isSupportedScalarType( int type ) {
+        return( type == QVariant::Int ||
+                type == QVariant::LongLong ||
+                type == QVariant::UInt ||
+                type == QVariant::ULongLong ||
+                type == QVariant::Bool ||
+                type == QVariant::Double ||
+                type == QVariant::String ||
+                type == QVariant::Date ||
+                type == QVariant::Time ||
+                type == QVariant::DateTime ||
+                type == QVariant::Url ||
+                type == qMetaTypeId<Nepomuk2::Resource>() );
+    }
 }
 
 
-class Nepomuk2::Variant::Private
+/*
+ * The value is immutable once created and shared between copies of a Variant.
+ * Scalars live directly in the QVariant, lists are stored as one QList which
+ * is only copied when a shared Variant is modified. The type information which
+ * is needed by all the accessors is determined once on construction.
+ */
+class Nepomuk2::Variant::Private : public QSharedData
 {
 public:
+    Private()
+        : simpleType( QVariant::Invalid ),
+          list( false ) {
+    }
+
+    explicit Private( const QVariant& v )
+        : value( v ) {
+        const int type = value.userType();
+        simpleType = listValueType( type );
+        list = ( simpleType != QVariant::Invalid );
+        if( !list )
+            simpleType = type;
+    }
+
+    /**
+     * Appends \p values in place. The value needs to be of type QList<T>.
+     */
+    template<typename T> void appendValues( const QList<T>& values ) {
+        Q_ASSERT( value.userType() == listTypeId<T>() );
+        *static_cast<QList<T>*>( value.data() ) += values;
+    }
+
+    template<typename T> void appendValue( const T& v ) {
+        Q_ASSERT( value.userType() == listTypeId<T>() );
+        static_cast<QList<T>*>( value.data() )->append( v );
+    }
+
     QVariant value;
+    int simpleType;
+    bool list;
 };
 
 
 Nepomuk2::Variant::Variant()
-    : d( new Private )
 {
+    // All invalid Variants share the same data
+    static QSharedDataPointer<Private> s_invalid( new Private );
+    d = s_invalid;
 }
 
 
 Nepomuk2::Variant::~Variant()
 {
-    delete d;
 }
 
 
 Nepomuk2::Variant::Variant( const Variant& other )
-    : d( new Private )
+    : d( other.d )
 {
-    operator=( other );
 }
 
 
 Nepomuk2::Variant::Variant( const QVariant& other )
-    : d( new Private )
-{
-    if ( other.userType() == QVariant::Int ||
-         other.userType() == QVariant::LongLong ||
-         other.userType() == QVariant::UInt ||
-         other.userType() == QVariant::ULongLong ||
-         other.userType() == QVariant::Bool ||
-         other.userType() == QVariant::Double ||
-         other.userType() == QVariant::String ||
-         other.userType() == QVariant::Date ||
-         other.userType() == QVariant::Time ||
-         other.userType() == QVariant::DateTime ||
-         other.userType() == QVariant::Url ||
-         other.userType() == qMetaTypeId<Resource>() ||
-         other.userType() == qMetaTypeId<QList<int> >() ||
-         other.userType() == qMetaTypeId<QList<qlonglong> >() ||
-         other.userType() == qMetaTypeId<QList<uint> >() ||
-         other.userType() == qMetaTypeId<QList<qulonglong> >() ||
-         other.userType() == qMetaTypeId<QList<bool> >() ||
-         other.userType() == qMetaTypeId<QList<double> >() ||
-         other.userType() == QVariant::StringList ||
-         other.userType() == qMetaTypeId<QList<QDate> >() ||
-         other.userType() == qMetaTypeId<QList<QTime> >() ||
-         other.userType() == qMetaTypeId<QList<QDateTime> >() ||
-         other.userType() == qMetaTypeId<QList<QUrl> >() ||
-         other.userType() == qMetaTypeId<QList<Resource> >() ) {
-        d->value = other;
+{
+    const int type = other.userType();
+    if ( isSupportedScalarType( type ) || listValueType( type ) != QVariant::Invalid ) {
+        d = new Private( other );
+    }
+    else {
+        d = Variant().d;
     }
 }
 
 
 Nepomuk2::Variant::Variant( int i )
-    : d( new Private )
+    : d( new Private( qVariantFromValue( i ) ) )
 {
-    d->value.setValue( i );
 }
 
 
 Nepomuk2::Variant::Variant( qlonglong i )
-    : d( new Private )
+    : d( new Private( qVariantFromValue( i ) ) )
 {
-    d->value.setValue( i );
 }
 
 
 Nepomuk2::Variant::Variant( uint i )
-    : d( new Private )
+    : d( new Private( qVariantFromValue( i ) ) )
 {
-    d->value.setValue( i );
 }
 
 
 Nepomuk2::Variant::Variant( qulonglong i )
-    : d( new Private )
+    : d( new Private( qVariantFromValue( i ) ) )
 {
-    d->value.setValue( i );
 }
 
 
 Nepomuk2::Variant::Variant( bool b )
-    : d( new Private )
+    : d( new Private( qVariantFromValue( b ) ) )
 {
-    d->value.setValue( b );
 }
 
 
 Nepomuk2::Variant::Variant( double v )
-    : d( new Private )
+    : d( new Private( qVariantFromValue( v ) ) )
 {
-    d->value.setValue( v );
 }
 
 
 Nepomuk2::Variant::Variant( const char* string )
-    : d( new Private )
+    : d( new Private( qVariantFromValue( QString::fromLatin1(string) ) ) )
 {
-    d->value.setValue( QString::fromLatin1(string) );
 }
 
 
 Nepomuk2::Variant::Variant( const QString& string )
-    : d( new Private )
+    : d( new Private( qVariantFromValue( string ) ) )
 {
-    d->value.setValue( string );
 }
 
 
 Nepomuk2::Variant::Variant( const QDate& date )
-    : d( new Private )
+    : d( new Private( qVariantFromValue( date ) ) )
 {
-    d->value.setValue( date );
 }
 
 
 Nepomuk2::Variant::Variant( const QTime& time )
-    : d( new Private )
+    : d( new Private( qVariantFromValue( time ) ) )
 {
-    d->value.setValue( time );
 }
 
 
 Nepomuk2::Variant::Variant( const QDateTime& datetime )
-    : d( new Private )
+    : d( new Private( qVariantFromValue( datetime ) ) )
 {
-    d->value.setValue( datetime );
 }
 
 
 Nepomuk2::Variant::Variant( const QUrl& url )
-    : d( new Private )
+    : d( new Private( qVariantFromValue( url ) ) )
 {
-    d->value.setValue( url );
 }
 
 
 Nepomuk2::Variant::Variant( const Nepomuk2::Resource& r )
-    : d( new Private )
+    : d( new Private( qVariantFromValue( r ) ) )
 {
-    d->value.setValue( r );
 }
 
 
 Nepomuk2::Variant::Variant( const QList<int>& i )
-    : d( new Private )
+    : d( new Private( qVariantFromValue( i ) ) )
 {
-    d->value.setValue( i );
 }
 
 
 Nepomuk2::Variant::Variant( const QList<qlonglong>& i )
-    : d( new Private )
+    : d( new Private( qVariantFromValue( i ) ) )
 {
-    d->value.setValue( i );
 }
 
 
 Nepomuk2::Variant::Variant( const QList<uint>& i )
-    : d( new Private )
+    : d( new Private( qVariantFromValue( i ) ) )
 {
-    d->value.setValue( i );
 }
 
 
 Nepomuk2::Variant::Variant( const QList<qulonglong>& i )
-    : d( new Private )
+    : d( new Private( qVariantFromValue( i ) ) )
 {
-    d->value.setValue( i );
 }
 
 
 Nepomuk2::Variant::Variant( const QList<bool>& b )
-    : d( new Private )
+    : d( new Private( qVariantFromValue( b ) ) )
 {
-    d->value.setValue( b );
 }
 
 
 Nepomuk2::Variant::Variant( const QList<double>& v )
-    : d( new Private )
+    : d( new Private( qVariantFromValue( v ) ) )
 {
-    d->value.setValue( v );
 }
 
 
 Nepomuk2::Variant::Variant( const QStringList& stringlist )
-    : d( new Private )
+    : d( new Private( qVariantFromValue( stringlist ) ) )
 {
-    d->value.setValue( stringlist );
 }
 
 
 Nepomuk2::Variant::Variant( const QList<QDate>& date )
-    : d( new Private )
+    : d( new Private( qVariantFromValue( date ) ) )
 {
-    d->value.setValue( date );
 }
 
 
 Nepomuk2::Variant::Variant( const QList<QTime>& time )
-    : d( new Private )
+    : d( new Private( qVariantFromValue( time ) ) )
 {
-    d->value.setValue( time );
 }
 
 
 Nepomuk2::Variant::Variant( const QList<QDateTime>& datetime )
-    : d( new Private )
+    : d( new Private( qVariantFromValue( datetime ) ) )
 {
-    d->value.setValue( datetime );
 }
 
 
 Nepomuk2::Variant::Variant( const QList<QUrl>& url )
-    : d( new Private )
+    : d( new Private( qVariantFromValue( url ) ) )
 {
-    d->value.setValue( url );
 }
 
 
 
 Nepomuk2::Variant::Variant( const QList<Resource>& r )
-    : d( new Private )
+    : d( new Private( qVariantFromValue( r ) ) )
 {
-    d->value.setValue( r );
 }
 
 
 Nepomuk2::Variant::Variant( const QList<Variant>& vl )
-    : d( new Private )
 {
+    d = Variant().d;
     foreach( const Variant& v, vl ) {
         append( v );
     }
@@ -286,273 +390,334 @@ Nepomuk2::Variant::Variant( const QList<Variant>& vl )
 
 Nepomuk2::Variant& Nepomuk2::Variant::operator=( const Variant& v )
 {
-    d->value = v.d->value;
+    d = v.d;
     return *this;
 }
 
 
 Nepomuk2::Variant& Nepomuk2::Variant::operator=( int i )
 {
-    d->value.setValue( i );
+    d = new Private( qVariantFromValue( i ) );
     return *this;
 }
 
 
 Nepomuk2::Variant& Nepomuk2::Variant::operator=( qlonglong i )
 {
-    d->value.setValue( i );
+    d = new Private( qVariantFromValue( i ) );
     return *this;
 }
 
 
 Nepomuk2::Variant& Nepomuk2::Variant::operator=( uint i )
 {
-    d->value.setValue( i );
+    d = new Private( qVariantFromValue( i ) );
     return *this;
 }
 
 
 Nepomuk2::Variant& Nepomuk2::Variant::operator=( qulonglong i )
 {
-    d->value.setValue( i );
+    d = new Private( qVariantFromValue( i ) );
     return *this;
 }
 
 
 Nepomuk2::Variant& Nepomuk2::Variant::operator=( bool b )
 {
-    d->value.setValue( b );
+    d = new Private( qVariantFromValue( b ) );
     return *this;
 }
 
 
 Nepomuk2::Variant& Nepomuk2::Variant::operator=( double v )
 {
-    d->value.setValue( v );
+    d = new Private( qVariantFromValue( v ) );
     return *this;
 }
 
 
 Nepomuk2::Variant& Nepomuk2::Variant::operator=( const QString& string )
 {
-    d->value.setValue( string );
+    d = new Private( qVariantFromValue( string ) );
     return *this;
 }
 
 
 Nepomuk2::Variant& Nepomuk2::Variant::operator=( const QDate& date )
 {
-    d->value.setValue( date );
+    d = new Private( qVariantFromValue( date ) );
     return *this;
 }
 
 
 Nepomuk2::Variant& Nepomuk2::Variant::operator=( const QTime& time )
 {
-    d->value.setValue( time );
+    d = new Private( qVariantFromValue( time ) );
     return *this;
 }
 
 
 Nepomuk2::Variant& Nepomuk2::Variant::operator=( const QDateTime& datetime )
 {
-    d->value.setValue( datetime );
+    d = new Private( qVariantFromValue( datetime ) );
     return *this;
 }
 
 
 Nepomuk2::Variant& Nepomuk2::Variant::operator=( const QUrl& url )
 {
-    d->value.setValue( url );
+    d = new Private( qVariantFromValue( url ) );
     return *this;
 }
 
 
 Nepomuk2::Variant& Nepomuk2::Variant::operator=( const Resource& r )
 {
-    d->value.setValue( r );
+    d = new Private( qVariantFromValue( r ) );
     return *this;
 }
 
 
 Nepomuk2::Variant& Nepomuk2::Variant::operator=( const QList<int>& i )
 {
-    d->value.setValue( i );
+    d = new Private( qVariantFromValue( i ) );
     return *this;
 }
 
 
 Nepomuk2::Variant& Nepomuk2::Variant::operator=( const QList<qlonglong>& i )
 {
-    d->value.setValue( i );
+    d = new Private( qVariantFromValue( i ) );
     return *this;
 }
 
 
 Nepomuk2::Variant& Nepomuk2::Variant::operator=( const QList<uint>& i )
 {
-    d->value.setValue( i );
+    d = new Private( qVariantFromValue( i ) );
     return *this;
 }
 
 
 Nepomuk2::Variant& Nepomuk2::Variant::operator=( const QList<qulonglong>& i )
 {
-    d->value.setValue( i );
+    d = new Private( qVariantFromValue( i ) );
     return *this;
 }
 
 
 Nepomuk2::Variant& Nepomuk2::Variant::operator=( const QList<bool>& b )
 {
-    d->value.setValue( b );
+    d = new Private( qVariantFromValue( b ) );
     return *this;
 }
 
 
 Nepomuk2::Variant& Nepomuk2::Variant::operator=( const QList<double>& v )
 {
-    d->value.setValue( v );
+    d = new Private( qVariantFromValue( v ) );
     return *this;
 }
 
 
 Nepomuk2::Variant& Nepomuk2::Variant::operator=( const QStringList& stringlist )
 {
-    d->value.setValue( stringlist );
+    d = new Private( qVariantFromValue( stringlist ) );
     return *this;
 }
 
 
 Nepomuk2::Variant& Nepomuk2::Variant::operator=( const QList<QDate>& date )
 {
-    d->value.setValue( date );
+    d = new Private( qVariantFromValue( date ) );
     return *this;
 }
 
 
 Nepomuk2::Variant& Nepomuk2::Variant::operator=( const QList<QTime>& time )
 {
-    d->value.setValue( time );
+    d = new Private( qVariantFromValue( time ) );
     return *this;
 }
 
 
 Nepomuk2::Variant& Nepomuk2::Variant::operator=( const QList<QDateTime>& datetime )
 {
-    d->value.setValue( datetime );
+    d = new Private( qVariantFromValue( datetime ) );
     return *this;
 }
 
 
 Nepomuk2::Variant& Nepomuk2::Variant::operator=( const QList<QUrl>& url )
 {
-    d->value.setValue( url );
+    d = new Private( qVariantFromValue( url ) );
     return *this;
 }
 
 
 Nepomuk2::Variant& Nepomuk2::Variant::operator=( const QList<Resource>& r )
 {
-    d->value.setValue( r );
+    d = new Private( qVariantFromValue( r ) );
     return *this;
 }
 
 
 void Nepomuk2::Variant::append( int i )
 {
-    QList<int> l = toIntList();
-    l.append( i );
-    operator=( l );
+    if( isIntList() ) {
+        d->appendValue( i );
+    }
+    else {
+        QList<int> l = toIntList();
+        l.append( i );
+        operator=( l );
+    }
 }
 
 
 void Nepomuk2::Variant::append( qlonglong i )
 {
-    QList<qlonglong> l = toInt64List();
-    l.append( i );
-    operator=( l );
+    if( isInt64List() ) {
+        d->appendValue( i );
+    }
+    else {
+        QList<qlonglong> l = toInt64List();
+        l.append( i );
+        operator=( l );
+    }
 }
 
 
 void Nepomuk2::Variant::append( uint i )
 {
-    QList<uint> l = toUnsignedIntList();
-    l.append( i );
-    operator=( l );
+    if( isUnsignedIntList() ) {
+        d->appendValue( i );
+    }
+    else {
+        QList<uint> l = toUnsignedIntList();
+        l.append( i );
+        operator=( l );
+    }
 }
 
 
 void Nepomuk2::Variant::append( qulonglong i )
 {
-    QList<qulonglong> l = toUnsignedInt64List();
-    l.append( i );
-    operator=( l );
+    if( isUnsignedInt64List() ) {
+        d->appendValue( i );
+    }
+    else {
+        QList<qulonglong> l = toUnsignedInt64List();
+        l.append( i );
+        operator=( l );
+    }
 }
 
 
 void Nepomuk2::Variant::append( bool b )
 {
-    QList<bool> l = toBoolList();
-    l.append( b );
-    operator=( l );
+    if( isBoolList() ) {
+        d->appendValue( b );
+    }
+    else {
+        QList<bool> l = toBoolList();
+        l.append( b );
+        operator=( l );
+    }
 }
 
 
-void Nepomuk2::Variant::append( double d )
+void Nepomuk2::Variant::append( double v )
 {
-    QList<double> l = toDoubleList();
-    l.append( d );
-    operator=( l );
+    if( isDoubleList() ) {
+        d->appendValue( v );
+    }
+    else {
+        QList<double> l = toDoubleList();
+        l.append( v );
+        operator=( l );
+    }
 }
 
 
 void Nepomuk2::Variant::append( const QString& string )
 {
-    QStringList l = toStringList();
-    l.append( string );
-    operator=( l );
+    if( isStringList() ) {
+        d->appendValue( string );
+    }
+    else {
+        QStringList l = toStringList();
+        l.append( string );
+        operator=( l );
+    }
 }
 
 
 void Nepomuk2::Variant::append( const QDate& date )
 {
-    QList<QDate> l = toDateList();
-    l.append( date );
-    operator=( l );
+    if( isDateList() ) {
+        d->appendValue( date );
+    }
+    else {
+        QList<QDate> l = toDateList();
+        l.append( date );
+        operator=( l );
+    }
 }
 
 
 void Nepomuk2::Variant::append( const QTime& time )
 {
-    QList<QTime> l = toTimeList();
-    l.append( time );
-    operator=( l );
+    if( isTimeList() ) {
+        d->appendValue( time );
+    }
+    else {
+        QList<QTime> l = toTimeList();
+        l.append( time );
+        operator=( l );
+    }
 }
 
 
 void Nepomuk2::Variant::append( const QDateTime& datetime )
 {
-    QList<QDateTime> l = toDateTimeList();
-    l.append( datetime );
-    operator=( l );
+    if( isDateTimeList() ) {
+        d->appendValue( datetime );
+    }
+    else {
+        QList<QDateTime> l = toDateTimeList();
+        l.append( datetime );
+        operator=( l );
+    }
 }
 
 
 void Nepomuk2::Variant::append( const QUrl& url )
 {
-    QList<QUrl> l = toUrlList();
-    l.append( url );
-    operator=( l );
+    if( isUrlList() ) {
+        d->appendValue( url );
+    }
+    else {
+        QList<QUrl> l = toUrlList();
+        l.append( url );
+        operator=( l );
+    }
 }
 
 
 void Nepomuk2::Variant::append( const Resource& r )
 {
-    QList<Resource> l = toResourceList();
-    if ( !l.contains( r ) ) {
-        l.append( r );
-        operator=( l );
+    if( type() == qMetaTypeId<QList<Resource> >() ) {
+        if( !listValue<Resource>( d.constData()->value ).contains( r ) )
+            d->appendValue( r );
+    }
+    else {
+        QList<Resource> l = toResourceList();
+        if ( !l.contains( r ) ) {
+            l.append( r );
+            operator=( l );
+        }
     }
 }
 
@@ -563,41 +728,78 @@ void Nepomuk2::Variant::append( const Variant& v )
         operator=( v );
     }
     else {
+        // Lists of the same type are extended in place, everything else is converted
         if( v.simpleType() == QVariant::Int ) {
-            operator=( toIntList() += v.toIntList() );
+            if( isIntList() )
+                d->appendValues( v.toIntList() );
+            else
+                operator=( toIntList() += v.toIntList() );
         }
         else if( v.simpleType() == QVariant::UInt ) {
-            operator=( toUnsignedIntList() += v.toUnsignedIntList() );
+            if( isUnsignedIntList() )
+                d->appendValues( v.toUnsignedIntList() );
+            else
+                operator=( toUnsignedIntList() += v.toUnsignedIntList() );
         }
         else if( v.simpleType() == QVariant::LongLong ) {
-            operator=( toInt64List() += v.toInt64List() );
+            if( isInt64List() )
+                d->appendValues( v.toInt64List() );
+            else
+                operator=( toInt64List() += v.toInt64List() );
         }
         else if( v.simpleType() == QVariant::ULongLong ) {
-            operator=( toUnsignedInt64List() += v.toUnsignedInt64List() );
+            if( isUnsignedInt64List() )
+                d->appendValues( v.toUnsignedInt64List() );
+            else
+                operator=( toUnsignedInt64List() += v.toUnsignedInt64List() );
         }
         else if( v.simpleType() == QVariant::Bool ) {
-            operator=( toBoolList() += v.toBoolList() );
+            if( isBoolList() )
+                d->appendValues( v.toBoolList() );
+            else
+                operator=( toBoolList() += v.toBoolList() );
         }
         else if( v.simpleType() == QVariant::Double ) {
-            operator=( toDoubleList() += v.toDoubleList() );
+            if( isDoubleList() )
+                d->appendValues( v.toDoubleList() );
+            else
+                operator=( toDoubleList() += v.toDoubleList() );
         }
         else if( v.simpleType() == QVariant::String ) {
-            operator=( toStringList() += v.toStringList() );
+            if( isStringList() )
+                d->appendValues<QString>( v.toStringList() );
+            else
+                operator=( toStringList() += v.toStringList() );
         }
         else if( v.simpleType() == QVariant::Date ) {
-            operator=( toDateList() += v.toDateList() );
+            if( isDateList() )
+                d->appendValues( v.toDateList() );
+            else
+                operator=( toDateList() += v.toDateList() );
         }
         else if( v.simpleType() == QVariant::Time ) {
-            operator=( toTimeList() += v.toTimeList() );
+            if( isTimeList() )
+                d->appendValues( v.toTimeList() );
+            else
+                operator=( toTimeList() += v.toTimeList() );
         }
         else if( v.simpleType() == QVariant::DateTime ) {
-            operator=( toDateTimeList() += v.toDateTimeList() );
+            if( isDateTimeList() )
+                d->appendValues( v.toDateTimeList() );
+            else
+                operator=( toDateTimeList() += v.toDateTimeList() );
         }
         else if( v.simpleType() == QVariant::Url ) {
-            operator=( toUrlList() += v.toUrlList() );
+            if( isUrlList() )
+                d->appendValues( v.toUrlList() );
+            else
+                operator=( toUrlList() += v.toUrlList() );
         }
         else if( v.simpleType() == qMetaTypeId<Resource>() ) {
-            operator=( toResourceList() += v.toResourceList() );
+            if( type() == qMetaTypeId<QList<Resource> >() )
+                d->appendValues( v.toResourceList() );
+            else
+                operator=( toResourceList() += v.toResourceList() );
         }
         else
             kDebug() << "(Variant::append) unknown type: " << v.simpleType();
@@ -680,37 +882,37 @@ bool Nepomuk2::Variant::isResource() const
 
 bool Nepomuk2::Variant::isIntList() const
 {
-    return( type() == qMetaTypeId<QList<int> >() );
+    return( d->list && d->simpleType == QVariant::Int );
 }
 
 
 bool Nepomuk2::Variant::isUnsignedIntList() const
 {
-    return( type() == qMetaTypeId<QList<uint> >() );
+    return( d->list && d->simpleType == QVariant::UInt );
 }
 
 
 bool Nepomuk2::Variant::isInt64List() const
 {
-    return( type() == qMetaTypeId<QList<qlonglong> >() );
+    return( d->list && d->simpleType == QVariant::LongLong );
 }
 
 
 bool Nepomuk2::Variant::isUnsignedInt64List() const
 {
-    return( type() == qMetaTypeId<QList<qulonglong> >() );
+    return( d->list && d->simpleType == QVariant::ULongLong );
 }
 
 
 bool Nepomuk2::Variant::isBoolList() const
 {
-    return( type() == qMetaTypeId<QList<bool> >() );
+    return( d->list && d->simpleType == QVariant::Bool );
 }
 
 
 bool Nepomuk2::Variant::isDoubleList() const
 {
-    return( type() == qMetaTypeId<QList<double> >() );
+    return( d->list && d->simpleType == QVariant::Double );
 }
 
 
@@ -722,43 +924,42 @@ bool Nepomuk2::Variant::isStringList() const
 
 bool Nepomuk2::Variant::isDateList() const
 {
-    return( type() == qMetaTypeId<QList<QDate> >() );
+    return( d->list && d->simpleType == QVariant::Date );
 }
 
 
 bool Nepomuk2::Variant::isTimeList() const
 {
-    return( type() == qMetaTypeId<QList<QTime> >() );
+    return( d->list && d->simpleType == QVariant::Time );
 }
 
 
 bool Nepomuk2::Variant::isDateTimeList() const
 {
-    return( type() == qMetaTypeId<QList<QDateTime> >() );
+    return( d->list && d->simpleType == QVariant::DateTime );
 }
 
 
 bool Nepomuk2::Variant::isUrlList() const
 {
-    return( type() == qMetaTypeId<QList<QUrl> >() );
+    return( d->list && d->simpleType == QVariant::Url );
 }
 
 
 bool Nepomuk2::Variant::isResourceList() const
 {
-    return( type() == qMetaTypeId<QList<Resource> >() ||
-            isUrlList() );
+    return( d->list &&
+            ( d->simpleType == qMetaTypeId<Resource>() ||
+              d->simpleType == QVariant::Url ) );
 }
 
 
 
 int Nepomuk2::Variant::toInt() const
 {
-    if(isList()) {
-        QList<int> l = toIntList();
-        if(!l.isEmpty())
-            return l.first();
-    }
+    int i = 0;
+    if( d->list && firstNumber( d->value, d->simpleType, i ) )
+        return i;
 
     return d->value.toInt();
 }
@@ -766,11 +967,9 @@ int Nepomuk2::Variant::toInt() const
 
 qlonglong Nepomuk2::Variant::toInt64() const
 {
-    if(isList()) {
-        QList<qlonglong> l = toInt64List();
-        if(!l.isEmpty())
-            return l.first();
-    }
+    qlonglong i = 0;
+    if( d->list && firstNumber( d->value, d->simpleType, i ) )
+        return i;
 
     return d->value.toLongLong();
 }
@@ -778,11 +977,9 @@ qlonglong Nepomuk2::Variant::toInt64() const
 
 uint Nepomuk2::Variant::toUnsignedInt() const
 {
-    if(isList()) {
-        QList<uint> l = toUnsignedIntList();
-        if(!l.isEmpty())
-            return l.first();
-    }
+    uint i = 0;
+    if( d->list && firstNumber( d->value, d->simpleType, i ) )
+        return i;
 
     return d->value.toUInt();
 }
@@ -790,11 +987,9 @@ uint Nepomuk2::Variant::toUnsignedInt() const
 
 qulonglong Nepomuk2::Variant::toUnsignedInt64() const
 {
-    if(isList()) {
-        QList<qulonglong> l = toUnsignedInt64List();
-        if(!l.isEmpty())
-            return l.first();
-    }
+    qulonglong i = 0;
+    if( d->list && firstNumber( d->value, d->simpleType, i ) )
+        return i;
 
     return d->value.toULongLong();
 }
@@ -802,11 +997,9 @@ qulonglong Nepomuk2::Variant::toUnsignedInt64() const
 
 bool Nepomuk2::Variant::toBool() const
 {
-    if(isList()) {
-        QList<bool> l = toBoolList();
-        if(!l.isEmpty())
-            return l.first();
-    }
+    bool b = false;
+    if( isBoolList() && firstValue<bool, bool>( d->value, b ) )
+        return b;
 
     return d->value.toBool();
 }
@@ -814,11 +1007,9 @@ bool Nepomuk2::Variant::toBool() const
 
 double Nepomuk2::Variant::toDouble() const
 {
-    if(isList()) {
-        QList<double> l = toDoubleList();
-        if(!l.isEmpty())
-            return l.first();
-    }
+    double v = 0.0;
+    if( isDoubleList() && firstValue<double, double>( d->value, v ) )
+        return v;
 
     return d->value.toDouble();
 }
@@ -859,46 +1050,48 @@ QString Nepomuk2::Variant::toString() const
 
 QDate Nepomuk2::Variant::toDate() const
 {
-    if(isList()) {
-        QList<QDate> l = toDateList();
-        if(!l.isEmpty())
-            return l.first();
-    }
+    QDate date;
+    if( isDateList() && firstValue<QDate, QDate>( d->value, date ) )
+        return date;
+
     return d->value.toDate();
 }
 
 
 QTime Nepomuk2::Variant::toTime() const
 {
-    if(isList()) {
-        QList<QTime> l = toTimeList();
-        if(!l.isEmpty())
-            return l.first();
-    }
+    QTime time;
+    if( isTimeList() && firstValue<QTime, QTime>( d->value, time ) )
+        return time;
+
     return d->value.toTime();
 }
 
 
 QDateTime Nepomuk2::Variant::toDateTime() const
 {
-    if(isList()) {
-        QList<QDateTime> l = toDateTimeList();
-        if(!l.isEmpty())
-            return l.first();
-    }
+    QDateTime dateTime;
+    if( isDateTimeList() && firstValue<QDateTime, QDateTime>( d->value, dateTime ) )
+        return dateTime;
+
     return d->value.toDateTime();
 }
 
 
 QUrl Nepomuk2::Variant::toUrl() const
 {
-    if(isList()) {
-        QList<QUrl> l = toUrlList();
-        if(!l.isEmpty())
-            return l.first();
+    if( isUrlList() ) {
+        QUrl url;
+        if( firstValue<QUrl, QUrl>( d->value, url ) )
+            return url;
+    }
+    else if( type() == qMetaTypeId<QList<Resource> >() ) {
+        const QList<Resource>& l = listValue<Resource>( d->value );
+        if( !l.isEmpty() )
+            return l.first().uri();
     }
-    else if(type() == qMetaTypeId<Resource>()) {
-        return toResource().uri();
+    else if( type() == qMetaTypeId<Resource>() ) {
+        return scalarValue<Resource>( d->value ).uri();
     }
 
     return d->value.toUrl();
@@ -907,13 +1100,18 @@ QUrl Nepomuk2::Variant::toUrl() const
 
 Nepomuk2::Resource Nepomuk2::Variant::toResource() const
 {
-    if(isResourceList() || isUrlList()) {
-        QList<Resource> l = toResourceList();
-        if(!l.isEmpty())
+    if( type() == qMetaTypeId<QList<Resource> >() ) {
+        const QList<Resource>& l = listValue<Resource>( d->value );
+        if( !l.isEmpty() )
             return l.first();
     }
-    else if(type() == QVariant::Url) {
-        return Resource(toUrl());
+    else if( isUrlList() ) {
+        const QList<QUrl>& l = listValue<QUrl>( d->value );
+        if( !l.isEmpty() )
+            return Resource( l.first() );
+    }
+    else if( isUrl() ) {
+        return Resource( scalarValue<QUrl>( d->value ) );
     }
 
     return d->value.value<Resource>();
@@ -923,100 +1121,116 @@ Nepomuk2::Resource Nepomuk2::Variant::toResource() const
 
 QList<int> Nepomuk2::Variant::toIntList() const
 {
-    if( isUnsignedInt() ||
-        isInt() ||
-        isUnsignedInt64() ||
-        isInt64() ) {
-        QList<int> l;
-        l.append( toInt() );
-        return l;
-    }
-    else if ( isUnsignedIntList() ) {
-        return convertList<uint, int>( d->value.value<QList<uint> >() );
-    }
-    else if ( isUnsignedInt64List() ) {
-        return convertList<qulonglong, int>( d->value.value<QList<qulonglong> >() );
-    }
-    else if ( isInt64List() ) {
-        return convertList<qlonglong, int>( d->value.value<QList<qlonglong> >() );
+    if( !d->list ) {
+        if( isUnsignedInt() ||
+            isInt() ||
+            isUnsignedInt64() ||
+            isInt64() ) {
+            QList<int> l;
+            l.append( toInt() );
+            return l;
+        }
+        return QList<int>();
     }
-    else {
-        return d->value.value<QList<int> >();
+
+    switch( d->simpleType ) {
+    case QVariant::Int:
+        return listValue<int>( d->value );
+    case QVariant::UInt:
+        return convertList<uint, int>( listValue<uint>( d->value ) );
+    case QVariant::ULongLong:
+        return convertList<qulonglong, int>( listValue<qulonglong>( d->value ) );
+    case QVariant::LongLong:
+        return convertList<qlonglong, int>( listValue<qlonglong>( d->value ) );
+    default:
+        return QList<int>();
     }
 }
 
 
 QList<qlonglong> Nepomuk2::Variant::toInt64List() const
 {
-    if( isUnsignedInt() ||
-        isInt() ||
-        isUnsignedInt64() ||
-        isInt64() ) {
-        QList<qlonglong> l;
-        l.append( toInt64() );
-        return l;
-    }
-    else if ( isIntList() ) {
-        return convertList<int, qlonglong>( d->value.value<QList<int> >() );
-    }
-    else if ( isUnsignedIntList() ) {
-        return convertList<uint, qlonglong>( d->value.value<QList<uint> >() );
-    }
-    else if ( isUnsignedInt64List() ) {
-        return convertList<qulonglong, qlonglong>( d->value.value<QList<qulonglong> >() );
+    if( !d->list ) {
+        if( isUnsignedInt() ||
+            isInt() ||
+            isUnsignedInt64() ||
+            isInt64() ) {
+            QList<qlonglong> l;
+            l.append( toInt64() );
+            return l;
+        }
+        return QList<qlonglong>();
     }
-    else {
-        return d->value.value<QList<qlonglong> >();
+
+    switch( d->simpleType ) {
+    case QVariant::LongLong:
+        return listValue<qlonglong>( d->value );
+    case QVariant::Int:
+        return convertList<int, qlonglong>( listValue<int>( d->value ) );
+    case QVariant::UInt:
+        return convertList<uint, qlonglong>( listValue<uint>( d->value ) );
+    case QVariant::ULongLong:
+        return convertList<qulonglong, qlonglong>( listValue<qulonglong>( d->value ) );
+    default:
+        return QList<qlonglong>();
     }
 }
 
 
 QList<uint> Nepomuk2::Variant::toUnsignedIntList() const
 {
-    if( isUnsignedInt() ||
-        isInt() ||
-        isUnsignedInt64() ||
-        isInt64() ) {
-        QList<uint> l;
-        l.append( toUnsignedInt() );
-        return l;
-    }
-    else if ( isIntList() ) {
-        return convertList<int, uint>( d->value.value<QList<int> >() );
-    }
-    else if ( isUnsignedInt64List() ) {
-        return convertList<qulonglong, uint>( d->value.value<QList<qulonglong> >() );
-    }
-    else if ( isInt64List() ) {
-        return convertList<qlonglong, uint>( d->value.value<QList<qlonglong> >() );
+    if( !d->list ) {
+        if( isUnsignedInt() ||
+            isInt() ||
+            isUnsignedInt64() ||
+            isInt64() ) {
+            QList<uint> l;
+            l.append( toUnsignedInt() );
+            return l;
+        }
+        return QList<uint>();
     }
-    else {
-        return d->value.value<QList<uint> >();
+
+    switch( d->simpleType ) {
+    case QVariant::UInt:
+        return listValue<uint>( d->value );
+    case QVariant::Int:
+        return convertList<int, uint>( listValue<int>( d->value ) );
+    case QVariant::ULongLong:
+        return convertList<qulonglong, uint>( listValue<qulonglong>( d->value ) );
+    case QVariant::LongLong:
+        return convertList<qlonglong, uint>( listValue<qlonglong>( d->value ) );
+    default:
+        return QList<uint>();
     }
 }
 
 
 QList<qulonglong> Nepomuk2::Variant::toUnsignedInt64List() const
 {
-    if( isUnsignedInt() ||
-        isInt() ||
-        isUnsignedInt64() ||
-        isInt64() ) {
-        QList<qulonglong> l;
-        l.append( toUnsignedInt() );
-        return l;
-    }
-    else if ( isIntList() ) {
-        return convertList<int, qulonglong>( d->value.value<QList<int> >() );
-    }
-    else if ( isUnsignedIntList() ) {
-        return convertList<uint, qulonglong>( d->value.value<QList<uint> >() );
-    }
-    else if ( isInt64List() ) {
-        return convertList<qlonglong, qulonglong>( d->value.value<QList<qlonglong> >() );
+    if( !d->list ) {
+        if( isUnsignedInt() ||
+            isInt() ||
+            isUnsignedInt64() ||
+            isInt64() ) {
+            QList<qulonglong> l;
+            l.append( toUnsignedInt64() );
+            return l;
+        }
+        return QList<qulonglong>();
     }
-    else {
-        return d->value.value<QList<qulonglong> >();
+
+    switch( d->simpleType ) {
+    case QVariant::ULongLong:
+        return listValue<qulonglong>( d->value );
+    case QVariant::Int:
+        return convertList<int, qulonglong>( listValue<int>( d->value ) );
+    case QVariant::UInt:
+        return convertList<uint, qulonglong>( listValue<uint>( d->value ) );
+    case QVariant::LongLong:
+        return convertList<qlonglong, qulonglong>( listValue<qlonglong>( d->value ) );
+    default:
+        return QList<qulonglong>();
     }
 }
 
@@ -1028,8 +1242,10 @@ QList<bool> Nepomuk2::Variant::toBoolList() const
         l.append( toBool() );
         return l;
     }
+    else if( isBoolList() )
+        return listValue<bool>( d->value );
     else
-        return d->value.value<QList<bool> >();
+        return QList<bool>();
 }
 
 
@@ -1040,19 +1256,20 @@ QList<double> Nepomuk2::Variant::toDoubleList() const
         l.append( toDouble() );
         return l;
     }
+    else if( isDoubleList() )
+        return listValue<double>( d->value );
     else
-        return d->value.value<QList<double> >();
+        return QList<double>();
 }
 
 
 template<typename T> QStringList convertToStringList( const QList<T>& l )
 {
     QStringList sl;
+    sl.reserve( l.count() );
     QListIterator<T> it( l );
     while( it.hasNext() )
         sl.append( Nepomuk2::Variant( it.next() ).toString() );
-//   for( QList<T>::const_iterator it = l.constBegin(); it != l.constEnd(); ++it )
-//     sl.append( Nepomuk2::Variant( *it ).toString() );
     return sl;
 }
 
@@ -1065,30 +1282,32 @@ QStringList Nepomuk2::Variant::toStringList() const
     if( !isList() )
         return QStringList( toString() );
 
-    else if( isIntList() )
-        return convertToStringList<int>( toIntList() );
-    else if( isInt64List() )
-        return convertToStringList<qlonglong>( toInt64List() );
-    else if( isUnsignedIntList() )
-        return convertToStringList<uint>( toUnsignedIntList() );
-    else if( isUnsignedInt64List() )
-        return convertToStringList<qulonglong>( toUnsignedInt64List() );
-    else if( isBoolList() )
-        return convertToStringList<bool>( toBoolList() );
-    else if( isDoubleList() )
-        return convertToStringList<double>( toDoubleList() );
-    else if( isDateList() )
-        return convertToStringList<QDate>( toDateList() );
-    else if( isTimeList() )
-        return convertToStringList<QTime>( toTimeList() );
-    else if( isDateTimeList() )
-        return convertToStringList<QDateTime>( toDateTimeList() );
-    else if( isUrlList() )
-        return convertToStringList<QUrl>( toUrlList() );
-    else if( isResourceList() )
-        return convertToStringList<Resource>( toResourceList() );
-    else
-        return d->value.value<QStringList>();
+    switch( d->simpleType ) {
+    case QVariant::String:
+        return scalarValue<QStringList>( d->value );
+    case QVariant::Int:
+        return convertToStringList<int>( listValue<int>( d->value ) );
+    case QVariant::LongLong:
+        return convertToStringList<qlonglong>( listValue<qlonglong>( d->value ) );
+    case QVariant::UInt:
+        return convertToStringList<uint>( listValue<uint>( d->value ) );
+    case QVariant::ULongLong:
+        return convertToStringList<qulonglong>( listValue<qulonglong>( d->value ) );
+    case QVariant::Bool:
+        return convertToStringList<bool>( listValue<bool>( d->value ) );
+    case QVariant::Double:
+        return convertToStringList<double>( listValue<double>( d->value ) );
+    case QVariant::Date:
+        return convertToStringList<QDate>( listValue<QDate>( d->value ) );
+    case QVariant::Time:
+        return convertToStringList<QTime>( listValue<QTime>( d->value ) );
+    case QVariant::DateTime:
+        return convertToStringList<QDateTime>( listValue<QDateTime>( d->value ) );
+    case QVariant::Url:
+        return convertToStringList<QUrl>( listValue<QUrl>( d->value ) );
+    default:
+        return convertToStringList<Resource>( listValue<Resource>( d->value ) );
+    }
 }
 
 
@@ -1099,8 +1318,10 @@ QList<QDate> Nepomuk2::Variant::toDateList() const
         l.append( toDate() );
         return l;
     }
+    else if( isDateList() )
+        return listValue<QDate>( d->value );
     else
-        return d->value.value<QList<QDate> >();
+        return QList<QDate>();
 }
 
 
@@ -1111,8 +1332,10 @@ QList<QTime> Nepomuk2::Variant::toTimeList() const
         l.append( toTime() );
         return l;
     }
+    else if( isTimeList() )
+        return listValue<QTime>( d->value );
     else
-        return d->value.value<QList<QTime> >();
+        return QList<QTime>();
 }
 
 
@@ -1123,8 +1346,10 @@ QList<QDateTime> Nepomuk2::Variant::toDateTimeList() const
         l.append( toDateTime() );
         return l;
     }
+    else if( isDateTimeList() )
+        return listValue<QDateTime>( d->value );
     else
-        return d->value.value<QList<QDateTime> >();
+        return QList<QDateTime>();
 }
 
 
@@ -1137,14 +1362,18 @@ QList<QUrl> Nepomuk2::Variant::toUrlList() const
         return l;
     }
     else if( type() == qMetaTypeId<QList<Resource> >() ) {
+        const QList<Resource>& rl = listValue<Resource>( d->value );
         QList<QUrl> l;
-        QList<Resource> rl = toResourceList();
+        l.reserve( rl.count() );
         foreach(const Resource& r, rl)
             l << r.uri();
         return l;
     }
+    else if( isUrlList() ) {
+        return listValue<QUrl>( d->value );
+    }
     else {
-        return d->value.value<QList<QUrl> >();
+        return QList<QUrl>();
     }
 }
 
@@ -1157,99 +1386,58 @@ QList<Nepomuk2::Resource> Nepomuk2::Variant::toResourceList() const
         l.append( toResource() );
         return l;
     }
-    else if( type() == qMetaTypeId<QList<QUrl> >() ) {
-        QList<QUrl> urls = toUrlList();
+    else if( isUrlList() ) {
+        const QList<QUrl>& urls = listValue<QUrl>( d->value );
         QList<Resource> l;
+        l.reserve( urls.count() );
         foreach(const QUrl& url, urls)
             l << Resource(url);
         return l;
     }
+    else if( type() == qMetaTypeId<QList<Resource> >() ) {
+        return listValue<Resource>( d->value );
+    }
     else {
-        return d->value.value<QList<Resource> >();
+        return QList<Resource>();
     }
 }
 
 
 QList<Nepomuk2::Variant> Nepomuk2::Variant::toVariantList() const
 {
-    QList<Variant> l;
+    if( !isValid() )
+        return QList<Variant>();
 
-    switch( simpleType() ) {
-    case QVariant::Int:
-        foreach( int i, toIntList() ) {
-            l.append( Variant(i) );
-        }
-        break;
+    // A single value simply shares its data with the only list element
+    if( !d->list )
+        return QList<Variant>() << *this;
 
+    switch( d->simpleType ) {
+    case QVariant::Int:
+        return toVariants( listValue<int>( d->value ) );
     case QVariant::LongLong:
-        foreach( qlonglong i, toInt64List() ) {
-            l.append( Variant(i) );
-        }
-        break;
-
+        return toVariants( listValue<qlonglong>( d->value ) );
     case QVariant::UInt:
-        foreach( uint i, toUnsignedIntList() ) {
-            l.append( Variant(i) );
-        }
-        break;
-
+        return toVariants( listValue<uint>( d->value ) );
     case QVariant::ULongLong:
-        foreach( qulonglong i, toUnsignedInt64List() ) {
-            l.append( Variant(i) );
-        }
-        break;
-
+        return toVariants( listValue<qulonglong>( d->value ) );
     case QVariant::Bool:
-        foreach( bool i, toBoolList() ) {
-            l.append( Variant(i) );
-        }
-        break;
-
+        return toVariants( listValue<bool>( d->value ) );
     case QVariant::Double:
-        foreach( double i, toDoubleList() ) {
-            l.append( Variant(i) );
-        }
-        break;
-
+        return toVariants( listValue<double>( d->value ) );
+    case QVariant::String:
+        return toVariants( listValue<QString>( d->value ) );
     case QVariant::Date:
-        foreach( const QDate& i, toDateList() ) {
-            l.append( Variant(i) );
-        }
-        break;
-
+        return toVariants( listValue<QDate>( d->value ) );
     case QVariant::Time:
-        foreach( const QTime& i, toTimeList() ) {
-            l.append( Variant(i) );
-        }
-        break;
-
+        return toVariants( listValue<QTime>( d->value ) );
     case QVariant::DateTime:
-        foreach( const QDateTime& i, toDateTimeList() ) {
-            l.append( Variant(i) );
-        }
-        break;
-
+        return toVariants( listValue<QDateTime>( d->value ) );
     case QVariant::Url:
-        foreach( const QUrl& i, toUrlList() ) {
-            l.append( Variant(i) );
-        }
-        break;
-
+        return toVariants( listValue<QUrl>( d->value ) );
     default:
-        if( simpleType() == qMetaTypeId<Resource>()) {
-            foreach( const Resource& i, toResourceList() ) {
-                l.append( Variant(i) );
-            }
-        }
-        else {
-            foreach( const QString& i, toStringList() ) {
-                l.append( Variant(i) );
-            }
-            break;
-        }
+        return toVariants( listValue<Resource>( d->value ) );
     }
-
-    return l;
 }
 
 
@@ -1269,15 +1457,18 @@ QList<Soprano::Node> Nepomuk2::Variant::toNodeList() const
     QList<Soprano::Node> nl;
 
     if ( isResourceList() ) {
-        QList<QUrl> urls = toUrlList();
+        const QList<QUrl> urls = toUrlList();
+        nl.reserve( urls.count() );
         for ( QList<QUrl>::const_iterator it = urls.constBegin(); it != urls.constEnd(); ++it ) {
             nl.append( Soprano::Node( *it ) );
         }
     }
     else if( isList() ) {
-        QStringList vl = toStringList();
-        for( QStringList::const_iterator it = vl.constBegin(); it != vl.constEnd(); ++it ) {
-            nl.append( Soprano::Node( Soprano::LiteralValue::fromString( *it, ( QVariant::Type )simpleType() ) ) );
+        // convert the values directly instead of going through their string representation
+        const QList<Variant> vl = toVariantList();
+        nl.reserve( vl.count() );
+        for( QList<Variant>::const_iterator it = vl.constBegin(); it != vl.constEnd(); ++it ) {
+            nl.append( it->toNode() );
         }
     }
     else if( isValid() ) {
@@ -1290,18 +1481,7 @@ QList<Soprano::Node> Nepomuk2::Variant::toNodeList() const
 
 bool Nepomuk2::Variant::isList() const
 {
-    return( isIntList() ||
-            isInt64List() ||
-            isUnsignedIntList() ||
-            isUnsignedInt64List() ||
-            isBoolList() ||
-            isDoubleList() ||
-            isStringList() ||
-            isDateList() ||
-            isTimeList() ||
-            isDateTimeList() ||
-            isUrlList() ||
-            isResourceList() );
+    return d->list;
 }
 
 
@@ -1313,32 +1493,7 @@ int Nepomuk2::Variant::type() const
 
 int Nepomuk2::Variant::simpleType() const
 {
-    if( isIntList() )
-        return QVariant::Int;
-    else if( isInt64List() )
-        return QVariant::LongLong;
-    else if( isUnsignedIntList() )
-        return QVariant::UInt;
-    else if( isUnsignedInt64List() )
-        return QVariant::ULongLong;
-    else if( isBoolList() )
-        return QVariant::Bool;
-    else if( isDoubleList() )
-        return QVariant::Double;
-    else if( isStringList() )
-        return QVariant::String;
-    else if( isDateList() )
-        return QVariant::Date;
-    else if( isTimeList() )
-        return QVariant::Time;
-    else if( isDateTimeList() )
-        return QVariant::DateTime;
-    else if( isUrlList() )
-        return QVariant::Url;
-    else if( isResourceList() )
-        return qMetaTypeId<Resource>();
-    else
-        return d->value.userType();
+    return d->simpleType;
 }
 
 
@@ -1410,38 +1565,49 @@ Nepomuk2::Variant Nepomuk2::Variant::fromNodeList( const QList<Soprano::Node>& v
 
 bool Nepomuk2::Variant::operator==( const Variant& other ) const
 {
+    // copies share their data
+    if( d == other.d )
+        return true;
+
     // we handle the special case of Urls and Resources before
     // comparing the simple type
-    if( isUrl() || isUrlList() )
-        return other.toUrlList() == toUrlList();
+    if( isUrl() || isUrlList() ) {
+        if( other.isUrl() || other.isUrlList() )
+            return valuesEqual<QUrl>( d->value, d->list, other.d->value, other.d->list );
+        else
+            return other.toUrlList() == toUrlList();
+    }
     else if( isResource() || isResourceList() )
         return other.toResourceList() == toResourceList();
 
     if( other.simpleType() != this->simpleType() )
         return false;
 
-    if( isInt() || isIntList() )
-        return other.toIntList() == toIntList();
-    else if( isInt64() || isInt64List() )
-        return other.toInt64List() == toInt64List();
-    else if( isUnsignedInt() || isUnsignedIntList() )
-        return other.toUnsignedIntList() == toUnsignedIntList();
-    else if( isUnsignedInt64() || isUnsignedInt64List() )
-        return other.toUnsignedInt64List() == toUnsignedInt64List();
-    else if( isBool() || isBoolList() )
-        return other.toBoolList() == toBoolList();
-    else if( isDouble() || isDoubleList() )
-        return other.toDoubleList() == toDoubleList();
-    else if( isString() || isStringList() )
-        return other.d->value.value<QStringList>() == d->value.value<QStringList>();
-    else if( isDate() || isDateList() )
-        return other.toDateList() == toDateList();
-    else if( isTime() || isTimeList() )
-        return other.toTimeList() == toTimeList();
-    else if( isDateTime() || isDateTimeList() )
-        return other.toDateTimeList() == toDateTimeList();
-    else
+    // Compare the stored values directly without converting them into lists
+    switch( d->simpleType ) {
+    case QVariant::Int:
+        return valuesEqual<int>( d->value, d->list, other.d->value, other.d->list );
+    case QVariant::LongLong:
+        return valuesEqual<qlonglong>( d->value, d->list, other.d->value, other.d->list );
+    case QVariant::UInt:
+        return valuesEqual<uint>( d->value, d->list, other.d->value, other.d->list );
+    case QVariant::ULongLong:
+        return valuesEqual<qulonglong>( d->value, d->list, other.d->value, other.d->list );
+    case QVariant::Bool:
+        return valuesEqual<bool>( d->value, d->list, other.d->value, other.d->list );
+    case QVariant::Double:
+        return valuesEqual<double>( d->value, d->list, other.d->value, other.d->list );
+    case QVariant::String:
+        return valuesEqual<QString>( d->value, d->list, other.d->value, other.d->list );
+    case QVariant::Date:
+        return valuesEqual<QDate>( d->value, d->list, other.d->value, other.d->list );
+    case QVariant::Time:
+        return valuesEqual<QTime>( d->value, d->list, other.d->value, other.d->list );
+    case QVariant::DateTime:
+        return valuesEqual<QDateTime>( d->value, d->list, other.d->value, other.d->list );
+    default:
         return ( d->value == other.d->value );
+    }
 }
 
 
@@ -27,6 +27,7 @@
 #include <QtCore/QDateTime>
 #include <QtCore/QUrl>
 #include <QtCore/QVariant>
+#include <QtCore/QSharedDataPointer>
 
 namespace Soprano {
     class Node;
@@ -382,7 +383,7 @@ namespace Nepomuk2 {
 
     private:
         class Private;
-        Private* const d;
+        QSharedDataPointer<Private> d;
     };
 }
 
@@ -0,0 +1,67 @@
+/*
+    This file is part of the Nepomuk KDE project.
+    Copyright (C) 2013  Nepomuk Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef _NEPOMUK2_ATOMIC_LOAD_H_
+#define _NEPOMUK2_ATOMIC_LOAD_H_
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QAtomicPointer>
+
+#if defined(Q_CC_MSVC)
+#include <intrin.h>
+#endif
+
+namespace Nepomuk2 {
+    namespace Types {
+        /**
+         * Keeps the loads following a plain atomic load from being done before
+         * it. Qt 4 has no loadAcquire() and fetchAndAddAcquire(0) would be a locked
+         * write, making all readers of a value fight over its cache line.
+         */
+        inline void acquireBarrier() {
+#if (defined(Q_CC_GNU) || defined(Q_CC_CLANG)) && (defined(__i386__) || defined(__x86_64__))
+            // x86 does not reorder loads with later loads and stores, only the compiler might
+            asm volatile( "" ::: "memory" );
+#elif defined(Q_CC_GNU) || defined(Q_CC_CLANG)
+            __sync_synchronize();
+#elif defined(Q_CC_MSVC) && (defined(_M_IX86) || defined(_M_X64))
+            _ReadWriteBarrier();
+#else
+            // the barrier of a locked operation on a value nobody else touches
+            QAtomicInt local;
+            local.fetchAndAddAcquire( 0 );
+#endif
+        }
+
+        inline int loadAcquire( const QAtomicInt& value ) {
+            const int v = value;
+            acquireBarrier();
+            return v;
+        }
+
+        template<typename T>
+        inline T* loadAcquire( const QAtomicPointer<T>& pointer ) {
+            T* p = pointer;
+            acquireBarrier();
+            return p;
+        }
+    }
+}
+
+#endif
@@ -19,6 +19,8 @@
 
 #include "class.h"
 #include "class_p.h"
+#include "ontologysnapshot_p.h"
+#include "atomicload_p.h"
 #include "ontology.h"
 #include "resourcemanager.h"
 #include "property.h"
@@ -56,6 +58,9 @@ bool Nepomuk2::Types::ClassPrivate::load()
         if ( parents.isEmpty() ) {
             if ( uri != Soprano::Vocabulary::RDFS::Resource() ) {
                 parents += Soprano::Vocabulary::RDFS::Resource();
+                if ( superEntitiesAvailable ) {
+                    superEntities += Soprano::Vocabulary::RDFS::Resource();
+                }
             }
         }
         return true;
@@ -72,11 +77,13 @@ bool Nepomuk2::Types::ClassPrivate::loadAncestors()
     // Nearly all here can be done in a very clean way. There is only
     // one special case: rdfs:Resource, the base class of them all
     //
-    if ( uri == Soprano::Vocabulary::RDFS::Resource() ) {
+    if ( uri == Soprano::Vocabulary::RDFS::Resource() &&
+         !OntologySnapshot::self()->isValid() ) {
         //
         // All classes that do not explicetely state a superclass are
         // derived from rdfs:Resource. This query selects those classes
-        // (might fail on redland though)
+        // (might fail on redland though). The ontology snapshot already
+        // contains them as ancestors of rdfs:Resource.
         //
         Soprano::QueryResultIterator it
             = ResourceManager::instance()->mainModel()->executeQuery( QString("select distinct ?s where { "
@@ -133,16 +140,31 @@ bool Nepomuk2::Types::ClassPrivate::addAncestorProperty( const QUrl& ancestorRes
 
 void Nepomuk2::Types::ClassPrivate::initProperties()
 {
+    if ( loadAcquire( propertiesAvailable ) >= 0 ) {
+        return;
+    }
+
     QMutexLocker lock( &mutex );
 
     if ( propertiesAvailable < 0 ) {
-        propertiesAvailable = loadProperties() ? 1 : 0;
+        propertiesAvailable.fetchAndStoreOrdered( loadProperties() ? 1 : 0 );
     }
 }
 
 
 bool Nepomuk2::Types::ClassPrivate::loadProperties()
 {
+    OntologySnapshot::Entry entry;
+    if ( OntologySnapshot::self()->entry( uri, entry ) ) {
+        foreach( const QUrl& p, entry.domainOf ) {
+            domainOf.append( Property( p ) );
+        }
+        foreach( const QUrl& p, entry.rangeOf ) {
+            rangeOf.append( Property( p ) );
+        }
+        return true;
+    }
+
     // load domains with a hack to get at least a subset of properties that inherit their domain from parents
     Soprano::QueryResultIterator it
         = ResourceManager::instance()->mainModel()->executeQuery( QString("select distinct ?p where { "
@@ -211,7 +233,7 @@ void Nepomuk2::Types::ClassPrivate::reset( bool recursive )
 
         domainOf.clear();
         rangeOf.clear();
-        propertiesAvailable = -1;
+        propertiesAvailable.fetchAndStoreOrdered( -1 );
     }
 
     if ( available != -1 ) {
@@ -221,7 +243,7 @@ void Nepomuk2::Types::ClassPrivate::reset( bool recursive )
             }
         }
         parents.clear();
-        available = -1;
+        available.fetchAndStoreOrdered( -1 );
     }
 
     if ( ancestorsAvailable != -1 ) {
@@ -231,7 +253,7 @@ void Nepomuk2::Types::ClassPrivate::reset( bool recursive )
             }
         }
         children.clear();
-        ancestorsAvailable = -1;
+        ancestorsAvailable.fetchAndStoreOrdered( -1 );
     }
 
     EntityPrivate::reset( recursive );
@@ -492,7 +514,10 @@ bool Nepomuk2::Types::Class::isSubClassOf( const Class& other )
     if ( d ) {
         D->init();
 
-        if ( D->parents.contains( other ) ) {
+        if ( D->superEntitiesAvailable ) {
+            return D->superEntities.contains( other.uri() );
+        }
+        else if ( D->parents.contains( other ) ) {
             return true;
         }
         else {
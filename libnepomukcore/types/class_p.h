@@ -44,7 +44,7 @@ namespace Nepomuk2 {
             // -1 - unknown
             // 0  - no
             // 1  - yes
-            int propertiesAvailable;
+            QAtomicInt propertiesAvailable;
 
             bool addProperty( const QUrl& property, const Soprano::Node& value );
             bool addAncestorProperty( const QUrl& ancestorResource, const QUrl& property );
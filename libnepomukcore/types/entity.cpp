@@ -19,6 +19,8 @@
 
 #include "entity.h"
 #include "entity_p.h"
+#include "ontologysnapshot_p.h"
+#include "atomicload_p.h"
 #include "resourcemanager.h"
 
 #include <QtCore/QHash>
@@ -37,6 +39,7 @@ Nepomuk2::Types::EntityPrivate::EntityPrivate( const QUrl& uri_ )
     : mutex(QMutex::Recursive),
       uri( uri_ ),
       userVisible( true ),
+      superEntitiesAvailable( false ),
       available( uri_.isValid() ? -1 : 0 ),
       ancestorsAvailable( uri_.isValid() ? -1 : 0 )
 {
@@ -45,26 +48,46 @@ Nepomuk2::Types::EntityPrivate::EntityPrivate( const QUrl& uri_ )
 
 void Nepomuk2::Types::EntityPrivate::init()
 {
+    // fast path without locking for the already loaded entity. The acquire
+    // load makes the data written by load() in another thread visible.
+    if ( loadAcquire( available ) >= 0 ) {
+        return;
+    }
+
     QMutexLocker lock( &mutex );
 
     if ( available < 0 ) {
-        available = load() ? 1 : 0;
+        available.fetchAndStoreOrdered( load() ? 1 : 0 );
     }
 }
 
 
 void Nepomuk2::Types::EntityPrivate::initAncestors()
 {
+    if ( loadAcquire( ancestorsAvailable ) >= 0 ) {
+        return;
+    }
+
     QMutexLocker lock( &mutex );
 
     if ( ancestorsAvailable < 0 ) {
-        ancestorsAvailable = loadAncestors() ? 1 : 0;
+        ancestorsAvailable.fetchAndStoreOrdered( loadAncestors() ? 1 : 0 );
     }
 }
 
 
 bool Nepomuk2::Types::EntityPrivate::load()
 {
+    OntologySnapshot::Entry entry;
+    if ( OntologySnapshot::self()->entry( uri, entry ) ) {
+        for ( int i = 0; i < entry.properties.count(); ++i ) {
+            loadProperty( entry.properties[i].first, entry.properties[i].second );
+        }
+        superEntities = entry.superEntities.toSet();
+        superEntitiesAvailable = true;
+        return true;
+    }
+
     const QString query = QString::fromLatin1( "select ?p ?o where { "
                                                "graph ?g { <%1> ?p ?o . } . "
                                                "{ ?g a %2 . } UNION { ?g a %3 . } . }" )
@@ -75,46 +98,57 @@ bool Nepomuk2::Types::EntityPrivate::load()
     Soprano::QueryResultIterator it
         = ResourceManager::instance()->mainModel()->executeQuery( query, Soprano::Query::QueryLanguageSparql );
     while ( it.next() ) {
-        QUrl property = it.binding( "p" ).uri();
-        Soprano::Node value = it.binding( "o" );
-
-        if ( property == Soprano::Vocabulary::RDFS::label() ) {
-            if ( value.language().isEmpty() ) {
-                label = value.toString();
-            }
-            else if( value.language() == KGlobal::locale()->language() ) {
-                l10nLabel = value.toString();
-            }
-        }
+        loadProperty( it.binding( "p" ).uri(), it.binding( "o" ) );
+    }
 
-        else if ( property == Soprano::Vocabulary::RDFS::comment() ) {
-            if ( value.language().isEmpty() ) {
-                comment = value.toString();
-            }
-            else if( value.language() == KGlobal::locale()->language() ) {
-                l10nComment = value.toString();
-            }
-        }
+    return !it.lastError();
+}
 
-        else if ( property == Soprano::Vocabulary::NAO::hasSymbol() ) {
-            icon = KIcon( value.toString() );
-        }
 
-        else if ( property == Soprano::Vocabulary::NAO::userVisible() ) {
-            userVisible = value.literal().toBool();
+void Nepomuk2::Types::EntityPrivate::loadProperty( const QUrl& property, const Soprano::Node& value )
+{
+    if ( property == Soprano::Vocabulary::RDFS::label() ) {
+        if ( value.language().isEmpty() ) {
+            label = value.toString();
+        }
+        else if( value.language() == KGlobal::locale()->language() ) {
+            l10nLabel = value.toString();
         }
+    }
 
-        else {
-            addProperty( property, value );
+    else if ( property == Soprano::Vocabulary::RDFS::comment() ) {
+        if ( value.language().isEmpty() ) {
+            comment = value.toString();
+        }
+        else if( value.language() == KGlobal::locale()->language() ) {
+            l10nComment = value.toString();
         }
     }
 
-    return !it.lastError();
+    else if ( property == Soprano::Vocabulary::NAO::hasSymbol() ) {
+        icon = KIcon( value.toString() );
+    }
+
+    else if ( property == Soprano::Vocabulary::NAO::userVisible() ) {
+        userVisible = value.literal().toBool();
+    }
+
+    else {
+        addProperty( property, value );
+    }
 }
 
 
 bool Nepomuk2::Types::EntityPrivate::loadAncestors()
 {
+    OntologySnapshot::Entry entry;
+    if ( OntologySnapshot::self()->entry( uri, entry ) ) {
+        for ( int i = 0; i < entry.ancestors.count(); ++i ) {
+            addAncestorProperty( entry.ancestors[i].first, entry.ancestors[i].second );
+        }
+        return true;
+    }
+
     const QString query = QString::fromLatin1( "select ?s ?p where { "
                                                "graph ?g { ?s ?p <%1> . } . "
                                                "{ ?g a %2 . } UNION { ?g a %3 . } . }" )
@@ -144,8 +178,11 @@ void Nepomuk2::Types::EntityPrivate::reset( bool )
 
     icon = QIcon();
 
-    available = -1;
-    ancestorsAvailable = -1;
+    superEntities.clear();
+    superEntitiesAvailable = false;
+
+    available.fetchAndStoreOrdered( -1 );
+    ancestorsAvailable.fetchAndStoreOrdered( -1 );
 }
 
 
@@ -282,6 +319,9 @@ bool Nepomuk2::Types::Entity::isAvailable() const
 
 void Nepomuk2::Types::Entity::reset( bool recursive )
 {
+    // pick up a snapshot which has been rewritten after an ontology update
+    OntologySnapshot::self()->reload();
+
     if( d )
         d->reset( recursive );
 }
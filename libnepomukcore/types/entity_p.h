@@ -23,11 +23,13 @@
 #include "entity.h"
 
 #include <QtCore/QHash>
+#include <QtCore/QSet>
 #include <QtCore/QString>
 #include <QtCore/QUrl>
 #include <QtGui/QIcon>
 #include <QtCore/QSharedData>
 #include <QtCore/QMutex>
+#include <QtCore/QAtomicInt>
 
 namespace Nepomuk2 {
     namespace Types {
@@ -49,11 +51,18 @@ namespace Nepomuk2 {
 
             bool userVisible;
 
+            // the transitive closure of the super classes or properties
+            // which is only known when loaded from the ontology snapshot
+            QSet<QUrl> superEntities;
+            bool superEntitiesAvailable;
+
             // -1 - unknown
             // 0  - no
             // 1  - yes
-            int available;
-            int ancestorsAvailable;
+            // Once set the loaded data does not change anymore (except for an explicit
+            // reset()) which allows init() to skip locking the mutex.
+            QAtomicInt available;
+            QAtomicInt ancestorsAvailable;
 
             void init();
             void initAncestors();
@@ -66,6 +75,9 @@ namespace Nepomuk2 {
         protected:
             virtual bool load();
             virtual bool loadAncestors();
+
+        private:
+            void loadProperty( const QUrl& property, const Soprano::Node& value );
         };
     }
 }
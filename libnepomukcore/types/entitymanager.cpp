@@ -21,63 +21,99 @@
 #include "class_p.h"
 #include "property_p.h"
 #include "ontology_p.h"
+#include "atomicload_p.h"
 
 #include "resourcemanager.h"
 
-#include <QtCore/QMutexLocker>
+#include <QtCore/QHash>
 
 Q_GLOBAL_STATIC( Nepomuk2::Types::EntityManager, entityManager )
 
-Nepomuk2::Types::EntityManager::EntityManager()
+
+template<typename T>
+Nepomuk2::Types::EntityMap<T>::EntityMap()
 {
 }
 
 
-QExplicitlySharedDataPointer<Nepomuk2::Types::ClassPrivate> Nepomuk2::Types::EntityManager::getClass( const QUrl& uri )
+template<typename T>
+Nepomuk2::Types::EntityMap<T>::~EntityMap()
 {
-    QMutexLocker lock( &m_mutex );
-
-    QHash<QUrl, QExplicitlySharedDataPointer<ClassPrivate> >::const_iterator it = m_classMap.constFind( uri );
-    if ( it != m_classMap.constEnd() ) {
-        return it.value();
+    for ( int i = 0; i < BucketCount; ++i ) {
+        Node* node = m_buckets[i];
+        while ( node ) {
+            Node* next = node->next;
+            delete node;
+            node = next;
+        }
     }
-    else {
-        QExplicitlySharedDataPointer<ClassPrivate> scp( new ClassPrivate( uri ) );
-        m_classMap.insert( uri, scp );
-        return scp;
+}
+
+
+// static
+template<typename T>
+typename Nepomuk2::Types::EntityMap<T>::Node* Nepomuk2::Types::EntityMap<T>::find( Node* first, Node* last, uint hash, const QUrl& uri )
+{
+    for ( Node* node = first; node != last; node = node->next ) {
+        if ( node->hash == hash && node->uri == uri ) {
+            return node;
+        }
     }
+    return 0;
 }
 
 
-QExplicitlySharedDataPointer<Nepomuk2::Types::PropertyPrivate> Nepomuk2::Types::EntityManager::getProperty( const QUrl& uri )
+template<typename T>
+QExplicitlySharedDataPointer<T> Nepomuk2::Types::EntityMap<T>::get( const QUrl& uri )
 {
-    QMutexLocker lock( &m_mutex );
+    const uint hash = qHash( uri );
+    QAtomicPointer<Node>& bucket = m_buckets[hash % BucketCount];
 
-    QHash<QUrl, QExplicitlySharedDataPointer<PropertyPrivate> >::const_iterator it = m_propertyMap.constFind( uri );
-    if ( it != m_propertyMap.constEnd() ) {
-        return it.value();
+    // The acquire loads make the nodes published by other threads visible
+    Node* head = loadAcquire( bucket );
+    if ( Node* node = find( head, 0, hash, uri ) ) {
+        return node->data;
     }
-    else {
-        QExplicitlySharedDataPointer<PropertyPrivate> cp( new PropertyPrivate( uri ) );
-        m_propertyMap.insert( uri, cp );
-        return cp;
+
+    Node* newNode = new Node( hash, uri );
+    forever {
+        newNode->next = head;
+        if ( bucket.testAndSetOrdered( head, newNode ) ) {
+            return newNode->data;
+        }
+
+        // Another thread inserted into the same bucket in the meantime. Only the
+        // nodes in front of our old head are new and might contain our uri.
+        Node* newHead = loadAcquire( bucket );
+        if ( Node* node = find( newHead, head, hash, uri ) ) {
+            delete newNode;
+            return node->data;
+        }
+        head = newHead;
     }
 }
 
 
-QExplicitlySharedDataPointer<Nepomuk2::Types::OntologyPrivate> Nepomuk2::Types::EntityManager::getOntology( const QUrl& uri )
+Nepomuk2::Types::EntityManager::EntityManager()
 {
-    QMutexLocker lock( &m_mutex );
+}
 
-    QHash<QUrl, QExplicitlySharedDataPointer<OntologyPrivate> >::const_iterator it = m_ontologyMap.constFind( uri );
-    if ( it != m_ontologyMap.constEnd() ) {
-        return it.value();
-    }
-    else {
-        QExplicitlySharedDataPointer<OntologyPrivate> cp( new OntologyPrivate( uri ) );
-        m_ontologyMap.insert( uri, cp );
-        return cp;
-    }
+
+QExplicitlySharedDataPointer<Nepomuk2::Types::ClassPrivate> Nepomuk2::Types::EntityManager::getClass( const QUrl& uri )
+{
+    return m_classMap.get( uri );
+}
+
+
+QExplicitlySharedDataPointer<Nepomuk2::Types::PropertyPrivate> Nepomuk2::Types::EntityManager::getProperty( const QUrl& uri )
+{
+    return m_propertyMap.get( uri );
+}
+
+
+QExplicitlySharedDataPointer<Nepomuk2::Types::OntologyPrivate> Nepomuk2::Types::EntityManager::getOntology( const QUrl& uri )
+{
+    return m_ontologyMap.get( uri );
 }
 
 
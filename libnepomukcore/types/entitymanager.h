@@ -20,10 +20,9 @@
 #ifndef _NEPOMUK2_ENTITY_MANAGER_H_
 #define _NEPOMUK2_ENTITY_MANAGER_H_
 
-#include <QtCore/QHash>
 #include <QtCore/QUrl>
 #include <QtCore/QSharedData>
-#include <QtCore/QMutex>
+#include <QtCore/QAtomicPointer>
 
 
 namespace Soprano {
@@ -37,6 +36,50 @@ namespace Nepomuk2 {
         class PropertyPrivate;
         class OntologyPrivate;
 
+        /**
+         * An insert-only hash map which can be read without any locking.
+         *
+         * New entries are published with a compare-and-swap on the head of their
+         * bucket. Entries are never changed or removed once published, so a reader
+         * can never see a half-initialized or deleted entry.
+         */
+        template<typename T>
+        class EntityMap
+        {
+        public:
+            EntityMap();
+            ~EntityMap();
+
+            /**
+             * \return The entity for \p uri which is created on first use.
+             */
+            QExplicitlySharedDataPointer<T> get( const QUrl& uri );
+
+        private:
+            struct Node {
+                Node( uint h, const QUrl& u )
+                    : hash( h ),
+                      uri( u ),
+                      data( new T( u ) ),
+                      next( 0 ) {
+                }
+
+                const uint hash;
+                const QUrl uri;
+                const QExplicitlySharedDataPointer<T> data;
+                Node* next;
+            };
+
+            /// search the nodes from \p first up to but excluding \p last
+            static Node* find( Node* first, Node* last, uint hash, const QUrl& uri );
+
+            // The ontologies define a few thousand entities which keeps the chains short
+            enum { BucketCount = 1024 };
+            QAtomicPointer<Node> m_buckets[BucketCount];
+
+            Q_DISABLE_COPY( EntityMap )
+        };
+
         /**
          * Cache for all loaded entities.
          */
@@ -52,11 +95,9 @@ namespace Nepomuk2 {
             static EntityManager* self();
 
         private:
-            QHash<QUrl, QExplicitlySharedDataPointer<ClassPrivate> > m_classMap;
-            QHash<QUrl, QExplicitlySharedDataPointer<PropertyPrivate> > m_propertyMap;
-            QHash<QUrl, QExplicitlySharedDataPointer<OntologyPrivate> > m_ontologyMap;
-
-            QMutex m_mutex;
+            EntityMap<ClassPrivate> m_classMap;
+            EntityMap<PropertyPrivate> m_propertyMap;
+            EntityMap<OntologyPrivate> m_ontologyMap;
         };
     }
 }
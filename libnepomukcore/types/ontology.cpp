@@ -19,11 +19,15 @@
 
 #include "ontology.h"
 #include "ontology_p.h"
+#include "atomicload_p.h"
+#include "ontologysnapshot_p.h"
 #include "class.h"
 #include "property.h"
 #include "entitymanager.h"
 #include "resourcemanager.h"
 
+#include <QtCore/QMutexLocker>
+
 #include <Soprano/QueryResultIterator>
 #include <Soprano/Model>
 #include <Soprano/Vocabulary/NAO>
@@ -43,14 +47,31 @@ Nepomuk2::Types::OntologyPrivate::OntologyPrivate( const QUrl& uri )
 
 void Nepomuk2::Types::OntologyPrivate::initEntities()
 {
+    if ( loadAcquire( entitiesAvailable ) >= 0 ) {
+        return;
+    }
+
+    QMutexLocker lock( &mutex );
+
     if ( entitiesAvailable < 0 ) {
-        entitiesAvailable = loadEntities() ? 1 : 0;
+        entitiesAvailable.fetchAndStoreOrdered( loadEntities() ? 1 : 0 );
     }
 }
 
 
 bool Nepomuk2::Types::OntologyPrivate::loadEntities()
 {
+    OntologySnapshot::Entry entry;
+    if ( OntologySnapshot::self()->entry( uri, entry ) ) {
+        foreach( const QUrl& c, entry.classes ) {
+            classes.append( Class( c ) );
+        }
+        foreach( const QUrl& p, entry.ontologyProperties ) {
+            properties.append( Property( p ) );
+        }
+        return true;
+    }
+
     // load classes
     // We use a FILTER(STR(?ns)...) to support both Soprano 2.3 (with plain literals) and earlier (with only typed ones)
     Soprano::QueryResultIterator it
@@ -112,7 +133,7 @@ void Nepomuk2::Types::OntologyPrivate::reset( bool recursive )
         classes.clear();
         properties.clear();
 
-        entitiesAvailable = -1;
+        entitiesAvailable.fetchAndStoreOrdered( -1 );
     }
 
     EntityPrivate::reset( recursive );
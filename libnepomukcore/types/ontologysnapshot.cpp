@@ -0,0 +1,547 @@
+/*
+    This file is part of the Nepomuk KDE project.
+    Copyright (C) 2013  Nepomuk Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "ontologysnapshot_p.h"
+
+#include <QtCore/QByteArray>
+#include <QtCore/QDataStream>
+#include <QtCore/QDateTime>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QMutex>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QSet>
+#include <QtCore/QSharedData>
+
+#include <Soprano/Model>
+#include <Soprano/LiteralValue>
+#include <Soprano/QueryResultIterator>
+#include <Soprano/Vocabulary/RDF>
+#include <Soprano/Vocabulary/RDFS>
+#include <Soprano/Vocabulary/NRL>
+#include <Soprano/Vocabulary/NAO>
+#include <Soprano/Vocabulary/OWL>
+
+#include <KSaveFile>
+#include <KStandardDirs>
+#include <KDebug>
+
+using namespace Soprano::Vocabulary;
+
+typedef Nepomuk2::Types::OntologySnapshot::Entry SnapshotEntry;
+
+namespace {
+    // "NOSS" - Nepomuk Ontology SnapShot
+    const quint32 s_magic = 0x4e4f5353;
+
+    // Increase whenever the layout of the file or of an entry changes
+    const quint32 s_formatVersion = 1;
+
+    const QDataStream::Version s_streamVersion = QDataStream::Qt_4_6;
+
+    void writeNode( QDataStream& stream, const Soprano::Node& node ) {
+        stream << quint8( node.type() );
+        if( node.isResource() ) {
+            stream << node.uri();
+        }
+        else if( node.isBlank() ) {
+            stream << node.identifier();
+        }
+        else if( node.isLiteral() ) {
+            const bool plain = node.literal().isPlain();
+            stream << plain << node.literal().toString();
+            if( plain )
+                stream << node.language();
+            else
+                stream << node.literal().dataTypeUri();
+        }
+    }
+
+    Soprano::Node readNode( QDataStream& stream ) {
+        quint8 type = 0;
+        stream >> type;
+
+        switch( type ) {
+        case Soprano::Node::ResourceNode: {
+            QUrl uri;
+            stream >> uri;
+            return Soprano::Node( uri );
+        }
+        case Soprano::Node::BlankNode: {
+            QString id;
+            stream >> id;
+            return Soprano::Node::createBlankNode( id );
+        }
+        case Soprano::Node::LiteralNode: {
+            bool plain = false;
+            QString value;
+            stream >> plain >> value;
+            if( plain ) {
+                QString language;
+                stream >> language;
+                return Soprano::Node( Soprano::LiteralValue::createPlainLiteral( value, language ) );
+            }
+            else {
+                QUrl dataType;
+                stream >> dataType;
+                return Soprano::Node( Soprano::LiteralValue::fromString( value, dataType ) );
+            }
+        }
+        default:
+            return Soprano::Node();
+        }
+    }
+
+    void writeEntry( QDataStream& stream, const SnapshotEntry& entry ) {
+        stream << quint32( entry.properties.count() );
+        for( int i = 0; i < entry.properties.count(); ++i ) {
+            stream << entry.properties[i].first;
+            writeNode( stream, entry.properties[i].second );
+        }
+        stream << entry.ancestors
+               << entry.superEntities
+               << entry.domainOf
+               << entry.rangeOf
+               << entry.classes
+               << entry.ontologyProperties;
+    }
+
+    void readEntry( QDataStream& stream, SnapshotEntry& entry ) {
+        quint32 count = 0;
+        stream >> count;
+        for( quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i ) {
+            QUrl property;
+            stream >> property;
+            entry.properties << qMakePair( property, readNode( stream ) );
+        }
+        stream >> entry.ancestors
+               >> entry.superEntities
+               >> entry.domainOf
+               >> entry.rangeOf
+               >> entry.classes
+               >> entry.ontologyProperties;
+    }
+
+    /// all ancestors of \p uri in \p parents, \p uri itself excluded. Handles loops.
+    QList<QUrl> closure( const QUrl& uri, const QHash<QUrl, QList<QUrl> >& parents ) {
+        QSet<QUrl> result;
+        QList<QUrl> todo = parents.value( uri );
+        while( !todo.isEmpty() ) {
+            const QUrl parent = todo.takeLast();
+            if( parent == uri || result.contains( parent ) )
+                continue;
+            result.insert( parent );
+            todo << parents.value( parent );
+        }
+        return result.toList();
+    }
+
+    /// the domains of \p property or, if it does not have any, the ones of its closest super properties
+    QList<QUrl> effectiveDomains( const QUrl& property,
+                                  const QHash<QUrl, QList<QUrl> >& domains,
+                                  const QHash<QUrl, QList<QUrl> >& parents ) {
+        QSet<QUrl> visited;
+        QList<QUrl> level;
+        level << property;
+        while( !level.isEmpty() ) {
+            QList<QUrl> result;
+            QList<QUrl> nextLevel;
+            foreach( const QUrl& p, level ) {
+                visited.insert( p );
+                result << domains.value( p );
+                foreach( const QUrl& parent, parents.value( p ) ) {
+                    if( !visited.contains( parent ) )
+                        nextLevel << parent;
+                }
+            }
+            if( !result.isEmpty() )
+                return result;
+            level = nextLevel;
+        }
+        return QList<QUrl>();
+    }
+}
+
+
+class Nepomuk2::Types::OntologySnapshot::Private
+{
+public:
+    /// One opened snapshot file. It is kept alive while an entry is decoded from it.
+    class Data : public QSharedData
+    {
+    public:
+        Data()
+            : map( 0 ),
+              size( 0 ) {
+        }
+        ~Data() {
+            if( map )
+                file.unmap( map );
+        }
+
+        bool readIndex();
+
+        QFile file;
+        uchar* map;
+        qint64 size;
+
+        /// the encoded URIs and the file offsets of their entries
+        QHash<QByteArray, qint64> index;
+    };
+
+    QString path;
+    QDateTime lastModified;
+    qint64 lastSize;
+    QExplicitlySharedDataPointer<Data> data;
+
+    mutable QMutex mutex;
+};
+
+
+bool Nepomuk2::Types::OntologySnapshot::Private::Data::readIndex()
+{
+    const QByteArray bytes = QByteArray::fromRawData( reinterpret_cast<const char*>( map ), size );
+    QDataStream stream( bytes );
+    stream.setVersion( s_streamVersion );
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    quint32 count = 0;
+    stream >> magic >> version;
+    if( magic != s_magic || version != s_formatVersion ) {
+        kDebug() << "Ignoring ontology snapshot" << file.fileName() << "with format version" << version;
+        return false;
+    }
+
+    stream >> count;
+    // every index entry takes at least 8 bytes, do not trust a corrupted count
+    index.reserve( int( qMin<qint64>( count, size / 8 ) ) );
+
+    QList<QPair<QByteArray, quint32> > offsets;
+    for( quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i ) {
+        QByteArray uri;
+        quint32 offset = 0;
+        stream >> uri >> offset;
+        offsets << qMakePair( uri, offset );
+    }
+    if( stream.status() != QDataStream::Ok ) {
+        kWarning() << "Corrupted ontology snapshot" << file.fileName();
+        return false;
+    }
+
+    // The entries follow the index
+    const qint64 dataStart = stream.device()->pos();
+    for( int i = 0; i < offsets.count(); ++i ) {
+        const qint64 pos = dataStart + offsets[i].second;
+        if( pos >= size ) {
+            kWarning() << "Corrupted ontology snapshot" << file.fileName();
+            return false;
+        }
+        index.insert( offsets[i].first, pos );
+    }
+
+    return true;
+}
+
+
+Nepomuk2::Types::OntologySnapshot::OntologySnapshot()
+    : d( new Private )
+{
+    d->lastSize = -1;
+}
+
+
+Nepomuk2::Types::OntologySnapshot::~OntologySnapshot()
+{
+    delete d;
+}
+
+
+bool Nepomuk2::Types::OntologySnapshot::open( const QString& path )
+{
+    QExplicitlySharedDataPointer<Private::Data> data( new Private::Data() );
+    data->file.setFileName( path );
+
+    const QFileInfo info( path );
+    bool valid = false;
+    if( info.exists() && data->file.open( QIODevice::ReadOnly ) ) {
+        data->size = data->file.size();
+        data->map = data->file.map( 0, data->size );
+        valid = data->map && data->readIndex();
+    }
+
+    QMutexLocker lock( &d->mutex );
+    d->path = path;
+    d->lastModified = info.lastModified();
+    d->lastSize = info.exists() ? info.size() : -1;
+    if( valid )
+        d->data = data;
+    else
+        d->data.reset();
+
+    return valid;
+}
+
+
+void Nepomuk2::Types::OntologySnapshot::reload()
+{
+    QString path;
+    QDateTime lastModified;
+    qint64 lastSize = -1;
+    {
+        QMutexLocker lock( &d->mutex );
+        path = d->path;
+        lastModified = d->lastModified;
+        lastSize = d->lastSize;
+    }
+
+    if( path.isEmpty() )
+        return;
+
+    const QFileInfo info( path );
+    const qint64 size = info.exists() ? info.size() : -1;
+    if( info.lastModified() != lastModified || size != lastSize ) {
+        kDebug() << "Reopening changed ontology snapshot" << path;
+        open( path );
+    }
+}
+
+
+void Nepomuk2::Types::OntologySnapshot::close()
+{
+    QMutexLocker lock( &d->mutex );
+    d->path.clear();
+    d->lastModified = QDateTime();
+    d->lastSize = -1;
+    d->data.reset();
+}
+
+
+bool Nepomuk2::Types::OntologySnapshot::isValid() const
+{
+    QMutexLocker lock( &d->mutex );
+    return d->data.data() != 0;
+}
+
+
+bool Nepomuk2::Types::OntologySnapshot::entry( const QUrl& uri, Entry& entry ) const
+{
+    // Take a reference so a concurrent reload() cannot unmap the file under our feet
+    QExplicitlySharedDataPointer<Private::Data> data;
+    {
+        QMutexLocker lock( &d->mutex );
+        data = d->data;
+    }
+    if( !data )
+        return false;
+
+    entry = Entry();
+
+    QHash<QByteArray, qint64>::const_iterator it = data->index.constFind( uri.toEncoded() );
+    if( it == data->index.constEnd() )
+        return true;
+
+    const QByteArray bytes = QByteArray::fromRawData( reinterpret_cast<const char*>( data->map ) + it.value(),
+                                                      data->size - it.value() );
+    QDataStream stream( bytes );
+    stream.setVersion( s_streamVersion );
+    readEntry( stream, entry );
+
+    if( stream.status() != QDataStream::Ok ) {
+        kWarning() << "Corrupted ontology snapshot entry for" << uri;
+        entry = Entry();
+        return false;
+    }
+
+    return true;
+}
+
+
+namespace {
+    class OntologySnapshotHolder
+    {
+    public:
+        OntologySnapshotHolder() {
+            snapshot.open( Nepomuk2::Types::OntologySnapshot::defaultPath() );
+        }
+
+        Nepomuk2::Types::OntologySnapshot snapshot;
+    };
+}
+
+Q_GLOBAL_STATIC( OntologySnapshotHolder, s_snapshotHolder )
+
+// static
+Nepomuk2::Types::OntologySnapshot* Nepomuk2::Types::OntologySnapshot::self()
+{
+    return &s_snapshotHolder()->snapshot;
+}
+
+
+// static
+QString Nepomuk2::Types::OntologySnapshot::defaultPath()
+{
+    return KStandardDirs::locateLocal( "data", QLatin1String( "nepomuk/ontologies.snapshot" ) );
+}
+
+
+// static
+bool Nepomuk2::Types::OntologySnapshot::write( const QHash<QUrl, Entry>& entries, const QString& path )
+{
+    // Serialize the entries first to know their offsets
+    QByteArray entryData;
+    QList<QPair<QByteArray, quint32> > offsets;
+    {
+        QDataStream stream( &entryData, QIODevice::WriteOnly );
+        stream.setVersion( s_streamVersion );
+
+        QHash<QUrl, Entry>::const_iterator end = entries.constEnd();
+        for( QHash<QUrl, Entry>::const_iterator it = entries.constBegin(); it != end; ++it ) {
+            offsets << qMakePair( it.key().toEncoded(), quint32( stream.device()->pos() ) );
+            writeEntry( stream, it.value() );
+        }
+    }
+
+    KSaveFile file( path );
+    if( !file.open() ) {
+        kWarning() << "Failed to write the ontology snapshot" << path << file.errorString();
+        return false;
+    }
+
+    QDataStream stream( &file );
+    stream.setVersion( s_streamVersion );
+    stream << s_magic << s_formatVersion << quint32( offsets.count() );
+    for( int i = 0; i < offsets.count(); ++i ) {
+        stream << offsets[i].first << offsets[i].second;
+    }
+    stream.writeRawData( entryData.constData(), entryData.size() );
+
+    if( stream.status() != QDataStream::Ok ) {
+        kWarning() << "Failed to write the ontology snapshot" << path;
+        file.abort();
+        return false;
+    }
+
+    return file.finalize();
+}
+
+
+// static
+bool Nepomuk2::Types::OntologySnapshot::create( Soprano::Model* model, const QString& path )
+{
+    QHash<QUrl, Entry> entries;
+
+    QSet<QUrl> classes;
+    QSet<QUrl> properties;
+    QHash<QUrl, QList<QUrl> > classParents;
+    QHash<QUrl, QList<QUrl> > propertyParents;
+    QHash<QUrl, QList<QUrl> > domains;
+    QHash<QUrl, QList<QUrl> > graphClasses;
+    QHash<QUrl, QList<QUrl> > graphProperties;
+
+    // One query for everything EntityPrivate::load() and loadAncestors() would ask for
+    const QString query = QString::fromLatin1( "select ?g ?s ?p ?o where { "
+                                               "graph ?g { ?s ?p ?o . } . "
+                                               "{ ?g a %1 . } UNION { ?g a %2 . } . }" )
+                          .arg( Soprano::Node::resourceToN3( NRL::Ontology() ),
+                                Soprano::Node::resourceToN3( NRL::KnowledgeBase() ) );
+
+    Soprano::QueryResultIterator it = model->executeQuery( query, Soprano::Query::QueryLanguageSparql );
+    while( it.next() ) {
+        const QUrl graph = it[0].uri();
+        const QUrl subject = it[1].uri();
+        const QUrl property = it[2].uri();
+        const Soprano::Node object = it[3];
+
+        entries[subject].properties << qMakePair( property, object );
+        if( !object.isResource() )
+            continue;
+
+        const QUrl objectUri = object.uri();
+        entries[objectUri].ancestors << qMakePair( subject, property );
+
+        if( property == RDF::type() ) {
+            if( objectUri == RDFS::Class() || objectUri == OWL::Class() )
+                classes.insert( subject );
+            else if( objectUri == RDF::Property() )
+                properties.insert( subject );
+
+            if( objectUri == RDFS::Class() )
+                graphClasses[graph] << subject;
+            else if( objectUri == RDF::Property() )
+                graphProperties[graph] << subject;
+        }
+        else if( property == RDFS::subClassOf() ) {
+            classParents[subject] << objectUri;
+        }
+        else if( property == RDFS::subPropertyOf() ) {
+            propertyParents[subject] << objectUri;
+        }
+        else if( property == RDFS::domain() ) {
+            domains[subject] << objectUri;
+        }
+        else if( property == RDFS::range() ) {
+            entries[objectUri].rangeOf << subject;
+        }
+    }
+    if( it.lastError() ) {
+        kWarning() << "Failed to read the ontologies:" << it.lastError().message();
+        return false;
+    }
+
+    // The ontologies are identified by their default namespace
+    it = model->executeQuery( QString::fromLatin1( "select ?g ?ns where { ?g %1 ?ns . }" )
+                              .arg( Soprano::Node::resourceToN3( NAO::hasDefaultNamespace() ) ),
+                              Soprano::Query::QueryLanguageSparql );
+    while( it.next() ) {
+        const QUrl graph = it[0].uri();
+        Entry& ontology = entries[QUrl( it[1].toString() )];
+        ontology.classes << graphClasses.value( graph );
+        ontology.ontologyProperties << graphProperties.value( graph );
+    }
+    if( it.lastError() ) {
+        kWarning() << "Failed to read the ontology namespaces:" << it.lastError().message();
+        return false;
+    }
+
+    // All classes without a super class are direct children of rdfs:Resource
+    QList<QPair<QUrl, QUrl> > resourceChildren;
+    foreach( const QUrl& c, classes ) {
+        Entry& entry = entries[c];
+        entry.superEntities = closure( c, classParents );
+        if( c != RDFS::Resource() ) {
+            if( !entry.superEntities.contains( RDFS::Resource() ) )
+                entry.superEntities << RDFS::Resource();
+            if( !classParents.contains( c ) )
+                resourceChildren << qMakePair( c, RDFS::subClassOf() );
+        }
+    }
+    entries[RDFS::Resource()].ancestors << resourceChildren;
+
+    foreach( const QUrl& p, properties ) {
+        entries[p].superEntities = closure( p, propertyParents );
+        foreach( const QUrl& domain, effectiveDomains( p, domains, propertyParents ) ) {
+            entries[domain].domainOf << p;
+        }
+    }
+
+    kDebug() << "Writing ontology snapshot with" << classes.count() << "classes and" << properties.count() << "properties";
+
+    return write( entries, path );
+}
@@ -0,0 +1,125 @@
+/*
+    This file is part of the Nepomuk KDE project.
+    Copyright (C) 2013  Nepomuk Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef _NEPOMUK2_ONTOLOGY_SNAPSHOT_H_
+#define _NEPOMUK2_ONTOLOGY_SNAPSHOT_H_
+
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QPair>
+#include <QtCore/QString>
+#include <QtCore/QUrl>
+
+#include <Soprano/Node>
+
+#include "nepomuk_export.h"
+
+namespace Soprano {
+    class Model;
+}
+
+namespace Nepomuk2 {
+    namespace Types {
+        /**
+         * A precompiled binary copy of all classes, properties and ontologies which
+         * allows the Types API to load entities without a single query.
+         *
+         * The snapshot is created by the storage service whenever the ontologies
+         * change and removed as soon as an ontology update starts. The file consists
+         * of a small index followed by the serialized entries. Only the index is
+         * read on open, the entries are decoded from the memory-mapped file on demand.
+         *
+         * Entity::reset() reopens the snapshot if it has been replaced in the
+         * meantime. A missing file or one with a different format version is
+         * simply ignored, in which case the Types API falls back to SPARQL.
+         */
+        class NEPOMUK_EXPORT OntologySnapshot
+        {
+        public:
+            struct Entry {
+                /// the results of EntityPrivate::load(), ie. all (?p, ?o) of the entity in the ontology graphs
+                QList<QPair<QUrl, Soprano::Node> > properties;
+
+                /// the results of EntityPrivate::loadAncestors(), ie. all (?s, ?p) pointing to the entity
+                QList<QPair<QUrl, QUrl> > ancestors;
+
+                /// the transitive closure of rdfs:subClassOf or rdfs:subPropertyOf
+                QList<QUrl> superEntities;
+
+                /// classes only: the properties with this class as (inherited) domain or as range
+                QList<QUrl> domainOf;
+                QList<QUrl> rangeOf;
+
+                /// ontologies only: the classes and properties defined in the ontology
+                QList<QUrl> classes;
+                QList<QUrl> ontologyProperties;
+            };
+
+            OntologySnapshot();
+            ~OntologySnapshot();
+
+            /**
+             * Open the snapshot at \p path, closing the currently opened one.
+             * \return \p true if the file exists and has the current format version.
+             */
+            bool open( const QString& path );
+
+            /**
+             * Reopen the snapshot if the file changed since it was opened.
+             */
+            void reload();
+
+            void close();
+
+            bool isValid() const;
+
+            /**
+             * Decode the entry for \p uri.
+             *
+             * \return \p false if the snapshot is not valid. For a valid snapshot
+             * an unknown \p uri results in an empty entry, which is exactly what the
+             * queries would have returned.
+             */
+            bool entry( const QUrl& uri, Entry& entry ) const;
+
+            /**
+             * The snapshot used by the Types API. It is opened on first use.
+             */
+            static OntologySnapshot* self();
+
+            static QString defaultPath();
+
+            /**
+             * Create the snapshot at \p path from the ontology graphs in \p model.
+             * Used by the storage service.
+             */
+            static bool create( Soprano::Model* model, const QString& path );
+
+            static bool write( const QHash<QUrl, Entry>& entries, const QString& path );
+
+        private:
+            class Private;
+            Private* const d;
+
+            Q_DISABLE_COPY( OntologySnapshot )
+        };
+    }
+}
+
+#endif
@@ -19,6 +19,7 @@
 
 #include "property.h"
 #include "property_p.h"
+#include "ontologysnapshot_p.h"
 #include "class.h"
 #include "ontology.h"
 #include "literal.h"
@@ -124,7 +125,7 @@ void Nepomuk2::Types::PropertyPrivate::reset( bool recursive )
         }
 
         parents.clear();
-        available = -1;
+        available.fetchAndStoreOrdered( -1 );
     }
 
     if ( ancestorsAvailable != -1 ) {
@@ -135,7 +136,7 @@ void Nepomuk2::Types::PropertyPrivate::reset( bool recursive )
         }
 
         children.clear();
-        ancestorsAvailable = -1;
+        ancestorsAvailable.fetchAndStoreOrdered( -1 );
     }
 
     EntityPrivate::reset( recursive );
@@ -434,7 +435,10 @@ bool Nepomuk2::Types::Property::isSubPropertyOf( const Property& other )
     if ( d ) {
         D->init();
 
-        if ( D->parents.contains( other ) ) {
+        if ( D->superEntitiesAvailable ) {
+            return D->superEntities.contains( other.uri() );
+        }
+        else if ( D->parents.contains( other ) ) {
             return true;
         }
         else {
@@ -19,24 +19,44 @@
 
 
 #include "basicindexingqueue.h"
+#include "directorycrawler.h"
+#include "directoryjournal.h"
 #include "fileindexerconfig.h"
+#include "mimetyperesolver.h"
 #include "util.h"
 #include "indexer/simpleindexer.h"
 
-#include "resourcemanager.h"
-
-#include <Soprano/Model>
-#include <Soprano/QueryResultIterator>
-
 #include <KDebug>
-#include <KMimeType>
 #include <QtCore/QDateTime>
+#include <QtCore/QHash>
+#include <QtCore/QStringList>
+
+namespace {
+    /// the maximum number of files whose basic data is stored at once
+    const int s_maxBatchSize = 50;
+}
 
 namespace Nepomuk2 {
 
 BasicIndexingQueue::BasicIndexingQueue(QObject* parent): IndexingQueue(parent)
 {
+    m_unbatchedCount = 0;
+    m_journal = new DirectoryJournal();
+    m_journalComplete = true;
+
+    m_crawler = new DirectoryCrawler( m_journal, this );
+    m_waitingForCrawler = false;
+    connect( m_crawler, SIGNAL(folderAvailable()), this, SLOT(slotCrawlerProgress()) );
+    connect( m_crawler, SIGNAL(finished()), this, SLOT(slotCrawlerProgress()) );
 
+    connect( this, SIGNAL(finishedIndexing()), this, SLOT(slotFinishedIndexing()) );
+}
+
+BasicIndexingQueue::~BasicIndexingQueue()
+{
+    // The crawler threads use the journal
+    delete m_crawler;
+    delete m_journal;
 }
 
 void BasicIndexingQueue::clear()
@@ -44,16 +64,47 @@ void BasicIndexingQueue::clear()
     m_currentUrl.clear();
     m_currentFlags = NoUpdateFlags;
     m_paths.clear();
+    m_batchUrls.clear();
+    m_batchMimeTypes.clear();
+    m_unbatchedCount = 0;
+    m_crawler->clear();
+
+    m_journal->discardPending();
+    m_journalComplete = true;
+
+    // The queue is cleared whenever the configuration changes
+    m_journal->checkConfig();
 }
 
 void BasicIndexingQueue::clear(const QString& path)
 {
-    QMutableVectorIterator< QPair<QString, UpdateDirFlags> > it( m_paths );
+    if( !m_crawler->isIdle() ) {
+        m_crawler->clear( path );
+
+        m_journal->discardPending();
+        m_journalComplete = false;
+    }
+
+    QMutableVectorIterator<Entry> it( m_paths );
     while( it.hasNext() ) {
         it.next();
-        if( it.value().first.startsWith( path ) )
+        if( isInFolder( it.value().path, path ) ) {
             it.remove();
+
+            // The dropped folders would be missing from the journal
+            m_journal->discardPending();
+            m_journalComplete = false;
+        }
     }
+
+    for( int i = m_batchUrls.count() - 1; i >= 0; --i ) {
+        if( isInFolder( m_batchUrls[i].toLocalFile(), path ) ) {
+            m_batchUrls.removeAt( i );
+            m_batchMimeTypes.removeAt( i );
+        }
+    }
+
+    m_journal->checkConfig();
 }
 
 QUrl BasicIndexingQueue::currentUrl() const
@@ -69,7 +120,7 @@ UpdateDirFlags BasicIndexingQueue::currentFlags() const
 
 bool BasicIndexingQueue::isEmpty()
 {
-    return m_paths.isEmpty();
+    return m_paths.isEmpty() && m_batchUrls.isEmpty() && m_crawler->isIdle();
 }
 
 void BasicIndexingQueue::enqueue(const QString& path)
@@ -83,8 +134,12 @@ void BasicIndexingQueue::enqueue(const QString& path)
 void BasicIndexingQueue::enqueue(const QString& path, UpdateDirFlags flags)
 {
     kDebug() << path;
-    bool wasEmpty = m_paths.empty();
-    m_paths.push( qMakePair( path, flags ) );
+    bool wasEmpty = isEmpty();
+    Entry entry;
+    entry.path = path;
+    entry.flags = flags;
+    entry.freshness = FreshnessUnknown;
+    m_paths.push( entry );
     callForNextIteration();
 
     if( wasEmpty )
@@ -96,60 +151,110 @@ void BasicIndexingQueue::processNextIteration()
     bool processingFile = false;
 
     if( !m_paths.isEmpty() ) {
-        QPair< QString, UpdateDirFlags > pair = m_paths.pop();
-        processingFile = process( pair.first, pair.second );
+        processingFile = process( m_paths.pop() );
+    }
+    else if( !m_batchUrls.isEmpty() ) {
+        // Store what has been collected before listing the next folder
+        indexBatch();
+        processingFile = true;
+    }
+    else if( m_crawler->hasFolder() ) {
+        enqueueCrawledFolder();
+    }
+    else {
+        // The crawler is still listing folders
+        m_waitingForCrawler = true;
+        return;
     }
 
     if( !processingFile )
         finishIteration();
 }
 
+void BasicIndexingQueue::slotCrawlerProgress()
+{
+    if( m_waitingForCrawler ) {
+        m_waitingForCrawler = false;
+        finishIteration();
+    }
+}
+
 
-bool BasicIndexingQueue::process(const QString& path, UpdateDirFlags flags)
+bool BasicIndexingQueue::process(const Entry& entry)
 {
     bool startedIndexing = false;
 
-    QUrl url = QUrl::fromLocalFile( path );
-    QString mimetype = KMimeType::findByUrl( url )->name();
+    const QString& path = entry.path;
+    const UpdateDirFlags flags = entry.flags;
 
     bool forced = flags & ForceUpdate;
     bool recursive = flags & UpdateRecursive;
-    bool indexingRequired = shouldIndex( path, mimetype );
 
     QFileInfo info( path );
+
+    QUrl url = QUrl::fromLocalFile( path );
+
+    // Going by the name is enough to decide if the file should be indexed. The
+    // content is checked once the file contents are indexed.
+    QString mimetype = MimeTypeResolver::mimeTypeByName( path, info.isDir() );
+    bool indexingRequired = shouldIndex( path, mimetype, entry.freshness );
+
     if( info.isDir() ) {
         if( forced || indexingRequired ) {
-            m_currentUrl = url;
-            m_currentFlags = flags;
-            m_currentMimeType = mimetype;
-
-            startedIndexing = true;
-            index( path );
+            startedIndexing = addToBatch( url, mimetype, flags );
         }
 
         // We don't want to follow system links
         if( recursive && !info.isSymLink() && shouldIndexContents(path) ) {
-            QDir::Filters dirFilter = QDir::NoDotAndDotDot|QDir::Readable|QDir::Files|QDir::Dirs;
-
-            QDirIterator it( path, dirFilter );
-            while( it.hasNext() ) {
-                m_paths.push( qMakePair(it.next(), flags) );
-            }
+            m_crawler->crawl( path, flags );
         }
     }
     else if( info.isFile() && (forced || indexingRequired) ) {
-        m_currentUrl = url;
-        m_currentFlags = flags;
-        m_currentMimeType = mimetype;
-
-        startedIndexing = true;
-        index( path );
+        startedIndexing = addToBatch( url, mimetype, flags );
     }
 
     return startedIndexing;
 }
 
-bool BasicIndexingQueue::shouldIndex(const QString& path, const QString& mimetype)
+void BasicIndexingQueue::enqueueCrawledFolder()
+{
+    const DirectoryCrawler::Folder folder = m_crawler->takeFolder();
+    const QList<DirectoryCrawler::Entry>& children = folder.children;
+
+    if( folder.flags & AutoUpdateFolder ) {
+        if( folder.unchanged )
+            m_journal->keep( folder.path );
+        else if( folder.hasState )
+            m_journal->record( folder.path, folder.state );
+    }
+
+    // Fetch what we know about the children with as few queries as possible instead
+    // of asking once per child
+    QList<QUrl> urls;
+    urls.reserve( children.count() );
+    foreach( const DirectoryCrawler::Entry& child, children ) {
+        urls << QUrl::fromLocalFile( child.path );
+    }
+    const QHash<QUrl, QDateTime> indexed = FreshnessCheck::indexedModificationTimes( urls );
+
+    // The crawler takes care of the subfolders
+    const UpdateDirFlags flags = folder.flags & ~UpdateRecursive;
+    const bool forced = flags & ForceUpdate;
+    for( int i = 0; i < children.count(); ++i ) {
+        const DirectoryCrawler::Entry& child = children[i];
+        Entry entry;
+        entry.path = child.path;
+        entry.flags = flags;
+        entry.freshness = FreshnessCheck::freshness( urls[i], child.isDir,
+                                                     QDateTime::fromTime_t( child.mtime ), indexed );
+
+        if( forced || entry.freshness == Modified ) {
+            m_paths.push( entry );
+        }
+    }
+}
+
+bool BasicIndexingQueue::shouldIndex(const QString& path, const QString& mimetype, Freshness freshness)
 {
     bool shouldIndexFile = FileIndexerConfig::self()->shouldFileBeIndexed( path );
     if( !shouldIndexFile )
@@ -163,28 +268,16 @@ bool BasicIndexingQueue::shouldIndex(const QString& path, const QString& mimetyp
     if( !fileInfo.exists() )
         return false;
 
-    bool needToIndex = false;
-
-    Soprano::Model* model = ResourceManager::instance()->mainModel();
-
-    // Optimization: We don't care about the mtime of directories. If it has been indexed once
-    // then it doesn't need to indexed again - ever
-    if( fileInfo.isDir() ) {
-        QString query = QString::fromLatin1("ask where { ?r nie:url %1 . }")
-                        .arg( Soprano::Node::resourceToN3( QUrl::fromLocalFile(path) ) );
-
-        needToIndex = !model->executeQuery( query, Soprano::Query::QueryLanguageSparqlNoInference ).boolValue();
+    // The folder the path is in already compared it with the database
+    if( freshness != FreshnessUnknown ) {
+        if( freshness == Modified )
+            kDebug() << path;
+        return freshness == Modified;
     }
-    else {
-        // check if this file is new by checking its mtime
-        QString query = QString::fromLatin1("ask where { ?r nie:url %1 ; nie:lastModified ?dt . FILTER(?dt=%2) .}")
-                        .arg( Soprano::Node::resourceToN3( QUrl::fromLocalFile(path) ),
-                            Soprano::Node::literalToN3( Soprano::LiteralValue(fileInfo.lastModified()) ) );
 
-        needToIndex = !model->executeQuery( query, Soprano::Query::QueryLanguageSparqlNoInference ).boolValue();
-    }
-
-    if( needToIndex ) {
+    const QUrl url = QUrl::fromLocalFile( path );
+    const QHash<QUrl, QDateTime> indexed = FreshnessCheck::indexedModificationTimes( QList<QUrl>() << url );
+    if( FreshnessCheck::freshness( url, fileInfo.isDir(), fileInfo.lastModified(), indexed ) == Modified ) {
         kDebug() << path;
         return true;
     }
@@ -197,13 +290,39 @@ bool BasicIndexingQueue::shouldIndexContents(const QString& dir)
     return FileIndexerConfig::self()->shouldFolderBeIndexed( dir );
 }
 
-void BasicIndexingQueue::index(const QString& path)
+bool BasicIndexingQueue::addToBatch(const QUrl& url, const QString& mimetype, UpdateDirFlags flags)
 {
-    kDebug() << path;
-    const QUrl fileUrl = QUrl::fromLocalFile( path );
-    emit beginIndexingFile( fileUrl );
+    if( m_batchUrls.isEmpty() )
+        m_batchFlags = flags;
 
-    KJob* job = clearIndexedData( fileUrl );
+    m_batchUrls << url;
+    m_batchMimeTypes << mimetype;
+
+    const int maxBatchSize = m_unbatchedCount > 0 ? 1 : s_maxBatchSize;
+    if( m_batchUrls.count() < maxBatchSize )
+        return false;
+
+    indexBatch();
+    return true;
+}
+
+void BasicIndexingQueue::indexBatch()
+{
+    m_currentUrls = m_batchUrls;
+    m_currentMimeTypes = m_batchMimeTypes;
+    m_currentUrl = m_currentUrls.first();
+    m_currentFlags = m_batchFlags;
+
+    m_batchUrls.clear();
+    m_batchMimeTypes.clear();
+    if( m_unbatchedCount > 0 )
+        --m_unbatchedCount;
+
+    kDebug() << m_currentUrls;
+    foreach( const QUrl& url, m_currentUrls )
+        emit beginIndexingFile( url );
+
+    KJob* job = clearIndexedData( m_currentUrls );
     connect( job, SIGNAL(finished(KJob*)), this, SLOT(slotClearIndexedDataFinished(KJob*)) );
 }
 
@@ -213,7 +332,7 @@ void BasicIndexingQueue::slotClearIndexedDataFinished(KJob* job)
         kDebug() << job->errorString();
     }
 
-    SimpleIndexingJob* indexingJob = new SimpleIndexingJob( m_currentUrl, m_currentMimeType );
+    SimpleIndexingJob* indexingJob = new SimpleIndexingJob( m_currentUrls, m_currentMimeTypes );
     indexingJob->start();
 
     connect( indexingJob, SIGNAL(finished(KJob*)), this, SLOT(slotIndexingFinished(KJob*)) );
@@ -221,20 +340,48 @@ void BasicIndexingQueue::slotClearIndexedDataFinished(KJob* job)
 
 void BasicIndexingQueue::slotIndexingFinished(KJob* job)
 {
+    const QList<QUrl> urls = m_currentUrls;
+    m_currentUrls.clear();
+    m_currentMimeTypes.clear();
+    m_currentUrl.clear();
+    m_currentFlags = NoUpdateFlags;
+
     if( job->error() ) {
         kDebug() << job->errorString();
-    }
 
-    QUrl url = m_currentUrl;
-    m_currentUrl.clear();
-    m_currentMimeType.clear();
-    m_currentFlags = NoUpdateFlags;
+        // One broken file must not keep the others from being stored. Index
+        // the files of the batch one by one.
+        if( urls.count() > 1 ) {
+            m_unbatchedCount = urls.count();
+            foreach( const QUrl& url, urls ) {
+                Entry entry;
+                entry.path = url.toLocalFile();
+                entry.flags = NoUpdateFlags;
+                entry.freshness = Modified;
+                m_paths.push( entry );
+            }
 
-    emit endIndexingFile( url );
+            finishIteration();
+            return;
+        }
+    }
+
+    foreach( const QUrl& url, urls )
+        emit endIndexingFile( url );
 
     // Continue the queue
     finishIteration();
 }
 
+void BasicIndexingQueue::slotFinishedIndexing()
+{
+    // Only a run which walked all folders may replace the journal
+    if( m_journalComplete )
+        m_journal->commit();
+    else
+        m_journal->discardPending();
+    m_journalComplete = true;
+}
+
 
 }
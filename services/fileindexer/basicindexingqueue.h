@@ -22,8 +22,10 @@
 #define BASICINDEXINGQUEUE_H
 
 #include "indexingqueue.h"
+#include "freshnesscheck.h"
 #include <KJob>
 #include <QtCore/QStack>
+#include <QtCore/QStringList>
 
 namespace Nepomuk2 {
 
@@ -52,16 +54,29 @@ namespace Nepomuk2 {
     };
     Q_DECLARE_FLAGS( UpdateDirFlags, UpdateDirFlag )
 
+    class DirectoryJournal;
+    class DirectoryCrawler;
+
     /**
      * This class represents a simple queue that iterates over the file system tree
      * and indexes each file which meets certain critera. The indexing performed by this
      * queue is very basic. It just pushes the mimetype, url and stat results of the file.
+     *
+     * The folders are listed by a DirectoryCrawler on worker threads. Folders which
+     * are updated automatically are compared with the DirectoryJournal written at the
+     * end of the last complete run, and unchanged subtrees are skipped.
+     *
+     * The basic data of consecutive files is stored in batches of a few
+     * dozen files with one request each. A batch is stored once it is full
+     * or once the queued paths have been processed, before the next folder
+     * is taken from the crawler.
      */
     class BasicIndexingQueue: public IndexingQueue
     {
         Q_OBJECT
     public:
         explicit BasicIndexingQueue(QObject* parent = 0);
+        ~BasicIndexingQueue();
 
         QUrl currentUrl() const;
         UpdateDirFlags currentFlags() const;
@@ -85,15 +100,31 @@ namespace Nepomuk2 {
     private slots:
         void slotClearIndexedDataFinished(KJob* job);
         void slotIndexingFinished(KJob* job);
+        void slotFinishedIndexing();
+        void slotCrawlerProgress();
 
     private:
         /**
-         * This method does not need to be synchronous. The indexing operation may be started
-         * and on completion, the finishedIndexing method should be called
+         * Add \p url to the batch of files whose basic data is stored next.
+         *
+         * \return \c true if the batch is full and its indexing was started
          */
-        void index(const QString& path);
+        bool addToBatch(const QUrl& url, const QString& mimetype, UpdateDirFlags flags);
 
-        bool shouldIndex(const QString& path, const QString& mimetype);
+        /**
+         * Clear the indexed data of the batched files and store their basic
+         * data. The indexing is asynchronous, slotIndexingFinished continues
+         * the queue.
+         */
+        void indexBatch();
+
+        struct Entry {
+            QString path;
+            UpdateDirFlags flags;
+            Freshness freshness;
+        };
+
+        bool shouldIndex(const QString& path, const QString& mimetype, Freshness freshness);
         bool shouldIndexContents(const QString& dir);
 
         /**
@@ -104,12 +135,37 @@ namespace Nepomuk2 {
          * \return \c true the path is being indexed
          * \return \c false the path did not meet the criteria
          */
-        bool process(const QString& path, Nepomuk2::UpdateDirFlags flags);
+        bool process(const Entry& entry);
+
+        /**
+         * Push the contents of the next folder listed by the crawler. The
+         * nie:lastModified of all children is fetched at once and only new or
+         * modified files and folders are queued.
+         */
+        void enqueueCrawledFolder();
+
+        QStack<Entry> m_paths;
+
+        DirectoryJournal* m_journal;
+        DirectoryCrawler* m_crawler;
+        bool m_waitingForCrawler;
+
+        /// false if parts of the current run have been dropped
+        bool m_journalComplete;
+
+        /// the files waiting for the next batch
+        QList<QUrl> m_batchUrls;
+        QStringList m_batchMimeTypes;
+        UpdateDirFlags m_batchFlags;
+
+        /// the number of batches which are limited to one file after a batch failed
+        int m_unbatchedCount;
 
-        QStack< QPair<QString, UpdateDirFlags> > m_paths;
+        /// the batch being indexed
+        QList<QUrl> m_currentUrls;
+        QStringList m_currentMimeTypes;
 
         QUrl m_currentUrl;
-        QString m_currentMimeType;
         UpdateDirFlags m_currentFlags;
     };
 
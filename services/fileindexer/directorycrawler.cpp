@@ -0,0 +1,277 @@
+/*
+    This file is part of the Nepomuk KDE project.
+    Copyright (C) 2013  Nepomuk Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "directorycrawler.h"
+#include "directoryjournal.h"
+#include "fileindexerconfig.h"
+#include "util.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QThread>
+#include <QtCore/QRunnable>
+#include <QtCore/QMutexLocker>
+
+#include <KDebug>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+    /// the number of listed entries after which the worker threads wait for the consumer
+    const int s_maxWaitingEntries = 20000;
+}
+
+class Nepomuk2::DirectoryCrawler::CrawlTask : public QRunnable
+{
+public:
+    CrawlTask(DirectoryCrawler* crawler, const QString& path, UpdateDirFlags flags, int serial)
+        : m_crawler( crawler ),
+          m_path( path ),
+          m_flags( flags ),
+          m_serial( serial ) {
+    }
+
+    void run() {
+        m_crawler->crawlFolder( m_path, m_flags, m_serial );
+        m_crawler->taskDone();
+    }
+
+private:
+    DirectoryCrawler* m_crawler;
+    QString m_path;
+    UpdateDirFlags m_flags;
+    int m_serial;
+};
+
+
+Nepomuk2::DirectoryCrawler::DirectoryCrawler(DirectoryJournal* journal, QObject* parent)
+    : QObject( parent ),
+      m_journal( journal ),
+      m_waitingEntries( 0 ),
+      m_runningTasks( 0 ),
+      m_serial( 0 )
+{
+    // Listing is bound by the disk. A few threads are enough to keep
+    // its queue filled.
+    m_threadPool.setMaxThreadCount( qBound( 2, QThread::idealThreadCount(), 4 ) );
+}
+
+Nepomuk2::DirectoryCrawler::~DirectoryCrawler()
+{
+    clear();
+    m_threadPool.waitForDone();
+}
+
+void Nepomuk2::DirectoryCrawler::crawl(const QString& path, UpdateDirFlags flags)
+{
+    QString folder = path;
+    if( folder.length() > 1 && folder.endsWith( QLatin1Char('/') ) )
+        folder.chop( 1 );
+
+    QMutexLocker lock( &m_mutex );
+    startTask( folder, flags, ++m_serial );
+}
+
+void Nepomuk2::DirectoryCrawler::startTask(const QString& path, UpdateDirFlags flags, int serial)
+{
+    // called with m_mutex locked
+    ++m_runningTasks;
+    m_threadPool.start( new CrawlTask( this, path, flags, serial ) );
+}
+
+bool Nepomuk2::DirectoryCrawler::isIdle() const
+{
+    QMutexLocker lock( &m_mutex );
+    return m_runningTasks == 0 && m_folders.isEmpty();
+}
+
+bool Nepomuk2::DirectoryCrawler::hasFolder() const
+{
+    QMutexLocker lock( &m_mutex );
+    return !m_folders.isEmpty();
+}
+
+Nepomuk2::DirectoryCrawler::Folder Nepomuk2::DirectoryCrawler::takeFolder()
+{
+    QMutexLocker lock( &m_mutex );
+    Folder folder = m_folders.dequeue();
+    m_waitingEntries -= folder.children.count();
+    m_folderTaken.wakeAll();
+    return folder;
+}
+
+void Nepomuk2::DirectoryCrawler::clear()
+{
+    clear( QString() );
+}
+
+void Nepomuk2::DirectoryCrawler::clear(const QString& path)
+{
+    QMutexLocker lock( &m_mutex );
+
+    QMutableListIterator<Folder> it( m_folders );
+    while( it.hasNext() ) {
+        const Folder& folder = it.next();
+        if( isInFolder( folder.path, path ) ) {
+            m_waitingEntries -= folder.children.count();
+            it.remove();
+        }
+    }
+
+    if( m_runningTasks )
+        m_cancelled << qMakePair( path, m_serial );
+
+    m_folderTaken.wakeAll();
+}
+
+bool Nepomuk2::DirectoryCrawler::isCancelled(const QString& path, int serial) const
+{
+    for( int i = 0; i < m_cancelled.count(); ++i ) {
+        if( serial <= m_cancelled[i].second && isInFolder( path, m_cancelled[i].first ) )
+            return true;
+    }
+    return false;
+}
+
+void Nepomuk2::DirectoryCrawler::crawlFolder(const QString& path, UpdateDirFlags flags, int serial)
+{
+    {
+        QMutexLocker lock( &m_mutex );
+        if( isCancelled( path, serial ) )
+            return;
+    }
+
+    FileIndexerConfig* config = FileIndexerConfig::self();
+    const bool indexHidden = config->indexHiddenFilesAndFolders();
+    const bool useJournal = m_journal && ( flags & AutoUpdateFolder ) && !( flags & ForceUpdate );
+
+    Folder folder;
+    folder.path = path;
+    folder.flags = flags;
+
+    // The entries of an unchanged folder are the same as in the last run, but its
+    // subfolders still have to be checked for changes further down.
+    folder.unchanged = useJournal && m_journal->isUnchanged( path );
+
+    // Taken before the listing so that changes made in the meantime show up in the next run
+    folder.hasState = m_journal && !folder.unchanged && DirectoryJournal::folderState( path, &folder.state );
+
+    QStringList subFolders;
+
+    // readdir fetches the entries in large batches
+    DIR* dir = ::opendir( QFile::encodeName( path ).constData() );
+    if( !dir ) {
+        kDebug() << "Could not open" << path;
+        folder.hasState = false;
+    }
+    else {
+        const int fd = ::dirfd( dir );
+        while( dirent* ent = ::readdir( dir ) ) {
+            const char* name = ent->d_name;
+            if( name[0] == '.' ) {
+                if( name[1] == '\0' || ( name[1] == '.' && name[2] == '\0' ) || !indexHidden )
+                    continue;
+            }
+
+#ifdef DT_DIR
+            // Saves the fstatat of the files. Symbolic links are not followed into folders anyway.
+            if( folder.unchanged && ent->d_type != DT_DIR && ent->d_type != DT_UNKNOWN )
+                continue;
+#endif
+
+            const QString fileName = QFile::decodeName( name );
+            if( !config->shouldFileBeIndexed( fileName ) )
+                continue;
+
+            struct stat st;
+            if( ::fstatat( fd, name, &st, AT_SYMLINK_NOFOLLOW ) != 0 )
+                continue;
+
+            // We index the target of symbolic links but don't follow them into folders
+            const bool isSymLink = S_ISLNK( st.st_mode );
+            if( isSymLink && ::fstatat( fd, name, &st, 0 ) != 0 )
+                continue;
+
+            if( !S_ISDIR( st.st_mode ) && !S_ISREG( st.st_mode ) )
+                continue;
+
+            if( ::faccessat( fd, name, R_OK, 0 ) != 0 )
+                continue;
+
+            Entry entry;
+            entry.path = path + QLatin1Char('/') + fileName;
+            entry.isDir = S_ISDIR( st.st_mode );
+            entry.mtime = st.st_mtime;
+            if( !folder.unchanged )
+                folder.children << entry;
+
+            if( entry.isDir && !isSymLink )
+                subFolders << entry.path;
+        }
+        ::closedir( dir );
+    }
+
+    QStringList foldersToCrawl;
+    foreach( const QString& subFolder, subFolders ) {
+        if( config->shouldFolderBeIndexed( subFolder ) )
+            foldersToCrawl << subFolder;
+    }
+
+    QMutexLocker lock( &m_mutex );
+    if( isCancelled( path, serial ) )
+        return;
+
+    foreach( const QString& subFolder, foldersToCrawl ) {
+        startTask( subFolder, flags, serial );
+    }
+
+    // Let the consumer catch up. A single folder is always accepted, however large.
+    while( m_waitingEntries >= s_maxWaitingEntries && !m_folders.isEmpty() &&
+           !isCancelled( path, serial ) ) {
+        m_folderTaken.wait( &m_mutex );
+    }
+
+    if( isCancelled( path, serial ) )
+        return;
+
+    const bool wasEmpty = m_folders.isEmpty();
+    m_waitingEntries += folder.children.count();
+    m_folders.enqueue( folder );
+    lock.unlock();
+
+    if( wasEmpty )
+        emit folderAvailable();
+}
+
+void Nepomuk2::DirectoryCrawler::taskDone()
+{
+    QMutexLocker lock( &m_mutex );
+    if( --m_runningTasks > 0 )
+        return;
+
+    m_cancelled.clear();
+    lock.unlock();
+
+    emit finished();
+}
+
+#include "directorycrawler.moc"
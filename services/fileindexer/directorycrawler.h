@@ -0,0 +1,149 @@
+/*
+    This file is part of the Nepomuk KDE project.
+    Copyright (C) 2013  Nepomuk Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef FILEINDEXER_DIRECTORYCRAWLER_H
+#define FILEINDEXER_DIRECTORYCRAWLER_H
+
+#include "basicindexingqueue.h" // Required for UpdateDirFlags
+#include "directoryjournal.h"
+
+#include <QtCore/QObject>
+#include <QtCore/QQueue>
+#include <QtCore/QPair>
+#include <QtCore/QStringList>
+#include <QtCore/QMutex>
+#include <QtCore/QWaitCondition>
+#include <QtCore/QThreadPool>
+
+namespace Nepomuk2 {
+
+    /**
+     * Lists folder trees on a pool of worker threads.
+     *
+     * Each folder is read with a single pass over its entries and one
+     * fstatat per entry. The exclude filters, hidden files and the folder
+     * configuration of the FileIndexerConfig are applied right away so that
+     * excluded subtrees are never entered. Of the folders which did not change
+     * according to the DirectoryJournal only the subfolders are listed, since
+     * changes further down do not show up in the state of their ancestors.
+     *
+     * The listed folders are handed to the consumer with takeFolder(). Once
+     * too many entries are waiting, the worker threads block until the
+     * consumer catches up.
+     */
+    class DirectoryCrawler : public QObject
+    {
+        Q_OBJECT
+
+    public:
+        /**
+         * \param journal The journal used to skip unchanged folders. It
+         * must not be committed while the crawler is running.
+         */
+        explicit DirectoryCrawler(DirectoryJournal* journal, QObject* parent = 0);
+        ~DirectoryCrawler();
+
+        struct Entry {
+            QString path;
+            bool isDir;
+            uint mtime;
+        };
+
+        struct Folder {
+            QString path;
+            UpdateDirFlags flags;
+
+            /// The state of the folder before it was listed, only valid with \p hasState
+            DirectoryJournal::FolderState state;
+            bool hasState;
+
+            /// The folder did not change since the last run, \p children is empty
+            bool unchanged;
+
+            /// The children which passed the filters
+            QList<Entry> children;
+        };
+
+        /**
+         * Start listing \p path and all its subfolders which should be indexed.
+         * \p path itself is not checked against the configuration.
+         */
+        void crawl(const QString& path, UpdateDirFlags flags);
+
+        /**
+         * \return \p true if no folder is being listed and none is waiting
+         * to be taken.
+         */
+        bool isIdle() const;
+
+        bool hasFolder() const;
+        Folder takeFolder();
+
+        /**
+         * Stop listing and drop all listed folders.
+         */
+        void clear();
+
+        /**
+         * Stop listing and drop the listed folders in \p path.
+         */
+        void clear(const QString& path);
+
+    Q_SIGNALS:
+        /**
+         * Emitted once a folder is available after there was none.
+         * Emitted from a worker thread.
+         */
+        void folderAvailable();
+
+        /**
+         * Emitted once all folders have been listed.
+         * Emitted from a worker thread.
+         */
+        void finished();
+
+    private:
+        class CrawlTask;
+
+        void startTask(const QString& path, UpdateDirFlags flags, int serial);
+        void crawlFolder(const QString& path, UpdateDirFlags flags, int serial);
+        void taskDone();
+
+        /// must be called with m_mutex locked
+        bool isCancelled(const QString& path, int serial) const;
+
+        DirectoryJournal* m_journal;
+        QThreadPool m_threadPool;
+
+        mutable QMutex m_mutex;
+        QWaitCondition m_folderTaken;
+
+        QQueue<Folder> m_folders;
+        int m_waitingEntries;
+        int m_runningTasks;
+
+        /// Each call to crawl() gets a new serial which is passed on to its subfolders
+        int m_serial;
+
+        /// The cleared paths together with the last serial they apply to
+        QList<QPair<QString, int> > m_cancelled;
+    };
+}
+
+#endif // FILEINDEXER_DIRECTORYCRAWLER_H
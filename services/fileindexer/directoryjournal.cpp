@@ -0,0 +1,419 @@
+/*
+    This file is part of the Nepomuk KDE project.
+    Copyright (C) 2013  Nepomuk Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "directoryjournal.h"
+#include "fileindexerconfig.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QStringList>
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QReadWriteLock>
+
+#include <KDebug>
+#include <KSaveFile>
+#include <KStandardDirs>
+#include <kde_file.h>
+
+#include <algorithm>
+
+namespace {
+    const quint32 s_magic = 0x4e444a4c; // "NDJL"
+    const quint32 s_version = 1;
+
+    struct Key {
+        quint64 device;
+        quint64 inode;
+    };
+
+    bool operator==( const Key& k1, const Key& k2 ) {
+        return k1.device == k2.device && k1.inode == k2.inode;
+    }
+
+    bool operator<( const Key& k1, const Key& k2 ) {
+        return k1.device < k2.device || ( k1.device == k2.device && k1.inode < k2.inode );
+    }
+
+    uint qHash( const Key& key ) {
+        return ::qHash( key.inode ) ^ ( ::qHash( key.device ) << 16 );
+    }
+
+    /// The on-disk record, the file is an array of them sorted by key
+    struct Record {
+        Key key;
+        Key parent;
+        qint64 mtime;
+        quint64 linkCount;
+    };
+
+    bool recordLessThan( const Record& r1, const Record& r2 ) {
+        return r1.key < r2.key;
+    }
+
+    bool recordKeyLessThan( const Record& r, const Key& key ) {
+        return r.key < key;
+    }
+
+    struct Header {
+        quint32 magic;
+        quint32 version;
+        char configHash[16];
+        quint32 count;
+        quint32 reserved;
+    };
+
+    bool statFolder( const QString& path, Record* record ) {
+        KDE_struct_stat buf;
+        if( KDE::lstat( path, &buf ) != 0 || !S_ISDIR( buf.st_mode ) )
+            return false;
+
+        record->key.device = buf.st_dev;
+        record->key.inode = buf.st_ino;
+        record->mtime = buf.st_mtime;
+        record->linkCount = buf.st_nlink;
+        return true;
+    }
+
+    bool statKey( const QString& path, Key* key ) {
+        Record record;
+        if( !statFolder( path, &record ) )
+            return false;
+        *key = record.key;
+        return true;
+    }
+
+    /// A hash of all settings which influence what the scan finds
+    QByteArray configHash() {
+        Nepomuk2::FileIndexerConfig* config = Nepomuk2::FileIndexerConfig::self();
+
+        QStringList includes = config->includeFolders();
+        QStringList excludes = config->excludeFolders();
+        QStringList filters = config->excludeFilters();
+        QStringList mimetypes = config->excludeMimetypes();
+        qSort( includes );
+        qSort( excludes );
+        qSort( filters );
+        qSort( mimetypes );
+
+        QCryptographicHash hash( QCryptographicHash::Md5 );
+        hash.addData( includes.join( QLatin1String("\n") ).toUtf8() );
+        hash.addData( "\1" );
+        hash.addData( excludes.join( QLatin1String("\n") ).toUtf8() );
+        hash.addData( "\1" );
+        hash.addData( filters.join( QLatin1String("\n") ).toUtf8() );
+        hash.addData( "\1" );
+        hash.addData( mimetypes.join( QLatin1String("\n") ).toUtf8() );
+        hash.addData( config->indexHiddenFilesAndFolders() ? "1" : "0" );
+        return hash.result();
+    }
+}
+
+
+class Nepomuk2::DirectoryJournal::Private
+{
+public:
+    Private()
+        : records( 0 ),
+          count( 0 ),
+          data( 0 ) {
+    }
+
+    void open();
+    void close();
+    const Record* find( const Key& key ) const;
+
+    QString path;
+
+    /// the hash of the configuration the journal and the pending folders belong to
+    QByteArray configHash;
+
+    /// isUnchanged() is called from the crawler threads while the journal is reopened
+    mutable QReadWriteLock lock;
+
+    QFile file;
+    const Record* records;
+    quint32 count;
+    uchar* data;
+
+    /// the folders whose contents have been queued since the last commit
+    QHash<Key, Record> recorded;
+
+    /// the folders whose subtrees have been skipped since the last commit
+    QList<Key> kept;
+};
+
+
+void Nepomuk2::DirectoryJournal::Private::open()
+{
+    close();
+
+    configHash = ::configHash();
+
+    file.setFileName( path );
+    if( !file.open( QIODevice::ReadOnly ) )
+        return;
+
+    const qint64 size = file.size();
+    if( size < qint64(sizeof(Header)) ) {
+        file.close();
+        return;
+    }
+
+    data = file.map( 0, size );
+    if( !data ) {
+        file.close();
+        return;
+    }
+
+    const Header* header = reinterpret_cast<const Header*>( data );
+    if( header->magic != s_magic ||
+        header->version != s_version ||
+        qint64(sizeof(Header)) + qint64(header->count) * qint64(sizeof(Record)) > size ) {
+        kDebug() << "Ignoring invalid folder journal" << path;
+        close();
+        return;
+    }
+
+    if( QByteArray::fromRawData( header->configHash, sizeof(header->configHash) ) != configHash ) {
+        kDebug() << "The configuration changed, ignoring the folder journal.";
+        close();
+        return;
+    }
+
+    records = reinterpret_cast<const Record*>( data + sizeof(Header) );
+    count = header->count;
+}
+
+
+void Nepomuk2::DirectoryJournal::Private::close()
+{
+    if( data )
+        file.unmap( data );
+    file.close();
+    data = 0;
+    records = 0;
+    count = 0;
+}
+
+
+const Record* Nepomuk2::DirectoryJournal::Private::find( const Key& key ) const
+{
+    const Record* end = records + count;
+    const Record* it = std::lower_bound( records, end, key, recordKeyLessThan );
+    if( it != end && it->key == key )
+        return it;
+    return 0;
+}
+
+
+Nepomuk2::DirectoryJournal::DirectoryJournal( const QString& path )
+    : d( new Private() )
+{
+    d->path = path;
+    QWriteLocker lock( &d->lock );
+    d->open();
+}
+
+
+Nepomuk2::DirectoryJournal::~DirectoryJournal()
+{
+    d->close();
+    delete d;
+}
+
+
+bool Nepomuk2::DirectoryJournal::isUnchanged( const QString& path ) const
+{
+    Record current;
+    if( !statFolder( path, &current ) )
+        return false;
+
+    QReadLocker lock( &d->lock );
+    if( !d->count )
+        return false;
+
+    const Record* record = d->find( current.key );
+    return record &&
+           record->mtime == current.mtime &&
+           record->linkCount == current.linkCount;
+}
+
+
+// static
+bool Nepomuk2::DirectoryJournal::folderState( const QString& path, FolderState* state )
+{
+    Record record;
+    if( !statFolder( path, &record ) )
+        return false;
+
+    state->device = record.key.device;
+    state->inode = record.key.inode;
+    state->mtime = record.mtime;
+    state->linkCount = record.linkCount;
+    return true;
+}
+
+
+void Nepomuk2::DirectoryJournal::record( const QString& path )
+{
+    FolderState state;
+    if( folderState( path, &state ) )
+        record( path, state );
+}
+
+
+void Nepomuk2::DirectoryJournal::record( const QString& path, const FolderState& state )
+{
+    Record record;
+    record.key.device = state.device;
+    record.key.inode = state.inode;
+    record.mtime = state.mtime;
+    record.linkCount = state.linkCount;
+
+    // the parent is required to find the subfolders of skipped folders
+    if( !statKey( QFileInfo( path ).path(), &record.parent ) ) {
+        record.parent.device = 0;
+        record.parent.inode = 0;
+    }
+
+    d->recorded.insert( record.key, record );
+}
+
+
+void Nepomuk2::DirectoryJournal::keep( const QString& path )
+{
+    Key key;
+    if( statKey( path, &key ) )
+        d->kept << key;
+}
+
+
+void Nepomuk2::DirectoryJournal::discardPending()
+{
+    d->recorded.clear();
+    d->kept.clear();
+}
+
+
+bool Nepomuk2::DirectoryJournal::commit()
+{
+    if( d->recorded.isEmpty() && d->kept.isEmpty() )
+        return true;
+
+    const QByteArray hash = configHash();
+    if( hash != d->configHash ) {
+        kDebug() << "The configuration changed during the scan, dropping the folder journal.";
+        invalidate();
+        return false;
+    }
+
+    QWriteLocker lock( &d->lock );
+
+    QHash<Key, Record> result = d->recorded;
+
+    // Take over the old records of the skipped subtrees
+    if( d->count && !d->kept.isEmpty() ) {
+        QMultiHash<Key, quint32> children;
+        children.reserve( d->count );
+        for( quint32 i = 0; i < d->count; ++i ) {
+            children.insert( d->records[i].parent, i );
+        }
+
+        QList<Key> todo = d->kept;
+        while( !todo.isEmpty() ) {
+            const Key key = todo.takeLast();
+            if( result.contains( key ) )
+                continue;
+
+            const Record* record = d->find( key );
+            if( !record )
+                continue;
+
+            result.insert( key, *record );
+
+            QMultiHash<Key, quint32>::const_iterator it = children.constFind( key );
+            for( ; it != children.constEnd() && it.key() == key; ++it ) {
+                todo << d->records[it.value()].key;
+            }
+        }
+    }
+
+    QList<Record> records = result.values();
+    qSort( records.begin(), records.end(), recordLessThan );
+
+    // we cannot write the file while it is mapped
+    d->close();
+
+    KSaveFile file( d->path );
+    if( !file.open() ) {
+        kDebug() << "Failed to write folder journal" << d->path << file.errorString();
+        discardPending();
+        return false;
+    }
+
+    Header header;
+    memset( &header, 0, sizeof(Header) );
+    header.magic = s_magic;
+    header.version = s_version;
+    memcpy( header.configHash, hash.constData(), qMin( hash.size(), int(sizeof(header.configHash)) ) );
+    header.count = records.count();
+
+    file.write( reinterpret_cast<const char*>( &header ), sizeof(Header) );
+    foreach( const Record& record, records ) {
+        file.write( reinterpret_cast<const char*>( &record ), sizeof(Record) );
+    }
+
+    discardPending();
+
+    if( !file.finalize() ) {
+        kDebug() << "Failed to write folder journal" << d->path << file.errorString();
+        return false;
+    }
+
+    d->open();
+    return true;
+}
+
+
+void Nepomuk2::DirectoryJournal::invalidate()
+{
+    QWriteLocker lock( &d->lock );
+    d->close();
+    d->configHash = configHash();
+    discardPending();
+    QFile::remove( d->path );
+}
+
+
+void Nepomuk2::DirectoryJournal::checkConfig()
+{
+    if( configHash() != d->configHash ) {
+        kDebug() << "The configuration changed, dropping the folder journal.";
+        invalidate();
+    }
+}
+
+
+// static
+QString Nepomuk2::DirectoryJournal::defaultPath()
+{
+    return KStandardDirs::locateLocal( "data", QLatin1String("nepomuk/file-indexer-folders.journal") );
+}
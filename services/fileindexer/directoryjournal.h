@@ -0,0 +1,129 @@
+/*
+    This file is part of the Nepomuk KDE project.
+    Copyright (C) 2013  Nepomuk Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef FILEINDEXER_DIRECTORYJOURNAL_H
+#define FILEINDEXER_DIRECTORYJOURNAL_H
+
+#include <QtCore/QString>
+#include <QtCore/QByteArray>
+
+namespace Nepomuk2 {
+
+    /**
+     * The state of all folders as of the last complete basic indexing run.
+     *
+     * For each folder the journal stores the mtime and the link count, keyed
+     * by device and inode. The startup scan does not look at the files of a
+     * folder whose state did not change since, only at its subfolders. The
+     * journal is a sorted binary file which is memory-mapped and searched in
+     * place.
+     *
+     * The mtime of a folder only changes if entries are added, removed, or
+     * renamed. Most applications save files by renaming a temporary file, but
+     * a file modified in place while the file indexer is not running is only
+     * noticed by a forced update.
+     *
+     * The journal is ignored if the indexer configuration has changed since
+     * it was written. A configuration change while the journal is open has
+     * to be reported with checkConfig().
+     */
+    class DirectoryJournal
+    {
+    public:
+        explicit DirectoryJournal( const QString& path = defaultPath() );
+        ~DirectoryJournal();
+
+        /**
+         * What the journal remembers about a folder.
+         */
+        struct FolderState {
+            quint64 device;
+            quint64 inode;
+            qint64 mtime;
+            quint64 linkCount;
+        };
+
+        /**
+         * Read the current state of the folder \p path.
+         *
+         * \return \p false if \p path is not a folder.
+         */
+        static bool folderState( const QString& path, FolderState* state );
+
+        /**
+         * \return \p true if the folder \p path has the same state as in
+         * the journal.
+         *
+         * May be called from several threads at once.
+         */
+        bool isUnchanged( const QString& path ) const;
+
+        /**
+         * Remember the current state of the folder \p path. Used once its contents
+         * have been queued. Only written by commit().
+         */
+        void record( const QString& path );
+
+        /**
+         * Remember \p state for the folder \p path. The state has to be read
+         * before the folder is listed, otherwise changes made while listing
+         * would be lost.
+         */
+        void record( const QString& path, const FolderState& state );
+
+        /**
+         * Keep the journal data of the unchanged folder \p path. The data of its
+         * subfolders is kept as well unless they are recorded.
+         */
+        void keep( const QString& path );
+
+        /**
+         * Forget everything recorded or kept since the last commit. Used when
+         * queued folders were dropped before they could be indexed.
+         */
+        void discardPending();
+
+        /**
+         * Replace the journal with the recorded and kept folders. Fails if the
+         * configuration changed since they were collected.
+         */
+        bool commit();
+
+        /**
+         * Remove the journal. The next scan will walk all folders.
+         */
+        void invalidate();
+
+        /**
+         * Invalidate the journal if the indexer configuration no longer
+         * matches the one it was opened or collected with.
+         */
+        void checkConfig();
+
+        static QString defaultPath();
+
+    private:
+        class Private;
+        Private* const d;
+
+        Q_DISABLE_COPY( DirectoryJournal )
+    };
+}
+
+#endif // FILEINDEXER_DIRECTORYJOURNAL_H
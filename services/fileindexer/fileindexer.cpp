@@ -142,6 +142,18 @@ void Nepomuk2::FileIndexer::resume() const
 }
 
 
+int Nepomuk2::FileIndexer::extractionCacheHits() const
+{
+    return m_indexScheduler->extractionCacheHits();
+}
+
+
+int Nepomuk2::FileIndexer::extractionCacheLookups() const
+{
+    return m_indexScheduler->extractionCacheLookups();
+}
+
+
 QString Nepomuk2::FileIndexer::currentFile() const
 {
    return m_indexScheduler->currentUrl().toLocalFile();
@@ -95,6 +95,14 @@ namespace Nepomuk2 {
         Q_SCRIPTABLE int indexedFiles() const;
         Q_SCRIPTABLE int totalFiles() const;
 
+        /**
+         * The number of files whose contents did not have to be extracted since
+         * their data was found in the extraction cache, and the number of files
+         * it was looked up for, since the service started.
+         */
+        Q_SCRIPTABLE int extractionCacheHits() const;
+        Q_SCRIPTABLE int extractionCacheLookups() const;
+
         /**
          * Update folder \a path if it is configured to be indexed.
          */
@@ -216,6 +216,13 @@ bool Nepomuk2::FileIndexerConfig::shouldFileBeIndexed( const QString& fileName )
     return !m_excludeFilterRegExpCache.exactMatch( fileName );
 }
 
+QStringList Nepomuk2::FileIndexerConfig::excludeMimetypes() const
+{
+    QReadLocker lock( &m_mimetypeMutex );
+    return m_excludeMimetypes.toList();
+}
+
+
 bool Nepomuk2::FileIndexerConfig::shouldMimeTypeBeIndexed(const QString& mimeType) const
 {
     QReadLocker lock( &m_mimetypeMutex );
@@ -483,5 +490,23 @@ bool Nepomuk2::FileIndexerConfig::isDebugModeEnabled() const
     return m_config.group( "General" ).readEntry( "debug mode", false );
 }
 
+QStringList Nepomuk2::FileIndexerConfig::priorityMimeTypes() const
+{
+    // documents are what users search for the most
+    QStringList defaults;
+    defaults << QLatin1String("text/")
+             << QLatin1String("application/pdf")
+             << QLatin1String("application/msword")
+             << QLatin1String("application/vnd.oasis.opendocument.text")
+             << QLatin1String("application/vnd.openxmlformats-officedocument.wordprocessingml.document");
+    return m_config.group( "General" ).readEntry( "priority mimetypes", defaults );
+}
+
+KIO::filesize_t Nepomuk2::FileIndexerConfig::lowPriorityFileSize() const
+{
+    // default: 50 MB
+    return m_config.group( "General" ).readEntry( "low priority file size", KIO::filesize_t( 50*1024*1024 ) );
+}
+
 
 #include "fileindexerconfig.moc"
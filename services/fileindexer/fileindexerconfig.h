@@ -72,6 +72,11 @@ namespace Nepomuk2 {
 
         QStringList excludeFilters() const;
 
+        /**
+         * The mimetypes which should never be indexed. Cached.
+         */
+        QStringList excludeMimetypes() const;
+
         bool indexHiddenFilesAndFolders() const;
 
         /**
@@ -105,6 +110,17 @@ namespace Nepomuk2 {
          */
         bool suspendOnPowerSaveDisabled() const;
 
+        /**
+         * The mimetypes whose contents are indexed before all other files.
+         * An entry ending in a slash such as "text/" matches all subtypes.
+         */
+        QStringList priorityMimeTypes() const;
+
+        /**
+         * Files larger than this are content-indexed after all other files.
+         */
+        KIO::filesize_t lowPriorityFileSize() const;
+
         /**
          * Check if \p path should be indexed taking into account
          * the includeFolders(), the excludeFolders(), and the
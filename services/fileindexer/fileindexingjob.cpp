@@ -20,6 +20,7 @@
 */
 
 #include "fileindexingjob.h"
+#include "indexerworker.h"
 #include "util.h"
 #include "fileindexerconfig.h"
 #include "resourcemanager.h"
@@ -27,7 +28,6 @@
 
 #include <KUrl>
 #include <KDebug>
-#include <KProcess>
 #include <KStandardDirs>
 
 #include <Soprano/Node>
@@ -39,9 +39,10 @@
 
 using namespace Nepomuk2::Vocabulary;
 
-Nepomuk2::FileIndexingJob::FileIndexingJob(const QUrl& fileUrl, QObject* parent)
+Nepomuk2::FileIndexingJob::FileIndexingJob(IndexerWorker* worker, const QUrl& fileUrl, QObject* parent)
     : KJob(parent),
-      m_url( fileUrl )
+      m_url( fileUrl ),
+      m_worker( worker )
 {
     // setup the timer used to kill the indexer process if it seems to get stuck
     m_processTimer = new QTimer(this);
@@ -57,20 +58,12 @@ void Nepomuk2::FileIndexingJob::start()
         return;
     }
 
-    // setup the external process which does the actual indexing
-    const QString exe = KStandardDirs::findExe(QLatin1String("nepomukindexer"));
+    // the worker process does the actual indexing
+    kDebug() << "Indexing" << m_url.toLocalFile();
 
-    kDebug() << "Running" << exe << m_url.toLocalFile();
-
-    m_process = new KProcess( this );
-
-    QStringList args;
-    args << m_url.toLocalFile();
-
-    m_process->setProgram( exe, args );
-    m_process->setOutputChannelMode(KProcess::OnlyStdoutChannel);
-    connect( m_process, SIGNAL(finished(int, QProcess::ExitStatus)), this, SLOT(slotIndexedFile(int, QProcess::ExitStatus)) );
-    m_process->start();
+    connect( m_worker, SIGNAL(finished(QUrl, int, QString)),
+             this, SLOT(slotIndexedFile(QUrl, int, QString)) );
+    m_worker->indexFile( m_url );
 
     // start the timer which will kill the process if it does not terminate after 5 minutes
     m_processTimer->start(5*60*1000);
@@ -94,35 +87,45 @@ void Nepomuk2::FileIndexingJob::slotProcessNonExistingFile()
 }
 
 
-void Nepomuk2::FileIndexingJob::slotIndexedFile(int exitCode, QProcess::ExitStatus exitStatus)
+void Nepomuk2::FileIndexingJob::slotIndexedFile(const QUrl& url, int status, const QString& message)
 {
+    if( url != m_url )
+        return;
+
     // stop the timer since there is no need to kill the process anymore
     m_processTimer->stop();
+    m_worker->disconnect( this );
 
-    //kDebug() << "Indexing of " << m_url.toLocalFile() << "finished with exit code" << exitCode;
-    if(exitStatus != QProcess::NormalExit) {
+    //kDebug() << "Indexing of " << m_url.toLocalFile() << "finished with status" << status;
+    if( status == IndexerWorker::Crashed ) {
         setError( IndexerCrashed );
-        setErrorText( QLatin1String( "Indexer process crashed on " ) + m_url.toLocalFile() );
+        setErrorText( message );
     }
-    if(exitCode == 1) {
+    else if( status == IndexerWorker::Failed ) {
         setError( IndexerFailed );
         setErrorText( QLatin1String( "Indexer process returned with an error for " ) + m_url.toLocalFile() );
-        if(FileIndexerConfig::self()->isDebugModeEnabled()) {
-            QFile errorLogFile(KStandardDirs::locateLocal("data", QLatin1String("nepomuk/file-indexer-error-log"), true));
-            if(errorLogFile.open(QIODevice::Append)) {
-                QTextStream s(&errorLogFile);
-                s << m_url.toLocalFile() << ": " << QString::fromLocal8Bit(m_process->readAllStandardOutput()) << endl;
-            }
-        }
+        logError( m_url, message );
     }
     emitResult();
 }
 
+// static
+void Nepomuk2::FileIndexingJob::logError(const QUrl& url, const QString& message)
+{
+    if(FileIndexerConfig::self()->isDebugModeEnabled()) {
+        QFile errorLogFile(KStandardDirs::locateLocal("data", QLatin1String("nepomuk/file-indexer-error-log"), true));
+        if(errorLogFile.open(QIODevice::Append)) {
+            QTextStream s(&errorLogFile);
+            s << url.toLocalFile() << ": " << message << endl;
+        }
+    }
+}
+
 void Nepomuk2::FileIndexingJob::slotProcessTimerTimeout()
 {
-    m_process->disconnect(this);
-    m_process->kill();
-    m_process->waitForFinished();
+    m_worker->disconnect( this );
+    // the next file will be handled by a new process
+    m_worker->kill();
     setError( KJob::KilledJobError );
     setErrorText( QLatin1String("Indexer process got stuck for") + m_url.toLocalFile() );
     emitResult();
@@ -24,7 +24,6 @@
 
 #include <KJob>
 #include <KUrl>
-#include <KProcess>
 
 class QFileInfo;
 class QTimer;
@@ -32,6 +31,7 @@ class QTimer;
 namespace Nepomuk2 {
 
     class Resource;
+    class IndexerWorker;
 
     /**
      * \class Indexer nepomukindexer.h Nepomuk2/Indexer
@@ -53,12 +53,22 @@ namespace Nepomuk2 {
         Q_OBJECT
 
     public:
-        FileIndexingJob( const QUrl& fileUrl, QObject* parent = 0 );
+        /**
+         * \param worker The indexer process used to index the file. It has
+         * to stay idle until the job finishes.
+         */
+        FileIndexingJob( IndexerWorker* worker, const QUrl& fileUrl, QObject* parent = 0 );
 
         KUrl url() const { return m_url; }
 
         virtual void start();
 
+        /**
+         * Append the failure of \p url to the error log of the file indexer.
+         * Only done in debug mode.
+         */
+        static void logError( const QUrl& url, const QString& message );
+
         /**
          * Error codes: IndexerFailed is emitted when the indexer returns 1
          *              IndexerCrashed is emitted when the indexer crashed
@@ -82,14 +92,13 @@ namespace Nepomuk2 {
         // TODO: actually emit the indexingDone signal
 
     private slots:
-        void slotIndexedFile(int exitCode, QProcess::ExitStatus exitStatus);
+        void slotIndexedFile(const QUrl& url, int status, const QString& message);
         void slotProcessTimerTimeout();
         void slotProcessNonExistingFile();
 
     private:
         KUrl m_url;
-        KProcess* m_process;
-        int m_exitCode;
+        IndexerWorker* m_worker;
         QTimer* m_processTimer;
     };
 }
@@ -21,7 +21,10 @@
 #include "fileindexingqueue.h"
 #include "resourcemanager.h"
 #include "fileindexingjob.h"
+#include "indexerworker.h"
+#include "pendingfilequeue.h"
 #include "fileindexerconfig.h"
+#include "mimetyperesolver.h"
 #include "util.h"
 
 #include <Soprano/Model>
@@ -29,15 +32,31 @@
 
 #include <KDebug>
 #include <QTimer>
+#include <QThread>
+#include <QDateTime>
+#include <QFileInfo>
+
+namespace {
+    /// the number of files compared with the database per iteration while reconciling
+    const int s_reconcilePageSize = 500;
+}
 
 namespace Nepomuk2 {
 
-FileIndexingQueue::FileIndexingQueue(QObject* parent): IndexingQueue(parent)
+FileIndexingQueue::FileIndexingQueue(QObject* parent)
+    : IndexingQueue(parent),
+      m_reconciled( false ),
+      m_maxJobs( defaultMaxJobs() ),
+      m_runningJobs( 0 ),
+      m_extractionCacheHits( 0 ),
+      m_extractionCacheLookups( 0 ),
+      m_waitingForSlot( false )
 {
-    m_fileQueue.reserve( 10 );
+    m_fileQueue = new PendingFileQueue( PendingFileQueue::defaultPath(), this );
 
     FileIndexerConfig* config = FileIndexerConfig::self();
     connect( config, SIGNAL(configChanged()), this, SLOT(slotConfigChanged()) );
+    readConfig();
 }
 
 void FileIndexingQueue::start()
@@ -50,56 +69,244 @@ void FileIndexingQueue::start()
 
 void FileIndexingQueue::fillQueue()
 {
-    /* prevent abuse this API */
-    if (m_fileQueue.size() > 0)
-        return;
+    // All other files are handed to us by the basic indexing
+    if( !m_reconciled )
+        reconcile();
+}
 
-    QString query = QString::fromLatin1("select distinct ?url where { ?r nie:url ?url ; kext:indexingLevel ?l "
-                                        " FILTER(?l = 1 ). } LIMIT 10");
+void FileIndexingQueue::reconcile()
+{
+    // the files being indexed right now still have level 1
+    const QSet<QUrl> runningUrls = filesInProgress();
+
+    // Paged by the url instead of an offset. The files indexed in the meantime
+    // leave the result and would shift the following pages.
+    QString query = QString::fromLatin1("select distinct ?url ?mime ?size ?dt (str(?url) as ?key) where { "
+                                        "?r nie:url ?url ; kext:indexingLevel ?l . FILTER(?l = 1 ) . ");
+    if( !m_reconcileLastUrl.isEmpty() ) {
+        query += QString::fromLatin1("FILTER(str(?url) > %1) . ")
+                 .arg( Soprano::Node::literalToN3( Soprano::LiteralValue( m_reconcileLastUrl ) ) );
+    }
+    query += QString::fromLatin1("OPTIONAL { ?r nie:mimeType ?mime . } "
+                                 "OPTIONAL { ?r nfo:fileSize ?size . } "
+                                 "OPTIONAL { ?r nie:lastModified ?dt . } } "
+                                 "ORDER BY str(?url) LIMIT %1").arg( s_reconcilePageSize );
 
+    int rows = 0;
     Soprano::Model* model = ResourceManager::instance()->mainModel();
     Soprano::QueryResultIterator it = model->executeQuery( query, Soprano::Query::QueryLanguageSparql );
-    while( it.next() )
-        m_fileQueue.enqueue( it[0].uri() );
+    while( it.next() ) {
+        ++rows;
+        const QUrl url = it[0].uri();
+        m_reconcileLastUrl = it[4].literal().toString();
+        if( runningUrls.contains( url ) || m_reconciledUrls.contains( url ) )
+            continue;
+
+        m_reconciledUrls << url;
+
+        // Keep the position of the files which survived the restart
+        if( !m_fileQueue->contains( url ) ) {
+            const QDateTime dt = it[3].literal().toDateTime();
+            enqueue( url, it[1].literal().toString(), it[2].literal().toInt64(),
+                     dt.isValid() ? dt.toTime_t() : 0 );
+        }
+    }
+
+    if( rows < s_reconcilePageSize ) {
+        m_fileQueue->retain( m_reconciledUrls );
+        m_reconciled = true;
+        m_reconciledUrls.clear();
+        m_reconcileLastUrl.clear();
+
+        kDebug() << m_fileQueue->count() << "files waiting to be indexed";
+    }
+}
+
+void FileIndexingQueue::enqueue(const QUrl& url, const QString& mimeType, qint64 size, qint64 mtime)
+{
+    PendingFileQueue::Priority priority = PendingFileQueue::NormalPriority;
+    if( size > m_lowPriorityFileSize ) {
+        priority = PendingFileQueue::LowPriority;
+    }
+    else {
+        foreach( const QString& type, m_priorityMimeTypes ) {
+            if( type.endsWith( QLatin1Char('/') ) ? mimeType.startsWith( type ) : mimeType == type ) {
+                priority = PendingFileQueue::HighPriority;
+                break;
+            }
+        }
+    }
+
+    m_fileQueue->enqueue( url, priority, mtime );
 }
 
 void FileIndexingQueue::enqueue(const QUrl& url)
 {
-    if( !m_fileQueue.contains(url) ) {
-        m_fileQueue.enqueue( url );
-        callForNextIteration();
+    // The pages which have already been compared do not know about the file
+    if( !m_reconciled )
+        m_reconciledUrls << url;
+
+    // a file is never indexed by two processes at the same time
+    if( !filesInProgress().contains(url) ) {
+        const QFileInfo info( url.toLocalFile() );
+        enqueue( url, MimeTypeResolver::mimeTypeByName( info.filePath(), info.isDir() ),
+                 info.size(), info.lastModified().toTime_t() );
+
+        if( m_waitingForSlot && idleWorker() )
+            continueIteration();
+        else
+            callForNextIteration();
     }
 }
 
+void FileIndexingQueue::readConfig()
+{
+    FileIndexerConfig* config = FileIndexerConfig::self();
+    m_priorityMimeTypes = config->priorityMimeTypes();
+    m_lowPriorityFileSize = config->lowPriorityFileSize();
+}
+
 
 bool FileIndexingQueue::isEmpty()
 {
-    return m_fileQueue.isEmpty();
+    return m_reconciled && m_fileQueue->isEmpty() && m_runningJobs == 0;
 }
 
 void FileIndexingQueue::processNextIteration()
 {
-    const QUrl fileUrl = m_fileQueue.dequeue();
-    process( fileUrl );
+    // The queue might have been loaded from disk. One page per iteration.
+    if( !m_reconciled )
+        reconcile();
+
+    IndexerWorker* worker = m_fileQueue->isEmpty() ? 0 : idleWorker();
+    if( !worker ) {
+        // reconciling might have emptied the queue, or it needs another iteration
+        if( isEmpty() || !m_reconciled ) {
+            finishIteration();
+            return;
+        }
+
+        // wait for one of the running jobs to finish
+        m_waitingForSlot = true;
+        return;
+    }
+
+    process( worker, m_fileQueue->dequeue() );
+
+    // Start the next file right away if there is still a free slot
+    if( !m_fileQueue->isEmpty() && idleWorker() )
+        finishIteration();
+    else
+        m_waitingForSlot = true;
 }
 
-void FileIndexingQueue::process(const QUrl& url)
+void FileIndexingQueue::process(IndexerWorker* worker, const QUrl& url)
 {
-    m_currentUrl = url;
+    ++m_runningJobs;
 
-    KJob* job = new FileIndexingJob( url );
+    KJob* job = new FileIndexingJob( worker, url );
+    connect( job, SIGNAL(finished(KJob*)), this, SLOT(slotFinishedIndexingFile(KJob*)) );
     job->start();
     emit beginIndexingFile( url );
-    connect( job, SIGNAL(finished(KJob*)), this, SLOT(slotFinishedIndexingFile(KJob*)) );
+}
+
+void FileIndexingQueue::continueIteration()
+{
+    if( m_waitingForSlot ) {
+        m_waitingForSlot = false;
+        finishIteration();
+    }
+}
+
+IndexerWorker* FileIndexingQueue::idleWorker()
+{
+    if( m_runningJobs >= m_maxJobs )
+        return 0;
+
+    foreach( IndexerWorker* worker, m_workers ) {
+        if( !worker->isBusy() )
+            return worker;
+    }
+
+    if( m_workers.count() < m_maxJobs ) {
+        IndexerWorker* worker = new IndexerWorker( this );
+        worker->setProgram( m_indexerProgram );
+        connect( worker, SIGNAL(storeFailed(QUrl, QString)),
+                 this, SLOT(slotStoreFailed(QUrl, QString)) );
+        // queued since the worker is killed from within a running job
+        connect( worker, SIGNAL(storeAborted(QUrl)),
+                 this, SLOT(slotStoreAborted(QUrl)), Qt::QueuedConnection );
+        connect( worker, SIGNAL(extractionCacheStatistics(int, int)),
+                 this, SLOT(slotExtractionCacheStatistics(int, int)) );
+        m_workers << worker;
+        return worker;
+    }
+
+    return 0;
+}
+
+void FileIndexingQueue::trimWorkers()
+{
+    // A worker with pending files closes its process gracefully once deleted so
+    // that the process can store them first. Still, there is no point in keeping
+    // a process around for that if there is an idle one with nothing to store.
+    for( int pass = 0; pass < 2; ++pass ) {
+        for( int i = m_workers.count() - 1; i >= 0 && m_workers.count() > m_maxJobs; --i ) {
+            IndexerWorker* worker = m_workers[i];
+            if( !worker->isBusy() && ( pass == 1 || worker->pendingUrls().isEmpty() ) ) {
+                // we might be called from within the worker's finished signal
+                m_workers.removeAt(i);
+                worker->deleteLater();
+            }
+        }
+    }
+}
+
+int FileIndexingQueue::maxJobs() const
+{
+    return m_maxJobs;
+}
+
+void FileIndexingQueue::setMaxJobs(int maxJobs)
+{
+    m_maxJobs = qMax( 0, maxJobs );
+    trimWorkers();
+
+    if( m_waitingForSlot && !m_fileQueue->isEmpty() && idleWorker() )
+        continueIteration();
+}
+
+// static
+int FileIndexingQueue::defaultMaxJobs()
+{
+    return qMax( 1, QThread::idealThreadCount() - 1 );
+}
+
+void FileIndexingQueue::setIndexerProgram(const QString& program)
+{
+    m_indexerProgram = program;
+}
+
+int FileIndexingQueue::extractionCacheHits() const
+{
+    return m_extractionCacheHits;
+}
+
+int FileIndexingQueue::extractionCacheLookups() const
+{
+    return m_extractionCacheLookups;
 }
 
 void FileIndexingQueue::slotFinishedIndexingFile(KJob* job)
 {
+    const QUrl url = static_cast<FileIndexingJob*>( job )->url();
+    --m_runningJobs;
+
     if( job->error() ) {
         kDebug() << job->errorString();
-        // Get the uri of the current file
+        // Get the uri of the file
         QString query = QString::fromLatin1("select ?r where { ?r nie:url %1 . }")
-                        .arg( Soprano::Node::resourceToN3( m_currentUrl ) );
+                        .arg( Soprano::Node::resourceToN3( url ) );
         Soprano::Model* model = ResourceManager::instance()->mainModel();
         Soprano::QueryResultIterator it = model->executeQuery( query, Soprano::Query::QueryLanguageSparqlNoInference );
 
@@ -110,40 +317,89 @@ void FileIndexingQueue::slotFinishedIndexingFile(KJob* job)
         }
     }
 
-    QUrl url = m_currentUrl;
-    m_currentUrl.clear();
     emit endIndexingFile( url );
-    if( m_fileQueue.isEmpty() ) {
-        fillQueue();
-    }
-    finishIteration();
+    trimWorkers();
+    continueIteration();
+}
+
+void FileIndexingQueue::slotStoreFailed(const QUrl& url, const QString& message)
+{
+    // The indexer already set the indexing level to -1
+    kDebug() << "Failed to store the data of" << url << message;
+    FileIndexingJob::logError( url, message );
+}
+
+void FileIndexingQueue::slotStoreAborted(const QUrl& url)
+{
+    kDebug() << "The data of" << url << "was not stored, indexing it again";
+    enqueue( url );
+}
+
+void FileIndexingQueue::slotExtractionCacheStatistics(int hits, int lookups)
+{
+    m_extractionCacheHits += hits;
+    m_extractionCacheLookups += lookups;
 }
 
 void FileIndexingQueue::clear()
 {
-    m_currentUrl.clear();
-    m_fileQueue.clear();
+    m_fileQueue->clear();
+
+    // Files which are not indexed again by the basic indexing still need their contents indexed
+    m_reconciled = false;
+    m_reconciledUrls.clear();
+    m_reconcileLastUrl.clear();
 }
 
 void FileIndexingQueue::clear(const QString& path)
 {
-    QMutableListIterator<QUrl> it( m_fileQueue );
-    while( it.hasNext() ) {
-        if( it.next().toLocalFile().startsWith( path ) )
-            it.remove();
-    }
+    m_fileQueue->clear( path );
 }
 
 
 QUrl FileIndexingQueue::currentUrl()
 {
-    return m_currentUrl;
+    foreach( IndexerWorker* worker, m_workers ) {
+        if( worker->isBusy() )
+            return worker->currentUrl();
+    }
+    return QUrl();
+}
+
+QSet<QUrl> FileIndexingQueue::filesInProgress() const
+{
+    QSet<QUrl> urls;
+    foreach( IndexerWorker* worker, m_workers ) {
+        if( worker->isBusy() )
+            urls << worker->currentUrl();
+        urls += worker->pendingUrls();
+    }
+    return urls;
+}
+
+QList<QUrl> FileIndexingQueue::currentUrls() const
+{
+    QList<QUrl> urls;
+    foreach( IndexerWorker* worker, m_workers ) {
+        if( worker->isBusy() )
+            urls << worker->currentUrl();
+    }
+    return urls;
 }
 
 void FileIndexingQueue::slotConfigChanged()
 {
-    m_fileQueue.clear();
+    const QStringList priorityMimeTypes = m_priorityMimeTypes;
+    const qint64 lowPriorityFileSize = m_lowPriorityFileSize;
+    readConfig();
+
+    // The queue only needs to be filled again if the priorities changed
+    if( m_priorityMimeTypes == priorityMimeTypes && m_lowPriorityFileSize == lowPriorityFileSize )
+        return;
+
+    clear();
     fillQueue();
+    callForNextIteration();
 }
 
 
@@ -23,11 +23,26 @@
 
 #include "indexingqueue.h"
 
+#include <QtCore/QSet>
+#include <QtCore/QStringList>
+
 #include <KJob>
 #include <Soprano/QueryResultIterator>
 
 namespace Nepomuk2 {
 
+    class IndexerWorker;
+    class PendingFileQueue;
+
+    /**
+     * Indexes the contents of the files which have indexing level 1.
+     *
+     * The basic indexing hands each file to enqueue() once its basic data
+     * has been stored. The files wait in a PendingFileQueue which survives
+     * restarts. The database is only searched for files with level 1 on
+     * startup and after the queue has been cleared, to catch files which
+     * were not handed over.
+     */
     class FileIndexingQueue : public IndexingQueue
     {
         Q_OBJECT
@@ -38,8 +53,44 @@ namespace Nepomuk2 {
 
         void clear();
         void clear( const QString& path );
+
+        /**
+         * One of the urls being indexed right now, empty if no file is being indexed.
+         */
         QUrl currentUrl();
 
+        /**
+         * All urls being indexed right now, one per busy indexer process.
+         */
+        QList<QUrl> currentUrls() const;
+
+        /**
+         * The number of files indexed in parallel, each by its own indexer process.
+         * 0 stops handing out new files without interrupting the running ones.
+         */
+        int maxJobs() const;
+        void setMaxJobs( int maxJobs );
+
+        /**
+         * The default number of parallel jobs: the number of cores minus one
+         * to keep the system responsive, but at least one.
+         */
+        static int defaultMaxJobs();
+
+        /**
+         * Start \p program instead of nepomukindexer for the new indexer
+         * processes. Used by the tests.
+         */
+        void setIndexerProgram( const QString& program );
+
+        /**
+         * The number of files whose data was found in the extraction cache and
+         * the number of files it was looked up for, summed over all indexer
+         * processes since the service started.
+         */
+        int extractionCacheHits() const;
+        int extractionCacheLookups() const;
+
     public slots:
         /**
          * Fills up the queue and starts the indexing
@@ -56,13 +107,65 @@ namespace Nepomuk2 {
 
     private slots:
         void slotFinishedIndexingFile(KJob* job);
+        void slotStoreFailed(const QUrl& url, const QString& message);
+        void slotStoreAborted(const QUrl& url);
+        void slotExtractionCacheStatistics(int hits, int lookups);
         void slotConfigChanged();
 
     private:
-        void process(const QUrl& url);
+        /**
+         * Queue all files with indexing level 1 which are not queued yet and
+         * drop the queued files which no longer have level 1.
+         *
+         * Each call compares one page of files with the database. m_reconciled
+         * is set once the last page has been handled.
+         */
+        void reconcile();
+
+        void enqueue( const QUrl& url, const QString& mimeType, qint64 size, qint64 mtime );
+
+        /// reads the priority settings from the config
+        void readConfig();
+
+        void process(IndexerWorker* worker, const QUrl& url);
+
+        /// returns an idle worker or 0 if all allowed ones are busy
+        IndexerWorker* idleWorker();
+
+        /// deletes idle workers above m_maxJobs, preferring the ones with no pending files
+        void trimWorkers();
+
+        /// the files being indexed and the ones whose data has not been stored yet
+        QSet<QUrl> filesInProgress() const;
+
+        /// called when a slot becomes available
+        void continueIteration();
+
+        PendingFileQueue* m_fileQueue;
+
+        /// false until the queue has been compared with the database
+        bool m_reconciled;
+
+        /// the files with level 1 found by the pages compared so far
+        QSet<QUrl> m_reconciledUrls;
+        /// the url the next page starts after
+        QString m_reconcileLastUrl;
+
+        QStringList m_priorityMimeTypes;
+        qint64 m_lowPriorityFileSize;
+
+        /// the long-lived indexer processes, at most m_maxJobs
+        QList<IndexerWorker*> m_workers;
+        QString m_indexerProgram;
+        int m_maxJobs;
+        int m_runningJobs;
+
+        int m_extractionCacheHits;
+        int m_extractionCacheLookups;
 
-        QQueue<QUrl> m_fileQueue;
-        QUrl m_currentUrl;
+        /// true if processNextIteration returned without finishing the iteration
+        /// since all slots were busy or there was nothing to start
+        bool m_waitingForSlot;
     };
 }
 
@@ -0,0 +1,77 @@
+/*
+    This file is part of the Nepomuk KDE project.
+    Copyright (C) 2013  Nepomuk Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "freshnesscheck.h"
+#include "resourcemanager.h"
+
+#include <Soprano/Node>
+#include <Soprano/Model>
+#include <Soprano/QueryResultIterator>
+
+namespace {
+    /// keeps the queries reasonably small
+    const int s_maxUrlsPerQuery = 200;
+}
+
+QStringList Nepomuk2::FreshnessCheck::queries( const QList<QUrl>& urls )
+{
+    QStringList result;
+    for( int start = 0; start < urls.count(); start += s_maxUrlsPerQuery ) {
+        QStringList urlsN3;
+        const int end = qMin( start + s_maxUrlsPerQuery, urls.count() );
+        for( int i = start; i < end; ++i ) {
+            urlsN3 << Soprano::Node::resourceToN3( urls[i] );
+        }
+
+        result << QString::fromLatin1("select ?url ?dt where { ?r nie:url ?url . "
+                                      "OPTIONAL { ?r nie:lastModified ?dt . } "
+                                      "FILTER(?url in (%1)) . }")
+                  .arg( urlsN3.join(QLatin1String(",")) );
+    }
+    return result;
+}
+
+QHash<QUrl, QDateTime> Nepomuk2::FreshnessCheck::indexedModificationTimes( const QList<QUrl>& urls )
+{
+    Soprano::Model* model = ResourceManager::instance()->mainModel();
+
+    QHash<QUrl, QDateTime> indexed;
+    foreach( const QString& query, queries( urls ) ) {
+        Soprano::QueryResultIterator it = model->executeQuery( query, Soprano::Query::QueryLanguageSparqlNoInference );
+        while( it.next() ) {
+            indexed.insert( it[0].uri(), it[1].literal().toDateTime() );
+        }
+    }
+    return indexed;
+}
+
+Nepomuk2::Freshness Nepomuk2::FreshnessCheck::freshness( const QUrl& url, bool isDir, const QDateTime& mtime,
+                                                         const QHash<QUrl, QDateTime>& indexed )
+{
+    QHash<QUrl, QDateTime>::const_iterator it = indexed.constFind( url );
+    if( it == indexed.constEnd() )
+        return Modified;
+
+    // Optimization: We don't care about the mtime of directories. If it has been indexed once
+    // then it doesn't need to indexed again - ever
+    if( isDir || it.value() == mtime )
+        return UpToDate;
+
+    return Modified;
+}
@@ -0,0 +1,68 @@
+/*
+    This file is part of the Nepomuk KDE project.
+    Copyright (C) 2013  Nepomuk Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef FILEINDEXER_FRESHNESSCHECK_H
+#define FILEINDEXER_FRESHNESSCHECK_H
+
+#include <QtCore/QUrl>
+#include <QtCore/QList>
+#include <QtCore/QHash>
+#include <QtCore/QDateTime>
+#include <QtCore/QStringList>
+
+namespace Nepomuk2 {
+
+    /**
+     * What is known about a path compared to the data in the database.
+     */
+    enum Freshness {
+        /// not checked yet
+        FreshnessUnknown,
+        /// new or modified since it was indexed
+        Modified,
+        /// indexed and unchanged
+        UpToDate
+    };
+
+    /**
+     * Compares files and folders with their data in the database.
+     */
+    namespace FreshnessCheck {
+        /**
+         * The queries which fetch the nie:lastModified of \p urls, one per
+         * few hundred urls.
+         */
+        QStringList queries( const QList<QUrl>& urls );
+
+        /**
+         * The nie:lastModified of those of \p urls which have been indexed.
+         * Urls indexed without a date are mapped to an invalid date.
+         */
+        QHash<QUrl, QDateTime> indexedModificationTimes( const QList<QUrl>& urls );
+
+        /**
+         * Compare the file or folder \p url, last modified at \p mtime, with
+         * \p indexed as returned by indexedModificationTimes().
+         */
+        Freshness freshness( const QUrl& url, bool isDir, const QDateTime& mtime,
+                             const QHash<QUrl, QDateTime>& indexed );
+    }
+}
+
+#endif // FILEINDEXER_FRESHNESSCHECK_H
@@ -0,0 +1,601 @@
+/*
+    This file is part of the Nepomuk KDE project.
+    Copyright (C) 2013  Nepomuk Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "extractioncache.h"
+#include "extractorplugin.h"
+#include "simpleresource.h"
+
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QSet>
+#include <QtCore/QDataStream>
+#include <QtCore/QCryptographicHash>
+
+#include <KDebug>
+#include <KSaveFile>
+#include <KStandardDirs>
+#include <kde_file.h>
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+namespace {
+    const quint32 s_magic = 0x4e455843; // "NEXC"
+    const quint32 s_version = 2;
+
+    const quint32 s_indexMagic = 0x4e455849; // "NEXI"
+    const quint32 s_indexVersion = 1;
+
+    /// The index is compacted once it holds more records, about 3 MiB
+    const int s_maxIndexRecords = 50000;
+
+    /// the size of each of the three samples hashed for large files
+    const qint64 s_sampleSize = 64*1024;
+
+    /// Larger entries are not cached. They are mostly plain text which is cheap to extract again.
+    const int s_maxEntrySize = 4*1024*1024;
+
+    QString indexFileName()
+    {
+        return QLatin1String("index");
+    }
+
+    QString lockFileName()
+    {
+        return QLatin1String("index.lock");
+    }
+
+    /**
+     * Holds a flock on the lock file of the index while it exists. The index
+     * itself cannot be locked since it is replaced when it is rewritten.
+     */
+    class IndexLocker
+    {
+    public:
+        IndexLocker(const QString& path, bool exclusive)
+            : m_fd( KDE::open( path, O_RDWR | O_CREAT, 0600 ) ) {
+            if( m_fd < 0 ) {
+                kDebug() << "Failed to open" << path;
+                return;
+            }
+            while( ::flock( m_fd, exclusive ? LOCK_EX : LOCK_SH ) != 0 && errno == EINTR ) {
+            }
+        }
+
+        ~IndexLocker() {
+            // releases the lock
+            if( m_fd >= 0 )
+                ::close( m_fd );
+        }
+
+    private:
+        int m_fd;
+    };
+
+    struct IndexHeader {
+        quint32 magic;
+        quint32 version;
+    };
+
+    /**
+     * The index is a header followed by these records. New records are appended,
+     * a file which has been recorded twice uses the last record. Compacting the
+     * index drops the older ones.
+     */
+    struct IndexRecord {
+        quint64 device;
+        quint64 inode;
+        qint64 mtime;
+        qint64 size;
+        char extractors[16];
+        char key[16];
+    };
+
+    /// stands in for the file resource in the stored graphs
+    QUrl placeholderUri()
+    {
+        return QUrl( QLatin1String("nepomukextractioncache:/file") );
+    }
+
+    QUrl mappedUri(const QUrl& uri, QHash<QUrl, QUrl>& uris)
+    {
+        QHash<QUrl, QUrl>::const_iterator it = uris.constFind( uri );
+        if( it != uris.constEnd() )
+            return it.value();
+
+        // Blank nodes are numbered per process. Those of a stored graph would clash
+        // with the ones of the other graphs which are stored together with it.
+        if( uri.toString().startsWith( QLatin1String("_:") ) ) {
+            const QUrl newUri = Nepomuk2::SimpleResource().uri();
+            uris.insert( uri, newUri );
+            return newUri;
+        }
+
+        return uri;
+    }
+
+    /**
+     * Replace the resource \p from with \p to in \p graph and give all blank nodes new names.
+     */
+    Nepomuk2::SimpleResourceGraph remap(const Nepomuk2::SimpleResourceGraph& graph, const QUrl& from, const QUrl& to)
+    {
+        QHash<QUrl, QUrl> uris;
+        uris.insert( from, to );
+
+        Nepomuk2::SimpleResourceGraph result;
+        result.reserve( graph.count() );
+        for( Nepomuk2::SimpleResourceGraph::const_iterator it = graph.constBegin(); it != graph.constEnd(); ++it ) {
+            Nepomuk2::SimpleResource res( mappedUri( it->uri(), uris ) );
+
+            const Nepomuk2::PropertyHash properties = it->properties();
+            for( Nepomuk2::PropertyHash::const_iterator pit = properties.constBegin(); pit != properties.constEnd(); ++pit ) {
+                if( pit.value().type() == QVariant::Url )
+                    res.addProperty( pit.key(), mappedUri( pit.value().toUrl(), uris ) );
+                else
+                    res.addProperty( pit.key(), pit.value() );
+            }
+
+            result.insert( res );
+        }
+        return result;
+    }
+}
+
+
+Nepomuk2::ExtractionCache::ExtractionCache(const QString& dir, qint64 maxSize)
+    : m_dir( dir ),
+      m_maxSize( maxSize ),
+      m_size( -1 ),
+      m_indexLoaded( false ),
+      m_hits( 0 ),
+      m_misses( 0 )
+{
+    if( !m_dir.endsWith( QLatin1Char('/') ) )
+        m_dir += QLatin1Char('/');
+    QDir().mkpath( m_dir );
+}
+
+Nepomuk2::ExtractionCache::~ExtractionCache()
+{
+}
+
+bool Nepomuk2::ExtractionCache::FileId::operator==(const FileId& other) const
+{
+    return inode == other.inode && device == other.device &&
+           extractors == other.extractors;
+}
+
+// static
+QByteArray Nepomuk2::ExtractionCache::fingerprint(const QString& filePath, bool complete)
+{
+    QFile file( filePath );
+    if( !file.open( QIODevice::ReadOnly ) )
+        return QByteArray();
+
+    const qint64 size = file.size();
+    QCryptographicHash hash( QCryptographicHash::Md5 );
+
+    if( complete && size > 3 * s_sampleSize ) {
+        qint64 read = 0;
+        while( read < size ) {
+            const QByteArray data = file.read( s_sampleSize );
+            if( data.isEmpty() )
+                return QByteArray();
+            hash.addData( data );
+            read += data.size();
+        }
+        if( read != size )
+            return QByteArray();
+    }
+    else if( size <= 3 * s_sampleSize ) {
+        const QByteArray data = file.readAll();
+        if( data.size() != size )
+            return QByteArray();
+        hash.addData( data );
+    }
+    else {
+        // Reading large files completely would cost about as much as extracting them.
+        // Files which only differ outside the samples and have the same size are
+        // rare enough among the file types with expensive extractors.
+        const qint64 offsets[] = { 0, ( size - s_sampleSize ) / 2, size - s_sampleSize };
+        for( int i = 0; i < 3; ++i ) {
+            if( !file.seek( offsets[i] ) )
+                return QByteArray();
+            const QByteArray data = file.read( s_sampleSize );
+            if( data.size() != s_sampleSize )
+                return QByteArray();
+            hash.addData( data );
+        }
+    }
+
+    return QByteArray::number( size ) + '-' + hash.result().toHex();
+}
+
+QByteArray Nepomuk2::ExtractionCache::key(const QString& filePath, const QString& mimeType,
+                                          const QStringList& extractorVersions)
+{
+    QCryptographicHash extractorHash( QCryptographicHash::Md5 );
+    extractorHash.addData( mimeType.toUtf8() );
+    foreach( const QString& version, extractorVersions ) {
+        extractorHash.addData( "\n" );
+        extractorHash.addData( version.toUtf8() );
+    }
+    // the extracted plain text is cut at this size
+    extractorHash.addData( QByteArray::number( ExtractorPlugin::maxPlainTextSize() ) );
+
+    KDE_struct_stat buf;
+    if( KDE::stat( filePath, &buf ) != 0 )
+        return QByteArray();
+
+    FileId id;
+    id.device = buf.st_dev;
+    id.inode = buf.st_ino;
+    id.extractors = extractorHash.result();
+
+    FileState state;
+    state.mtime = buf.st_mtime;
+    state.size = buf.st_size;
+
+    // The file did not change since it was read last time
+    loadIndex();
+    QHash<FileId, FileState>::const_iterator it = m_index.constFind( id );
+    if( it != m_index.constEnd() && it->mtime == state.mtime && it->size == state.size )
+        return it->key;
+
+    // The samples of a file edited in place might all be the same as before. Its
+    // copies miss the cache since they are sampled, but it is never mistaken for them.
+    const bool modified = it != m_index.constEnd();
+    const QByteArray print = fingerprint( filePath, modified );
+    if( print.isEmpty() )
+        return QByteArray();
+
+    QCryptographicHash hash( QCryptographicHash::Md5 );
+    hash.addData( print );
+    hash.addData( id.extractors );
+    state.key = hash.result().toHex();
+
+    // replaces the record of a modified file
+    m_index.insert( id, state );
+    appendToIndex( id, state );
+    return state.key;
+}
+
+bool Nepomuk2::ExtractionCache::lookup(const QByteArray& key, const QUrl& uri, SimpleResourceGraph* graph)
+{
+    const QString path = entryPath( key );
+    QFile file( path );
+    if( !file.open( QIODevice::ReadOnly ) ) {
+        ++m_misses;
+        return false;
+    }
+
+    QDataStream stream( &file );
+    stream.setVersion( QDataStream::Qt_4_6 );
+
+    quint32 magic, version;
+    QByteArray compressed;
+    stream >> magic >> version;
+    if( stream.status() == QDataStream::Ok && magic == s_magic && version == s_version )
+        stream >> compressed;
+
+    SimpleResourceGraph stored;
+    if( stream.status() == QDataStream::Ok && magic == s_magic && version == s_version ) {
+        QDataStream graphStream( qUncompress( compressed ) );
+        graphStream.setVersion( QDataStream::Qt_4_6 );
+        graphStream >> stored;
+        stream.setStatus( graphStream.status() );
+    }
+
+    if( stream.status() != QDataStream::Ok || magic != s_magic || version != s_version ) {
+        kDebug() << "Removing invalid cache entry" << path;
+        file.close();
+        QFile::remove( path );
+        ++m_misses;
+        return false;
+    }
+
+    // The mtime of an entry is the time it was used last
+    KDE::utime( path, 0 );
+
+    *graph = remap( stored, placeholderUri(), uri );
+    ++m_hits;
+    return true;
+}
+
+void Nepomuk2::ExtractionCache::insert(const QByteArray& key, const QUrl& uri, const SimpleResourceGraph& graph)
+{
+    QByteArray data;
+    QDataStream graphStream( &data, QIODevice::WriteOnly );
+    graphStream.setVersion( QDataStream::Qt_4_6 );
+    graphStream << remap( graph, uri, placeholderUri() );
+
+    // Mostly text, which compresses well
+    const QByteArray compressed = qCompress( data );
+    if( compressed.size() > s_maxEntrySize )
+        return;
+
+    KSaveFile file( entryPath( key ) );
+    if( !file.open() ) {
+        kDebug() << "Failed to write cache entry" << file.fileName() << file.errorString();
+        return;
+    }
+
+    QDataStream stream( &file );
+    stream.setVersion( QDataStream::Qt_4_6 );
+    stream << s_magic << s_version << compressed;
+
+    if( stream.status() != QDataStream::Ok || !file.finalize() ) {
+        kDebug() << "Failed to write cache entry" << file.fileName() << file.errorString();
+        file.abort();
+        return;
+    }
+
+    if( m_size < 0 ) {
+        m_size = 0;
+        const QFileInfoList entries = QDir( m_dir ).entryInfoList( QDir::Files );
+        foreach( const QFileInfo& entry, entries ) {
+            m_size += entry.size();
+        }
+    }
+    else {
+        m_size += compressed.size();
+    }
+
+    if( m_size > m_maxSize )
+        evict();
+}
+
+void Nepomuk2::ExtractionCache::evict()
+{
+    // Evicting only down to the limit would mean evicting again with the next insertion
+    const qint64 targetSize = m_maxSize * 3 / 4;
+
+    // the least recently used entries first
+    const QFileInfoList entries = QDir( m_dir ).entryInfoList( QDir::Files, QDir::Time | QDir::Reversed );
+
+    // the index counts as well, it is compacted below
+    qint64 size = 0;
+    foreach( const QFileInfo& entry, entries ) {
+        size += entry.size();
+    }
+
+    int evicted = 0;
+    foreach( const QFileInfo& entry, entries ) {
+        if( entry.fileName() == indexFileName() || entry.fileName() == lockFileName() )
+            continue;
+
+        if( size > targetSize && QFile::remove( entry.filePath() ) ) {
+            size -= entry.size();
+            ++evicted;
+        }
+    }
+
+    kDebug() << "Evicted" << evicted << "entries," << size << "bytes left";
+
+    // Drop the records of the removed entries. Their files will have to be read again.
+    const qint64 indexSize = QFileInfo( indexPath() ).size();
+    {
+        IndexLocker locker( lockPath(), true );
+        compactIndex();
+    }
+    m_size = size - indexSize + QFileInfo( indexPath() ).size();
+}
+
+void Nepomuk2::ExtractionCache::loadIndex()
+{
+    if( m_indexLoaded )
+        return;
+    m_indexLoaded = true;
+
+    bool valid;
+    {
+        IndexLocker locker( lockPath(), false );
+        valid = readIndex();
+    }
+
+    if( !valid || m_index.count() > s_maxIndexRecords ) {
+        kDebug() << "Rewriting the extraction cache index" << indexPath();
+        IndexLocker locker( lockPath(), true );
+        compactIndex();
+    }
+}
+
+bool Nepomuk2::ExtractionCache::readIndex()
+{
+    m_index.clear();
+
+    QFile file( indexPath() );
+    if( !file.open( QIODevice::ReadOnly ) )
+        return true;
+
+    const QByteArray data = file.readAll();
+    file.close();
+
+    if( data.isEmpty() )
+        return true;
+
+    IndexHeader header;
+    if( data.size() < int( sizeof( IndexHeader ) ) )
+        return false;
+    memcpy( &header, data.constData(), sizeof( IndexHeader ) );
+    if( header.magic != s_indexMagic || header.version != s_indexVersion ) {
+        kDebug() << "Ignoring invalid extraction cache index" << indexPath();
+        return false;
+    }
+
+    const int count = ( data.size() - sizeof( IndexHeader ) ) / sizeof( IndexRecord );
+    const char* pos = data.constData() + sizeof( IndexHeader );
+    m_index.reserve( qMin( count, s_maxIndexRecords ) );
+    for( int i = 0; i < count; ++i, pos += sizeof( IndexRecord ) ) {
+        IndexRecord record;
+        memcpy( &record, pos, sizeof( IndexRecord ) );
+
+        FileId id;
+        id.device = record.device;
+        id.inode = record.inode;
+        id.extractors = QByteArray( record.extractors, sizeof( record.extractors ) );
+
+        FileState state;
+        state.mtime = record.mtime;
+        state.size = record.size;
+        state.key = QByteArray( record.key, sizeof( record.key ) ).toHex();
+
+        // later records replace the earlier ones of the same file
+        m_index.insert( id, state );
+    }
+
+    // A record was cut off. The next ones would be appended at the wrong offset.
+    return sizeof( IndexHeader ) + count * sizeof( IndexRecord ) == uint( data.size() );
+}
+
+void Nepomuk2::ExtractionCache::appendToIndex(const FileId& id, const FileState& state)
+{
+    IndexLocker locker( lockPath(), true );
+
+    QFile file( indexPath() );
+    if( !file.open( QIODevice::WriteOnly | QIODevice::Append ) )
+        return;
+
+    // Only one process can get here at a time, so there is only one header
+    if( file.size() == 0 ) {
+        IndexHeader header;
+        header.magic = s_indexMagic;
+        header.version = s_indexVersion;
+        file.write( reinterpret_cast<const char*>( &header ), sizeof( IndexHeader ) );
+    }
+
+    file.write( toRecord( id, state ) );
+    if( m_size >= 0 )
+        m_size += sizeof( IndexRecord );
+
+    // The records of modified files and the ones of other processes pile up
+    const qint64 records = ( file.size() - sizeof( IndexHeader ) ) / sizeof( IndexRecord );
+    file.close();
+    if( records > s_maxIndexRecords ) {
+        kDebug() << "Compacting the extraction cache index with" << records << "records";
+        compactIndex();
+    }
+}
+
+void Nepomuk2::ExtractionCache::compactIndex()
+{
+    // The other processes might have appended records since the index was loaded
+    readIndex();
+
+    // Records whose entry is gone only save reading a file to find out that its
+    // data is not cached.
+    QSet<QByteArray> keys;
+    const QStringList entries = QDir( m_dir ).entryList( QDir::Files );
+    foreach( const QString& entry, entries ) {
+        keys.insert( entry.toLatin1() );
+    }
+
+    QMutableHashIterator<FileId, FileState> it( m_index );
+    while( it.hasNext() ) {
+        if( !keys.contains( it.next().value().key ) )
+            it.remove();
+    }
+
+    // Leave room for new records. The index does not know which records were
+    // used last, thus, drop random ones.
+    const int targetCount = s_maxIndexRecords * 3 / 4;
+    it.toFront();
+    while( m_index.count() > targetCount && it.hasNext() ) {
+        it.next();
+        it.remove();
+    }
+
+    writeIndex();
+}
+
+void Nepomuk2::ExtractionCache::writeIndex()
+{
+    KSaveFile file( indexPath() );
+    if( !file.open() ) {
+        kDebug() << "Failed to write" << file.fileName() << file.errorString();
+        return;
+    }
+
+    IndexHeader header;
+    header.magic = s_indexMagic;
+    header.version = s_indexVersion;
+    file.write( reinterpret_cast<const char*>( &header ), sizeof( IndexHeader ) );
+
+    for( QHash<FileId, FileState>::const_iterator it = m_index.constBegin(); it != m_index.constEnd(); ++it ) {
+        file.write( toRecord( it.key(), it.value() ) );
+    }
+
+    if( !file.finalize() )
+        kDebug() << "Failed to write" << file.fileName() << file.errorString();
+}
+
+// static
+QByteArray Nepomuk2::ExtractionCache::toRecord(const FileId& id, const FileState& state)
+{
+    IndexRecord record;
+    record.device = id.device;
+    record.inode = id.inode;
+    record.mtime = state.mtime;
+    record.size = state.size;
+    memcpy( record.extractors, id.extractors.constData(), sizeof( record.extractors ) );
+    memcpy( record.key, QByteArray::fromHex( state.key ).constData(), sizeof( record.key ) );
+
+    return QByteArray( reinterpret_cast<const char*>( &record ), sizeof( IndexRecord ) );
+}
+
+int Nepomuk2::ExtractionCache::hits() const
+{
+    return m_hits;
+}
+
+int Nepomuk2::ExtractionCache::misses() const
+{
+    return m_misses;
+}
+
+QString Nepomuk2::ExtractionCache::entryPath(const QByteArray& key) const
+{
+    return m_dir + QString::fromLatin1( key );
+}
+
+QString Nepomuk2::ExtractionCache::indexPath() const
+{
+    return m_dir + indexFileName();
+}
+
+QString Nepomuk2::ExtractionCache::lockPath() const
+{
+    return m_dir + lockFileName();
+}
+
+// static
+QString Nepomuk2::ExtractionCache::defaultDir()
+{
+    return KStandardDirs::locateLocal( "cache", QLatin1String("nepomuk-extraction/") );
+}
+
+// static
+qint64 Nepomuk2::ExtractionCache::defaultMaxSize()
+{
+    return 100*1024*1024;
+}
@@ -0,0 +1,166 @@
+/*
+    This file is part of the Nepomuk KDE project.
+    Copyright (C) 2013  Nepomuk Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef NEPOMUK_INDEXER_EXTRACTIONCACHE_H
+#define NEPOMUK_INDEXER_EXTRACTIONCACHE_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QHash>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QUrl>
+
+#include "simpleresourcegraph.h"
+
+namespace Nepomuk2 {
+
+    /**
+     * Keeps the data extracted from file contents on disk so that copies of a
+     * file, and files whose data was lost with the database, do not have to
+     * go through the extractors again.
+     *
+     * Entries are found by a fingerprint of the file contents together with
+     * the mimetype and the versions of the extractors which were used. The
+     * fingerprint of a file is remembered in an index by device and inode
+     * together with the mtime and size so that an unchanged file is not read
+     * again. The graphs are stored compressed with a placeholder for the file
+     * resource and are mapped to the resource of the file they are requested for.
+     *
+     * The least recently used entries are removed once the cache, including
+     * the index, grows beyond its size limit. The index is compacted once it
+     * holds too many records. Several indexer processes share the cache, the
+     * index is only read and written while holding a lock on a separate file.
+     */
+    class ExtractionCache
+    {
+    public:
+        /**
+         * \param maxSize The size limit of the stored entries in bytes
+         */
+        explicit ExtractionCache(const QString& dir = defaultDir(), qint64 maxSize = defaultMaxSize());
+        ~ExtractionCache();
+
+        /**
+         * A fingerprint of the contents of \p filePath. Files up to a few
+         * hundred kilobytes are hashed completely, larger ones are sampled
+         * at their beginning, middle and end unless \p complete is set. The
+         * size is always included.
+         *
+         * \return An empty array if the file could not be read.
+         */
+        static QByteArray fingerprint(const QString& filePath, bool complete = false);
+
+        /**
+         * The cache key for the data extracted from \p filePath by the
+         * extractors identified by \p extractorVersions. The file is only
+         * read if it changed since its key was last requested. A file which
+         * was modified since is hashed completely, an edit in place often
+         * keeps the size and might not touch the samples.
+         *
+         * \return An empty array if the file could not be read.
+         */
+        QByteArray key(const QString& filePath, const QString& mimeType,
+                       const QStringList& extractorVersions);
+
+        /**
+         * Fetch the graph stored for \p key and map it to the resource \p uri.
+         *
+         * \return \p true on a hit
+         */
+        bool lookup(const QByteArray& key, const QUrl& uri, SimpleResourceGraph* graph);
+
+        /**
+         * Store \p graph, which has been extracted for the resource \p uri.
+         */
+        void insert(const QByteArray& key, const QUrl& uri, const SimpleResourceGraph& graph);
+
+        int hits() const;
+        int misses() const;
+
+        static QString defaultDir();
+        static qint64 defaultMaxSize();
+
+    private:
+        /// identifies a file and the extractors used for it
+        struct FileId {
+            quint64 device;
+            quint64 inode;
+            QByteArray extractors;
+
+            bool operator==(const FileId& other) const;
+
+            friend uint qHash(const FileId& id) {
+                return qHash( id.inode ) ^ qHash( id.extractors );
+            }
+        };
+
+        /// the state of the file when its key was computed
+        struct FileState {
+            qint64 mtime;
+            qint64 size;
+            QByteArray key;
+        };
+
+        QString entryPath(const QByteArray& key) const;
+        QString indexPath() const;
+        QString lockPath() const;
+
+        void loadIndex();
+
+        /**
+         * Replace m_index with the records in the index file. Has to be called
+         * with the index lock held.
+         *
+         * \return \p false if the file is damaged and needs to be rewritten
+         */
+        bool readIndex();
+        void appendToIndex(const FileId& id, const FileState& state);
+
+        /**
+         * Merge the records appended by other processes, drop the ones whose
+         * entries no longer exist and rewrite the index, with a single record
+         * per file. Removes records at random if there are still too many.
+         * Has to be called with the exclusive index lock held.
+         */
+        void compactIndex();
+        void writeIndex();
+        static QByteArray toRecord(const FileId& id, const FileState& state);
+
+        /**
+         * Remove the least recently used entries until the cache is well below
+         * its limit and compact the index.
+         */
+        void evict();
+
+        QString m_dir;
+        qint64 m_maxSize;
+
+        /// the size of all entries and the index, -1 until it is needed for the first time
+        qint64 m_size;
+
+        /// maps a file to the key of its contents
+        QHash<FileId, FileState> m_index;
+        bool m_indexLoaded;
+
+        int m_hits;
+        int m_misses;
+    };
+}
+
+#endif // NEPOMUK_INDEXER_EXTRACTIONCACHE_H
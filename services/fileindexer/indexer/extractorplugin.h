@@ -55,6 +55,11 @@ namespace Nepomuk2 {
      * Make sure to implement either mimetypes or the shouldExtract function
      * and update the indexingCriteria accordingly
      *
+     * The mimetypes should also be listed in the X-Nepomuk-MimeTypes key of the
+     * .desktop file of the plugin. Wildcards like "text/*" may be used there.
+     * The plugin is then only loaded once a file with one of those mimetypes is
+     * indexed. Plugins without the key are loaded for every file.
+     *
      * \author Vishesh Handa <me@vhanda.in>
      */
     class NEPOMUK_EXTRACTOR_EXPORT ExtractorPlugin : public QObject
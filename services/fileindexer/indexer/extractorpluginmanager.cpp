@@ -22,69 +22,131 @@
 #include "extractorpluginmanager.h"
 
 #include <KService>
-#include <KMimeType>
 #include <KServiceTypeTrader>
+#include <KPluginLoader>
 #include <KDebug>
 
+#include <QtCore/QFileInfo>
+#include <QtCore/QDateTime>
+#include <QtCore/QTime>
+
 namespace Nepomuk2 {
 
 
 ExtractorPluginManager::ExtractorPluginManager(QObject* parent): QObject(parent)
 {
-    QList< ExtractorPlugin* > all = allExtractors();
+    // Only the .desktop files are read here. Libraries like ffmpeg and poppler
+    // are expensive to load and most indexer runs do not need all of them.
+    KService::List services = KServiceTypeTrader::self()->query( "NepomukFileExtractor" );
 
-    foreach(ExtractorPlugin* ex, all) {
-        if( ex->criteria() == ExtractorPlugin::BasicMimeType ) {
-            foreach(const QString& type, ex->mimetypes()) {
-                m_simpleExtractors.insertMulti( type, ex );
-            }
-        }
-        else if( ex->criteria() == ExtractorPlugin::Custom ) {
-            m_complexExtractors << ex;
-        }
+    foreach( const KService::Ptr& service, services ) {
+        const int index = m_plugins.count();
+
+        Plugin plugin;
+        plugin.service = service;
+        plugin.instance = 0;
+        plugin.loaded = false;
+        m_plugins << plugin;
+
+        m_matcher.add( index, service->property( QLatin1String("X-Nepomuk-MimeTypes"), QVariant::StringList ).toStringList() );
     }
 }
 
 ExtractorPluginManager::~ExtractorPluginManager()
 {
-    qDeleteAll( m_simpleExtractors.values().toSet() );
-    qDeleteAll( m_complexExtractors );
+    foreach( const Plugin& plugin, m_plugins ) {
+        delete plugin.instance;
+    }
 }
 
 
-QList<ExtractorPlugin*> ExtractorPluginManager::allExtractors()
+ExtractorPlugin* ExtractorPluginManager::load(int index)
 {
-    // Get all the plugins
-    KService::List plugins = KServiceTypeTrader::self()->query( "NepomukFileExtractor" );
-
-    QList<ExtractorPlugin*> extractors;
-    KService::List::const_iterator it;
-    for( it = plugins.constBegin(); it != plugins.constEnd(); it++ ) {
-        KService::Ptr service = *it;
-
-        QString error;
-        Nepomuk2::ExtractorPlugin* ex = service->createInstance<Nepomuk2::ExtractorPlugin>( this, QVariantList(), &error );
-        if( !ex ) {
-            kError() << "Could not create Extractor: " << service->library();
-            kError() << error;
-            continue;
-        }
-
-        extractors << ex;
+    Plugin& plugin = m_plugins[index];
+    if( plugin.loaded )
+        return plugin.instance;
+    plugin.loaded = true;
+
+    QTime timer;
+    timer.start();
+
+    QString error;
+    KService::Ptr service = plugin.service;
+    ExtractorPlugin* ex = service->createInstance<Nepomuk2::ExtractorPlugin>( this, QVariantList(), &error );
+    if( !ex ) {
+        kError() << "Could not create Extractor: " << service->library();
+        kError() << error;
+        return 0;
     }
 
-    return extractors;
+    kDebug() << "Loaded" << service->library() << "in" << timer.elapsed() << "ms";
+
+    plugin.instance = ex;
+    if( ex->criteria() == ExtractorPlugin::BasicMimeType )
+        plugin.mimeTypes = ex->mimetypes();
+
+    return ex;
+}
+
+QString ExtractorPluginManager::version(int index)
+{
+    Plugin& plugin = m_plugins[index];
+    if( plugin.version.isEmpty() ) {
+        // The plugins have no version of their own. KPluginLoader only
+        // looks up the library here, it is not loaded.
+        const KService::Ptr service = plugin.service;
+        const QFileInfo library( KPluginLoader( *service ).fileName() );
+        plugin.version = QString::fromLatin1("%1:%2:%3")
+                         .arg( service->library() )
+                         .arg( library.lastModified().toTime_t() )
+                         .arg( library.size() );
+    }
+    return plugin.version;
 }
 
 QList<ExtractorPlugin*> ExtractorPluginManager::fetchExtractors(const QUrl& url, const QString& mimetype)
 {
-    QList<ExtractorPlugin*> plugins = m_simpleExtractors.values( mimetype );
-    foreach( ExtractorPlugin* ex, m_complexExtractors ) {
-        if( ex->shouldExtract( url, mimetype ) )
-            plugins << ex;
+    QList<ExtractorPlugin*> plugins;
+    foreach( int index, m_matcher.candidates( mimetype ) ) {
+        ExtractorPlugin* ex = load( index );
+        if( !ex )
+            continue;
+
+        // The .desktop file might list more mimetypes than the plugin supports in this setup
+        const Plugin& plugin = m_plugins[index];
+        if( ex->criteria() == ExtractorPlugin::BasicMimeType ) {
+            if( plugin.mimeTypes.contains( mimetype ) )
+                plugins << ex;
+        }
+        else if( ex->criteria() == ExtractorPlugin::Custom ) {
+            if( ex->shouldExtract( url, mimetype ) )
+                plugins << ex;
+        }
     }
 
     return plugins;
 }
 
+QStringList ExtractorPluginManager::extractorVersions(const QString& mimetype)
+{
+    QStringList versions;
+    foreach( int index, m_matcher.candidates( mimetype ) ) {
+        versions << version( index );
+    }
+    return versions;
+}
+
+bool ExtractorPluginManager::onlyPlainText(const QString& mimetype) const
+{
+    const QList<int> indices = m_matcher.candidates( mimetype );
+    if( indices.isEmpty() )
+        return false;
+
+    foreach( int index, indices ) {
+        if( m_plugins[index].service->library() != QLatin1String("nepomukplaintextextractor") )
+            return false;
+    }
+    return true;
+}
+
 }
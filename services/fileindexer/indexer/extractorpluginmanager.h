@@ -21,12 +21,25 @@
 #ifndef EXTRACTORPLUGINMANAGER_H
 #define EXTRACTORPLUGINMANAGER_H
 
+#include "mimetypematcher.h"
+
 #include <QtCore/QUrl>
+#include <QtCore/QList>
+#include <QtCore/QStringList>
+
+#include <KService>
 
 namespace Nepomuk2 {
 
     class ExtractorPlugin;
 
+    /**
+     * Finds the extractors for a file.
+     *
+     * The plugins are looked up by the mimetypes listed in their .desktop
+     * files and only loaded once a file needs them. Plugins which do not
+     * list their mimetypes are loaded with the first file.
+     */
     class ExtractorPluginManager : public QObject
     {
     public:
@@ -39,12 +52,36 @@ namespace Nepomuk2 {
          */
         QList<ExtractorPlugin*> fetchExtractors(const QUrl& url, const QString& mimetype);
 
+        /**
+         * The versions of the plugins which might extract data for files with
+         * the given mimetype. A version changes whenever the plugin library is
+         * replaced, for example by an update. The plugins are not loaded.
+         */
+        QStringList extractorVersions(const QString& mimetype);
+
+        /**
+         * \return \p true if the plain text extractor is the only plugin for
+         * files with the given mimetype.
+         */
+        bool onlyPlainText(const QString& mimetype) const;
+
     private:
-        QHash<QString, ExtractorPlugin*> m_simpleExtractors;
-        QList<ExtractorPlugin*> m_complexExtractors;
+        struct Plugin {
+            KService::Ptr service;
+            ExtractorPlugin* instance;
+            bool loaded;
+
+            /// the mimetypes the instance supports, if it uses ExtractorPlugin::BasicMimeType
+            QStringList mimeTypes;
+            QString version;
+        };
+        QList<Plugin> m_plugins;
 
+        /// the plugins for each mimetype listed in the .desktop files
+        MimeTypeMatcher m_matcher;
 
-        QList<ExtractorPlugin*> allExtractors();
+        ExtractorPlugin* load(int index);
+        QString version(int index);
     };
 }
 
@@ -21,13 +21,16 @@
 */
 
 #include "indexer.h"
+#include "extractioncache.h"
 #include "extractorplugin.h"
 #include "extractorpluginmanager.h"
 #include "simpleindexer.h"
+#include "../mimetyperesolver.h"
 #include "../util.h"
 #include "kext.h"
 #include "nie.h"
 
+#include "datamanagement.h"
 #include "storeresourcesjob.h"
 #include "resourcemanager.h"
 
@@ -38,7 +41,6 @@
 #include <KJob>
 
 #include <KService>
-#include <KMimeType>
 #include <KServiceTypeTrader>
 
 #include <QtCore/QDataStream>
@@ -54,13 +56,16 @@ using namespace Soprano::Vocabulary;
 using namespace Nepomuk2::Vocabulary;
 
 Nepomuk2::Indexer::Indexer( QObject* parent )
-    : QObject( parent )
+    : QObject( parent ),
+      m_batchMode( false )
 {
     m_extractorManager = new ExtractorPluginManager( this );
+    m_extractionCache = new ExtractionCache();
 }
 
 Nepomuk2::Indexer::~Indexer()
 {
+    delete m_extractionCache;
 }
 
 
@@ -81,6 +86,7 @@ bool Nepomuk2::Indexer::indexFile(const KUrl& url)
 
     QUrl uri;
     QString mimeType;
+    QString guessedMimeType;
     if( it.next() ) {
         uri = it[0].uri();
         mimeType = it[1].literal().toString();
@@ -91,6 +97,15 @@ bool Nepomuk2::Indexer::indexFile(const KUrl& url)
             if( !simpleIndex( url, &uri, &mimeType ) )
                 return false;
         }
+        else {
+            // The basic indexing only looked at the file name
+            const QString detectedType = MimeTypeResolver::mimeType( url.toLocalFile() );
+            if( detectedType != mimeType ) {
+                kDebug() << "Correcting the mimetype of" << url << "from" << mimeType << "to" << detectedType;
+                guessedMimeType = mimeType;
+                mimeType = detectedType;
+            }
+        }
     }
     else {
         if( !simpleIndex( url, &uri, &mimeType ) )
@@ -98,7 +113,7 @@ bool Nepomuk2::Indexer::indexFile(const KUrl& url)
     }
 
     kDebug() << uri << mimeType;
-    return fileIndex( uri, url, mimeType );
+    return fileIndex( uri, url, mimeType, guessedMimeType );
 }
 
 
@@ -137,56 +152,216 @@ bool Nepomuk2::Indexer::simpleIndex(const QUrl& url, QUrl* uri, QString* mimetyp
     return true;
 }
 
-bool Nepomuk2::Indexer::fileIndex(const QUrl& uri, const QUrl& url, const QString& mimeType)
+void Nepomuk2::Indexer::removeGuessedMimeTypes(const QList<PendingFile>& files)
+{
+    // Removing the union of the stale types might hit a type which another
+    // corrected file really has. The graph stored afterwards adds it again.
+    QList<QUrl> uris;
+    QSet<QUrl> staleTypes;
+    foreach( const PendingFile& file, files ) {
+        if( file.mimeTypeChanged ) {
+            uris << file.uri;
+            staleTypes += file.staleTypes;
+        }
+    }
+    if( uris.isEmpty() )
+        return;
+
+    kDebug() << "Replacing the guessed mimetype of" << uris.count() << "files";
+
+    // we do not have an event loop - thus, we need to delete the jobs ourselves
+    QScopedPointer<KJob> job( Nepomuk2::removeProperties( uris, QList<QUrl>() << NIE::mimeType() ) );
+    job->setAutoDelete(false);
+    job->exec();
+    if( job->error() )
+        kError() << job->errorString();
+
+    if( !staleTypes.isEmpty() ) {
+        QVariantList types;
+        foreach( const QUrl& type, staleTypes )
+            types << type;
+
+        job.reset( Nepomuk2::removeProperty( uris, RDF::type(), types ) );
+        job->setAutoDelete(false);
+        job->exec();
+        if( job->error() )
+            kError() << job->errorString();
+    }
+}
+
+bool Nepomuk2::Indexer::fileIndex(const QUrl& uri, const QUrl& url, const QString& mimeType,
+                                  const QString& guessedMimeType)
+{
+    PendingFile file;
+    file.uri = uri;
+    file.url = url;
+    file.mimeTypeChanged = false;
+
+    file.graph = extract( uri, url, mimeType );
+
+    // The corrected mimetype and its types are stored together with the
+    // extracted data. flush() removes the ones of the guess before.
+    if( !guessedMimeType.isEmpty() ) {
+        const QSet<QUrl> types = SimpleIndexingJob::typesForMimeType( mimeType );
+        file.mimeTypeChanged = true;
+        file.staleTypes = SimpleIndexingJob::typesForMimeType( guessedMimeType ) - types;
+
+        file.graph.add( uri, NIE::mimeType(), mimeType );
+        foreach( const QUrl& type, types )
+            file.graph.add( uri, RDF::type(), type );
+    }
+
+    if( !file.graph.isEmpty() ) {
+        // Do not send the full plain text content with all the other properties.
+        // It is too large
+        SimpleResourceGraph::iterator it = file.graph.find( uri );
+        if( it != file.graph.end() ) {
+            QVariantList vl = it->property( NIE::plainTextContent() );
+            if( vl.size() == 1 ) {
+                file.plainText = vl.first().toString();
+                it->remove( NIE::plainTextContent() );
+                // Check that the SimpleResource is still valid:
+                // if it only contained text it may not be.
+                if ( !it->isValid() )
+                    file.graph.erase( it );
+            }
+        }
+    }
+
+    // Update the indexing level even if no data has changed
+    m_pendingFiles << file;
+
+    if( !m_batchMode ) {
+        const QHash<QUrl, QString> failed = flush();
+        if( !failed.isEmpty() ) {
+            m_lastError = failed.constBegin().value();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+Nepomuk2::SimpleResourceGraph Nepomuk2::Indexer::extract(const QUrl& uri, const QUrl& url, const QString& mimeType)
 {
     SimpleResourceGraph graph;
 
+    // The key only depends on the plugins which could handle the mimetype so
+    // that none of them has to be loaded on a hit
+    const QStringList versions = m_extractorManager->extractorVersions( mimeType );
+    if( versions.isEmpty() )
+        return graph;
+
+    // Copies of a file and files whose data was removed from the database
+    // are not extracted again. Reading plain text again costs about as much
+    // as hashing the file and reading the entry.
+    QByteArray cacheKey;
+    if( !m_extractorManager->onlyPlainText( mimeType ) )
+        cacheKey = m_extractionCache->key( url.toLocalFile(), mimeType, versions );
+    if( !cacheKey.isEmpty() && m_extractionCache->lookup( cacheKey, uri, &graph ) ) {
+        kDebug() << "Using the cached data for" << url;
+        return graph;
+    }
+
     QList<ExtractorPlugin*> extractors = m_extractorManager->fetchExtractors( url, mimeType );
+    if( extractors.isEmpty() )
+        return graph;
+
     foreach( ExtractorPlugin* ex, extractors ) {
         graph += ex->extract( uri, url, mimeType );
     }
 
-    if( !graph.isEmpty() ) {
-        // Do not send the full plain text content with all the other properties.
-        // It is too large
-        QString plainText;
-        QVariantList vl = graph[uri].property( NIE::plainTextContent() );
-        if( vl.size() == 1 ) {
-            plainText = vl.first().toString();
-            graph[uri].remove( NIE::plainTextContent() );
-            // Check that the SimpleResource is still valid:
-            // if it only contained text it may not be.
-            if ( !graph[uri].isValid() )
-                graph.remove(uri);
-        }
+    if( !cacheKey.isEmpty() )
+        m_extractionCache->insert( cacheKey, uri, graph );
 
-        // Check again that the graph is not empty: it may have only contained text
-        if( !graph.isEmpty() ) {
-            QHash<QUrl, QVariant> additionalMetadata;
-            additionalMetadata.insert( RDF::type(), NRL::DiscardableInstanceBase() );
-
-            // we do not have an event loop - thus, we need to delete the job ourselves
-            QScopedPointer<StoreResourcesJob> job( Nepomuk2::storeResources( graph, IdentifyNew,
-                                                                             NoStoreResourcesFlags, additionalMetadata ) );
-            job->setAutoDelete(false);
-            job->exec();
-            if( job->error() ) {
-                m_lastError = job->errorString();
-                kError() << "SimpleIndexerError: " << m_lastError;
-                return false;
+    return graph;
+}
+
+int Nepomuk2::Indexer::extractionCacheHits() const
+{
+    return m_extractionCache->hits();
+}
+
+int Nepomuk2::Indexer::extractionCacheLookups() const
+{
+    return m_extractionCache->hits() + m_extractionCache->misses();
+}
+
+void Nepomuk2::Indexer::setBatchMode(bool enabled)
+{
+    m_batchMode = enabled;
+}
+
+int Nepomuk2::Indexer::pendingCount() const
+{
+    return m_pendingFiles.count();
+}
+
+QHash<QUrl, QString> Nepomuk2::Indexer::flush()
+{
+    QHash<QUrl, QString> failed;
+    if( m_pendingFiles.isEmpty() )
+        return failed;
+
+    QList<PendingFile> files = m_pendingFiles;
+    m_pendingFiles.clear();
+
+    SimpleResourceGraph graph;
+    foreach( const PendingFile& file, files ) {
+        graph += file.graph;
+    }
+
+    removeGuessedMimeTypes( files );
+
+    QString error;
+    if( !graph.isEmpty() && !storeGraph( graph, &error ) ) {
+        // One broken file must not prevent the others from being stored
+        const bool retry = files.count() > 1;
+        if( retry )
+            kDebug() << "Storing" << files.count() << "files at once failed. Trying one by one.";
+        QList<QUrl> failedUris;
+        QMutableListIterator<PendingFile> it( files );
+        while( it.hasNext() ) {
+            const PendingFile& file = it.next();
+            if( !file.graph.isEmpty() && ( !retry || !storeGraph( file.graph, &error ) ) ) {
+                kError() << "SimpleIndexerError: " << file.url << error;
+                failed.insert( file.url, error );
+                failedUris << file.uri;
+                it.remove();
             }
         }
 
-        if( plainText.length() ) {
-            kDebug() << "Saving plain text content";
-            setNiePlainTextContent( uri, plainText );
-        }
+        // make sure the failed files are not tried again
+        Nepomuk2::updateIndexingLevel( failedUris, -1 );
     }
 
-    // Update the indexing level even if no data has changed
+    kDebug() << "Saving plain text content";
+    setNiePlainTextContent( files );
+
     kDebug() << "Updating indexing level";
-    Nepomuk2::updateIndexingLevel( uri, 2 );
+    QList<QUrl> uris;
+    foreach( const PendingFile& file, files ) {
+        uris << file.uri;
+    }
+    Nepomuk2::updateIndexingLevel( uris, 2 );
+
+    return failed;
+}
 
+bool Nepomuk2::Indexer::storeGraph(const SimpleResourceGraph& graph, QString* error)
+{
+    QHash<QUrl, QVariant> additionalMetadata;
+    additionalMetadata.insert( RDF::type(), NRL::DiscardableInstanceBase() );
+
+    // we do not have an event loop - thus, we need to delete the job ourselves
+    QScopedPointer<StoreResourcesJob> job( Nepomuk2::storeResources( graph, IdentifyNew,
+                                                                     NoStoreResourcesFlags, additionalMetadata ) );
+    job->setAutoDelete(false);
+    job->exec();
+    if( job->error() ) {
+        *error = job->errorString();
+        return false;
+    }
     return true;
 }
 
@@ -196,7 +371,7 @@ Nepomuk2::SimpleResourceGraph Nepomuk2::Indexer::indexFileGraph(const QUrl& url)
 {
     SimpleResource res;
 
-    QString mimeType = KMimeType::findByUrl( url )->name();
+    QString mimeType = MimeTypeResolver::mimeType( url.toLocalFile() );
     res.addProperty(NIE::mimeType(), mimeType);
     res.addProperty(NIE::url(), url);
 
@@ -218,32 +393,51 @@ QString Nepomuk2::Indexer::lastError() const
     return m_lastError;
 }
 
-void Nepomuk2::Indexer::setNiePlainTextContent(const QUrl& uri, QString& plainText)
+void Nepomuk2::Indexer::setNiePlainTextContent(QList<PendingFile>& files)
 {
     // This number has been experimentally chosen. Virtuoso cannot handle more than this
     static const int maxSize = ExtractorPlugin::maxPlainTextSize();
-    if( plainText.size() > maxSize )  {
-        kWarning() << "Trimming plain text content from " << plainText.size() << " to " << maxSize;
-        plainText.resize( maxSize );
+
+    QStringList urisN3;
+    for( QList<PendingFile>::iterator it = files.begin(); it != files.end(); ++it ) {
+        if( it->plainText.isEmpty() )
+            continue;
+
+        if( it->plainText.size() > maxSize )  {
+            kWarning() << "Trimming plain text content from " << it->plainText.size() << " to " << maxSize;
+            it->plainText.resize( maxSize );
+        }
+        urisN3 << Soprano::Node::resourceToN3( it->uri );
     }
+    if( urisN3.isEmpty() )
+        return;
 
     // We can use the kext:indexingLevel graph because they are both added by the same application
-    QString query = QString::fromLatin1("select ?g where { graph ?g { %1 kext:indexingLevel ?l . } }")
-                    .arg ( Soprano::Node::resourceToN3(uri) );
+    QString query = QString::fromLatin1("select ?r ?g where { graph ?g { ?r kext:indexingLevel ?l . } "
+                                        "FILTER(?r in (%1)) . }")
+                    .arg( urisN3.join(QLatin1String(",")) );
     Soprano::Model* model = ResourceManager::instance()->mainModel();
     Soprano::QueryResultIterator it = model->executeQuery( query, Soprano::Query::QueryLanguageSparqlNoInference );
 
-    Soprano::Node graph;
-    if( it.next() ) {
-        graph = it[0];
-        it.close();
+    QHash<QUrl, Soprano::Node> graphs;
+    while( it.next() ) {
+        graphs.insert( it[0].uri(), it[1] );
+    }
+
+    QList<Soprano::Statement> statements;
+    foreach( const PendingFile& file, files ) {
+        QHash<QUrl, Soprano::Node>::const_iterator git = graphs.constFind( file.uri );
+        if( !file.plainText.isEmpty() && git != graphs.constEnd() ) {
+            statements << Soprano::Statement( file.uri, NIE::plainTextContent(),
+                                              Soprano::LiteralValue(file.plainText), git.value() );
+        }
     }
 
-    if( !graph.isEmpty() ) {
-        // We use addStatement so that the virtuoso backend internally uses paramertized
+    if( !statements.isEmpty() ) {
+        // We use addStatements so that the virtuoso backend internally uses paramertized
         // queries to push the plain text. Parameterized queries seem to use less memory in
         // virtuoso when inserting.
-        model->addStatement( uri, NIE::plainTextContent(), Soprano::LiteralValue(plainText), graph );
+        model->addStatements( statements );
         if( model->lastError() ) {
             kError() << model->lastError().message();
         }
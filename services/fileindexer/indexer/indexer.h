@@ -25,13 +25,17 @@
 
 #include <QtCore/QObject>
 #include <QtCore/QStringList>
+#include <QtCore/QHash>
+#include <QtCore/QSet>
 #include <KUrl>
 
+#include "simpleresourcegraph.h"
+
 namespace Nepomuk2 {
 
     class Resource;
     class ExtractorPluginManager;
-    class SimpleResourceGraph;
+    class ExtractionCache;
 
     class Indexer : public QObject
     {
@@ -66,21 +70,84 @@ namespace Nepomuk2 {
 
         QString lastError() const;
 
+        /**
+         * In batch mode indexFile() only extracts the data. It is kept in memory until
+         * flush() stores the data of all files with one storeResources call, one
+         * bulk plain text insertion and one indexing level update.
+         *
+         * Batch mode is disabled by default.
+         */
+        void setBatchMode( bool enabled );
+
+        /**
+         * The number of files whose data has not been stored yet.
+         */
+        int pendingCount() const;
+
+        /**
+         * Store the data of all pending files. If the combined graph cannot be
+         * stored each file is tried on its own. Files which still fail get the
+         * indexing level -1.
+         *
+         * \return The failed file urls mapped to the error message.
+         */
+        QHash<QUrl, QString> flush();
+
+        /**
+         * The number of files whose data was found in the extraction cache and
+         * the number of files it was looked up for, since the indexer was created.
+         */
+        int extractionCacheHits() const;
+        int extractionCacheLookups() const;
+
     private:
         QString m_lastError;
         ExtractorPluginManager* m_extractorManager;
+        ExtractionCache* m_extractionCache;
+
+        struct PendingFile {
+            QUrl uri;
+            QUrl url;
+            SimpleResourceGraph graph;
+            QString plainText;
 
-        void updateIndexingLevel( const QUrl& uri, int level );
+            /// true if the graph replaces the mimetype guessed by the basic indexing
+            bool mimeTypeChanged;
+            /// the types of the guessed mimetype which do not apply to the file
+            QSet<QUrl> staleTypes;
+        };
+        QList<PendingFile> m_pendingFiles;
+        bool m_batchMode;
+
+        bool storeGraph( const SimpleResourceGraph& graph, QString* error );
 
         /**
-         * Sets the nie:plainTextContent as \p plainText. The parameter \p plainText
-         * might be modified in the process, if it is too large.
+         * Sets the nie:plainTextContent of all \p files. The plain text might
+         * be trimmed in the process, if it is too large.
          */
-        void setNiePlainTextContent( const QUrl& uri, QString& plainText );
+        void setNiePlainTextContent( QList<PendingFile>& files );
 
         bool clearIndexingData( const QUrl& url );
         bool simpleIndex( const QUrl& url, QUrl* uri, QString* mimetype );
-        bool fileIndex( const QUrl& uri, const QUrl& url, const QString& mimeType );
+        /**
+         * \param guessedMimeType The mimetype stored by the basic indexing if
+         * it differs from \p mimeType, otherwise empty.
+         */
+        bool fileIndex( const QUrl& uri, const QUrl& url, const QString& mimeType,
+                        const QString& guessedMimeType = QString() );
+
+        /**
+         * Run the extractors for \p url or take their data from the extraction
+         * cache if the same content has been extracted before.
+         */
+        SimpleResourceGraph extract( const QUrl& uri, const QUrl& url, const QString& mimeType );
+
+        /**
+         * Remove the mimetype guessed by the basic indexing and its types from
+         * the \p files whose mimetype has been corrected. One request for all
+         * of them.
+         */
+        void removeGuessedMimeTypes( const QList<PendingFile>& files );
     };
 }
 
@@ -36,15 +36,126 @@
 
 #include <QApplication>
 #include <QtCore/QDir>
+#include <QtCore/QTime>
+#include <QtCore/QHash>
 #include <QtCore/QTextStream>
 
 #include <iostream>
+#include <string>
+
+#include <poll.h>
+#include <unistd.h>
 #include <KDebug>
 #include <KUrl>
 #include <KJob>
 
 using namespace Nepomuk2::Vocabulary;
 
+namespace {
+    /// the maximum number of files whose data is stored at once
+    const int s_maxBatchSize = 25;
+
+    /// the maximum time in msec the data of an indexed file is kept in memory
+    const int s_maxBatchDelay = 2000;
+
+    /**
+     * Wait at most \p msec for input on stdin.
+     */
+    bool waitForInput( int msec )
+    {
+        if( std::cin.rdbuf()->in_avail() > 0 )
+            return true;
+
+        pollfd fd;
+        fd.fd = STDIN_FILENO;
+        fd.events = POLLIN;
+        fd.revents = 0;
+        return ::poll( &fd, 1, msec ) > 0;
+    }
+
+    /// the extraction cache statistics reported so far
+    int s_reportedCacheHits = 0;
+    int s_reportedCacheLookups = 0;
+
+    void flush( Nepomuk2::Indexer& indexer )
+    {
+        // The failed files already got indexing level -1 but have been reported
+        // as indexed before. Report them again so that the service can log them.
+        const QHash<QUrl, QString> failed = indexer.flush();
+        for( QHash<QUrl, QString>::const_iterator it = failed.constBegin(); it != failed.constEnd(); ++it ) {
+            QString error = it.value();
+            error.replace( QLatin1Char('\n'), QLatin1Char(' ') );
+            std::cout << "storefailed " << it.key().toEncoded().constData() << ' '
+                      << error.toLocal8Bit().constData() << std::endl;
+        }
+
+        const int hits = indexer.extractionCacheHits();
+        const int lookups = indexer.extractionCacheLookups();
+        if( lookups > s_reportedCacheLookups ) {
+            std::cout << "cachestats " << hits - s_reportedCacheHits << ' '
+                      << lookups - s_reportedCacheLookups << std::endl;
+            s_reportedCacheHits = hits;
+            s_reportedCacheLookups = lookups;
+        }
+
+        std::cout << "flushed" << std::endl;
+    }
+
+    /**
+     * Worker mode used by the file indexing service: read one encoded file url per
+     * line from stdin and answer each with "indexed <url>" or "failed <url> <error>"
+     * on stdout. Returns on EOF.
+     *
+     * The extracted data is stored in batches. "indexed" only means that the data
+     * has been extracted, "flushed" is written once all of it has been stored.
+     * Files whose data could not be stored are listed before as
+     * "storefailed <url> <error>", followed by "cachestats <hits> <lookups>"
+     * with the extraction cache lookups since the previous flush, if any.
+     */
+    int runWorker( Nepomuk2::Indexer& indexer )
+    {
+        indexer.setBatchMode( true );
+
+        QTime batchTime;
+        std::string line;
+        forever {
+            if( indexer.pendingCount() ) {
+                const int remaining = s_maxBatchDelay - batchTime.elapsed();
+                if( remaining <= 0 || !waitForInput( remaining ) ) {
+                    flush( indexer );
+                    continue;
+                }
+            }
+
+            if( !std::getline( std::cin, line ) )
+                break;
+
+            const QByteArray encodedUrl = QByteArray( line.c_str() ).trimmed();
+            if( encodedUrl.isEmpty() )
+                continue;
+
+            const bool startBatch = ( indexer.pendingCount() == 0 );
+            const KUrl url = QUrl::fromEncoded( encodedUrl );
+            if( indexer.indexFile( url ) ) {
+                std::cout << "indexed " << encodedUrl.constData() << std::endl;
+            }
+            else {
+                QString error = indexer.lastError();
+                error.replace( QLatin1Char('\n'), QLatin1Char(' ') );
+                std::cout << "failed " << encodedUrl.constData() << ' ' << error.toLocal8Bit().constData() << std::endl;
+            }
+
+            if( startBatch )
+                batchTime.start();
+            if( indexer.pendingCount() >= s_maxBatchSize )
+                flush( indexer );
+        }
+
+        flush( indexer );
+        return 0;
+    }
+}
+
 int main(int argc, char *argv[])
 {
     lowerIOPriority();
@@ -65,6 +176,7 @@ int main(int argc, char *argv[])
     options.add("+[url]", ki18n("The URL of the file to be indexed"));
     options.add("clear", ki18n("Remove all indexed data of the URL provided"));
     options.add("data", ki18n("Streams the indexed data to stdout"));
+    options.add("worker", ki18n("Index the URLs read from stdin, one per line, until stdin is closed"));
 
     KCmdLineArgs::addCmdLineOptions(options);
     const KCmdLineArgs *args = KCmdLineArgs::parsedArgs();
@@ -73,6 +185,11 @@ int main(int argc, char *argv[])
     QApplication app( argc, argv );
     KComponentData data( aboutData, KComponentData::RegisterAsMainComponent );
 
+    if( args->isSet("worker") ) {
+        Nepomuk2::Indexer indexer;
+        return runWorker( indexer );
+    }
+
     if( args->count() == 0 ) {
         QTextStream err( stderr );
         err << "Must input url of the file to be indexed";
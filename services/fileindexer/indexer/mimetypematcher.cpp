@@ -0,0 +1,55 @@
+/*
+    This file is part of the Nepomuk KDE project.
+    Copyright (C) 2013  Nepomuk Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "mimetypematcher.h"
+
+void Nepomuk2::MimeTypeMatcher::add(int index, const QStringList& mimeTypes)
+{
+    if( mimeTypes.isEmpty() ) {
+        m_unindexedPlugins << index;
+        return;
+    }
+
+    foreach( const QString& type, mimeTypes ) {
+        if( type.contains( QLatin1Char('*') ) )
+            m_mimeTypePatterns << qMakePair( QRegExp( type, Qt::CaseSensitive, QRegExp::Wildcard ), index );
+        else
+            m_mimeTypeIndex.insertMulti( type, index );
+    }
+}
+
+QList<int> Nepomuk2::MimeTypeMatcher::candidates(const QString& mimetype) const
+{
+    QList<int> indices = m_mimeTypeIndex.values( mimetype );
+    for( int i = 0; i < m_mimeTypePatterns.count(); ++i ) {
+        if( m_mimeTypePatterns[i].first.exactMatch( mimetype ) )
+            indices << m_mimeTypePatterns[i].second;
+    }
+    indices << m_unindexedPlugins;
+
+    // The same plugins in the same order for the same mimetype
+    qSort( indices );
+
+    QList<int> result;
+    foreach( int index, indices ) {
+        if( result.isEmpty() || result.last() != index )
+            result << index;
+    }
+    return result;
+}
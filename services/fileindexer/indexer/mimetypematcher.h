@@ -0,0 +1,55 @@
+/*
+    This file is part of the Nepomuk KDE project.
+    Copyright (C) 2013  Nepomuk Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef NEPOMUK_INDEXER_MIMETYPEMATCHER_H
+#define NEPOMUK_INDEXER_MIMETYPEMATCHER_H
+
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QPair>
+#include <QtCore/QRegExp>
+#include <QtCore/QStringList>
+
+namespace Nepomuk2 {
+
+    /**
+     * Maps mimetypes to the indices of the extractor plugins which might
+     * handle them, going by the mimetypes listed in the .desktop files.
+     * Entries containing a \c * are matched as wildcards.
+     */
+    class MimeTypeMatcher
+    {
+    public:
+        /**
+         * Registers the plugin \p index for \p mimeTypes. A plugin without
+         * mimetypes is a candidate for every file.
+         */
+        void add(int index, const QStringList& mimeTypes);
+
+        /// the plugins matching \p mimetype, sorted by index and without duplicates
+        QList<int> candidates(const QString& mimetype) const;
+
+    private:
+        QHash<QString, int> m_mimeTypeIndex;
+        QList< QPair<QRegExp, int> > m_mimeTypePatterns;
+        QList<int> m_unindexedPlugins;
+    };
+}
+
+#endif // NEPOMUK_INDEXER_MIMETYPEMATCHER_H
@@ -20,6 +20,7 @@
 */
 
 #include "simpleindexer.h"
+#include "../mimetyperesolver.h"
 #include "datamanagement.h"
 #include "storeresourcesjob.h"
 
@@ -33,7 +34,6 @@
 #include <QtCore/QFileInfo>
 #include <QtCore/QDateTime>
 
-#include <KMimeType>
 #include <KDebug>
 #include <KJob>
 #include <kde_file.h>
@@ -43,31 +43,47 @@ using namespace Soprano::Vocabulary;
 
 Nepomuk2::SimpleIndexingJob::SimpleIndexingJob(const QUrl& fileUrl, QObject* parent)
     : KJob( parent )
-    , m_nieUrl( fileUrl )
 {
+    m_nieUrls << fileUrl;
 }
 
 Nepomuk2::SimpleIndexingJob::SimpleIndexingJob(const QUrl& fileUrl, const QString& mimeType, QObject* parent)
     : KJob(parent)
-    , m_nieUrl( fileUrl )
-    , m_mimeType( mimeType )
 {
+    m_nieUrls << fileUrl;
+    m_mimeTypes << mimeType;
 }
 
-void Nepomuk2::SimpleIndexingJob::start()
+Nepomuk2::SimpleIndexingJob::SimpleIndexingJob(const QList<QUrl>& fileUrls, const QStringList& mimeTypes, QObject* parent)
+    : KJob(parent)
+    , m_mimeTypes( mimeTypes )
 {
-    SimpleResource m_res = createSimpleResource( m_nieUrl, &m_mimeType );
-    m_resUri = m_res.uri();
+    foreach( const QUrl& url, fileUrls )
+        m_nieUrls << url;
+}
 
-    // Indexing Level
-    m_res.setProperty(KExt::indexingLevel(), 1);
+void Nepomuk2::SimpleIndexingJob::start()
+{
+    SimpleResourceGraph graph;
+    m_resUris.clear();
+    for( int i = 0; i < m_nieUrls.count(); ++i ) {
+        QString mimeType = m_mimeTypes.value( i );
+        SimpleResource res = createSimpleResource( m_nieUrls[i], &mimeType );
+        if( i < m_mimeTypes.count() )
+            m_mimeTypes[i] = mimeType;
+        else
+            m_mimeTypes << mimeType;
+
+        // Indexing Level
+        res.setProperty(KExt::indexingLevel(), 1);
+
+        m_resUris << res.uri();
+        graph << res;
+    }
 
     QHash<QUrl, QVariant> additionalMetadata;
     additionalMetadata.insert( RDF::type(), NRL::DiscardableInstanceBase() );
 
-    SimpleResourceGraph graph;
-    graph << m_res;
-
     // In order to be compatibile with earlier releases we keep the old app name
     KComponentData component = KGlobal::mainComponent();
     if( component.componentName() != QLatin1String("nepomukindexer") ) {
@@ -90,7 +106,9 @@ void Nepomuk2::SimpleIndexingJob::slotJobFinished(KJob* job_)
         setErrorText( job->errorString() );
     }
 
-    m_resUri = job->mappings().value( m_resUri );
+    const QHash<QUrl, QUrl> mappings = job->mappings();
+    for( int i = 0; i < m_resUris.count(); ++i )
+        m_resUris[i] = mappings.value( m_resUris[i] );
     emitResult();
 }
 
@@ -120,7 +138,7 @@ Nepomuk2::SimpleResource Nepomuk2::SimpleIndexingJob::createSimpleResource(const
         mime = *mimeType;
 
     if( mime.isEmpty() ) {
-        mime = KMimeType::findByUrl( fileUrl )->name();
+        mime = MimeTypeResolver::mimeType( fileUrl.toLocalFile() );
         if( mimeType )
             *mimeType = mime;
     }
@@ -238,11 +256,11 @@ QSet<QUrl> Nepomuk2::SimpleIndexingJob::typesForMimeType(const QString& mimeType
 
 QString Nepomuk2::SimpleIndexingJob::mimeType()
 {
-    return m_mimeType;
+    return m_mimeTypes.value( 0 );
 }
 
 QUrl Nepomuk2::SimpleIndexingJob::uri()
 {
-    return m_resUri;
+    return m_resUris.value( 0 );
 }
 
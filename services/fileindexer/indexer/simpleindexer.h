@@ -23,6 +23,7 @@
 #define SIMPLEINDEXER_H
 
 #include <QtCore/QUrl>
+#include <QtCore/QStringList>
 
 #include "simpleresource.h"
 #include "simpleresourcegraph.h"
@@ -41,8 +42,19 @@ namespace Nepomuk2 {
         SimpleIndexingJob(const QUrl& fileUrl, QObject* parent = 0);
         SimpleIndexingJob(const QUrl& fileUrl, const QString& mimeType, QObject* parent = 0);
 
+        /**
+         * Store the basic data of all \p fileUrls with a single request.
+         *
+         * \param mimeTypes The mimetypes of the files in the same order. An empty
+         *                  list or empty entries make the job determine them.
+         */
+        SimpleIndexingJob(const QList<QUrl>& fileUrls, const QStringList& mimeTypes, QObject* parent = 0);
+
         virtual void start();
 
+        /**
+         * The resource uri and the mimetype of the first file.
+         */
         QUrl uri();
         QString mimeType();
 
@@ -56,15 +68,18 @@ namespace Nepomuk2 {
          */
         static SimpleResource createSimpleResource( const KUrl& fileUrl, QString* mimeType );
 
+        /**
+         * The types of a file of \p mimeType in addition to nfo:FileDataObject.
+         */
+        static QSet<QUrl> typesForMimeType(const QString& mimeType);
+
     private slots:
         void slotJobFinished(KJob* job);
 
     private:
-        KUrl m_nieUrl;
-        QUrl m_resUri;
-        QString m_mimeType;
-
-        static QSet<QUrl> typesForMimeType(const QString& mimeType);
+        QList<KUrl> m_nieUrls;
+        QList<QUrl> m_resUris;
+        QStringList m_mimeTypes;
     };
 }
 
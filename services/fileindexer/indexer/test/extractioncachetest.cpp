@@ -0,0 +1,278 @@
+/*
+    This file is part of the Nepomuk KDE project.
+    Copyright (C) 2013  Nepomuk Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "extractioncachetest.h"
+#include "../extractioncache.h"
+
+#include "simpleresource.h"
+#include "simpleresourcegraph.h"
+#include "nie.h"
+#include "nmm.h"
+
+#include <KTempDir>
+#include <qtest_kde.h>
+
+#include <QtTest>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+
+#include <kde_file.h>
+#include <utime.h>
+
+using namespace Nepomuk2;
+using namespace Nepomuk2::Vocabulary;
+
+namespace {
+    void writeFile(const QString& path, const QByteArray& data) {
+        QFile file( path );
+        QVERIFY( file.open( QIODevice::WriteOnly ) );
+        file.write( data );
+    }
+}
+
+void ExtractionCacheTest::testFingerprint()
+{
+    KTempDir dir;
+
+    // large enough to be sampled
+    QByteArray data( 1024*1024, 'a' );
+    writeFile( dir.name() + QLatin1String("a"), data );
+    writeFile( dir.name() + QLatin1String("copy"), data );
+
+    data[0] = 'b';
+    writeFile( dir.name() + QLatin1String("changed"), data );
+
+    const QByteArray print = ExtractionCache::fingerprint( dir.name() + QLatin1String("a") );
+    QVERIFY( !print.isEmpty() );
+    QCOMPARE( ExtractionCache::fingerprint( dir.name() + QLatin1String("copy") ), print );
+    QVERIFY( ExtractionCache::fingerprint( dir.name() + QLatin1String("changed") ) != print );
+
+    QVERIFY( ExtractionCache::fingerprint( dir.name() + QLatin1String("missing") ).isEmpty() );
+}
+
+void ExtractionCacheTest::testKey()
+{
+    KTempDir dir;
+    ExtractionCache cache( dir.name() + QLatin1String("cache") );
+
+    const QString path = dir.name() + QLatin1String("a");
+    const QString copyPath = dir.name() + QLatin1String("copy");
+    writeFile( path, "content" );
+    writeFile( copyPath, "content" );
+
+    const QStringList extractors = QStringList() << QLatin1String("ex:1");
+    const QByteArray key = cache.key( path, QLatin1String("text/plain"), extractors );
+    QVERIFY( !key.isEmpty() );
+    QCOMPARE( cache.key( copyPath, QLatin1String("text/plain"), extractors ), key );
+
+    // the extractors are part of the key
+    QVERIFY( cache.key( path, QLatin1String("text/plain"), QStringList() << QLatin1String("ex:2") ) != key );
+    QVERIFY( cache.key( path, QLatin1String("text/html"), extractors ) != key );
+
+    QVERIFY( cache.key( dir.name() + QLatin1String("missing"), QLatin1String("text/plain"), extractors ).isEmpty() );
+}
+
+void ExtractionCacheTest::testUnchangedFileIsNotRead()
+{
+    KTempDir dir;
+    const QString path = dir.name() + QLatin1String("a");
+    writeFile( path, "content" );
+
+    const QStringList extractors = QStringList() << QLatin1String("ex:1");
+    QByteArray key;
+    {
+        ExtractionCache cache( dir.name() + QLatin1String("cache") );
+        key = cache.key( path, QLatin1String("text/plain"), extractors );
+    }
+
+    // Same size and mtime. The index was saved, thus the file is not hashed again.
+    KDE_struct_stat buf;
+    QCOMPARE( KDE::stat( path, &buf ), 0 );
+    writeFile( path, "CONTENT" );
+    struct utimbuf times;
+    times.actime = buf.st_atime;
+    times.modtime = buf.st_mtime;
+    QCOMPARE( KDE::utime( path, &times ), 0 );
+
+    ExtractionCache cache( dir.name() + QLatin1String("cache") );
+    QCOMPARE( cache.key( path, QLatin1String("text/plain"), extractors ), key );
+
+    // a modified file is read again
+    times.modtime += 10;
+    QCOMPARE( KDE::utime( path, &times ), 0 );
+    QVERIFY( cache.key( path, QLatin1String("text/plain"), extractors ) != key );
+}
+
+void ExtractionCacheTest::testModifiedFileIsHashedCompletely()
+{
+    KTempDir dir;
+    const QString path = dir.name() + QLatin1String("a");
+
+    // large enough to be sampled
+    QByteArray data( 1024*1024, 'a' );
+    writeFile( path, data );
+
+    const QStringList extractors = QStringList() << QLatin1String("ex:1");
+    ExtractionCache cache( dir.name() + QLatin1String("cache") );
+    const QByteArray key = cache.key( path, QLatin1String("image/jpeg"), extractors );
+    QVERIFY( !key.isEmpty() );
+
+    // edited in place between the samples, the size stays the same
+    KDE_struct_stat buf;
+    QCOMPARE( KDE::stat( path, &buf ), 0 );
+    const QByteArray print = ExtractionCache::fingerprint( path );
+    data[200*1024] = 'b';
+    writeFile( path, data );
+    QCOMPARE( ExtractionCache::fingerprint( path ), print );
+
+    struct utimbuf times;
+    times.actime = buf.st_atime;
+    times.modtime = buf.st_mtime + 10;
+    QCOMPARE( KDE::utime( path, &times ), 0 );
+
+    const QByteArray newKey = cache.key( path, QLatin1String("image/jpeg"), extractors );
+    QVERIFY( !newKey.isEmpty() );
+    QVERIFY( newKey != key );
+    QCOMPARE( ExtractionCache::fingerprint( path, true ), ExtractionCache::fingerprint( path, true ) );
+}
+
+void ExtractionCacheTest::testDamagedIndex()
+{
+    KTempDir dir;
+    const QString path = dir.name() + QLatin1String("a");
+    writeFile( path, "content" );
+
+    // a header written twice and a record cut off
+    const QString cacheDir = dir.name() + QLatin1String("cache/");
+    QVERIFY( QDir().mkpath( cacheDir ) );
+    writeFile( cacheDir + QLatin1String("index"), QByteArray( "IXEN\1\0\0\0IXEN\1\0\0\0abc", 19 ) );
+
+    const QStringList extractors = QStringList() << QLatin1String("ex:1");
+    QByteArray key;
+    {
+        ExtractionCache cache( cacheDir );
+        key = cache.key( path, QLatin1String("text/plain"), extractors );
+        QVERIFY( !key.isEmpty() );
+    }
+
+    // The index has been rewritten, the record of the file can be read
+    KDE_struct_stat buf;
+    QCOMPARE( KDE::stat( path, &buf ), 0 );
+    writeFile( path, "CONTENT" );
+    struct utimbuf times;
+    times.actime = buf.st_atime;
+    times.modtime = buf.st_mtime;
+    QCOMPARE( KDE::utime( path, &times ), 0 );
+
+    ExtractionCache cache( cacheDir );
+    QCOMPARE( cache.key( path, QLatin1String("text/plain"), extractors ), key );
+}
+
+void ExtractionCacheTest::testLookup()
+{
+    KTempDir dir;
+    ExtractionCache cache( dir.name() );
+
+    const QUrl uri( QLatin1String("nepomuk:/res/first") );
+    SimpleResource artist;
+    artist.addProperty( NIE::title(), QLatin1String("Artist") );
+
+    SimpleResource file( uri );
+    file.addProperty( NIE::title(), QLatin1String("Song") );
+    file.addProperty( NMM::performer(), artist );
+
+    SimpleResourceGraph graph;
+    graph << file << artist;
+    cache.insert( "key", uri, graph );
+
+    const QUrl copyUri( QLatin1String("nepomuk:/res/copy") );
+    SimpleResourceGraph cached;
+    QVERIFY( cache.lookup( "key", copyUri, &cached ) );
+    QCOMPARE( cache.hits(), 1 );
+    QCOMPARE( cached.count(), 2 );
+
+    const SimpleResource copy = cached[copyUri];
+    QVERIFY( copy.isValid() );
+    QVERIFY( copy.property( NIE::title() ) == QVariantList() << QString::fromLatin1("Song") );
+
+    // the artist is a new blank node which the copy refers to
+    const QList<QVariant> performers = copy.property( NMM::performer() );
+    QCOMPARE( performers.count(), 1 );
+    const QUrl artistUri = performers.first().toUrl();
+    QVERIFY( artistUri.toString().startsWith( QLatin1String("_:") ) );
+    QVERIFY( artistUri != artist.uri() );
+    QVERIFY( cached[artistUri].property( NIE::title() ) == QVariantList() << QString::fromLatin1("Artist") );
+}
+
+void ExtractionCacheTest::testEviction()
+{
+    KTempDir dir;
+
+    // Random text does not compress much, thus all entries have about the same size
+    SimpleResourceGraph graphs[4];
+    for( int i = 0; i < 4; ++i ) {
+        QString text;
+        for( int j = 0; j < 10*1024; ++j )
+            text += QChar( 'a' + qrand() % 26 );
+        graphs[i].add( QUrl( QLatin1String("nepomuk:/res/a") ), NIE::plainTextContent(), text );
+    }
+
+    const QUrl uri( QLatin1String("nepomuk:/res/a") );
+    qint64 entrySize = 0;
+    {
+        ExtractionCache probe( dir.name() + QLatin1String("probe") );
+        probe.insert( "probe", uri, graphs[0] );
+        entrySize = QFileInfo( dir.name() + QLatin1String("probe/probe") ).size();
+        QVERIFY( entrySize > 0 );
+    }
+
+    // room for three entries
+    ExtractionCache cache( dir.name() + QLatin1String("cache"), entrySize * 7 / 2 );
+    cache.insert( "first", uri, graphs[0] );
+    cache.insert( "second", uri, graphs[1] );
+    cache.insert( "third", uri, graphs[2] );
+
+    // the mtime has a resolution of one second
+    QTest::qSleep( 1100 );
+    SimpleResourceGraph graph;
+    QVERIFY( cache.lookup( "first", uri, &graph ) );
+
+    // the least recently used entries make room for the new one
+    cache.insert( "fourth", uri, graphs[3] );
+    QVERIFY( cache.lookup( "first", uri, &graph ) );
+    QVERIFY( cache.lookup( "fourth", uri, &graph ) );
+    QVERIFY( !cache.lookup( "second", uri, &graph ) );
+    QVERIFY( !cache.lookup( "third", uri, &graph ) );
+}
+
+void ExtractionCacheTest::testMiss()
+{
+    KTempDir dir;
+    ExtractionCache cache( dir.name() );
+
+    SimpleResourceGraph graph;
+    QVERIFY( !cache.lookup( "unknown", QUrl( QLatin1String("nepomuk:/res/a") ), &graph ) );
+    QCOMPARE( cache.misses(), 1 );
+    QCOMPARE( cache.hits(), 0 );
+}
+
+QTEST_KDEMAIN_CORE(ExtractionCacheTest)
+
+#include "extractioncachetest.moc"
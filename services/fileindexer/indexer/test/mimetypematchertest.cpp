@@ -0,0 +1,81 @@
+/*
+    This file is part of the Nepomuk KDE project.
+    Copyright (C) 2013  Nepomuk Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "mimetypematchertest.h"
+#include "../mimetypematcher.h"
+
+#include <qtest_kde.h>
+
+#include <QtTest>
+
+using namespace Nepomuk2;
+
+void MimeTypeMatcherTest::testExactMatch()
+{
+    MimeTypeMatcher matcher;
+    matcher.add( 0, QStringList() << QLatin1String("application/pdf") );
+    matcher.add( 1, QStringList() << QLatin1String("audio/mpeg") << QLatin1String("audio/ogg") );
+
+    QCOMPARE( matcher.candidates( QLatin1String("application/pdf") ), QList<int>() << 0 );
+    QCOMPARE( matcher.candidates( QLatin1String("audio/ogg") ), QList<int>() << 1 );
+    QVERIFY( matcher.candidates( QLatin1String("image/png") ).isEmpty() );
+}
+
+void MimeTypeMatcherTest::testWildcards()
+{
+    MimeTypeMatcher matcher;
+    matcher.add( 0, QStringList() << QLatin1String("text/*") );
+    matcher.add( 1, QStringList() << QLatin1String("*/xml") );
+    matcher.add( 2, QStringList() << QLatin1String("text/html") );
+
+    QCOMPARE( matcher.candidates( QLatin1String("text/plain") ), QList<int>() << 0 );
+    QCOMPARE( matcher.candidates( QLatin1String("text/xml") ), QList<int>() << 0 << 1 );
+    QCOMPARE( matcher.candidates( QLatin1String("application/xml") ), QList<int>() << 1 );
+    QCOMPARE( matcher.candidates( QLatin1String("text/html") ), QList<int>() << 0 << 2 );
+
+    // the whole mimetype has to match
+    QVERIFY( matcher.candidates( QLatin1String("application/xml-dtd") ).isEmpty() );
+    QVERIFY( matcher.candidates( QLatin1String("image/png") ).isEmpty() );
+}
+
+void MimeTypeMatcherTest::testUnindexedPlugins()
+{
+    // a plugin without X-Nepomuk-MimeTypes has to decide itself
+    MimeTypeMatcher matcher;
+    matcher.add( 0, QStringList() << QLatin1String("application/pdf") );
+    matcher.add( 1, QStringList() );
+
+    QCOMPARE( matcher.candidates( QLatin1String("application/pdf") ), QList<int>() << 0 << 1 );
+    QCOMPARE( matcher.candidates( QLatin1String("image/png") ), QList<int>() << 1 );
+}
+
+void MimeTypeMatcherTest::testDuplicates()
+{
+    MimeTypeMatcher matcher;
+    matcher.add( 2, QStringList() << QLatin1String("text/plain") << QLatin1String("text/*") );
+    matcher.add( 0, QStringList() << QLatin1String("text/plain") << QLatin1String("text/plain") );
+    matcher.add( 1, QStringList() << QLatin1String("*/plain") << QLatin1String("text/*") );
+
+    // each plugin once, in the order of the indices
+    QCOMPARE( matcher.candidates( QLatin1String("text/plain") ), QList<int>() << 0 << 1 << 2 );
+}
+
+QTEST_KDEMAIN_CORE(MimeTypeMatcherTest)
+
+#include "mimetypematchertest.moc"
@@ -0,0 +1,231 @@
+/*
+    This file is part of the Nepomuk KDE project.
+    Copyright (C) 2013  Nepomuk Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "indexerworker.h"
+
+#include <KDebug>
+#include <KProcess>
+#include <KStandardDirs>
+
+namespace {
+    /// the number of files after which the worker process is replaced by a fresh one
+    const int s_maxFilesPerProcess = 500;
+}
+
+Nepomuk2::IndexerWorker::IndexerWorker(QObject* parent)
+    : QObject(parent),
+      m_process(0),
+      m_fileCount(0)
+{
+}
+
+Nepomuk2::IndexerWorker::~IndexerWorker()
+{
+    if( isBusy() )
+        kill();
+    else
+        close();
+}
+
+void Nepomuk2::IndexerWorker::setProgram(const QString& program)
+{
+    m_program = program;
+}
+
+bool Nepomuk2::IndexerWorker::isBusy() const
+{
+    return !m_currentUrl.isEmpty();
+}
+
+QUrl Nepomuk2::IndexerWorker::currentUrl() const
+{
+    return m_currentUrl;
+}
+
+QSet<QUrl> Nepomuk2::IndexerWorker::pendingUrls() const
+{
+    return m_pendingUrls;
+}
+
+void Nepomuk2::IndexerWorker::startProcess()
+{
+    QString exe = m_program;
+    if( exe.isEmpty() )
+        exe = KStandardDirs::findExe(QLatin1String("nepomukindexer"));
+    if( exe.isEmpty() ) {
+        // let KProcess report the failure through the error signal
+        exe = QLatin1String("nepomukindexer");
+    }
+
+    kDebug() << "Starting indexer worker" << exe;
+
+    m_process = new KProcess( this );
+    m_process->setProgram( exe, QStringList() << QLatin1String("--worker") );
+    m_process->setOutputChannelMode( KProcess::OnlyStdoutChannel );
+    connect( m_process, SIGNAL(readyReadStandardOutput()),
+             this, SLOT(slotReadyRead()) );
+    connect( m_process, SIGNAL(finished(int, QProcess::ExitStatus)),
+             this, SLOT(slotProcessFinished(int, QProcess::ExitStatus)) );
+    connect( m_process, SIGNAL(error(QProcess::ProcessError)),
+             this, SLOT(slotProcessError(QProcess::ProcessError)) );
+    m_process->start();
+    m_fileCount = 0;
+}
+
+void Nepomuk2::IndexerWorker::indexFile(const QUrl& url)
+{
+    Q_ASSERT( !isBusy() );
+
+    if( !m_process )
+        startProcess();
+
+    m_currentUrl = url;
+    m_process->write( url.toEncoded() + '\n' );
+}
+
+void Nepomuk2::IndexerWorker::kill()
+{
+    if( m_process ) {
+        m_process->disconnect( this );
+        m_process->kill();
+        m_process->waitForFinished();
+        delete m_process;
+        m_process = 0;
+    }
+    m_currentUrl.clear();
+    abortPending();
+}
+
+void Nepomuk2::IndexerWorker::close()
+{
+    Q_ASSERT( !isBusy() );
+
+    if( !m_process )
+        return;
+
+    // The process stores its last batch once it reads EOF and deletes itself when
+    // done, even if the worker is gone by then. The files are no longer reported
+    // as pending. At worst they are picked up again in the meantime.
+    m_process->disconnect( this );
+    m_process->setParent( 0 );
+    connect( m_process, SIGNAL(finished(int, QProcess::ExitStatus)),
+             m_process, SLOT(deleteLater()) );
+    m_process->closeWriteChannel();
+    m_process = 0;
+    m_pendingUrls.clear();
+}
+
+void Nepomuk2::IndexerWorker::abortPending()
+{
+    // Not stored, they still have indexing level 1. Taken first since the
+    // receivers check pendingUrls() before queueing them again.
+    const QSet<QUrl> urls = m_pendingUrls;
+    m_pendingUrls.clear();
+    foreach( const QUrl& url, urls ) {
+        emit storeAborted( url );
+    }
+}
+
+void Nepomuk2::IndexerWorker::slotReadyRead()
+{
+    while( m_process && m_process->canReadLine() ) {
+        // The worker answers with "indexed <url>" or "failed <url> <message>" and
+        // writes "flushed" once the data of the indexed files has been stored,
+        // preceded by "storefailed <url> <message>" for each file which could not
+        // be stored and "cachestats <hits> <lookups>". Anything else is output of some
+        // extractor library and can be ignored.
+        const QByteArray line = m_process->readLine().trimmed();
+        if( line == "flushed" ) {
+            m_pendingUrls.clear();
+            continue;
+        }
+
+        const QList<QByteArray> parts = line.split(' ');
+        if( parts.count() == 3 && parts[0] == "cachestats" ) {
+            emit extractionCacheStatistics( parts[1].toInt(), parts[2].toInt() );
+            continue;
+        }
+
+        if( parts.count() >= 2 && parts[0] == "storefailed" ) {
+            const QUrl url = QUrl::fromEncoded( parts[1] );
+            const int pos = parts[0].size() + parts[1].size() + 2;
+            m_pendingUrls.remove( url );
+            emit storeFailed( url, QString::fromLocal8Bit( line.mid(pos) ) );
+            continue;
+        }
+
+        if( parts.count() < 2 || !isBusy() || parts[1] != m_currentUrl.toEncoded() )
+            continue;
+
+        if( parts[0] == "indexed" ) {
+            m_pendingUrls.insert( m_currentUrl );
+            finishFile( Indexed, QString() );
+        }
+        else if( parts[0] == "failed" ) {
+            const int pos = parts[0].size() + parts[1].size() + 2;
+            finishFile( Failed, QString::fromLocal8Bit( line.mid(pos) ) );
+        }
+    }
+}
+
+void Nepomuk2::IndexerWorker::slotProcessFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    m_process->deleteLater();
+    m_process = 0;
+
+    // an exit without "flushed" means the last batch was not stored
+    abortPending();
+
+    if( isBusy() ) {
+        if( exitStatus != QProcess::NormalExit ) {
+            finishFile( Crashed, QLatin1String("Indexer process crashed on ") + m_currentUrl.toLocalFile() );
+        }
+        else {
+            finishFile( Failed, QString::fromLatin1("Indexer process exited with code %1 on %2")
+                                .arg( exitCode ).arg( m_currentUrl.toLocalFile() ) );
+        }
+    }
+}
+
+void Nepomuk2::IndexerWorker::slotProcessError(QProcess::ProcessError error)
+{
+    // all other errors result in the finished signal
+    if( error == QProcess::FailedToStart ) {
+        kError() << "Failed to start the indexer:" << m_process->errorString();
+        m_process->deleteLater();
+        m_process = 0;
+
+        if( isBusy() )
+            finishFile( Failed, QLatin1String("Failed to start the indexer process") );
+    }
+}
+
+void Nepomuk2::IndexerWorker::finishFile(int status, const QString& message)
+{
+    const QUrl url = m_currentUrl;
+    m_currentUrl.clear();
+
+    if( m_process && ++m_fileCount >= s_maxFilesPerProcess ) {
+        close();
+    }
+
+    emit finished( url, status, message );
+}
+
+#include "indexerworker.moc"
@@ -0,0 +1,148 @@
+/*
+    This file is part of the Nepomuk KDE project.
+    Copyright (C) 2013  Nepomuk Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef FILEINDEXER_INDEXERWORKER_H
+#define FILEINDEXER_INDEXERWORKER_H
+
+#include <QtCore/QObject>
+#include <QtCore/QUrl>
+#include <QtCore/QSet>
+#include <QtCore/QProcess>
+
+class KProcess;
+
+namespace Nepomuk2 {
+
+    /**
+     * A long-lived nepomukindexer process started in worker mode.
+     *
+     * The worker reads one file url per line on stdin and reports the result
+     * of each file on stdout. This saves the KDE initialization, the loading of
+     * all extractor plugins and the D-Bus connection setup for every single file.
+     *
+     * The process is started on demand and respawned after a crash. It is also
+     * replaced after a fixed number of files in order to keep leaks in the
+     * extractor libraries from accumulating.
+     *
+     * The process stores the extracted data in batches. A file is reported
+     * as indexed once its data has been extracted. Until the batch has been
+     * stored it is listed in pendingUrls(). Files whose data could not be
+     * stored are reported through storeFailed, files whose data was lost
+     * with the process through storeAborted.
+     *
+     * Deleting the worker lets the process store its last batch before it
+     * quits.
+     */
+    class IndexerWorker : public QObject
+    {
+        Q_OBJECT
+
+    public:
+        explicit IndexerWorker(QObject* parent = 0);
+        ~IndexerWorker();
+
+        enum Status {
+            Indexed,
+            Failed,
+            Crashed
+        };
+
+        /**
+         * Start \p program instead of nepomukindexer. It is passed the
+         * \p --worker argument. Used by the tests.
+         */
+        void setProgram(const QString& program);
+
+        bool isBusy() const;
+        QUrl currentUrl() const;
+
+        /**
+         * The files which have been indexed but whose data has not been
+         * stored yet.
+         */
+        QSet<QUrl> pendingUrls() const;
+
+        /**
+         * Hand \p url to the worker process. Only one file can be
+         * indexed at a time. Will result in the finished signal.
+         */
+        void indexFile(const QUrl& url);
+
+        /**
+         * Kill the worker process, for example because it got stuck.
+         * The finished signal is not emitted for the current file. The
+         * pending files are reported through storeAborted.
+         */
+        void kill();
+
+        /**
+         * Let the process store the pending files and quit once it has read
+         * all urls. Must not be called while a file is being indexed. The
+         * next file starts a new process.
+         */
+        void close();
+
+    Q_SIGNALS:
+        /**
+         * \param status One of Status
+         * \param message The error message of the indexer in case of failure
+         */
+        void finished(const QUrl& url, int status, const QString& message);
+
+        /**
+         * Emitted when the data of \p url could not be stored after the file
+         * has already been reported as indexed through finished.
+         */
+        void storeFailed(const QUrl& url, const QString& message);
+
+        /**
+         * Emitted when the process was killed or crashed after \p url had been
+         * reported as indexed but before its data was stored. The file needs
+         * to be indexed again.
+         */
+        void storeAborted(const QUrl& url);
+
+        /**
+         * Emitted after each batch with the number of files whose data was
+         * found in the extraction cache and the number of files it was
+         * looked up for since the previous batch.
+         */
+        void extractionCacheStatistics(int hits, int lookups);
+
+    private Q_SLOTS:
+        void slotReadyRead();
+        void slotProcessFinished(int exitCode, QProcess::ExitStatus exitStatus);
+        void slotProcessError(QProcess::ProcessError error);
+
+    private:
+        void startProcess();
+        void finishFile(int status, const QString& message);
+
+        /// reports the pending files through storeAborted
+        void abortPending();
+
+        QString m_program;
+        KProcess* m_process;
+        QUrl m_currentUrl;
+        QSet<QUrl> m_pendingUrls;
+        int m_fileCount;
+    };
+}
+
+#endif // FILEINDEXER_INDEXERWORKER_H
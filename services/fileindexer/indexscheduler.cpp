@@ -33,6 +33,7 @@
 #include <QtCore/QDirIterator>
 #include <QtCore/QDateTime>
 #include <QtCore/QByteArray>
+#include <QtCore/QStringList>
 #include <QtCore/QUrl>
 
 #include <KDebug>
@@ -96,6 +97,8 @@ Nepomuk2::IndexScheduler::IndexScheduler( QObject* parent )
     connect( m_fileIQ, SIGNAL(startedIndexing()), this, SLOT(emitStatusStringChanged()) );
     connect( m_fileIQ, SIGNAL(finishedIndexing()), this, SLOT(emitStatusStringChanged()) );
     connect( this, SIGNAL(indexingSuspended(bool)), this, SLOT(emitStatusStringChanged()) );
+    connect( m_fileIQ, SIGNAL(beginIndexingFile(QUrl)), this, SLOT(emitStatusStringChanged()) );
+    connect( m_fileIQ, SIGNAL(endIndexingFile(QUrl)), this, SLOT(emitStatusStringChanged()) );
 
     m_eventMonitor = new EventMonitor( this );
     connect( m_eventMonitor, SIGNAL(diskSpaceStatusChanged(bool)),
@@ -165,6 +168,16 @@ bool Nepomuk2::IndexScheduler::isIndexing() const
     return m_indexing;
 }
 
+int Nepomuk2::IndexScheduler::extractionCacheHits() const
+{
+    return m_fileIQ->extractionCacheHits();
+}
+
+int Nepomuk2::IndexScheduler::extractionCacheLookups() const
+{
+    return m_fileIQ->extractionCacheLookups();
+}
+
 QUrl Nepomuk2::IndexScheduler::currentUrl() const
 {
     if( !m_fileIQ->currentUrl().isEmpty() )
@@ -387,7 +400,10 @@ void Nepomuk2::IndexScheduler::slotScheduleIndexing()
         m_basicIQ->setDelay(0);
         m_basicIQ->resume();
 
-        m_fileIQ->suspend();
+        // a single indexer process does not drain the battery too much
+        m_fileIQ->setMaxJobs( 1 );
+        m_fileIQ->setDelay( 3000 );
+        m_fileIQ->resume();
         if( m_cleaner )
             m_cleaner->suspend();
     }
@@ -404,6 +420,7 @@ void Nepomuk2::IndexScheduler::slotScheduleIndexing()
             m_basicIQ->setDelay( 0 );
             m_basicIQ->resume();
 
+            m_fileIQ->setMaxJobs( FileIndexingQueue::defaultMaxJobs() );
             m_fileIQ->setDelay( 0 );
             m_fileIQ->resume();
         }
@@ -416,6 +433,7 @@ void Nepomuk2::IndexScheduler::slotScheduleIndexing()
         m_basicIQ->setDelay( 0 );
         m_basicIQ->resume();
 
+        m_fileIQ->setMaxJobs( FileIndexingQueue::defaultMaxJobs() );
         m_fileIQ->setDelay( 3000 );
         m_fileIQ->resume();
     }
@@ -435,6 +453,22 @@ QString Nepomuk2::IndexScheduler::userStatusString() const
         return i18nc( "@info:status", "Cleaning invalid file metadata");
     }
     else if ( indexing ) {
+        // the file each busy indexer is working on
+        const QList<QUrl> urls = m_fileIQ->currentUrls();
+        QStringList fileNames;
+        foreach( const QUrl& url, urls ) {
+            fileNames << KUrl( url ).fileName();
+        }
+
+        if ( fileNames.count() > 1 ) {
+            return i18nc( "@info:status %3 is a list of file names",
+                          "Indexing files for desktop search (%1 of %2 indexers busy): %3",
+                          fileNames.count(), m_fileIQ->maxJobs(),
+                          fileNames.join( i18nc( "@info:status separator of file names", ", " ) ) );
+        }
+        else if ( fileNames.count() == 1 ) {
+            return i18nc( "@info:status", "Indexing %1 for desktop search.", fileNames.first() );
+        }
         return i18nc( "@info:status", "Indexing files for desktop search." );
     }
     else if ( processing ) {
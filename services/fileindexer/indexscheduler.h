@@ -95,6 +95,12 @@ namespace Nepomuk2 {
          */
         UpdateDirFlags currentFlags() const;
 
+        /**
+         * \sa FileIndexingQueue::extractionCacheHits()
+         */
+        int extractionCacheHits() const;
+        int extractionCacheLookups() const;
+
     public Q_SLOTS:
         void suspend();
         void resume();
@@ -0,0 +1,113 @@
+/*
+    This file is part of the Nepomuk KDE project.
+    Copyright (C) 2013  Nepomuk Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "mimetyperesolver.h"
+
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QMutexLocker>
+
+#include <KMimeType>
+#include <KGlobal>
+#include <kde_file.h>
+
+namespace {
+    struct CacheKey {
+        quint64 device;
+        quint64 inode;
+        qint64 mtime;
+    };
+
+    bool operator==( const CacheKey& k1, const CacheKey& k2 ) {
+        return k1.inode == k2.inode && k1.device == k2.device && k1.mtime == k2.mtime;
+    }
+
+    uint qHash( const CacheKey& key ) {
+        return ::qHash( key.inode ) ^ ::qHash( key.mtime );
+    }
+
+    struct CacheEntry {
+        /// A rename does not change the mtime
+        QString path;
+        QString mimeType;
+    };
+
+    class MimeTypeCache {
+    public:
+        QMutex mutex;
+        QHash<CacheKey, CacheEntry> entries;
+    };
+
+    K_GLOBAL_STATIC( MimeTypeCache, s_cache )
+
+    const int s_maxCacheSize = 10000;
+}
+
+QString Nepomuk2::MimeTypeResolver::mimeTypeByName(const QString& path, bool isDir, bool* exact)
+{
+    if( isDir ) {
+        if( exact )
+            *exact = true;
+        return QLatin1String("inode/directory");
+    }
+
+    // In fast mode KMimeType only matches the name. The accuracy is 100
+    // if exactly one glob pattern matched.
+    int accuracy = 0;
+    KMimeType::Ptr mime = KMimeType::findByPath( path, 0, true, &accuracy );
+    if( exact )
+        *exact = ( accuracy == 100 && !mime->isDefault() );
+    return mime->name();
+}
+
+QString Nepomuk2::MimeTypeResolver::mimeType(const QString& path)
+{
+    KDE_struct_stat buf;
+    if( KDE::stat( path, &buf ) != 0 )
+        return KMimeType::findByPath( path )->name();
+
+    CacheKey key;
+    key.device = buf.st_dev;
+    key.inode = buf.st_ino;
+    key.mtime = buf.st_mtime;
+
+    MimeTypeCache* cache = s_cache;
+    {
+        QMutexLocker lock( &cache->mutex );
+        QHash<CacheKey, CacheEntry>::const_iterator it = cache->entries.constFind( key );
+        if( it != cache->entries.constEnd() && it->path == path )
+            return it->mimeType;
+    }
+
+    bool exact = false;
+    QString mimeType = mimeTypeByName( path, S_ISDIR( buf.st_mode ), &exact );
+    if( !exact )
+        mimeType = KMimeType::findByPath( path, buf.st_mode )->name();
+
+    QMutexLocker lock( &cache->mutex );
+    if( cache->entries.count() >= s_maxCacheSize )
+        cache->entries.clear();
+
+    CacheEntry entry;
+    entry.path = path;
+    entry.mimeType = mimeType;
+    cache->entries.insert( key, entry );
+
+    return mimeType;
+}
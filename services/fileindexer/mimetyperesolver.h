@@ -0,0 +1,51 @@
+/*
+    This file is part of the Nepomuk KDE project.
+    Copyright (C) 2013  Nepomuk Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef FILEINDEXER_MIMETYPERESOLVER_H
+#define FILEINDEXER_MIMETYPERESOLVER_H
+
+#include <QtCore/QString>
+
+namespace Nepomuk2 {
+
+    /**
+     * Mimetype detection for the file indexer.
+     *
+     * The basic indexing only looks at the file name, which is enough for most
+     * files and does not open them. If a name matches several mimetypes or none
+     * the best guess is stored. The content is checked once the file indexer
+     * reads the file anyway.
+     */
+    namespace MimeTypeResolver {
+        /**
+         * The mimetype of \p path going by the name only. The file is not accessed.
+         *
+         * \param exact Set to \p true if the name matches exactly one mimetype.
+         */
+        QString mimeTypeByName( const QString& path, bool isDir, bool* exact = 0 );
+
+        /**
+         * The mimetype of \p path. The content is only checked if the name is
+         * ambiguous. Results are cached by inode and mtime.
+         */
+        QString mimeType( const QString& path );
+    }
+}
+
+#endif // FILEINDEXER_MIMETYPERESOLVER_H
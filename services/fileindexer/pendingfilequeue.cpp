@@ -0,0 +1,221 @@
+/*
+    This file is part of the Nepomuk KDE project.
+    Copyright (C) 2013  Nepomuk Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "pendingfilequeue.h"
+#include "util.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QTimer>
+#include <QtCore/QDataStream>
+
+#include <KDebug>
+#include <KSaveFile>
+#include <KStandardDirs>
+
+namespace {
+    const quint32 s_magic = 0x4e504651; // "NPFQ"
+    const quint32 s_version = 1;
+
+    /// The queue changes with every indexed file. Writing it once a minute is enough.
+    const int s_saveDelay = 60*1000;
+}
+
+bool Nepomuk2::PendingFileQueue::Key::operator<(const Key& other) const
+{
+    if( priority != other.priority )
+        return priority < other.priority;
+    // the most recently modified file first
+    if( mtime != other.mtime )
+        return mtime > other.mtime;
+    return serial < other.serial;
+}
+
+
+Nepomuk2::PendingFileQueue::PendingFileQueue(const QString& path, QObject* parent)
+    : QObject( parent ),
+      m_serial( 0 ),
+      m_path( path )
+{
+    m_saveTimer = new QTimer( this );
+    m_saveTimer->setSingleShot( true );
+    m_saveTimer->setInterval( s_saveDelay );
+    connect( m_saveTimer, SIGNAL(timeout()), this, SLOT(save()) );
+
+    load();
+}
+
+Nepomuk2::PendingFileQueue::~PendingFileQueue()
+{
+    if( m_saveTimer->isActive() )
+        save();
+}
+
+bool Nepomuk2::PendingFileQueue::isEmpty() const
+{
+    return m_queue.isEmpty();
+}
+
+int Nepomuk2::PendingFileQueue::count() const
+{
+    return m_queue.count();
+}
+
+bool Nepomuk2::PendingFileQueue::contains(const QUrl& url) const
+{
+    return m_keys.contains( url );
+}
+
+void Nepomuk2::PendingFileQueue::enqueue(const QUrl& url, Priority priority, qint64 mtime)
+{
+    QHash<QUrl, Key>::iterator it = m_keys.find( url );
+    if( it != m_keys.end() ) {
+        m_queue.remove( it.value() );
+        m_keys.erase( it );
+    }
+
+    Key key;
+    key.priority = priority;
+    key.mtime = mtime;
+    key.serial = m_serial++;
+
+    m_queue.insert( key, url );
+    m_keys.insert( url, key );
+    scheduleSave();
+}
+
+QUrl Nepomuk2::PendingFileQueue::dequeue()
+{
+    QMap<Key, QUrl>::iterator it = m_queue.begin();
+    const QUrl url = it.value();
+    m_queue.erase( it );
+    m_keys.remove( url );
+
+    scheduleSave();
+    return url;
+}
+
+void Nepomuk2::PendingFileQueue::clear()
+{
+    m_queue.clear();
+    m_keys.clear();
+    scheduleSave();
+}
+
+void Nepomuk2::PendingFileQueue::clear(const QString& path)
+{
+    QMutableMapIterator<Key, QUrl> it( m_queue );
+    while( it.hasNext() ) {
+        it.next();
+        if( isInFolder( it.value().toLocalFile(), path ) ) {
+            m_keys.remove( it.value() );
+            it.remove();
+        }
+    }
+    scheduleSave();
+}
+
+void Nepomuk2::PendingFileQueue::retain(const QSet<QUrl>& urls)
+{
+    QMutableMapIterator<Key, QUrl> it( m_queue );
+    while( it.hasNext() ) {
+        it.next();
+        if( !urls.contains( it.value() ) ) {
+            m_keys.remove( it.value() );
+            it.remove();
+        }
+    }
+    scheduleSave();
+}
+
+void Nepomuk2::PendingFileQueue::scheduleSave()
+{
+    // do not postpone the save forever while files keep coming in
+    if( !m_saveTimer->isActive() )
+        m_saveTimer->start();
+}
+
+void Nepomuk2::PendingFileQueue::save()
+{
+    m_saveTimer->stop();
+
+    KSaveFile file( m_path );
+    if( !file.open() ) {
+        kDebug() << "Failed to save the file queue" << m_path << file.errorString();
+        return;
+    }
+
+    QDataStream stream( &file );
+    stream.setVersion( QDataStream::Qt_4_6 );
+    stream << s_magic << s_version << quint32( m_queue.count() );
+
+    // saved in order, the serials are reassigned when loading
+    QMap<Key, QUrl>::const_iterator end = m_queue.constEnd();
+    for( QMap<Key, QUrl>::const_iterator it = m_queue.constBegin(); it != end; ++it ) {
+        stream << it.value() << qint32( it.key().priority ) << it.key().mtime;
+    }
+
+    if( !file.finalize() )
+        kDebug() << "Failed to save the file queue" << m_path << file.errorString();
+}
+
+void Nepomuk2::PendingFileQueue::load()
+{
+    QFile file( m_path );
+    if( !file.open( QIODevice::ReadOnly ) )
+        return;
+
+    QDataStream stream( &file );
+    stream.setVersion( QDataStream::Qt_4_6 );
+
+    quint32 magic, version, count;
+    stream >> magic >> version >> count;
+    if( stream.status() != QDataStream::Ok || magic != s_magic || version != s_version ) {
+        kDebug() << "Ignoring invalid file queue" << m_path;
+        return;
+    }
+
+    for( quint32 i = 0; i < count; ++i ) {
+        QUrl url;
+        qint32 priority;
+        qint64 mtime;
+        stream >> url >> priority >> mtime;
+        if( stream.status() != QDataStream::Ok ) {
+            kDebug() << "File queue" << m_path << "is truncated";
+            break;
+        }
+
+        Key key;
+        key.priority = qBound( qint32(HighPriority), priority, qint32(LowPriority) );
+        key.mtime = mtime;
+        key.serial = m_serial++;
+
+        m_queue.insert( key, url );
+        m_keys.insert( url, key );
+    }
+
+    kDebug() << "Loaded" << m_queue.count() << "queued files";
+}
+
+// static
+QString Nepomuk2::PendingFileQueue::defaultPath()
+{
+    return KStandardDirs::locateLocal( "data", QLatin1String("nepomuk/file-indexer-queue") );
+}
+
+#include "pendingfilequeue.moc"
@@ -0,0 +1,112 @@
+/*
+    This file is part of the Nepomuk KDE project.
+    Copyright (C) 2013  Nepomuk Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef FILEINDEXER_PENDINGFILEQUEUE_H
+#define FILEINDEXER_PENDINGFILEQUEUE_H
+
+#include <QtCore/QObject>
+#include <QtCore/QUrl>
+#include <QtCore/QMap>
+#include <QtCore/QHash>
+#include <QtCore/QSet>
+
+class QTimer;
+
+namespace Nepomuk2 {
+
+    /**
+     * The files waiting to be content-indexed, ordered by priority and then
+     * by modification time with the most recent file first.
+     *
+     * The queue is saved to disk a little while after it changed and when
+     * it is destroyed, and it is loaded again on construction.
+     */
+    class PendingFileQueue : public QObject
+    {
+        Q_OBJECT
+
+    public:
+        explicit PendingFileQueue(const QString& path = defaultPath(), QObject* parent = 0);
+        ~PendingFileQueue();
+
+        enum Priority {
+            HighPriority = 0,
+            NormalPriority = 1,
+            LowPriority = 2
+        };
+
+        bool isEmpty() const;
+        int count() const;
+        bool contains(const QUrl& url) const;
+
+        /**
+         * Add \p url to the queue. If it is queued already it is moved
+         * to its new position.
+         *
+         * \param mtime The modification time in seconds since the epoch,
+         * 0 if unknown.
+         */
+        void enqueue(const QUrl& url, Priority priority, qint64 mtime);
+
+        /**
+         * Remove and return the file with the highest priority.
+         */
+        QUrl dequeue();
+
+        void clear();
+
+        /**
+         * Remove all files in \p path.
+         */
+        void clear(const QString& path);
+
+        /**
+         * Remove all files which are not in \p urls.
+         */
+        void retain(const QSet<QUrl>& urls);
+
+        static QString defaultPath();
+
+    public Q_SLOTS:
+        void save();
+
+    private:
+        void load();
+        void scheduleSave();
+
+        struct Key {
+            int priority;
+            qint64 mtime;
+            quint64 serial;
+
+            bool operator<(const Key& other) const;
+        };
+
+        QMap<Key, QUrl> m_queue;
+        QHash<QUrl, Key> m_keys;
+
+        /// keeps the order of files with the same priority and mtime stable
+        quint64 m_serial;
+
+        QString m_path;
+        QTimer* m_saveTimer;
+    };
+}
+
+#endif // FILEINDEXER_PENDINGFILEQUEUE_H
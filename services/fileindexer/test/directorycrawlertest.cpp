@@ -0,0 +1,222 @@
+/*
+    This file is part of the Nepomuk KDE project.
+    Copyright (C) 2013  Nepomuk Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "directorycrawlertest.h"
+#include "../directorycrawler.h"
+#include "../directoryjournal.h"
+#include "../fileindexerconfig.h"
+#include "fileindexerconfigutils.h"
+
+#include <KTempDir>
+#include <qtest_kde.h>
+
+#include <QtCore/QFile>
+#include <QtCore/QHash>
+#include <QtCore/QScopedPointer>
+
+#include <QtTest>
+
+using namespace Nepomuk2::Test;
+
+namespace {
+    void createFile(const QString& path) {
+        QFile file( path );
+        file.open( QIODevice::WriteOnly );
+        file.write( "data" );
+    }
+
+    QStringList childPaths(const Nepomuk2::DirectoryCrawler::Folder& folder) {
+        QStringList paths;
+        foreach( const Nepomuk2::DirectoryCrawler::Entry& entry, folder.children ) {
+            paths << entry.path;
+        }
+        return paths;
+    }
+}
+
+void DirectoryCrawlerTest::initTestCase()
+{
+    new Nepomuk2::FileIndexerConfig( this );
+}
+
+void DirectoryCrawlerTest::testCrawl()
+{
+    QScopedPointer<KTempDir> mainDir( createTmpFolders(QStringList()
+                                                       << indexedRootDir
+                                                       << indexedSubDir
+                                                       << indexedSubSubDir
+                                                       << excludedSubSubDir
+                                                       << hiddenSubSubDir) );
+    const QString dirPrefix = mainDir->name();
+
+    writeIndexerConfig(QStringList() << dirPrefix + indexedRootDir,
+                       QStringList() << dirPrefix + excludedSubSubDir,
+                       QStringList() << QLatin1String("*.o"),
+                       false);
+    Nepomuk2::FileIndexerConfig::self()->forceConfigUpdate();
+
+    createFile( dirPrefix + indexedRootDir + QLatin1String("/file.txt") );
+    createFile( dirPrefix + indexedRootDir + QLatin1String("/file.o") );
+    createFile( dirPrefix + excludedSubSubDir + QLatin1String("/file.txt") );
+
+    Nepomuk2::DirectoryCrawler crawler( 0 );
+    crawler.crawl( dirPrefix + indexedRootDir, Nepomuk2::UpdateRecursive );
+    if( !crawler.isIdle() )
+        QTest::kWaitForSignal( &crawler, SIGNAL(finished()), 5000 );
+
+    QHash<QString, QStringList> folders;
+    while( crawler.hasFolder() ) {
+        const Nepomuk2::DirectoryCrawler::Folder folder = crawler.takeFolder();
+        QCOMPARE( folder.flags, Nepomuk2::UpdateDirFlags(Nepomuk2::UpdateRecursive) );
+        folders.insert( folder.path, childPaths( folder ) );
+    }
+    QVERIFY( crawler.isIdle() );
+
+    // neither excluded nor hidden folders are entered
+    QCOMPARE( folders.count(), 3 );
+    QVERIFY( folders.contains( dirPrefix + indexedRootDir ) );
+    QVERIFY( folders.contains( dirPrefix + indexedSubDir ) );
+    QVERIFY( folders.contains( dirPrefix + indexedSubSubDir ) );
+
+    const QStringList rootChildren = folders.value( dirPrefix + indexedRootDir );
+    QVERIFY( rootChildren.contains( dirPrefix + indexedRootDir + QLatin1String("/file.txt") ) );
+    QVERIFY( !rootChildren.contains( dirPrefix + indexedRootDir + QLatin1String("/file.o") ) );
+    QVERIFY( rootChildren.contains( dirPrefix + indexedSubDir ) );
+
+    const QStringList subChildren = folders.value( dirPrefix + indexedSubDir );
+    QVERIFY( subChildren.contains( dirPrefix + indexedSubSubDir ) );
+    QVERIFY( !subChildren.contains( dirPrefix + hiddenSubSubDir ) );
+}
+
+void DirectoryCrawlerTest::testClear()
+{
+    QScopedPointer<KTempDir> mainDir( createTmpFolders(QStringList()
+                                                       << indexedRootDir
+                                                       << indexedSubDir
+                                                       << indexedSubSubDir) );
+    const QString dirPrefix = mainDir->name();
+
+    writeIndexerConfig(QStringList() << dirPrefix + indexedRootDir, QStringList(), QStringList(), false);
+    Nepomuk2::FileIndexerConfig::self()->forceConfigUpdate();
+
+    Nepomuk2::DirectoryCrawler crawler( 0 );
+    crawler.crawl( dirPrefix + indexedRootDir, Nepomuk2::UpdateRecursive );
+    crawler.clear();
+    if( !crawler.isIdle() )
+        QTest::kWaitForSignal( &crawler, SIGNAL(finished()), 5000 );
+
+    QVERIFY( !crawler.hasFolder() );
+    QVERIFY( crawler.isIdle() );
+}
+
+void DirectoryCrawlerTest::testClearPath()
+{
+    const QString siblingDir = indexedSubDir + QLatin1String("x");
+    QScopedPointer<KTempDir> mainDir( createTmpFolders(QStringList()
+                                                       << indexedRootDir
+                                                       << indexedSubDir
+                                                       << indexedSubSubDir
+                                                       << siblingDir) );
+    const QString dirPrefix = mainDir->name();
+
+    writeIndexerConfig(QStringList() << dirPrefix + indexedRootDir, QStringList(), QStringList(), false);
+    Nepomuk2::FileIndexerConfig::self()->forceConfigUpdate();
+
+    Nepomuk2::DirectoryCrawler crawler( 0 );
+    crawler.crawl( dirPrefix + indexedRootDir, Nepomuk2::UpdateRecursive );
+    if( !crawler.isIdle() )
+        QTest::kWaitForSignal( &crawler, SIGNAL(finished()), 5000 );
+
+    crawler.clear( dirPrefix + indexedSubDir );
+
+    QStringList folders;
+    while( crawler.hasFolder() ) {
+        folders << crawler.takeFolder().path;
+    }
+
+    // the folder sharing the prefix of the cleared one is kept
+    QCOMPARE( folders.count(), 2 );
+    QVERIFY( folders.contains( dirPrefix + indexedRootDir ) );
+    QVERIFY( folders.contains( dirPrefix + siblingDir ) );
+}
+
+void DirectoryCrawlerTest::testUnchangedAncestors()
+{
+    QScopedPointer<KTempDir> mainDir( createTmpFolders(QStringList()
+                                                       << indexedRootDir
+                                                       << indexedSubDir
+                                                       << indexedSubSubDir) );
+    const QString dirPrefix = mainDir->name();
+
+    writeIndexerConfig(QStringList() << dirPrefix + indexedRootDir, QStringList(), QStringList(), false);
+    Nepomuk2::FileIndexerConfig::self()->forceConfigUpdate();
+
+    createFile( dirPrefix + indexedRootDir + QLatin1String("/file.txt") );
+
+    Nepomuk2::DirectoryJournal journal( dirPrefix + QLatin1String("journal") );
+    journal.record( dirPrefix + indexedRootDir );
+    journal.record( dirPrefix + indexedSubDir );
+    journal.record( dirPrefix + indexedSubSubDir );
+    QVERIFY( journal.commit() );
+
+    // only changes the innermost folder
+    createFile( dirPrefix + indexedSubSubDir + QLatin1String("/new.txt") );
+    QVERIFY( journal.isUnchanged( dirPrefix + indexedRootDir ) );
+    QVERIFY( journal.isUnchanged( dirPrefix + indexedSubDir ) );
+    QVERIFY( !journal.isUnchanged( dirPrefix + indexedSubSubDir ) );
+
+    Nepomuk2::DirectoryCrawler crawler( &journal );
+    crawler.crawl( dirPrefix + indexedRootDir, Nepomuk2::UpdateRecursive | Nepomuk2::AutoUpdateFolder );
+    if( !crawler.isIdle() )
+        QTest::kWaitForSignal( &crawler, SIGNAL(finished()), 5000 );
+
+    QHash<QString, Nepomuk2::DirectoryCrawler::Folder> folders;
+    while( crawler.hasFolder() ) {
+        const Nepomuk2::DirectoryCrawler::Folder folder = crawler.takeFolder();
+        folders.insert( folder.path, folder );
+    }
+    QCOMPARE( folders.count(), 3 );
+
+    // the unchanged folders are not listed, but entered
+    QVERIFY( folders.value( dirPrefix + indexedRootDir ).unchanged );
+    QVERIFY( folders.value( dirPrefix + indexedRootDir ).children.isEmpty() );
+    QVERIFY( folders.value( dirPrefix + indexedSubDir ).unchanged );
+
+    const Nepomuk2::DirectoryCrawler::Folder subSub = folders.value( dirPrefix + indexedSubSubDir );
+    QVERIFY( !subSub.unchanged );
+    QVERIFY( subSub.hasState );
+    QVERIFY( childPaths( subSub ).contains( dirPrefix + indexedSubSubDir + QLatin1String("/new.txt") ) );
+
+    // a forced update lists everything
+    crawler.crawl( dirPrefix + indexedRootDir,
+                   Nepomuk2::UpdateRecursive | Nepomuk2::AutoUpdateFolder | Nepomuk2::ForceUpdate );
+    if( !crawler.isIdle() )
+        QTest::kWaitForSignal( &crawler, SIGNAL(finished()), 5000 );
+
+    while( crawler.hasFolder() ) {
+        const Nepomuk2::DirectoryCrawler::Folder folder = crawler.takeFolder();
+        QVERIFY( !folder.unchanged );
+        if( folder.path == dirPrefix + indexedRootDir )
+            QVERIFY( childPaths( folder ).contains( dirPrefix + indexedRootDir + QLatin1String("/file.txt") ) );
+    }
+}
+
+QTEST_KDEMAIN_CORE(DirectoryCrawlerTest)
+
+#include "directorycrawlertest.moc"
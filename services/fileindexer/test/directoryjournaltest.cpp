@@ -0,0 +1,179 @@
+/*
+    This file is part of the Nepomuk KDE project.
+    Copyright (C) 2013  Nepomuk Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "directoryjournaltest.h"
+#include "../directoryjournal.h"
+#include "../fileindexerconfig.h"
+#include "fileindexerconfigutils.h"
+
+#include <KTempDir>
+
+#include <QtCore/QDir>
+#include <QtCore/QScopedPointer>
+
+#include <QtTest>
+
+#include "qtest_kde.h"
+
+using namespace Nepomuk2::Test;
+
+void DirectoryJournalTest::initTestCase()
+{
+    // FileIndexerConfig::self() is used by the journal
+    new Nepomuk2::FileIndexerConfig( this );
+}
+
+namespace {
+    void setIndexerConfig(const QStringList& includeFolders, const QStringList& excludeFolders) {
+        writeIndexerConfig(includeFolders, excludeFolders, QStringList(), false);
+        Nepomuk2::FileIndexerConfig::self()->forceConfigUpdate();
+    }
+}
+
+void DirectoryJournalTest::testRecordAndCommit()
+{
+    QScopedPointer<KTempDir> mainDir( createTmpFolders(QStringList() << indexedRootDir << indexedSubDir) );
+    const QString dirPrefix = mainDir->name();
+    setIndexerConfig(QStringList() << dirPrefix + indexedRootDir, QStringList());
+
+    const QString journalPath = dirPrefix + QLatin1String("journal");
+    {
+        Nepomuk2::DirectoryJournal journal( journalPath );
+        QVERIFY(!journal.isUnchanged(dirPrefix + indexedRootDir));
+
+        journal.record(dirPrefix + indexedRootDir);
+        journal.record(dirPrefix + indexedSubDir);
+
+        // nothing is used before the commit
+        QVERIFY(!journal.isUnchanged(dirPrefix + indexedRootDir));
+
+        QVERIFY(journal.commit());
+        QVERIFY(journal.isUnchanged(dirPrefix + indexedRootDir));
+        QVERIFY(journal.isUnchanged(dirPrefix + indexedSubDir));
+    }
+
+    // a new subfolder changes the link count of its parent
+    QVERIFY(QDir(dirPrefix + indexedSubDir).mkdir(QLatin1String("new")));
+
+    // the parent is unchanged, the crawler still has to enter it to find the change
+    Nepomuk2::DirectoryJournal journal( journalPath );
+    QVERIFY(journal.isUnchanged(dirPrefix + indexedRootDir));
+    QVERIFY(!journal.isUnchanged(dirPrefix + indexedSubDir));
+    QVERIFY(!journal.isUnchanged(dirPrefix + indexedSubDir + QLatin1String("/new")));
+
+    journal.invalidate();
+    QVERIFY(!journal.isUnchanged(dirPrefix + indexedRootDir));
+    QVERIFY(!QFile::exists(journalPath));
+}
+
+void DirectoryJournalTest::testKeepSkippedSubtree()
+{
+    QScopedPointer<KTempDir> mainDir( createTmpFolders(QStringList()
+                                                       << indexedRootDir
+                                                       << indexedSubDir
+                                                       << indexedSubSubDir
+                                                       << excludedSubDir) );
+    const QString dirPrefix = mainDir->name();
+    setIndexerConfig(QStringList() << dirPrefix + indexedRootDir, QStringList());
+
+    Nepomuk2::DirectoryJournal journal( dirPrefix + QLatin1String("journal") );
+    journal.record(dirPrefix + indexedRootDir);
+    journal.record(dirPrefix + indexedSubDir);
+    journal.record(dirPrefix + indexedSubSubDir);
+    journal.record(dirPrefix + excludedSubDir);
+    QVERIFY(journal.commit());
+
+    // the second run walks the root folder and skips the unchanged subfolders
+    journal.record(dirPrefix + indexedRootDir);
+    journal.keep(dirPrefix + indexedSubDir);
+    QVERIFY(journal.commit());
+
+    QVERIFY(journal.isUnchanged(dirPrefix + indexedRootDir));
+    QVERIFY(journal.isUnchanged(dirPrefix + indexedSubDir));
+    QVERIFY(journal.isUnchanged(dirPrefix + indexedSubSubDir));
+
+    // neither walked nor skipped
+    QVERIFY(!journal.isUnchanged(dirPrefix + excludedSubDir));
+}
+
+void DirectoryJournalTest::testDiscardPending()
+{
+    QScopedPointer<KTempDir> mainDir( createTmpFolders(QStringList() << indexedRootDir) );
+    const QString dirPrefix = mainDir->name();
+    setIndexerConfig(QStringList() << dirPrefix + indexedRootDir, QStringList());
+
+    Nepomuk2::DirectoryJournal journal( dirPrefix + QLatin1String("journal") );
+    journal.record(dirPrefix + indexedRootDir);
+    journal.discardPending();
+    QVERIFY(journal.commit());
+    QVERIFY(!journal.isUnchanged(dirPrefix + indexedRootDir));
+}
+
+void DirectoryJournalTest::testConfigChange()
+{
+    QScopedPointer<KTempDir> mainDir( createTmpFolders(QStringList() << indexedRootDir << indexedSubDir) );
+    const QString dirPrefix = mainDir->name();
+    const QString journalPath = dirPrefix + QLatin1String("journal");
+
+    setIndexerConfig(QStringList() << dirPrefix + indexedRootDir, QStringList());
+    {
+        Nepomuk2::DirectoryJournal journal( journalPath );
+        journal.record(dirPrefix + indexedRootDir);
+        QVERIFY(journal.commit());
+    }
+
+    // excluding a folder needs a full scan
+    setIndexerConfig(QStringList() << dirPrefix + indexedRootDir,
+                     QStringList() << dirPrefix + indexedSubDir);
+    Nepomuk2::DirectoryJournal journal( journalPath );
+    QVERIFY(!journal.isUnchanged(dirPrefix + indexedRootDir));
+}
+
+void DirectoryJournalTest::testConfigChangeWhileOpen()
+{
+    QScopedPointer<KTempDir> mainDir( createTmpFolders(QStringList() << indexedRootDir << indexedSubDir) );
+    const QString dirPrefix = mainDir->name();
+
+    setIndexerConfig(QStringList() << dirPrefix + indexedRootDir, QStringList());
+    Nepomuk2::DirectoryJournal journal( dirPrefix + QLatin1String("journal") );
+    journal.record(dirPrefix + indexedRootDir);
+    journal.record(dirPrefix + indexedSubDir);
+    QVERIFY(journal.commit());
+    QVERIFY(journal.isUnchanged(dirPrefix + indexedRootDir));
+
+    setIndexerConfig(QStringList() << dirPrefix + indexedRootDir,
+                     QStringList() << dirPrefix + indexedSubDir);
+    journal.checkConfig();
+    QVERIFY(!journal.isUnchanged(dirPrefix + indexedRootDir));
+
+    // folders collected with the old configuration are not committed
+    journal.record(dirPrefix + indexedRootDir);
+    setIndexerConfig(QStringList() << dirPrefix + indexedRootDir, QStringList());
+    QVERIFY(!journal.commit());
+    QVERIFY(!journal.isUnchanged(dirPrefix + indexedRootDir));
+
+    // a scan with the current configuration is committed again
+    journal.record(dirPrefix + indexedRootDir);
+    QVERIFY(journal.commit());
+    QVERIFY(journal.isUnchanged(dirPrefix + indexedRootDir));
+}
+
+QTEST_KDEMAIN_CORE(DirectoryJournalTest)
+
+#include "directoryjournaltest.moc"
@@ -0,0 +1,176 @@
+/*
+    This file is part of the Nepomuk KDE project.
+    Copyright (C) 2013  Nepomuk Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "fileindexingqueuetest.h"
+#include "../fileindexingqueue.h"
+#include "../fileindexerconfig.h"
+
+#include <KTempDir>
+#include <qtest_kde.h>
+
+#include <QtCore/QFile>
+#include <QtTest>
+
+using namespace Nepomuk2;
+
+namespace {
+    /// Answers like "nepomukindexer --worker", but takes a while for each file
+    const char s_fakeIndexer[] =
+        "#!/bin/sh\n"
+        "while read url; do\n"
+        "    sleep 0.3\n"
+        "    echo \"indexed $url\"\n"
+        "done\n"
+        "echo flushed\n";
+
+    /// waits until \p counter has seen \p count files finish
+    bool waitForFinished(JobCounter& counter, Nepomuk2::FileIndexingQueue& queue, int count) {
+        for( int i = 0; i < 50 && counter.finished < count; ++i ) {
+            QTest::kWaitForSignal( &queue, SIGNAL(endIndexingFile(QUrl)), 200 );
+        }
+        return counter.finished == count;
+    }
+}
+
+JobCounter::JobCounter(FileIndexingQueue* queue)
+    : QObject( queue ),
+      running( 0 ),
+      maxRunning( 0 ),
+      started( 0 ),
+      finished( 0 )
+{
+    connect( queue, SIGNAL(beginIndexingFile(QUrl)), this, SLOT(slotBegin(QUrl)) );
+    connect( queue, SIGNAL(endIndexingFile(QUrl)), this, SLOT(slotEnd(QUrl)) );
+}
+
+void JobCounter::slotBegin(const QUrl&)
+{
+    ++started;
+    maxRunning = qMax( maxRunning, ++running );
+}
+
+void JobCounter::slotEnd(const QUrl&)
+{
+    ++finished;
+    --running;
+}
+
+void FileIndexingQueueTest::initTestCase()
+{
+    new Nepomuk2::FileIndexerConfig( this );
+
+    m_tempDir = new KTempDir();
+    m_program = m_tempDir->name() + QLatin1String("fakeindexer");
+
+    QFile file( m_program );
+    QVERIFY( file.open( QIODevice::WriteOnly ) );
+    file.write( s_fakeIndexer );
+    file.close();
+    QVERIFY( file.setPermissions( QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner ) );
+}
+
+void FileIndexingQueueTest::cleanupTestCase()
+{
+    delete m_tempDir;
+}
+
+QUrl FileIndexingQueueTest::createFile(const QString& name)
+{
+    const QString path = m_tempDir->name() + name;
+    QFile file( path );
+    file.open( QIODevice::WriteOnly );
+    file.write( "data" );
+    return QUrl::fromLocalFile( path );
+}
+
+void FileIndexingQueueTest::testParallelJobs()
+{
+    FileIndexingQueue queue;
+    queue.clear();
+    queue.setIndexerProgram( m_program );
+    queue.setMaxJobs( 2 );
+    QCOMPARE( queue.maxJobs(), 2 );
+    JobCounter counter( &queue );
+
+    queue.start();
+    for( int i = 0; i < 4; ++i ) {
+        queue.enqueue( createFile( QString::fromLatin1("parallel%1.txt").arg( i ) ) );
+    }
+
+    QVERIFY( waitForFinished( counter, queue, 4 ) );
+    QCOMPARE( counter.started, 4 );
+    QCOMPARE( counter.maxRunning, 2 );
+    QVERIFY( queue.currentUrls().isEmpty() );
+}
+
+void FileIndexingQueueTest::testNoJobs()
+{
+    FileIndexingQueue queue;
+    queue.clear();
+    queue.setIndexerProgram( m_program );
+    queue.setMaxJobs( 0 );
+    JobCounter counter( &queue );
+
+    // no file is handed out without a slot
+    queue.start();
+    queue.enqueue( createFile( QLatin1String("nojobs.txt") ) );
+    QTest::qWait( 500 );
+    QCOMPARE( counter.started, 0 );
+    QVERIFY( !queue.isEmpty() );
+
+    // a free slot starts the waiting file right away
+    queue.setMaxJobs( 1 );
+    QVERIFY( waitForFinished( counter, queue, 1 ) );
+    QCOMPARE( counter.started, 1 );
+    QVERIFY( queue.isEmpty() );
+}
+
+void FileIndexingQueueTest::testLowerMaxJobs()
+{
+    FileIndexingQueue queue;
+    queue.clear();
+    queue.setIndexerProgram( m_program );
+    queue.setMaxJobs( 3 );
+    JobCounter counter( &queue );
+
+    queue.start();
+    for( int i = 0; i < 3; ++i ) {
+        queue.enqueue( createFile( QString::fromLatin1("lower%1.txt").arg( i ) ) );
+    }
+    for( int i = 0; i < 10 && counter.started < 3; ++i ) {
+        QTest::kWaitForSignal( &queue, SIGNAL(beginIndexingFile(QUrl)), 200 );
+    }
+    QCOMPARE( counter.running, 3 );
+
+    // the running files are not interrupted
+    queue.setMaxJobs( 1 );
+    QCOMPARE( queue.maxJobs(), 1 );
+    QVERIFY( waitForFinished( counter, queue, 3 ) );
+
+    counter.maxRunning = 0;
+    for( int i = 0; i < 3; ++i ) {
+        queue.enqueue( createFile( QString::fromLatin1("lower%1.txt").arg( i + 3 ) ) );
+    }
+    QVERIFY( waitForFinished( counter, queue, 6 ) );
+    QCOMPARE( counter.maxRunning, 1 );
+}
+
+QTEST_KDEMAIN_CORE(FileIndexingQueueTest)
+
+#include "fileindexingqueuetest.moc"
@@ -0,0 +1,70 @@
+/*
+    This file is part of the Nepomuk KDE project.
+    Copyright (C) 2013  Nepomuk Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef FILEINDEXINGQUEUETEST_H
+#define FILEINDEXINGQUEUETEST_H
+
+#include <QObject>
+#include <QtCore/QUrl>
+
+class KTempDir;
+
+namespace Nepomuk2 {
+    class FileIndexingQueue;
+}
+
+/**
+ * Counts the files a FileIndexingQueue works on at the same time.
+ */
+class JobCounter : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit JobCounter(Nepomuk2::FileIndexingQueue* queue);
+
+    int running;
+    int maxRunning;
+    int started;
+    int finished;
+
+private slots:
+    void slotBegin(const QUrl& url);
+    void slotEnd(const QUrl& url);
+};
+
+class FileIndexingQueueTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void testParallelJobs();
+    void testNoJobs();
+    void testLowerMaxJobs();
+
+private:
+    QUrl createFile(const QString& name);
+
+    KTempDir* m_tempDir;
+    QString m_program;
+};
+
+#endif // FILEINDEXINGQUEUETEST_H
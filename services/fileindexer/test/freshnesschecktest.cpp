@@ -0,0 +1,87 @@
+/*
+    This file is part of the Nepomuk KDE project.
+    Copyright (C) 2013  Nepomuk Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "freshnesschecktest.h"
+#include "../freshnesscheck.h"
+
+#include <Soprano/Node>
+#include <qtest_kde.h>
+
+#include <QtTest>
+
+using namespace Nepomuk2;
+
+namespace {
+    QUrl fileUrl(int i) {
+        return QUrl::fromLocalFile( QString::fromLatin1("/home/user/file%1.txt").arg( i ) );
+    }
+}
+
+void FreshnessCheckTest::testQueries()
+{
+    QVERIFY( FreshnessCheck::queries( QList<QUrl>() ).isEmpty() );
+
+    QList<QUrl> urls;
+    for( int i = 0; i < 450; ++i ) {
+        urls << fileUrl( i );
+    }
+
+    // one query for the children of most folders, a few for large ones
+    const QStringList queries = FreshnessCheck::queries( urls );
+    QCOMPARE( queries.count(), 3 );
+
+    for( int i = 0; i < urls.count(); ++i ) {
+        const QString n3 = Soprano::Node::resourceToN3( urls[i] ) + QLatin1Char(',');
+        const QString lastN3 = Soprano::Node::resourceToN3( urls[i] ) + QLatin1Char(')');
+        int found = 0;
+        foreach( const QString& query, queries ) {
+            if( query.contains( n3 ) || query.contains( lastN3 ) )
+                ++found;
+        }
+        QCOMPARE( found, 1 );
+    }
+}
+
+void FreshnessCheckTest::testFreshness()
+{
+    const QDateTime mtime = QDateTime::fromTime_t( 1000000 );
+    const QDateTime later = QDateTime::fromTime_t( 2000000 );
+
+    QHash<QUrl, QDateTime> indexed;
+    indexed.insert( fileUrl( 1 ), mtime );
+    indexed.insert( fileUrl( 2 ), QDateTime() );
+
+    // new
+    QCOMPARE( FreshnessCheck::freshness( fileUrl( 0 ), false, mtime, indexed ), Modified );
+    QCOMPARE( FreshnessCheck::freshness( fileUrl( 0 ), true, mtime, indexed ), Modified );
+
+    QCOMPARE( FreshnessCheck::freshness( fileUrl( 1 ), false, mtime, indexed ), UpToDate );
+    QCOMPARE( FreshnessCheck::freshness( fileUrl( 1 ), false, later, indexed ), Modified );
+
+    // the mtime of folders does not matter
+    QCOMPARE( FreshnessCheck::freshness( fileUrl( 1 ), true, later, indexed ), UpToDate );
+    QCOMPARE( FreshnessCheck::freshness( fileUrl( 2 ), true, later, indexed ), UpToDate );
+
+    // a file indexed without a date is indexed again
+    QCOMPARE( FreshnessCheck::freshness( fileUrl( 2 ), false, mtime, indexed ), Modified );
+}
+
+QTEST_KDEMAIN_CORE(FreshnessCheckTest)
+
+#include "freshnesschecktest.moc"
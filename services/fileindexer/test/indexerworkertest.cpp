@@ -0,0 +1,224 @@
+/*
+    This file is part of the Nepomuk KDE project.
+    Copyright (C) 2013  Nepomuk Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "indexerworkertest.h"
+#include "../indexerworker.h"
+
+#include <KTempDir>
+#include <qtest_kde.h>
+
+#include <QtCore/QFile>
+#include <QtTest>
+
+using namespace Nepomuk2;
+
+namespace {
+    /// Answers like "nepomukindexer --worker", the url decides the outcome
+    const char s_fakeIndexer[] =
+        "#!/bin/sh\n"
+        "while read url; do\n"
+        "    case \"$url\" in\n"
+        "        *storefail*) echo \"indexed $url\"; echo \"storefailed $url disk full\"; echo flushed ;;\n"
+        "        *crash*) kill -9 $$ ;;\n"
+        "        *fail*) echo \"failed $url cannot read\" ;;\n"
+        "        *pid*) echo \"failed $url $$\" ;;\n"
+        "        *flush*) echo \"indexed $url\"; echo \"cachestats 1 2\"; echo flushed ;;\n"
+        "        *) echo \"some extractor output\"; echo \"indexed $url\" ;;\n"
+        "    esac\n"
+        "done\n"
+        "echo flushed\n";
+
+    QUrl fileUrl(const QString& name) {
+        return QUrl::fromLocalFile( QLatin1String("/home/user/") + name );
+    }
+
+    /// indexes \p url and waits for the result, \return the status
+    int indexFile(IndexerWorker& worker, const QUrl& url, QString* message = 0) {
+        QSignalSpy spy( &worker, SIGNAL(finished(QUrl, int, QString)) );
+        worker.indexFile( url );
+        if( spy.isEmpty() )
+            QTest::kWaitForSignal( &worker, SIGNAL(finished(QUrl, int, QString)), 5000 );
+        if( spy.count() != 1 || spy.first().at(0).toUrl() != url )
+            return -1;
+        if( message )
+            *message = spy.first().at(2).toString();
+        return spy.first().at(1).toInt();
+    }
+
+    /// the pid of the process used by \p worker, counts as one file
+    QString processId(IndexerWorker& worker) {
+        QString message;
+        indexFile( worker, fileUrl("pid"), &message );
+        return message;
+    }
+}
+
+void IndexerWorkerTest::initTestCase()
+{
+    m_tempDir = new KTempDir();
+    m_program = m_tempDir->name() + QLatin1String("fakeindexer");
+
+    QFile file( m_program );
+    QVERIFY( file.open( QIODevice::WriteOnly ) );
+    file.write( s_fakeIndexer );
+    file.close();
+    QVERIFY( file.setPermissions( QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner ) );
+}
+
+void IndexerWorkerTest::cleanupTestCase()
+{
+    delete m_tempDir;
+}
+
+void IndexerWorkerTest::testIndexed()
+{
+    IndexerWorker worker;
+    worker.setProgram( m_program );
+    QVERIFY( !worker.isBusy() );
+
+    QCOMPARE( indexFile( worker, fileUrl("a.txt") ), int(IndexerWorker::Indexed) );
+    QVERIFY( !worker.isBusy() );
+
+    // the same process is used for all files
+    QCOMPARE( indexFile( worker, fileUrl("b.txt") ), int(IndexerWorker::Indexed) );
+    QCOMPARE( worker.pendingUrls().count(), 2 );
+    QVERIFY( worker.pendingUrls().contains( fileUrl("a.txt") ) );
+
+    // stored with the next batch
+    QCOMPARE( indexFile( worker, fileUrl("flush.txt") ), int(IndexerWorker::Indexed) );
+    if( !worker.pendingUrls().isEmpty() )
+        QTest::qWait( 500 );
+    QVERIFY( worker.pendingUrls().isEmpty() );
+}
+
+void IndexerWorkerTest::testFailed()
+{
+    IndexerWorker worker;
+    worker.setProgram( m_program );
+
+    QString message;
+    QCOMPARE( indexFile( worker, fileUrl("fail.txt"), &message ), int(IndexerWorker::Failed) );
+    QCOMPARE( message, QString::fromLatin1("cannot read") );
+    QVERIFY( worker.pendingUrls().isEmpty() );
+
+    QCOMPARE( indexFile( worker, fileUrl("a.txt") ), int(IndexerWorker::Indexed) );
+}
+
+void IndexerWorkerTest::testStoreFailed()
+{
+    IndexerWorker worker;
+    worker.setProgram( m_program );
+    QSignalSpy spy( &worker, SIGNAL(storeFailed(QUrl, QString)) );
+
+    QCOMPARE( indexFile( worker, fileUrl("storefail.txt") ), int(IndexerWorker::Indexed) );
+    if( spy.isEmpty() )
+        QTest::kWaitForSignal( &worker, SIGNAL(storeFailed(QUrl, QString)), 5000 );
+
+    QCOMPARE( spy.count(), 1 );
+    QCOMPARE( spy.first().at(0).toUrl(), fileUrl("storefail.txt") );
+    QCOMPARE( spy.first().at(1).toString(), QString::fromLatin1("disk full") );
+    QVERIFY( worker.pendingUrls().isEmpty() );
+}
+
+void IndexerWorkerTest::testCrashWithPendingFiles()
+{
+    IndexerWorker worker;
+    worker.setProgram( m_program );
+    QSignalSpy spy( &worker, SIGNAL(storeAborted(QUrl)) );
+
+    QCOMPARE( indexFile( worker, fileUrl("a.txt") ), int(IndexerWorker::Indexed) );
+    QCOMPARE( indexFile( worker, fileUrl("crash.txt") ), int(IndexerWorker::Crashed) );
+
+    // the data of the file indexed before was never stored
+    QCOMPARE( spy.count(), 1 );
+    QCOMPARE( spy.first().at(0).toUrl(), fileUrl("a.txt") );
+    QVERIFY( worker.pendingUrls().isEmpty() );
+
+    // a new process is started
+    QCOMPARE( indexFile( worker, fileUrl("b.txt") ), int(IndexerWorker::Indexed) );
+}
+
+void IndexerWorkerTest::testKillWithPendingFiles()
+{
+    IndexerWorker worker;
+    worker.setProgram( m_program );
+    QSignalSpy spy( &worker, SIGNAL(storeAborted(QUrl)) );
+
+    QCOMPARE( indexFile( worker, fileUrl("a.txt") ), int(IndexerWorker::Indexed) );
+    QCOMPARE( indexFile( worker, fileUrl("b.txt") ), int(IndexerWorker::Indexed) );
+
+    worker.kill();
+    QVERIFY( !worker.isBusy() );
+    QVERIFY( worker.pendingUrls().isEmpty() );
+    QCOMPARE( spy.count(), 2 );
+}
+
+void IndexerWorkerTest::testRespawn()
+{
+    IndexerWorker worker;
+    worker.setProgram( m_program );
+
+    const QString pid = processId( worker );
+    QVERIFY( !pid.isEmpty() );
+    QCOMPARE( processId( worker ), pid );
+
+    QCOMPARE( indexFile( worker, fileUrl("crash.txt") ), int(IndexerWorker::Crashed) );
+    const QString newPid = processId( worker );
+    QVERIFY( !newPid.isEmpty() );
+    QVERIFY( newPid != pid );
+}
+
+void IndexerWorkerTest::testRecycle()
+{
+    IndexerWorker worker;
+    worker.setProgram( m_program );
+
+    // the process is replaced after 500 files, failed ones included
+    const QString pid = processId( worker );
+    for( int i = 0; i < 498; ++i ) {
+        QCOMPARE( indexFile( worker, fileUrl( QString::fromLatin1("file%1.txt").arg( i ) ) ), int(IndexerWorker::Indexed) );
+    }
+    QCOMPARE( processId( worker ), pid );
+
+    // the pending files of the old process are no longer reported
+    QVERIFY( worker.pendingUrls().isEmpty() );
+
+    const QString newPid = processId( worker );
+    QVERIFY( !newPid.isEmpty() );
+    QVERIFY( newPid != pid );
+}
+
+void IndexerWorkerTest::testExtractionCacheStatistics()
+{
+    IndexerWorker worker;
+    worker.setProgram( m_program );
+    QSignalSpy spy( &worker, SIGNAL(extractionCacheStatistics(int, int)) );
+
+    QCOMPARE( indexFile( worker, fileUrl("flush.txt") ), int(IndexerWorker::Indexed) );
+    if( spy.isEmpty() )
+        QTest::kWaitForSignal( &worker, SIGNAL(extractionCacheStatistics(int, int)), 5000 );
+
+    QCOMPARE( spy.count(), 1 );
+    QCOMPARE( spy.first().at(0).toInt(), 1 );
+    QCOMPARE( spy.first().at(1).toInt(), 2 );
+}
+
+QTEST_KDEMAIN_CORE(IndexerWorkerTest)
+
+#include "indexerworkertest.moc"
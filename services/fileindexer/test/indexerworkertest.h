@@ -0,0 +1,48 @@
+/*
+    This file is part of the Nepomuk KDE project.
+    Copyright (C) 2013  Nepomuk Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef INDEXERWORKERTEST_H
+#define INDEXERWORKERTEST_H
+
+#include <QObject>
+
+class KTempDir;
+
+class IndexerWorkerTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void testIndexed();
+    void testFailed();
+    void testStoreFailed();
+    void testCrashWithPendingFiles();
+    void testKillWithPendingFiles();
+    void testExtractionCacheStatistics();
+    void testRespawn();
+    void testRecycle();
+
+private:
+    KTempDir* m_tempDir;
+    QString m_program;
+};
+
+#endif // INDEXERWORKERTEST_H
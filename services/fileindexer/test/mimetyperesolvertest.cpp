@@ -0,0 +1,97 @@
+/*
+    This file is part of the Nepomuk KDE project.
+    Copyright (C) 2013  Nepomuk Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "mimetyperesolvertest.h"
+#include "../mimetyperesolver.h"
+
+#include <KTempDir>
+#include <qtest_kde.h>
+
+#include <QtCore/QFile>
+#include <QtTest>
+
+using namespace Nepomuk2;
+
+namespace {
+    void writeFile( const QString& path, const QByteArray& data ) {
+        QFile file( path );
+        QVERIFY( file.open( QIODevice::WriteOnly ) );
+        file.write( data );
+    }
+}
+
+void MimeTypeResolverTest::testMimeTypeByName()
+{
+    bool exact = false;
+    QCOMPARE( MimeTypeResolver::mimeTypeByName( QLatin1String("/home/user/image.png"), false, &exact ),
+              QString::fromLatin1("image/png") );
+    QVERIFY( exact );
+
+    // the name of a folder does not matter
+    exact = false;
+    QCOMPARE( MimeTypeResolver::mimeTypeByName( QLatin1String("/home/user/image.png"), true, &exact ),
+              QString::fromLatin1("inode/directory") );
+    QVERIFY( exact );
+
+    // no pattern matches, the content has to decide
+    exact = true;
+    QCOMPARE( MimeTypeResolver::mimeTypeByName( QLatin1String("/home/user/nepomukunknownfile"), false, &exact ),
+              QString::fromLatin1("application/octet-stream") );
+    QVERIFY( !exact );
+
+    // the file is never accessed
+    QCOMPARE( MimeTypeResolver::mimeTypeByName( QLatin1String("/nonexistent/folder/notes.txt"), false ),
+              QString::fromLatin1("text/plain") );
+}
+
+void MimeTypeResolverTest::testMimeType()
+{
+    KTempDir dir;
+    const QString script = dir.name() + QLatin1String("nepomukscript");
+    writeFile( script, "#!/bin/sh\necho hello\n" );
+
+    // the name says nothing, the content does
+    QCOMPARE( MimeTypeResolver::mimeType( script ), QString::fromLatin1("application/x-shellscript") );
+    QCOMPARE( MimeTypeResolver::mimeType( script ), QString::fromLatin1("application/x-shellscript") );
+
+    const QString notes = dir.name() + QLatin1String("notes.txt");
+    writeFile( notes, "#!/bin/sh\necho hello\n" );
+
+    // an exact name match does not look at the content
+    QCOMPARE( MimeTypeResolver::mimeType( notes ), QString::fromLatin1("text/plain") );
+
+    QCOMPARE( MimeTypeResolver::mimeType( dir.name() ), QString::fromLatin1("inode/directory") );
+}
+
+void MimeTypeResolverTest::testMimeTypeAfterRename()
+{
+    KTempDir dir;
+    const QString notes = dir.name() + QLatin1String("notes.txt");
+    writeFile( notes, "hello" );
+    QCOMPARE( MimeTypeResolver::mimeType( notes ), QString::fromLatin1("text/plain") );
+
+    // same inode and mtime, but the cached entry belongs to the old name
+    const QString page = dir.name() + QLatin1String("notes.html");
+    QVERIFY( QFile::rename( notes, page ) );
+    QCOMPARE( MimeTypeResolver::mimeType( page ), QString::fromLatin1("text/html") );
+}
+
+QTEST_KDEMAIN_CORE(MimeTypeResolverTest)
+
+#include "mimetyperesolvertest.moc"
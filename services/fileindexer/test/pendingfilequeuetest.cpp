@@ -0,0 +1,143 @@
+/*
+    This file is part of the Nepomuk KDE project.
+    Copyright (C) 2013  Nepomuk Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "pendingfilequeuetest.h"
+#include "../pendingfilequeue.h"
+
+#include <KTempDir>
+#include <qtest_kde.h>
+
+#include <QtTest>
+
+using namespace Nepomuk2;
+
+namespace {
+    QUrl fileUrl(const QString& name) {
+        return QUrl::fromLocalFile( QLatin1String("/home/user/") + name );
+    }
+}
+
+void PendingFileQueueTest::testOrder()
+{
+    KTempDir dir;
+    PendingFileQueue queue( dir.name() + QLatin1String("queue") );
+    QVERIFY( queue.isEmpty() );
+
+    queue.enqueue( fileUrl("old.txt"), PendingFileQueue::NormalPriority, 100 );
+    queue.enqueue( fileUrl("new.txt"), PendingFileQueue::NormalPriority, 300 );
+    queue.enqueue( fileUrl("large.avi"), PendingFileQueue::LowPriority, 500 );
+    queue.enqueue( fileUrl("doc.pdf"), PendingFileQueue::HighPriority, 50 );
+    queue.enqueue( fileUrl("unknown.txt"), PendingFileQueue::NormalPriority, 0 );
+    QCOMPARE( queue.count(), 5 );
+
+    QCOMPARE( queue.dequeue(), fileUrl("doc.pdf") );
+    QCOMPARE( queue.dequeue(), fileUrl("new.txt") );
+    QCOMPARE( queue.dequeue(), fileUrl("old.txt") );
+    QCOMPARE( queue.dequeue(), fileUrl("unknown.txt") );
+    QCOMPARE( queue.dequeue(), fileUrl("large.avi") );
+    QVERIFY( queue.isEmpty() );
+}
+
+void PendingFileQueueTest::testEnqueueTwice()
+{
+    KTempDir dir;
+    PendingFileQueue queue( dir.name() + QLatin1String("queue") );
+
+    queue.enqueue( fileUrl("a.txt"), PendingFileQueue::NormalPriority, 100 );
+    queue.enqueue( fileUrl("b.txt"), PendingFileQueue::NormalPriority, 200 );
+
+    // modified again
+    queue.enqueue( fileUrl("a.txt"), PendingFileQueue::NormalPriority, 300 );
+    QCOMPARE( queue.count(), 2 );
+
+    QCOMPARE( queue.dequeue(), fileUrl("a.txt") );
+    QCOMPARE( queue.dequeue(), fileUrl("b.txt") );
+    QVERIFY( !queue.contains( fileUrl("a.txt") ) );
+}
+
+void PendingFileQueueTest::testClearPath()
+{
+    KTempDir dir;
+    PendingFileQueue queue( dir.name() + QLatin1String("queue") );
+
+    queue.enqueue( fileUrl("docs/a.txt"), PendingFileQueue::NormalPriority, 100 );
+    queue.enqueue( fileUrl("docs/sub/b.txt"), PendingFileQueue::NormalPriority, 100 );
+    queue.enqueue( fileUrl("c.txt"), PendingFileQueue::NormalPriority, 100 );
+    queue.enqueue( fileUrl("docs2/d.txt"), PendingFileQueue::NormalPriority, 100 );
+
+    queue.clear( QLatin1String("/home/user/docs") );
+    QCOMPARE( queue.count(), 2 );
+    QVERIFY( queue.contains( fileUrl("c.txt") ) );
+
+    // a folder sharing the prefix is not inside the cleared one
+    QVERIFY( queue.contains( fileUrl("docs2/d.txt") ) );
+
+    queue.clear( QLatin1String("/home/user/docs2/") );
+    QCOMPARE( queue.count(), 1 );
+
+    queue.clear();
+    QVERIFY( queue.isEmpty() );
+}
+
+void PendingFileQueueTest::testRetain()
+{
+    KTempDir dir;
+    PendingFileQueue queue( dir.name() + QLatin1String("queue") );
+
+    queue.enqueue( fileUrl("a.txt"), PendingFileQueue::NormalPriority, 100 );
+    queue.enqueue( fileUrl("b.txt"), PendingFileQueue::NormalPriority, 100 );
+    queue.enqueue( fileUrl("c.txt"), PendingFileQueue::NormalPriority, 100 );
+
+    queue.retain( QSet<QUrl>() << fileUrl("b.txt") << fileUrl("d.txt") );
+    QCOMPARE( queue.count(), 1 );
+    QCOMPARE( queue.dequeue(), fileUrl("b.txt") );
+}
+
+void PendingFileQueueTest::testSaveAndLoad()
+{
+    KTempDir dir;
+    const QString path = dir.name() + QLatin1String("queue");
+
+    {
+        PendingFileQueue queue( path );
+        queue.enqueue( fileUrl("a.txt"), PendingFileQueue::NormalPriority, 100 );
+        queue.enqueue( fileUrl("b.pdf"), PendingFileQueue::HighPriority, 50 );
+        queue.enqueue( fileUrl("c.txt"), PendingFileQueue::NormalPriority, 200 );
+        // saved on destruction
+    }
+
+    PendingFileQueue queue( path );
+    QCOMPARE( queue.count(), 3 );
+    QCOMPARE( queue.dequeue(), fileUrl("b.pdf") );
+    QCOMPARE( queue.dequeue(), fileUrl("c.txt") );
+    QCOMPARE( queue.dequeue(), fileUrl("a.txt") );
+
+    // the order does not change when loaded again
+    queue.enqueue( fileUrl("d.txt"), PendingFileQueue::NormalPriority, 100 );
+    queue.enqueue( fileUrl("e.txt"), PendingFileQueue::NormalPriority, 100 );
+    queue.save();
+
+    PendingFileQueue loaded( path );
+    QCOMPARE( loaded.dequeue(), fileUrl("d.txt") );
+    QCOMPARE( loaded.dequeue(), fileUrl("e.txt") );
+}
+
+QTEST_KDEMAIN_CORE(PendingFileQueueTest)
+
+#include "pendingfilequeuetest.moc"
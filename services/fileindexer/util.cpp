@@ -24,6 +24,9 @@
 #include "kext.h"
 
 #include <QtCore/QUrl>
+#include <QtCore/QHash>
+#include <QtCore/QSet>
+#include <QtCore/QStringList>
 #include <QtCore/QFile>
 #include <QtCore/QFileInfo>
 #include <QtCore/QUuid>
@@ -103,3 +106,64 @@ void Nepomuk2::updateIndexingLevel(const QUrl& uri, int level)
         job->exec();
     }
 }
+
+void Nepomuk2::updateIndexingLevel(const QList<QUrl>& uris, int level)
+{
+    if( uris.isEmpty() )
+        return;
+    if( uris.count() == 1 ) {
+        updateIndexingLevel( uris.first(), level );
+        return;
+    }
+
+    QStringList urisN3;
+    foreach( const QUrl& uri, uris )
+        urisN3 << Soprano::Node::resourceToN3( uri );
+
+    QString query = QString::fromLatin1("select ?r ?g ?l where { graph ?g { ?r kext:indexingLevel ?l . } "
+                                        "FILTER(?r in (%1)) . }")
+                    .arg( urisN3.join(QLatin1String(",")) );
+    Soprano::Model* model = ResourceManager::instance()->mainModel();
+    Soprano::QueryResultIterator it = model->executeQuery( query, Soprano::Query::QueryLanguageSparqlNoInference );
+
+    // group the changes by graph, there typically are only very few of them
+    QHash<QUrl, QStringList> removeTriples;
+    QHash<QUrl, QStringList> insertTriples;
+    QSet<QUrl> found;
+    const QString levelN3 = Soprano::Node::literalToN3( level );
+    while( it.next() ) {
+        const QUrl uri = it[0].uri();
+        const QString uriN3 = Soprano::Node::resourceToN3( uri );
+        removeTriples[it[1].uri()] << QString::fromLatin1("%1 kext:indexingLevel %2 .").arg( uriN3, it[2].toN3() );
+        if( !found.contains( uri ) ) {
+            insertTriples[it[1].uri()] << QString::fromLatin1("%1 kext:indexingLevel %2 .").arg( uriN3, levelN3 );
+            found.insert( uri );
+        }
+    }
+
+    for( QHash<QUrl, QStringList>::const_iterator git = removeTriples.constBegin();
+         git != removeTriples.constEnd(); ++git ) {
+        QString removeCommand = QString::fromLatin1("sparql delete { graph %1 { %2 } }")
+                                .arg( Soprano::Node::resourceToN3( git.key() ), git.value().join(QLatin1String(" ")) );
+        model->executeQuery( removeCommand, Soprano::Query::QueryLanguageUser, QLatin1String("sql") );
+    }
+    for( QHash<QUrl, QStringList>::const_iterator git = insertTriples.constBegin();
+         git != insertTriples.constEnd(); ++git ) {
+        QString insertCommand = QString::fromLatin1("sparql insert { graph %1 { %2 } }")
+                                .arg( Soprano::Node::resourceToN3( git.key() ), git.value().join(QLatin1String(" ")) );
+        model->executeQuery( insertCommand, Soprano::Query::QueryLanguageUser, QLatin1String("sql") );
+    }
+
+    // Practically, this should never happen, but still
+    QList<QUrl> missing;
+    foreach( const QUrl& uri, uris ) {
+        if( !found.contains( uri ) )
+            missing << uri;
+    }
+    if( !missing.isEmpty() ) {
+        QScopedPointer<KJob> job( Nepomuk2::setProperty( missing, KExt::indexingLevel(),
+                                                         QVariantList() << QVariant(level) ) );
+        job->setAutoDelete(false);
+        job->exec();
+    }
+}
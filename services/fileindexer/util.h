@@ -30,6 +30,19 @@ namespace Nepomuk2 {
     KJob* clearIndexedData( const QList<QUrl>& urls );
     /// update kext::indexingLevel for \p url
     void updateIndexingLevel( const QUrl& uri, int level );
+    /// update kext::indexingLevel for all \p uris with a single query
+    void updateIndexingLevel( const QList<QUrl>& uris, int level );
+
+    /// \return \p true if \p path is \p folder or lies below it. An empty \p folder contains all paths.
+    inline bool isInFolder( const QString& path, const QString& folder ) {
+        if( !path.startsWith( folder ) )
+            return false;
+        // "/home/user/docs2" is not in "/home/user/docs"
+        return path.length() == folder.length()
+            || folder.isEmpty()
+            || folder.endsWith( QLatin1Char('/') )
+            || path[folder.length()] == QLatin1Char('/');
+    }
 
 }
 #endif
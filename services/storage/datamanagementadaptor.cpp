@@ -38,8 +38,12 @@
 #include <QtCore/QStringList>
 #include <QtCore/QVariant>
 #include <QtCore/QThreadPool>
+#include <QtCore/QFile>
+#include <QtCore/QDataStream>
 #include <QtDBus/QDBusMetaType>
 
+#include <KDebug>
+
 
 Nepomuk2::DataManagementAdaptor::DataManagementAdaptor(Nepomuk2::DataManagementModel *parent)
     : QObject(parent),
@@ -116,6 +120,17 @@ QHash< QString, QString > Nepomuk2::DataManagementAdaptor::storeResources(const
     return QHash<QString, QString>();
 }
 
+QHash< QString, QString > Nepomuk2::DataManagementAdaptor::storeResourcesFromFile(const QDBusUnixFileDescriptor& fd, int identificationMode, int flags, const Nepomuk2::PropertyHash& additionalMetadata, const QString& app)
+{
+    Q_ASSERT(calledFromDBus());
+    setDelayedReply(true);
+    // the graph is decoded on the thread pool
+    StoreResourcesCommand* command = new StoreResourcesCommand(fd, app, identificationMode, flags, additionalMetadata, m_model, message());
+    m_storeResourcesThreadPool->start(command);
+    // QtDBus will ignore this return value
+    return QHash<QString, QString>();
+}
+
 void Nepomuk2::DataManagementAdaptor::mergeResources(const QString &resource1, const QString &resource2, const QString &app)
 {
     Q_ASSERT(calledFromDBus());
@@ -227,6 +242,60 @@ QList<QUrl> Nepomuk2::DataManagementAdaptor::decodeUris(const QStringList &urlSt
     return urls;
 }
 
+// static
+bool Nepomuk2::DataManagementAdaptor::decodeResourceGraph(const QDBusUnixFileDescriptor& fd, Nepomuk2::SimpleResourceGraph& graph)
+{
+    if(!fd.isValid()) {
+        kDebug() << "Invalid file descriptor";
+        return false;
+    }
+
+    QFile file;
+    if(!file.open(fd.fileDescriptor(), QIODevice::ReadOnly)) {
+        kDebug() << "Failed to open file descriptor" << fd.fileDescriptor() << file.errorString();
+        return false;
+    }
+
+    // The file offset is shared with the client which leaves it at the end. Reading
+    // instead of mapping the file means that a file truncated by the client results
+    // in a stream error rather than a SIGBUS.
+    if(!file.seek(0)) {
+        kDebug() << "Failed to rewind file descriptor" << fd.fileDescriptor() << file.errorString();
+        return false;
+    }
+    const qint64 size = file.size();
+    if(size <= 0) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_4_6);
+
+    // This is QList<SimpleResource> serialization as used by operator<<(QDataStream&, SimpleResourceGraph).
+    // We decode it resource by resource to avoid building the intermediate list.
+    quint32 count = 0;
+    stream >> count;
+
+    SimpleResourceGraph result;
+    // do not trust the count blindly, a resource takes more than 16 bytes anyway
+    result.reserve(int(qMin<qint64>(count, size / 16)));
+    for(quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        SimpleResource res;
+        stream >> res;
+        if(stream.status() == QDataStream::Ok) {
+            result.insert(res);
+        }
+    }
+
+    if(stream.status() != QDataStream::Ok) {
+        kDebug() << "Truncated or invalid resource graph in file descriptor" << fd.fileDescriptor();
+        return false;
+    }
+
+    graph.swap(result);
+    return true;
+}
+
 void Nepomuk2::DataManagementAdaptor::setPrefixes(const QHash<QString, QString>& prefixes)
 {
     m_namespaces = prefixes;
@@ -253,6 +322,15 @@ QString Nepomuk2::DataManagementAdaptor::exportResources(const QStringList &reso
     return QString();
 }
 
+QList<Nepomuk2::SimpleResource> Nepomuk2::DataManagementAdaptor::complete(const QString &type, const QString &prefix, int limit)
+{
+    Q_ASSERT(calledFromDBus());
+    setDelayedReply(true);
+    enqueueCommand(new CompleteCommand(decodeUri(type), prefix, limit, m_model, message()));
+    // QtDBus will ignore this return value
+    return QList<SimpleResource>();
+}
+
 void Nepomuk2::DataManagementAdaptor::clearCache()
 {
     m_model->clearCache();
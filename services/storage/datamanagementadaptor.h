@@ -32,6 +32,7 @@
 #include <QtCore/QRegExp>
 #include <QtDBus/QDBusContext>
 #include <QtDBus/QDBusVariant>
+#include <QtDBus/QDBusUnixFileDescriptor>
 
 #include "simpleresource.h"
 
@@ -40,6 +41,7 @@ class QThreadPool;
 namespace Nepomuk2 {
 class DataManagementModel;
 class DataManagementCommand;
+class SimpleResourceGraph;
 
 /*
  * Adaptor class for interface org.kde.nepomuk.DataManagement
@@ -69,6 +71,15 @@ public:
      */
     QList<QUrl> decodeUris(const QStringList& s, bool namespaceAbbrExpansion = true) const;
 
+    /**
+     * Decodes the resource graph written to the file \p fd by StoreResourcesJob, ie. the
+     * QDataStream serialization of a SimpleResourceGraph. The file is read from the start and
+     * the resources are decoded one by one into \p graph.
+     *
+     * \return \p false if the file could not be read or does not contain a valid graph.
+     */
+    static bool decodeResourceGraph(const QDBusUnixFileDescriptor& fd, Nepomuk2::SimpleResourceGraph& graph);
+
 public Q_SLOTS:
     Q_SCRIPTABLE void setProperty(const QStringList &resources, const QString &property, const QVariantList &values, const QString &app);
     Q_SCRIPTABLE void addProperty(const QStringList &resources, const QString &property, const QVariantList &values, const QString &app);
@@ -78,12 +89,14 @@ public Q_SLOTS:
     Q_SCRIPTABLE void removeResources(const QStringList &resources, int flags, const QString &app);
     Q_SCRIPTABLE QList<Nepomuk2::SimpleResource> describeResources(const QStringList &resources, int flags, const QStringList& targetParties);
     Q_SCRIPTABLE QHash<QString, QString> storeResources(const QList<Nepomuk2::SimpleResource>& resources, int identificationMode, int flags, const Nepomuk2::PropertyHash &additionalMetadata, const QString &app);
+    Q_SCRIPTABLE QHash<QString, QString> storeResourcesFromFile(const QDBusUnixFileDescriptor& fd, int identificationMode, int flags, const Nepomuk2::PropertyHash &additionalMetadata, const QString &app);
     Q_SCRIPTABLE void mergeResources(const QString &resource1, const QString &resource2, const QString &app);
     Q_SCRIPTABLE void mergeResources(const QStringList &resources, const QString& app);
     Q_SCRIPTABLE void removeDataByApplication(int flags, const QString &app);
     Q_SCRIPTABLE void removeDataByApplication(const QStringList &resources, int flags, const QString &app);
     Q_SCRIPTABLE void importResources(const QString& url, const QString& serialization, int identificationMode, int flags, const Nepomuk2::PropertyHash &additionalMetadata, const QString& app);
     Q_SCRIPTABLE QString exportResources(const QStringList &resources, const QString& mimeType, int flags, const QStringList& targetParties);
+    Q_SCRIPTABLE QList<Nepomuk2::SimpleResource> complete(const QString &type, const QString &prefix, int limit);
 
     /// convinience overloads for scripts (no lists)
     Q_SCRIPTABLE void setProperty(const QString &resource, const QString &property, const QDBusVariant &value, const QString &app);
@@ -49,7 +49,8 @@ QDBusError::ErrorType convertSopranoErrorCode(int code)
 Nepomuk2::DataManagementCommand::DataManagementCommand(DataManagementModel* model, const QDBusMessage& msg)
     : QRunnable(),
       m_model(model),
-      m_msg(msg)
+      m_msg(msg),
+      m_errorType(QDBusError::NoError)
 {
 }
 
@@ -62,7 +63,10 @@ void Nepomuk2::DataManagementCommand::run()
     QVariant result = runCommand();
     Soprano::Error::Error error = model()->lastError();
     QDBusConnection con = KDBusConnectionPool::threadConnection();
-    if(error) {
+    if(m_errorType != QDBusError::NoError) {
+        con.send(m_msg.createErrorReply(m_errorType, m_errorMessage));
+    }
+    else if(error) {
         // send error reply
         con.send(m_msg.createErrorReply(convertSopranoErrorCode(error.code()), error.message()));
     }
@@ -91,6 +95,12 @@ void Nepomuk2::DataManagementCommand::run()
     loop.processEvents();
 }
 
+void Nepomuk2::DataManagementCommand::setError(QDBusError::ErrorType type, const QString& message)
+{
+    m_errorType = type;
+    m_errorMessage = message;
+}
+
 
 // static
 QUrl Nepomuk2::decodeUrl(const QString& urlsString)
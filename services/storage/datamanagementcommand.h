@@ -25,12 +25,15 @@
 #include <QRunnable>
 #include <QtCore/QVariant>
 #include <QtDBus/QDBusMessage>
+#include <QtDBus/QDBusError>
+#include <QtDBus/QDBusUnixFileDescriptor>
 
 #include "dbustypes.h"
 #include "simpleresource.h"
 #include "simpleresourcegraph.h"
 #include "datamanagement.h"
 #include "datamanagementmodel.h"
+#include "datamanagementadaptor.h"
 
 
 namespace Nepomuk2 {
@@ -58,9 +61,17 @@ protected:
      */
     virtual QVariant runCommand() = 0;
 
+    /**
+     * Report an error which does not come from the model. It is sent
+     * instead of the result of runCommand().
+     */
+    void setError(QDBusError::ErrorType type, const QString& message);
+
 private:
     DataManagementModel* m_model;
     QDBusMessage m_msg;
+    QDBusError::ErrorType m_errorType;
+    QString m_errorMessage;
 };
 
 class AddPropertyCommand : public DataManagementCommand
@@ -155,6 +166,26 @@ public:
                           const QDBusMessage& msg)
         : DataManagementCommand(model, msg),
           m_resources(resources),
+          m_fromFile(false),
+          m_app(app),
+          m_identificationMode(Nepomuk2::StoreIdentificationMode(identificationMode)),
+          m_flags(flags),
+          m_additionalMetadata(additionalMetadata) {}
+
+    /**
+     * Stores the graph written to \p fd by StoreResourcesJob. It is decoded by
+     * the command so that the D-Bus thread is not blocked reading large graphs.
+     */
+    StoreResourcesCommand(const QDBusUnixFileDescriptor& fd,
+                          const QString& app,
+                          int identificationMode,
+                          int flags,
+                          const QHash<QUrl, QVariant>& additionalMetadata,
+                          Nepomuk2::DataManagementModel* model,
+                          const QDBusMessage& msg)
+        : DataManagementCommand(model, msg),
+          m_fd(fd),
+          m_fromFile(true),
           m_app(app),
           m_identificationMode(Nepomuk2::StoreIdentificationMode(identificationMode)),
           m_flags(flags),
@@ -162,6 +193,16 @@ public:
 
 private:
     QVariant runCommand() {
+        if(m_fromFile) {
+            const bool decoded = DataManagementAdaptor::decodeResourceGraph(m_fd, m_resources);
+            // closes our copy of the descriptor
+            m_fd = QDBusUnixFileDescriptor();
+            if(!decoded) {
+                setError(QDBusError::InvalidArgs, QLatin1String("Failed to decode the resource graph from the file descriptor."));
+                return QVariant();
+            }
+        }
+
         QHash<QUrl,QUrl> uriMappings
             = model()->storeResources(m_resources, m_app, m_identificationMode, m_flags, m_additionalMetadata);
 
@@ -176,6 +217,8 @@ private:
     }
 
     SimpleResourceGraph m_resources;
+    QDBusUnixFileDescriptor m_fd;
+    bool m_fromFile;
     QString m_app;
     Nepomuk2::StoreIdentificationMode m_identificationMode;
     Nepomuk2::StoreResourcesFlags m_flags;
@@ -410,6 +453,29 @@ private:
     Nepomuk2::DescribeResourcesFlags m_flags;
     QList<QUrl> m_targetParties;
 };
+
+class CompleteCommand : public DataManagementCommand
+{
+public:
+    CompleteCommand(const QUrl& type,
+                    const QString& prefix,
+                    int limit,
+                    Nepomuk2::DataManagementModel* model,
+                    const QDBusMessage& msg)
+        : DataManagementCommand(model, msg),
+          m_type(type),
+          m_prefix(prefix),
+          m_limit(limit) {}
+
+private:
+    QVariant runCommand() {
+        return QVariant::fromValue(model()->complete(m_type, m_prefix, m_limit));
+    }
+
+    QUrl m_type;
+    QString m_prefix;
+    int m_limit;
+};
 }
 
 #endif
@@ -31,6 +31,7 @@
 #include "syncresource.h"
 #include "nepomuktools.h"
 #include "typecache.h"
+#include "labelcompletionindex.h"
 
 #include <Soprano/Vocabulary/NRL>
 #include <Soprano/Vocabulary/NAO>
@@ -59,6 +60,7 @@
 
 #include "nie.h"
 #include "nfo.h"
+#include "nco.h"
 #include "pimo.h"
 
 #include <KDebug>
@@ -205,6 +207,7 @@ public:
     QMutex m_graphCacheMutex;
 
     TypeCache* m_typeCache;
+    LabelCompletionIndex* m_labelIndex;
     QUrl m_nepomukGraph;
 };
 
@@ -217,6 +220,11 @@ Nepomuk2::DataManagementModel::DataManagementModel(Nepomuk2::ClassAndPropertyTre
     d->m_typeCache = new TypeCache(this);
     d->m_appCache.setMaxCost( 10 );
 
+    // the types for which we provide label completion
+    d->m_labelIndex = new LabelCompletionIndex(this);
+    d->m_labelIndex->addIndexedType(NAO::Tag(), QList<QUrl>() << NAO::prefLabel() << NAO::identifier());
+    d->m_labelIndex->addIndexedType(NCO::Contact(), QList<QUrl>() << NCO::fullname() << NCO::nickname() << NAO::prefLabel());
+
     setParent(parent);
 
     // meta data properties are protected. This means they cannot be removed. But they
@@ -255,6 +263,7 @@ void Nepomuk2::DataManagementModel::clearCache()
     lock.unlock();
 
     d->m_typeCache->clear();
+    d->m_labelIndex->clear();
     d->m_nepomukGraph = fetchGraph(QLatin1String("nepomuk"));
 
     // Specially add <nepomuk:/me> cause the clients cannot
@@ -268,6 +277,7 @@ void Nepomuk2::DataManagementModel::clearCache()
 Nepomuk2::DataManagementModel::~DataManagementModel()
 {
     delete d->m_typeCache;
+    delete d->m_labelIndex;
     delete d;
 }
 
@@ -603,6 +613,7 @@ void Nepomuk2::DataManagementModel::setProperty(const QList<QUrl> &resources, co
                                                   property,
                                                   added,
                                                   removed);
+                d->m_labelIndex->changeProperty(res, property, added, removed);
             }
         }
         if(!resolvedUris.isEmpty()) {
@@ -695,6 +706,7 @@ void Nepomuk2::DataManagementModel::removeProperty(const QList<QUrl> &resources,
 
         if(!removedValues.isEmpty()) {
             d->m_watchManager->changeProperty( res, property, QList<Soprano::Node>(), removedValues );
+            d->m_labelIndex->changeProperty( res, property, QList<Soprano::Node>(), removedValues );
         }
 
         // we only update the mtime in case we actually remove anything
@@ -795,6 +807,7 @@ void Nepomuk2::DataManagementModel::removeProperties(const QList<QUrl> &resource
             }
 
             d->m_watchManager->changeProperty(res, property, QList<Soprano::Node>(), values);
+            d->m_labelIndex->changeProperty(res, property, QList<Soprano::Node>(), values);
         }
 
         // we only update the mtime in case we actually remove anything
@@ -901,6 +914,13 @@ QUrl Nepomuk2::DataManagementModel::createResource(const QList<QUrl> &types, con
     d->m_watchManager->createResource(resUri, allTypes);
     d->m_watchManager->changeSomething();
 
+    d->m_labelIndex->createResource(resUri, allTypes);
+    if(!label.isEmpty()) {
+        d->m_labelIndex->changeProperty(resUri, NAO::prefLabel(),
+                                        QList<Soprano::Node>() << Soprano::LiteralValue::createPlainLiteral(label),
+                                        QList<Soprano::Node>());
+    }
+
     return resUri;
 }
 
@@ -1137,6 +1157,9 @@ void Nepomuk2::DataManagementModel::removeDataByApplication(const QList<QUrl> &r
                                       urlSetToN3(resolvedResources).join(",") );
         executeQuery( deleteCommand, Soprano::Query::QueryLanguageUser, QLatin1String("sql") );
     }
+
+    // The removed statements are not reported one by one
+    d->m_labelIndex->updateResources( finalResourcesList.toSet() );
 }
 
 
@@ -1209,6 +1232,10 @@ void Nepomuk2::DataManagementModel::removeDataByApplication(RemovalFlags flags,
 
         executeQuery( query, Soprano::Query::QueryLanguageSparqlNoInference );
     }
+
+    // All data of the application is gone, reload the labels on the next completion
+    if( !graphs.isEmpty() )
+        d->m_labelIndex->clear();
 }
 
 
@@ -1320,12 +1347,15 @@ QHash<QUrl, QUrl> DataManagementModel::storeResources(const SimpleResourceGraph&
     //
     // Resolve the nie URLs which are present as resource uris
     //
+    // Each resource is converted exactly once into a Sync::SyncResource. This first
+    // pass only creates them with their final URI and the properties the resolution
+    // adds. All subjects need to be known before the property values can be resolved.
+    //
     QSet<QUrl> blankResources;
-    SimpleResourceGraph resGraph( resources );
-    QList<SimpleResource> resGraphList = resGraph.toList();
-    QMutableListIterator<SimpleResource> iter( resGraphList );
-    while( iter.hasNext() ) {
-        SimpleResource & res = iter.next();
+    QList<Sync::SyncResource> subjectResources;
+    subjectResources.reserve( resources.count() );
+    for( SimpleResourceGraph::const_iterator rit = resources.constBegin(); rit != resources.constEnd(); ++rit ) {
+        const SimpleResource& res = rit.value();
 
         if( !res.isValid() ) {
             QString error = QString::fromLatin1("The resource with URI %1 is invalid.")
@@ -1334,9 +1364,11 @@ QHash<QUrl, QUrl> DataManagementModel::storeResources(const SimpleResourceGraph&
             return QHash<QUrl, QUrl>();
         }
 
+        Sync::SyncResource syncRes( res.uri() );
+
         const UriState state = uriState(res.uri());
         if(state == NepomukUri) {
-            continue;
+            // nothing to resolve
         }
         else if(state == BlankUri) {
             blankResources << res.uri();
@@ -1357,17 +1389,17 @@ QHash<QUrl, QUrl> DataManagementModel::storeResources(const SimpleResourceGraph&
                 newResUri = SimpleResource().uri(); // HACK: improveme
 
                 if( state == ExistingFileUrl ) {
-                    res.addProperty( RDF::type(), NFO::FileDataObject() );
+                    syncRes.insert( RDF::type(), NFO::FileDataObject() );
                     if( QFileInfo( nieUrl.toLocalFile() ).isDir() )
-                        res.addProperty( RDF::type(), NFO::Folder() );
+                        syncRes.insert( RDF::type(), NFO::Folder() );
                 }
             }
 
-            res.addProperty( NIE::url(), nieUrl );
+            syncRes.insert( NIE::url(), nieUrl );
 
             resolvedNodes.insert( nieUrl, newResUri );
 
-            res.setUri( newResUri );
+            syncRes.setUri( newResUri );
         }
         else if( state == OtherUri ) {
             // Legacy support - Sucks but we need it
@@ -1379,23 +1411,24 @@ QHash<QUrl, QUrl> DataManagementModel::storeResources(const SimpleResourceGraph&
             setError(QLatin1String("It is not allowed to add classes or properties through this API."), Soprano::Error::ErrorInvalidArgument);
             return QHash<QUrl, QUrl>();
         }
+
+        subjectResources << syncRes;
     }
-    resGraph = resGraphList;
 
     ResourceIdentifier resIdent( identificationMode, this );
     QList<Sync::SyncResource> syncResources;
+    syncResources.reserve( subjectResources.count() );
 
     //
     // Resolve URLs in property values and prepare the resource identifier
     //
-    foreach( const SimpleResource& res, resGraph.toList() ) {
+    int subjectIndex = 0;
+    for( SimpleResourceGraph::const_iterator rit = resources.constBegin(); rit != resources.constEnd(); ++rit, ++subjectIndex ) {
         // Convert to a Sync::SyncResource
         //
-        Sync::SyncResource syncRes( res.uri() );
-        QHashIterator<QUrl, QVariant> hit( res.properties() );
-        while( hit.hasNext() ) {
-            hit.next();
-
+        Sync::SyncResource& syncRes = subjectResources[subjectIndex];
+        const PropertyHash properties = rit.value().properties();
+        for( PropertyHash::const_iterator hit = properties.constBegin(); hit != properties.constEnd(); ++hit ) {
             Soprano::Node n = d->m_classAndPropertyTree->variantToNode( hit.value(), hit.key() );
             // The ClassAndPropertyTree returns blank nodes as URIs. It does not understand the
             // concept of blank nodes, and since only storeResources requires blank nodes,
@@ -1408,7 +1441,10 @@ QHash<QUrl, QUrl> DataManagementModel::storeResources(const SimpleResourceGraph&
                 setError( error );
                 return QHash<QUrl, QUrl>();
             }
-            syncRes.insert( hit.key(), n );
+
+            // The resolution above might already have added the value
+            if( !syncRes.contains( hit.key(), n ) )
+                syncRes.insert( hit.key(), n );
         }
 
         // Temporarily remove the nie:url, we will add it back later
@@ -1669,6 +1705,8 @@ void Nepomuk2::DataManagementModel::mergeResources(const QList<QUrl>& resources,
             addStatement(resUri, prop, v, binding["g"]);
             d->m_watchManager->changeProperty( resUri, prop, QList<Soprano::Node>() << v,
                                                QList<Soprano::Node>() );
+            d->m_labelIndex->changeProperty( resUri, prop, QList<Soprano::Node>() << v,
+                                             QList<Soprano::Node>() );
         }
     }
 
@@ -2207,6 +2245,7 @@ QHash< QUrl, QList< Soprano::Node > > DataManagementModel::addProperty(const QLi
     if(signalPropertyChanged) {
         for(QHash<QUrl, QList<Soprano::Node> >::const_iterator it = finalValuesPerResource.constBegin(); it != finalValuesPerResource.constEnd(); ++it) {
             d->m_watchManager->changeProperty(it.key(), property, it.value(), QList<Soprano::Node>());
+            d->m_labelIndex->changeProperty(it.key(), property, it.value(), QList<Soprano::Node>());
         }
         if(!finalValuesPerResource.isEmpty()) {
             d->m_watchManager->changeSomething();
@@ -2605,6 +2644,28 @@ TypeCache* DataManagementModel::typeCache()
     return d->m_typeCache;
 }
 
+LabelCompletionIndex* DataManagementModel::labelCompletionIndex()
+{
+    return d->m_labelIndex;
+}
+
+QList<SimpleResource> DataManagementModel::complete(const QUrl& type, const QString& prefix, int limit)
+{
+    if(type.isEmpty()) {
+        setError(QLatin1String("complete: No type specified."), Soprano::Error::ErrorInvalidArgument);
+        return QList<SimpleResource>();
+    }
+    if(!d->m_labelIndex->isIndexedType(type)) {
+        setError(QString::fromLatin1("complete: Labels of type %1 are not indexed.").arg(type.toString()),
+                 Soprano::Error::ErrorInvalidArgument);
+        return QList<SimpleResource>();
+    }
+
+    clearError();
+
+    return d->m_labelIndex->complete(type, prefix, limit);
+}
+
 QUrl DataManagementModel::nepomukGraph()
 {
     return d->m_nepomukGraph;
@@ -2679,6 +2740,7 @@ void Nepomuk2::DataManagementModel::removeAllResources(const QSet< QUrl >& resou
     foreach(const Soprano::Node& res, actuallyRemovedResources) {
         // The WatcherManaager fill automatically fetch the types
         d->m_watchManager->removeResource(res.uri(), QList<QUrl>());
+        d->m_labelIndex->removeResource(res.uri());
 
         removeAllStatements(res, Soprano::Node(), Soprano::Node());
         removeAllStatements(Soprano::Node(), Soprano::Node(), res);
@@ -2689,6 +2751,9 @@ void Nepomuk2::DataManagementModel::removeAllResources(const QSet< QUrl >& resou
         d->m_watchManager->changeProperty( st.subject().uri(), st.predicate().uri(),
                                            QList<Soprano::Node>(),
                                            QList<Soprano::Node>() << st.object() );
+        d->m_labelIndex->changeProperty( st.subject().uri(), st.predicate().uri(),
+                                         QList<Soprano::Node>(),
+                                         QList<Soprano::Node>() << st.object() );
     }
 
     if(!actuallyRemovedResources.isEmpty()) {
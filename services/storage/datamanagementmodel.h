@@ -35,6 +35,8 @@ class ResourceMerger;
 class SimpleResourceGraph;
 class ResourceWatcherManager;
 class TypeCache;
+class LabelCompletionIndex;
+class SimpleResource;
 
 class DataManagementModel : public Soprano::FilterModel
 {
@@ -246,6 +248,24 @@ public Q_SLOTS:
                             const QList<QUrl>& targetParties = QList<QUrl>() );
     //@}
 
+    /**
+     * Complete the labels of resources of type \p type.
+     *
+     * Only the labels of a few types like nao:Tag and nco:Contact are indexed.
+     * Completion is done on an in-memory index which is maintained by the methods
+     * above. Thus, no query is run unless it is the first completion for \p type.
+     *
+     * \param type The type of the resources to complete, eg. nao:Tag.
+     * \param prefix The beginning of the label or of one of its words. The comparison
+     * is not case sensitive.
+     * \param limit The maximum number of resources to return. A value smaller than 1
+     * means no limit.
+     *
+     * \return The matching resources. Each resource only contains its type and the
+     * matched label.
+     */
+    QList<SimpleResource> complete(const QUrl& type, const QString& prefix, int limit);
+
     /**
      * Clear the internal cache present in the model
      */
@@ -253,6 +273,9 @@ public Q_SLOTS:
 
     TypeCache* typeCache();
 
+    /// used by the ResourceMerger to keep the label index up to date
+    LabelCompletionIndex* labelCompletionIndex();
+
     QUrl nepomukGraph();
 private:
     QUrl createNepomukGraph();
@@ -0,0 +1,442 @@
+/*
+    This file is part of the Nepomuk KDE project.
+    Copyright (C) 2013  Nepomuk Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include "labelcompletionindex.h"
+#include "classandpropertytree.h"
+#include "simpleresource.h"
+
+#include <QtCore/QMutexLocker>
+#include <QtCore/QPair>
+#include <QtCore/QStringList>
+#include <QtCore/QtAlgorithms>
+
+#include <Soprano/Model>
+#include <Soprano/QueryResultIterator>
+#include <Soprano/Vocabulary/RDF>
+
+#include <KDebug>
+
+using namespace Nepomuk2;
+using namespace Soprano::Vocabulary;
+
+namespace {
+    QString resourcesToN3( const QList<QUrl>& resources ) {
+        QStringList n3;
+        foreach( const QUrl& res, resources )
+            n3 << Soprano::Node::resourceToN3( res );
+        return n3.join( QLatin1String(",") );
+    }
+}
+
+bool LabelCompletionIndex::Entry::operator<(const LabelCompletionIndex::Entry& other) const
+{
+    if( key != other.key )
+        return key < other.key;
+    return resource < other.resource;
+}
+
+bool LabelCompletionIndex::Entry::operator==(const LabelCompletionIndex::Entry& other) const
+{
+    return key == other.key && resource == other.resource &&
+           property == other.property && label == other.label;
+}
+
+LabelCompletionIndex::LabelCompletionIndex(Soprano::Model* model)
+    : m_model( model )
+{
+}
+
+LabelCompletionIndex::~LabelCompletionIndex()
+{
+}
+
+void LabelCompletionIndex::addIndexedType(const QUrl& type, const QList<QUrl>& labelProperties)
+{
+    QMutexLocker lock( &m_mutex );
+    TypeIndex& index = m_types[type];
+    index.labelProperties = labelProperties;
+    index.entries.clear();
+    index.members.clear();
+    index.loaded = false;
+}
+
+bool LabelCompletionIndex::isIndexedType(const QUrl& type) const
+{
+    QMutexLocker lock( &m_mutex );
+    return m_types.contains( type );
+}
+
+// static
+QStringList LabelCompletionIndex::keys(const QString& label)
+{
+    // The full label and the start of each word
+    const QStringList words = label.toCaseFolded().simplified().split( QLatin1Char(' '), QString::SkipEmptyParts );
+
+    QStringList keys;
+    for( int i = 0; i < words.count(); ++i ) {
+        keys << QStringList( words.mid( i ) ).join( QLatin1String(" ") );
+    }
+    return keys;
+}
+
+void LabelCompletionIndex::insertLabel(LabelCompletionIndex::TypeIndex& index, const QUrl& res,
+                                       const QUrl& property, const QString& label)
+{
+    foreach( const QString& key, keys( label ) ) {
+        Entry entry;
+        entry.key = key;
+        entry.label = label;
+        entry.property = property;
+        entry.resource = res;
+
+        // Inserting into the sorted array costs one memmove which is cheap compared
+        // to the query it saves. Duplicates are ignored since the same change can be
+        // reported more than once.
+        QVector<Entry>::iterator it = qLowerBound( index.entries.begin(), index.entries.end(), entry );
+        bool duplicate = false;
+        for( QVector<Entry>::iterator dit = it; dit != index.entries.end() && dit->key == key && dit->resource == res; ++dit ) {
+            if( *dit == entry ) {
+                duplicate = true;
+                break;
+            }
+        }
+        if( !duplicate )
+            index.entries.insert( it, entry );
+    }
+}
+
+void LabelCompletionIndex::removeLabel(LabelCompletionIndex::TypeIndex& index, const QUrl& res,
+                                       const QUrl& property, const QString& label)
+{
+    foreach( const QString& key, keys( label ) ) {
+        Entry entry;
+        entry.key = key;
+        entry.resource = res;
+
+        QVector<Entry>::iterator it = qLowerBound( index.entries.begin(), index.entries.end(), entry );
+        while( it != index.entries.end() && it->key == key && it->resource == res ) {
+            if( it->property == property && it->label == label )
+                it = index.entries.erase( it );
+            else
+                ++it;
+        }
+    }
+}
+
+void LabelCompletionIndex::removeMember(LabelCompletionIndex::TypeIndex& index, const QUrl& res)
+{
+    removeMembers( index, QSet<QUrl>() << res );
+}
+
+void LabelCompletionIndex::removeMembers(LabelCompletionIndex::TypeIndex& index, const QSet<QUrl>& resources)
+{
+    bool removed = false;
+    foreach( const QUrl& res, resources ) {
+        if( index.members.remove( res ) )
+            removed = true;
+    }
+    if( !removed )
+        return;
+
+    QVector<Entry>::iterator it = index.entries.begin();
+    while( it != index.entries.end() ) {
+        if( resources.contains( it->resource ) )
+            it = index.entries.erase( it );
+        else
+            ++it;
+    }
+}
+
+void LabelCompletionIndex::load(const QUrl& type, LabelCompletionIndex::TypeIndex& index)
+{
+    index.entries.clear();
+    index.members.clear();
+
+    // The optional pattern makes sure we also know about the resources without a label
+    // which might get one later on.
+    const QString query = QString::fromLatin1("select distinct ?r ?p ?l where { ?r a %1 . "
+                                              "OPTIONAL { ?r ?p ?l . FILTER(?p in (%2)) . } }")
+                          .arg( Soprano::Node::resourceToN3( type ),
+                                resourcesToN3( index.labelProperties ) );
+
+    QVector<Entry> entries;
+    Soprano::QueryResultIterator it = m_model->executeQuery( query, Soprano::Query::QueryLanguageSparql );
+    while( it.next() ) {
+        const QUrl res = it[0].uri();
+        index.members.insert( res );
+
+        const QString label = it[2].toString();
+        if( label.isEmpty() )
+            continue;
+
+        foreach( const QString& key, keys( label ) ) {
+            Entry entry;
+            entry.key = key;
+            entry.label = label;
+            entry.property = it[1].uri();
+            entry.resource = res;
+            entries.append( entry );
+        }
+    }
+
+    qSort( entries );
+    index.entries = entries;
+    index.loaded = true;
+
+    kDebug() << "Loaded" << index.entries.count() << "label keys for" << index.members.count() << type;
+}
+
+QList<SimpleResource> LabelCompletionIndex::complete(const QUrl& type, const QString& prefix, int limit)
+{
+    QList<SimpleResource> results;
+
+    QMutexLocker lock( &m_mutex );
+    QHash<QUrl, TypeIndex>::iterator typeIt = m_types.find( type );
+    if( typeIt == m_types.end() )
+        return results;
+
+    TypeIndex& index = typeIt.value();
+    if( !index.loaded )
+        load( type, index );
+
+    Entry needle;
+    needle.key = prefix.toCaseFolded().simplified();
+
+    QSet<QUrl> seen;
+    QVector<Entry>::const_iterator it = qLowerBound( index.entries.constBegin(), index.entries.constEnd(), needle );
+    for( ; it != index.entries.constEnd() && it->key.startsWith( needle.key ); ++it ) {
+        if( limit > 0 && results.count() >= limit )
+            break;
+
+        if( seen.contains( it->resource ) )
+            continue;
+        seen.insert( it->resource );
+
+        SimpleResource res( it->resource );
+        res.addType( type );
+        res.addProperty( it->property, it->label );
+        results << res;
+    }
+
+    return results;
+}
+
+void LabelCompletionIndex::changeProperty(const QUrl& res, const QUrl& property,
+                                          const QList<Soprano::Node>& addedValues,
+                                          const QList<Soprano::Node>& removedValues)
+{
+    if( property == RDF::type() ) {
+        changeTypes( res, addedValues, removedValues );
+        return;
+    }
+
+    QMutexLocker lock( &m_mutex );
+
+    QHash<QUrl, TypeIndex>::iterator it = m_types.begin();
+    for( ; it != m_types.end(); ++it ) {
+        TypeIndex& index = it.value();
+
+        // Not loaded indices will fetch everything from the database anyway
+        if( !index.loaded )
+            continue;
+
+        if( index.labelProperties.contains( property ) && index.members.contains( res ) ) {
+            foreach( const Soprano::Node& node, removedValues ) {
+                if( node.isLiteral() )
+                    removeLabel( index, res, property, node.toString() );
+            }
+            foreach( const Soprano::Node& node, addedValues ) {
+                if( node.isLiteral() )
+                    insertLabel( index, res, property, node.toString() );
+            }
+        }
+    }
+}
+
+void LabelCompletionIndex::changeTypes(const QUrl& res,
+                                       const QList<Soprano::Node>& addedTypes,
+                                       const QList<Soprano::Node>& removedTypes)
+{
+    // Find the indices which might be affected
+    QList<QUrl> leftTypes;
+    QHash<QUrl, QList<QUrl> > joinedTypes;
+    {
+        QMutexLocker lock( &m_mutex );
+
+        QHash<QUrl, TypeIndex>::const_iterator it = m_types.constBegin();
+        for( ; it != m_types.constEnd(); ++it ) {
+            const QUrl& type = it.key();
+            const TypeIndex& index = it.value();
+            if( !index.loaded )
+                continue;
+
+            const bool member = index.members.contains( res );
+            const QList<Soprano::Node>& types = member ? removedTypes : addedTypes;
+            foreach( const Soprano::Node& node, types ) {
+                if( ClassAndPropertyTree::self()->isChildOf( node.uri(), type ) ) {
+                    if( member )
+                        leftTypes << type;
+                    else
+                        joinedTypes.insert( type, index.labelProperties );
+                    break;
+                }
+            }
+        }
+    }
+
+    if( leftTypes.isEmpty() && joinedTypes.isEmpty() )
+        return;
+
+    // Query without the lock
+    QList<QUrl> removedFrom;
+    foreach( const QUrl& type, leftTypes ) {
+        // the resource might still be of the type through one of its other types
+        const QString q = QString::fromLatin1("ask where { %1 a %2 . }")
+                          .arg( Soprano::Node::resourceToN3( res ),
+                                Soprano::Node::resourceToN3( type ) );
+        if( !m_model->executeQuery( q, Soprano::Query::QueryLanguageSparql ).boolValue() )
+            removedFrom << type;
+    }
+
+    // pick up the labels the resource already has
+    QHash<QUrl, QList<QPair<QUrl, QString> > > labels;
+    for( QHash<QUrl, QList<QUrl> >::const_iterator it = joinedTypes.constBegin(); it != joinedTypes.constEnd(); ++it ) {
+        QList<QPair<QUrl, QString> >& typeLabels = labels[it.key()];
+        const QString q = QString::fromLatin1("select ?p ?l where { %1 ?p ?l . FILTER(?p in (%2)) . }")
+                          .arg( Soprano::Node::resourceToN3( res ),
+                                resourcesToN3( it.value() ) );
+        Soprano::QueryResultIterator qit = m_model->executeQuery( q, Soprano::Query::QueryLanguageSparql );
+        while( qit.next() ) {
+            typeLabels << qMakePair( qit[0].uri(), qit[1].toString() );
+        }
+    }
+
+    QMutexLocker lock( &m_mutex );
+
+    // An index which has been cleared in the meantime will load the new state
+    foreach( const QUrl& type, removedFrom ) {
+        QHash<QUrl, TypeIndex>::iterator it = m_types.find( type );
+        if( it != m_types.end() && it.value().loaded )
+            removeMember( it.value(), res );
+    }
+
+    for( QHash<QUrl, QList<QPair<QUrl, QString> > >::const_iterator lit = labels.constBegin(); lit != labels.constEnd(); ++lit ) {
+        QHash<QUrl, TypeIndex>::iterator it = m_types.find( lit.key() );
+        if( it == m_types.end() || !it.value().loaded )
+            continue;
+
+        TypeIndex& index = it.value();
+        index.members.insert( res );
+        for( int i = 0; i < lit.value().count(); ++i ) {
+            insertLabel( index, res, lit.value()[i].first, lit.value()[i].second );
+        }
+    }
+}
+
+void LabelCompletionIndex::createResource(const QUrl& uri, const QSet<QUrl>& types)
+{
+    QMutexLocker lock( &m_mutex );
+
+    QHash<QUrl, TypeIndex>::iterator it = m_types.begin();
+    for( ; it != m_types.end(); ++it ) {
+        if( it.value().loaded && types.contains( it.key() ) ) {
+            it.value().members.insert( uri );
+        }
+    }
+}
+
+void LabelCompletionIndex::removeResource(const QUrl& uri)
+{
+    QMutexLocker lock( &m_mutex );
+
+    QHash<QUrl, TypeIndex>::iterator it = m_types.begin();
+    for( ; it != m_types.end(); ++it ) {
+        removeMember( it.value(), uri );
+    }
+}
+
+void LabelCompletionIndex::updateResources(const QSet<QUrl>& resources)
+{
+    if( resources.isEmpty() )
+        return;
+
+    QHash<QUrl, QList<QUrl> > loadedTypes;
+    {
+        QMutexLocker lock( &m_mutex );
+        QHash<QUrl, TypeIndex>::const_iterator it = m_types.constBegin();
+        for( ; it != m_types.constEnd(); ++it ) {
+            if( it.value().loaded )
+                loadedTypes.insert( it.key(), it.value().labelProperties );
+        }
+    }
+
+    // Query without the lock, one query per type
+    QHash<QUrl, TypeIndex> updates;
+    for( QHash<QUrl, QList<QUrl> >::const_iterator it = loadedTypes.constBegin(); it != loadedTypes.constEnd(); ++it ) {
+        TypeIndex& update = updates[it.key()];
+        const QString query = QString::fromLatin1("select distinct ?r ?p ?l where { ?r a %1 . "
+                                                  "OPTIONAL { ?r ?p ?l . FILTER(?p in (%2)) . } "
+                                                  "FILTER(?r in (%3)) . }")
+                              .arg( Soprano::Node::resourceToN3( it.key() ),
+                                    resourcesToN3( it.value() ),
+                                    resourcesToN3( resources.toList() ) );
+        Soprano::QueryResultIterator qit = m_model->executeQuery( query, Soprano::Query::QueryLanguageSparql );
+        while( qit.next() ) {
+            const QUrl res = qit[0].uri();
+            update.members.insert( res );
+
+            const QString label = qit[2].toString();
+            if( label.isEmpty() )
+                continue;
+
+            Entry entry;
+            entry.label = label;
+            entry.property = qit[1].uri();
+            entry.resource = res;
+            update.entries.append( entry );
+        }
+    }
+
+    QMutexLocker lock( &m_mutex );
+    for( QHash<QUrl, TypeIndex>::const_iterator uit = updates.constBegin(); uit != updates.constEnd(); ++uit ) {
+        QHash<QUrl, TypeIndex>::iterator it = m_types.find( uit.key() );
+        if( it == m_types.end() || !it.value().loaded )
+            continue;
+
+        TypeIndex& index = it.value();
+        removeMembers( index, resources );
+        index.members += uit.value().members;
+        foreach( const Entry& entry, uit.value().entries ) {
+            insertLabel( index, entry.resource, entry.property, entry.label );
+        }
+    }
+}
+
+void LabelCompletionIndex::clear()
+{
+    QMutexLocker lock( &m_mutex );
+
+    QHash<QUrl, TypeIndex>::iterator it = m_types.begin();
+    for( ; it != m_types.end(); ++it ) {
+        it.value().entries.clear();
+        it.value().members.clear();
+        it.value().loaded = false;
+    }
+}
@@ -0,0 +1,138 @@
+/*
+    This file is part of the Nepomuk KDE project.
+    Copyright (C) 2013  Nepomuk Developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#ifndef NEPOMUK2_LABELCOMPLETIONINDEX_H
+#define NEPOMUK2_LABELCOMPLETIONINDEX_H
+
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QSet>
+#include <QtCore/QUrl>
+#include <QtCore/QVector>
+#include <QtCore/QMutex>
+
+#include <Soprano/Node>
+
+namespace Soprano {
+    class Model;
+}
+
+namespace Nepomuk2 {
+
+class SimpleResource;
+
+/**
+ * An in-memory index of the labels of resources of selected types like nao:Tag
+ * or nco:Contact which is used for label completion.
+ *
+ * Each type has a sorted array of case-folded label keys. A completion is a binary
+ * search for the prefix followed by a scan of the matching range which makes
+ * its cost independent of the number of labels.
+ *
+ * The index for a type is loaded with one query on first use. Afterwards it is
+ * kept up to date by the DataManagementModel which reports all changes through
+ * changeProperty(), createResource(), removeResource() and updateResources().
+ * The queries needed for an update are run without holding the lock which
+ * completions wait for.
+ */
+class LabelCompletionIndex
+{
+public:
+    LabelCompletionIndex( Soprano::Model* model );
+    ~LabelCompletionIndex();
+
+    /**
+     * Index the labels stored in \p labelProperties of all resources of \p type.
+     */
+    void addIndexedType( const QUrl& type, const QList<QUrl>& labelProperties );
+
+    bool isIndexedType( const QUrl& type ) const;
+
+    /**
+     * \return Up to \p limit resources of \p type which have a label starting with
+     * \p prefix. Apart from the URI each resource contains the matched label.
+     * Labels are also matched by the start of each word.
+     */
+    QList<SimpleResource> complete( const QUrl& type, const QString& prefix, int limit );
+
+    void changeProperty( const QUrl& res,
+                         const QUrl& property,
+                         const QList<Soprano::Node>& addedValues,
+                         const QList<Soprano::Node>& removedValues );
+    void createResource( const QUrl& uri, const QSet<QUrl>& types );
+    void removeResource( const QUrl& uri );
+
+    /**
+     * Read the types and labels of \p resources from the database again. Used
+     * after changes which are not reported statement by statement.
+     */
+    void updateResources( const QSet<QUrl>& resources );
+
+    /**
+     * Drop all indexed labels. They will be loaded again on the next completion.
+     */
+    void clear();
+
+private:
+    struct Entry {
+        QString key;
+        QString label;
+        QUrl property;
+        QUrl resource;
+
+        bool operator<( const Entry& other ) const;
+        bool operator==( const Entry& other ) const;
+    };
+
+    struct TypeIndex {
+        TypeIndex()
+            : loaded( false ) {
+        }
+
+        QList<QUrl> labelProperties;
+        bool loaded;
+
+        /// sorted by key
+        QVector<Entry> entries;
+
+        /// all resources of the type
+        QSet<QUrl> members;
+    };
+
+    void load( const QUrl& type, TypeIndex& index );
+    void changeTypes( const QUrl& res,
+                      const QList<Soprano::Node>& addedTypes,
+                      const QList<Soprano::Node>& removedTypes );
+    void insertLabel( TypeIndex& index, const QUrl& res, const QUrl& property, const QString& label );
+    void removeLabel( TypeIndex& index, const QUrl& res, const QUrl& property, const QString& label );
+    void removeMember( TypeIndex& index, const QUrl& res );
+    void removeMembers( TypeIndex& index, const QSet<QUrl>& resources );
+
+    static QStringList keys( const QString& label );
+
+    Soprano::Model* m_model;
+
+    QHash<QUrl, TypeIndex> m_types;
+    mutable QMutex m_mutex;
+};
+
+}
+
+#endif // NEPOMUK2_LABELCOMPLETIONINDEX_H
@@ -20,6 +20,7 @@
 #include "ontologymanagermodel.h"
 #include "ontologymanageradaptor.h"
 #include "graphretriever.h"
+#include "ontologysnapshot_p.h"
 
 #include <Soprano/Global>
 #include <Soprano/Node>
@@ -38,6 +39,7 @@
 #include <KDirWatch>
 #include <kdbusconnectionpool.h>
 
+#include <QtCore/QFile>
 #include <QtCore/QFileInfo>
 #include <QtCore/QTimer>
 
@@ -68,11 +70,24 @@ public:
 
     void updateOntology( const QString& filename );
 
+    /// Remove the ontology snapshot so no client loads outdated types. The
+    /// Repository writes a new one once the update is finished.
+    void removeSnapshot();
+
 private:
     OntologyLoader* q;
 };
 
 
+void Nepomuk2::OntologyLoader::Private::removeSnapshot()
+{
+    const QString path = Types::OntologySnapshot::defaultPath();
+    if( QFile::exists( path ) && !QFile::remove( path ) ) {
+        kWarning() << "Failed to remove the outdated ontology snapshot" << path;
+    }
+}
+
+
 void Nepomuk2::OntologyLoader::Private::updateOntology( const QString& filename )
 {
     KConfig ontologyDescFile( filename );
@@ -130,6 +145,7 @@ void Nepomuk2::OntologyLoader::Private::updateOntology( const QString& filename
         }
 
         kDebug() << "Parsing" << ontoFileInf.filePath();
+        removeSnapshot();
 
         Soprano::StatementIterator it = parser->parseFile( ontoFileInf.filePath(),
                                                            ontoNamespace,
@@ -239,6 +255,7 @@ void Nepomuk2::OntologyLoader::slotGraphRetrieverResult( KJob* job )
     else {
         // TODO: find a way to check if the imported version of the ontology
         // is newer than the already installed one
+        d->removeSnapshot();
         if ( d->model->updateOntology( graphRetriever->statements(), QUrl()/*graphRetriever->url()*/ ) ) {
             emit ontologyUpdated( QString::fromAscii( graphRetriever->url().toEncoded() ) );
             emit ontologyUpdateFinished(true);
@@ -0,0 +1,201 @@
+/*
+   Copyright (c) 2013 Nepomuk Developers
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License version 2 as published by the Free Software Foundation.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "facetqueryrunnable.h"
+
+#include <Soprano/Model>
+#include <Soprano/Node>
+#include <Soprano/LiteralValue>
+#include <Soprano/QueryResultIterator>
+#include <Soprano/Vocabulary/XMLSchema>
+
+#include <QtCore/QDateTime>
+#include <QtCore/QStringList>
+#include <QtCore/QTime>
+#include <QtDBus/QDBusConnection>
+
+#include <KUrl>
+#include <KDebug>
+#include <kdbusconnectionpool.h>
+
+Nepomuk2::Query::FacetQueryRunnable::FacetQueryRunnable( Soprano::Model* model,
+                                                         const Query& query,
+                                                         const QList<QUrl>& properties,
+                                                         const FacetCountsDBus& cachedCounts,
+                                                         int generation,
+                                                         const QDBusMessage& msg )
+    : QRunnable(),
+      m_model( model ),
+      m_query( query ),
+      m_properties( properties ),
+      m_cachedCounts( cachedCounts ),
+      m_generation( generation ),
+      m_message( msg )
+{
+}
+
+
+Nepomuk2::Query::FacetQueryRunnable::~FacetQueryRunnable()
+{
+}
+
+
+// static
+QString Nepomuk2::Query::FacetQueryRunnable::facetPattern( const Query& query, const QList<QUrl>& properties )
+{
+    QStringList props;
+    foreach( const QUrl& prop, properties )
+        props << Soprano::Node::resourceToN3( prop );
+
+    QString pattern;
+    if( query.isValid() ) {
+        // the request properties, the sorting and the paging are irrelevant for the counts
+        Query baseQuery( query );
+        baseQuery.setRequestProperties( QList<Query::RequestProperty>() );
+        baseQuery.setLimit( 0 );
+        baseQuery.setOffset( 0 );
+
+        const QString sparql = baseQuery.toSparqlQuery();
+        if( sparql.isEmpty() )
+            return QString();
+        pattern = QString::fromLatin1("?r ?p ?v . { ") + sparql + QLatin1String(" } . ");
+    }
+    else {
+        // All resources. Only the facet values in user graphs are counted, which
+        // leaves out the ontologies and the graph metadata.
+        pattern = QLatin1String("graph ?fg { ?r ?p ?v . } . "
+                                "{ ?fg a nrl:InstanceBase . } UNION { ?fg a nrl:DiscardableInstanceBase . } . ");
+    }
+    return pattern + QString::fromLatin1("FILTER(?p in (%1)) . ").arg( props.join( QLatin1String(",") ) );
+}
+
+
+// static
+QString Nepomuk2::Query::FacetQueryRunnable::dateTypes()
+{
+    return QString::fromLatin1("%1, %2")
+        .arg( Soprano::Node::resourceToN3( Soprano::Vocabulary::XMLSchema::dateTime() ),
+              Soprano::Node::resourceToN3( Soprano::Vocabulary::XMLSchema::date() ) );
+}
+
+
+// static
+QString Nepomuk2::Query::FacetQueryRunnable::facetQuery( const Query& query, const QList<QUrl>& properties )
+{
+    const QString pattern = facetPattern( query, properties );
+    if( pattern.isEmpty() )
+        return QString();
+
+    return QString::fromLatin1("select ?p ?v count(distinct ?r) as ?cnt where { "
+                               "%1 FILTER(!isLiteral(?v) || !(datatype(?v) in (%2))) . } group by ?p ?v")
+           .arg( pattern, dateTypes() );
+}
+
+
+// static
+QString Nepomuk2::Query::FacetQueryRunnable::dateFacetQuery( const Query& query, const QList<QUrl>& properties )
+{
+    const QString pattern = facetPattern( query, properties );
+    if( pattern.isEmpty() )
+        return QString();
+
+    return QString::fromLatin1("select distinct ?r ?p ?v where { "
+                               "%1 FILTER(isLiteral(?v) && datatype(?v) in (%2)) . }")
+           .arg( pattern, dateTypes() );
+}
+
+
+// static
+QString Nepomuk2::Query::FacetQueryRunnable::facetValue( const Soprano::Node& node )
+{
+    if( node.isResource() )
+        return KUrl( node.uri() ).url();
+
+    const Soprano::LiteralValue value = node.literal();
+    if( value.isDateTime() )
+        return value.toDateTime().toUTC().toString( QLatin1String("yyyy-MM") );
+    else if( value.isDate() )
+        return value.toDate().toString( QLatin1String("yyyy-MM") );
+    else
+        return value.toString();
+}
+
+
+// static
+QString Nepomuk2::Query::FacetQueryRunnable::facetValue( const QVariant& value )
+{
+    if( value.type() == QVariant::Url )
+        return KUrl( value.toUrl() ).url();
+    else
+        return facetValue( Soprano::Node( Soprano::LiteralValue( value ) ) );
+}
+
+
+void Nepomuk2::Query::FacetQueryRunnable::run()
+{
+#ifndef NDEBUG
+    QTime time;
+    time.start();
+#endif
+
+    FacetCountsDBus counts;
+    FacetDateValues dateValues;
+    foreach( const QUrl& prop, m_properties )
+        counts.insert( KUrl( prop ).url(), FacetValueCountsDBus() );
+
+    const QString query = facetQuery( m_query, m_properties );
+    if( !query.isEmpty() ) {
+        Soprano::QueryResultIterator it = m_model->executeQuery( query, Soprano::Query::QueryLanguageSparql );
+        while( it.next() ) {
+            FacetValueCountsDBus& valueCounts = counts[KUrl( it[0].uri() ).url()];
+            valueCounts[facetValue( it[1] )] += it[2].literal().toInt();
+        }
+
+        // The dates are grouped here rather than in the query so that the
+        // incremental updates in Folder::updateFacetCount() use the same months
+        Soprano::QueryResultIterator dateIt = m_model->executeQuery( dateFacetQuery( m_query, m_properties ),
+                                                                     Soprano::Query::QueryLanguageSparql );
+        while( dateIt.next() ) {
+            QHash<QUrl, int>& resources = dateValues[KUrl( dateIt[1].uri() ).url()][facetValue( dateIt[2] )];
+            ++resources[dateIt[0].uri()];
+        }
+
+        for( FacetDateValues::const_iterator propIt = dateValues.constBegin(); propIt != dateValues.constEnd(); ++propIt ) {
+            FacetValueCountsDBus& valueCounts = counts[propIt.key()];
+            for( QHash<QString, QHash<QUrl, int> >::const_iterator it = propIt.value().constBegin();
+                 it != propIt.value().constEnd(); ++it ) {
+                valueCounts.insert( it.key(), it.value().count() );
+            }
+        }
+    }
+
+#ifndef NDEBUG
+    kDebug() << "Facet Query Time:" << time.elapsed()/1000.0 << "seconds";
+#endif
+
+    FacetCountsDBus reply( m_cachedCounts );
+    for( FacetCountsDBus::const_iterator it = counts.constBegin(); it != counts.constEnd(); ++it )
+        reply.insert( it.key(), it.value() );
+
+    QDBusConnection con = KDBusConnectionPool::threadConnection();
+    con.send( m_message.createReply( QVariant::fromValue( reply ) ) );
+
+    emit facetQueryFinished( counts, dateValues, m_generation );
+}
+
+#include "facetqueryrunnable.moc"
@@ -0,0 +1,129 @@
+/*
+   Copyright (c) 2013 Nepomuk Developers
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License version 2 as published by the Free Software Foundation.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef _NEPOMUK_FACET_QUERY_RUNNABLE_H_
+#define _NEPOMUK_FACET_QUERY_RUNNABLE_H_
+
+#include <QtCore/QHash>
+#include <QtCore/QObject>
+#include <QtCore/QRunnable>
+#include <QtCore/QUrl>
+#include <QtCore/QVariant>
+#include <QtDBus/QDBusMessage>
+
+#include "query/query.h"
+#include "dbusoperators_p.h"
+
+namespace Soprano {
+    class Model;
+    class Node;
+}
+
+namespace Nepomuk2 {
+    namespace Query {
+
+        /**
+         * The number of date values of each resource per facet property and
+         * month. Needed to keep the date counts correct when single values
+         * change, since a resource is only counted once per month.
+         */
+        typedef QHash<QString, QHash<QString, QHash<QUrl, int> > > FacetDateValues;
+
+        /**
+         * Calculates the facet counts of a query with one grouped query
+         * and sends them as the delayed reply to \p msg.
+         *
+         * The counts which were calculated are also emitted via
+         * facetQueryFinished() so they can be cached by the folder.
+         */
+        class FacetQueryRunnable : public QObject, public QRunnable
+        {
+            Q_OBJECT
+
+        public:
+            /**
+             * \param query The base query. An invalid query means all resources.
+             * \param properties The facet properties to count.
+             * \param cachedCounts Already known counts which are merged into the reply.
+             * \param generation Passed on to facetQueryFinished() to detect outdated counts.
+             */
+            FacetQueryRunnable( Soprano::Model* model,
+                                const Query& query,
+                                const QList<QUrl>& properties,
+                                const FacetCountsDBus& cachedCounts,
+                                int generation,
+                                const QDBusMessage& msg );
+            ~FacetQueryRunnable();
+
+            void run();
+
+            /**
+             * The grouped SPARQL query which counts the resources matching
+             * \p query per value of each of the \p properties. Dates are
+             * left out, see dateFacetQuery().
+             */
+            static QString facetQuery( const Query& query, const QList<QUrl>& properties );
+
+            /**
+             * The SPARQL query which lists the date values of the \p properties
+             * per resource matching \p query. They are grouped by month with
+             * facetValue() since the stored lexical forms are not normalized
+             * to UTC.
+             */
+            static QString dateFacetQuery( const Query& query, const QList<QUrl>& properties );
+
+            /**
+             * The facet value \p node is counted for. Resources are identified by their URI,
+             * literals by their lexical form. Dates are grouped by month ("yyyy-MM").
+             */
+            static QString facetValue( const Soprano::Node& node );
+
+            /**
+             * \overload
+             *
+             * Used for the values reported by the ResourceWatcher.
+             */
+            static QString facetValue( const QVariant& value );
+
+        Q_SIGNALS:
+            void facetQueryFinished( const FacetCountsDBus& counts,
+                                     const Nepomuk2::Query::FacetDateValues& dateValues,
+                                     int generation );
+
+        private:
+            /**
+             * The graph pattern matching the values of \p properties as ?v
+             * for the resources ?r matching \p query.
+             */
+            static QString facetPattern( const Query& query, const QList<QUrl>& properties );
+            static QString dateTypes();
+
+            Soprano::Model* m_model;
+
+            Query m_query;
+            QList<QUrl> m_properties;
+            FacetCountsDBus m_cachedCounts;
+            int m_generation;
+            QDBusMessage m_message;
+        };
+    }
+}
+
+Q_DECLARE_METATYPE( Nepomuk2::Query::FacetDateValues )
+
+#endif
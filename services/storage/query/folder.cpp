@@ -20,6 +20,7 @@
 #include "folderconnection.h"
 #include "queryservice.h"
 #include "countqueryrunnable.h"
+#include "facetqueryrunnable.h"
 #include "searchrunnable.h"
 
 #include "resource.h"
@@ -32,6 +33,7 @@
 #include "comparisonterm.h"
 #include "negationterm.h"
 #include "resourcewatcher.h"
+#include "property.h"
 
 #include <Soprano/Model>
 
@@ -117,17 +119,25 @@ void Nepomuk2::Query::Folder::init()
     m_resultCount = -1;
     m_initialListingDone = false;
     m_storageChanged = false;
+    m_facetGeneration = 0;
+    m_resultsChanged = false;
 
     m_updateTimer.setSingleShot( true );
     m_updateTimer.setInterval( 2000 );
 
     ResourceWatcher* watcher = new ResourceWatcher( this );
     initWatcherForQuery( watcher, m_query );
+    m_watcher = watcher;
+
+    // remember the properties the query depends on since facet properties
+    // will be added to the watcher later on
+    foreach( const Types::Property& prop, watcher->properties() )
+        m_queryProperties.insert( prop.uri() );
 
     connect( watcher, SIGNAL(propertyAdded(Nepomuk2::Resource,Nepomuk2::Types::Property,QVariant)),
-             this, SLOT(slotStorageChanged()) );
+             this, SLOT(slotPropertyAdded(Nepomuk2::Resource,Nepomuk2::Types::Property,QVariant)) );
     connect( watcher, SIGNAL(propertyRemoved(Nepomuk2::Resource,Nepomuk2::Types::Property,QVariant)),
-             this, SLOT(slotStorageChanged()) );
+             this, SLOT(slotPropertyRemoved(Nepomuk2::Resource,Nepomuk2::Types::Property,QVariant)) );
     connect( watcher, SIGNAL(resourceCreated(Nepomuk2::Resource,QList<QUrl>)),
              this, SLOT(slotStorageChanged()) );
     connect( watcher, SIGNAL(resourceRemoved(QUrl,QList<QUrl>)),
@@ -224,6 +234,7 @@ void Nepomuk2::Query::Folder::addResult(const Result& result)
     m_newResults.insert( resUri, result );
 
     if ( !m_results.contains( resUri ) ) {
+        m_resultsChanged = true;
         emit newEntries( QList<Result>() << result );
     }
 }
@@ -249,6 +260,12 @@ void Nepomuk2::Query::Folder::listingFinished()
         emit entriesRemoved( removedResults );
     }
 
+    // the facet counts are only updated incrementally for changes of the facet values
+    if ( m_initialListingDone && ( m_resultsChanged || !removedResults.isEmpty() ) ) {
+        invalidateFacetCounts();
+    }
+    m_resultsChanged = false;
+
     // reset
     m_results = m_newResults;
     m_newResults.clear();
@@ -273,6 +290,22 @@ void Nepomuk2::Query::Folder::slotStorageChanged()
 }
 
 
+void Nepomuk2::Query::Folder::slotPropertyAdded( const Nepomuk2::Resource& res, const Nepomuk2::Types::Property& prop, const QVariant& value )
+{
+    if ( m_queryProperties.isEmpty() || m_queryProperties.contains( prop.uri() ) )
+        slotStorageChanged();
+    updateFacetCount( res.uri(), prop.uri(), value, 1 );
+}
+
+
+void Nepomuk2::Query::Folder::slotPropertyRemoved( const Nepomuk2::Resource& res, const Nepomuk2::Types::Property& prop, const QVariant& value )
+{
+    if ( m_queryProperties.isEmpty() || m_queryProperties.contains( prop.uri() ) )
+        slotStorageChanged();
+    updateFacetCount( res.uri(), prop.uri(), value, -1 );
+}
+
+
 void Nepomuk2::Query::Folder::slotUpdateTimeout()
 {
     if ( m_storageChanged && !m_currentSearchRunnable ) {
@@ -293,6 +326,90 @@ void Nepomuk2::Query::Folder::countQueryFinished( int count )
 }
 
 
+QList<QUrl> Nepomuk2::Query::Folder::facetCounts( const QList<QUrl>& properties, FacetCountsDBus& counts )
+{
+    QList<QUrl> missing;
+    foreach( const QUrl& prop, properties ) {
+        const QString key = KUrl( prop ).url();
+        FacetCountsDBus::const_iterator it = m_facetCounts.constFind( key );
+        if ( it != m_facetCounts.constEnd() ) {
+            counts.insert( key, it.value() );
+        }
+        else {
+            missing << prop;
+
+            // an empty property list already means that all properties are watched
+            if ( !m_queryProperties.isEmpty() && !m_watcher->properties().contains( prop ) )
+                m_watcher->addProperty( prop );
+        }
+    }
+    return missing;
+}
+
+
+void Nepomuk2::Query::Folder::addFacetCounts( const FacetCountsDBus& counts,
+                                              const FacetDateValues& dateValues,
+                                              int generation )
+{
+    // the results changed while the counts were calculated
+    if ( generation != m_facetGeneration )
+        return;
+
+    for ( FacetCountsDBus::const_iterator it = counts.constBegin(); it != counts.constEnd(); ++it ) {
+        m_facetCounts.insert( it.key(), it.value() );
+        m_facetDateValues.insert( it.key(), dateValues.value( it.key() ) );
+    }
+}
+
+
+void Nepomuk2::Query::Folder::updateFacetCount( const QUrl& res, const QUrl& prop, const QVariant& value, int delta )
+{
+    FacetCountsDBus::iterator it = m_facetCounts.find( KUrl( prop ).url() );
+    if ( it == m_facetCounts.end() )
+        return;
+
+    // without the full list of results we cannot tell if the change is relevant
+    if ( !m_initialListingDone ) {
+        invalidateFacetCounts();
+        return;
+    }
+
+    if ( !m_results.contains( res ) )
+        return;
+
+    FacetValueCountsDBus& valueCounts = it.value();
+    const QString facetValue = FacetQueryRunnable::facetValue( value );
+
+    int count = 0;
+    if ( value.type() == QVariant::DateTime || value.type() == QVariant::Date ) {
+        // a resource is counted once per month, no matter how many dates it has in it
+        QHash<QUrl, int>& resources = m_facetDateValues[it.key()][facetValue];
+        const int values = resources.value( res ) + delta;
+        if ( values > 0 )
+            resources.insert( res, values );
+        else
+            resources.remove( res );
+        count = resources.count();
+    }
+    else {
+        count = valueCounts.value( facetValue ) + delta;
+    }
+
+    if ( count > 0 )
+        valueCounts.insert( facetValue, count );
+    else
+        valueCounts.remove( facetValue );
+}
+
+
+void Nepomuk2::Query::Folder::invalidateFacetCounts()
+{
+    m_facetCounts.clear();
+    m_facetDateValues.clear();
+    ++m_facetGeneration;
+}
+
+
 void Nepomuk2::Query::Folder::addConnection( FolderConnection* conn )
 {
     Q_ASSERT( conn != 0 );
@@ -23,6 +23,8 @@
 
 #include "query/result.h"
 #include "query/query.h"
+#include "dbusoperators_p.h"
+#include "facetqueryrunnable.h"
 
 #include <QtCore/QSet>
 #include <QtCore/QTimer>
@@ -33,6 +35,14 @@
 #include <KUrl>
 
 namespace Nepomuk2 {
+
+    class Resource;
+    class ResourceWatcher;
+
+    namespace Types {
+        class Property;
+    }
+
     namespace Query {
 
         uint qHash( const Result& );
@@ -89,6 +99,31 @@ namespace Nepomuk2 {
              */
             int getResultCount() const { return m_resultCount; }
 
+            /**
+             * Get the cached facet counts of \p properties.
+             *
+             * Once requested the counts are kept up to date with the changes
+             * reported by the folder's resource watcher.
+             *
+             * \param counts Will be filled with the cached counts.
+             * \return The properties for which no counts are cached. Their counts
+             * need to be calculated via a FacetQueryRunnable and be added via
+             * addFacetCounts().
+             */
+            QList<QUrl> facetCounts( const QList<QUrl>& properties, FacetCountsDBus& counts );
+
+            /**
+             * Incremented each time the cached facet counts are dropped. Used to
+             * ignore counts which were calculated before the last change.
+             */
+            int facetGeneration() const { return m_facetGeneration; }
+
+        public Q_SLOTS:
+            /// called by the FacetQueryRunnable
+            void addFacetCounts( const FacetCountsDBus& counts,
+                                 const Nepomuk2::Query::FacetDateValues& dateValues,
+                                 int generation );
+
         private Q_SLOTS:
             void addResult( const Nepomuk2::Query::Result& result );
             void listingFinished();
@@ -116,10 +151,23 @@ namespace Nepomuk2 {
         private Q_SLOTS:
             void slotStorageChanged();
             void slotUpdateTimeout();
+            void slotPropertyAdded( const Nepomuk2::Resource& res, const Nepomuk2::Types::Property& prop, const QVariant& value );
+            void slotPropertyRemoved( const Nepomuk2::Resource& res, const Nepomuk2::Types::Property& prop, const QVariant& value );
 
         private:
             void init();
 
+            /**
+             * Adjust the cached facet count of \p value by \p delta if \p res is
+             * one of the results.
+             */
+            void updateFacetCount( const QUrl& res, const QUrl& prop, const QVariant& value, int delta );
+
+            /**
+             * Drop all cached facet counts, typically because the results changed.
+             */
+            void invalidateFacetCounts();
+
             /**
              * Called by the FolderConnection constructor.
              */
@@ -170,6 +218,22 @@ namespace Nepomuk2 {
             /// used to ensure that we do not update all the time if the storage changes a lot
             QTimer m_updateTimer;
 
+            /// watches the properties used in the query and the facet properties
+            ResourceWatcher* m_watcher;
+
+            /// the properties the query depends on, empty if it depends on all of them
+            QSet<QUrl> m_queryProperties;
+
+            /// the cached facet counts, see facetCounts()
+            FacetCountsDBus m_facetCounts;
+            int m_facetGeneration;
+
+            /// the date values of the results behind the cached date counts
+            FacetDateValues m_facetDateValues;
+
+            /// true if the results changed during the current update
+            bool m_resultsChanged;
+
             // for addConnection and removeConnection
             friend class FolderConnection;
         };
@@ -19,6 +19,7 @@
 #include "queryservice.h"
 #include "folder.h"
 #include "folderconnection.h"
+#include "facetqueryrunnable.h"
 #include "dbusoperators_p.h"
 
 #include <QtCore/QThreadPool>
@@ -56,6 +57,7 @@ Nepomuk2::Query::QueryService::QueryService( Soprano::Model* model, QObject* par
     // register type used to communicate removeEntries between threads
     qRegisterMetaType<QList<QUrl> >();
     qRegisterMetaType<QList<Nepomuk2::Query::Result> >();
+    qRegisterMetaType<Nepomuk2::Query::FacetDateValues>();
 
     //Register the service
     QLatin1String serviceName("nepomukqueryservice");
@@ -154,6 +156,50 @@ QDBusObjectPath Nepomuk2::Query::QueryService::sparqlQuery( const QString& sparq
 }
 
 
+FacetCountsDBus Nepomuk2::Query::QueryService::facets( const QString& query, const QStringList& properties, const QDBusMessage& msg )
+{
+    Query q;
+    if( !query.isEmpty() ) {
+        q = Query::fromString( query );
+        if( !q.isValid() ) {
+            kDebug() << "Invalid query:" << query;
+            QDBusConnection con = KDBusConnectionPool::threadConnection();
+            con.send( msg.createErrorReply( QDBusError::InvalidArgs, i18n("Invalid query: '%1'", query) ) );
+            return FacetCountsDBus();
+        }
+    }
+
+    QList<QUrl> props;
+    foreach( const QString& prop, properties )
+        props << KUrl( prop );
+
+    kDebug() << "Facet request:" << q << properties;
+
+    // Only open folders cache the counts since only they are notified about changes
+    FacetCountsDBus counts;
+    int generation = 0;
+    Folder* folder = q.isValid() ? m_openQueryFolders.value( q ) : 0;
+    if( folder ) {
+        props = folder->facetCounts( props, counts );
+        generation = folder->facetGeneration();
+        if( props.isEmpty() ) {
+            return counts;
+        }
+    }
+
+    msg.setDelayedReply( true );
+    FacetQueryRunnable* runnable = new FacetQueryRunnable( m_model, q, props, counts, generation, msg );
+    if( folder ) {
+        connect( runnable, SIGNAL(facetQueryFinished(FacetCountsDBus,Nepomuk2::Query::FacetDateValues,int)),
+                 folder, SLOT(addFacetCounts(FacetCountsDBus,Nepomuk2::Query::FacetDateValues,int)), Qt::QueuedConnection );
+    }
+    searchThreadPool()->start( runnable, 0 );
+
+    // QtDBus will ignore this return value
+    return FacetCountsDBus();
+}
+
+
 Nepomuk2::Query::Folder* Nepomuk2::Query::QueryService::getFolder( const Query& query )
 {
     QHash<Query, Folder*>::const_iterator it = m_openQueryFolders.constFind( query );
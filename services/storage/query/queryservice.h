@@ -28,6 +28,7 @@
 
 #include <QtCore/QVariant>
 #include <QtCore/QHash>
+#include <QtCore/QStringList>
 
 class QDBusObjectPath;
 class QDBusMessage;
@@ -68,6 +69,18 @@ namespace Nepomuk2 {
              */
             Q_SCRIPTABLE QDBusObjectPath sparqlQuery( const QString& query, const RequestPropertyMapDBus& requestProps, const QDBusMessage& msg );
 
+            /**
+             * Count the results of encoded query \p query per value of each of the \p properties.
+             * An empty \p query counts all resources.
+             *
+             * The counts are cached in the query's folder as long as it is open and kept up to date
+             * with the changes of the folder.
+             *
+             * \return A mapping from property to the result count of each value. See
+             * FacetQueryRunnable::facetValue() for how values are encoded.
+             */
+            Q_SCRIPTABLE FacetCountsDBus facets( const QString& query, const QStringList& properties, const QDBusMessage& msg );
+
         private Q_SLOTS:
             void slotFolderAboutToBeDeleted( Nepomuk2::Query::Folder* folder );
 
@@ -18,6 +18,7 @@
 #include "classandpropertytree.h"
 #include "virtuosoinferencemodel.h"
 #include "ontologyloader.h"
+#include "ontologysnapshot_p.h"
 
 #include <Soprano/Backend>
 #include <Soprano/PluginManager>
@@ -331,6 +332,15 @@ void Nepomuk2::Repository::updateInference(bool ontologiesChanged)
     // update the rest
     m_classAndPropertyTree->rebuildTree(this);
     m_inferenceModel->updateOntologyGraphs(ontologiesChanged);
+
+    // publish the ontologies to the Types API of the clients. The snapshot has been
+    // removed when the update started, an outdated format is rewritten as well.
+    const QString snapshotPath = Types::OntologySnapshot::defaultPath();
+    Types::OntologySnapshot snapshot;
+    if( ontologiesChanged || !snapshot.open( snapshotPath ) ) {
+        snapshot.close();
+        Types::OntologySnapshot::create( this, snapshotPath );
+    }
 }
 
 void Nepomuk2::Repository::slotVirtuosoInitParameters(int port, const QString& version)
@@ -42,6 +42,7 @@
 #include <Soprano/Graph>
 #include "resourcewatchermanager.h"
 #include "typecache.h"
+#include "labelcompletionindex.h"
 
 using namespace Soprano::Vocabulary;
 using namespace Nepomuk2::Vocabulary;
@@ -425,6 +426,7 @@ bool Nepomuk2::ResourceMerger::merge(const Nepomuk2::Sync::ResourceHash& resHash
         QList<Soprano::Node> types = resHash[ newUri ].values( RDF::type() );
         QSet<QUrl> allTypes = ClassAndPropertyTree::self()->allParents( nodeListToUriList(types) );
         m_rvm->createResource( newUri, allTypes );
+        m_model->labelCompletionIndex()->createResource( newUri, allTypes );
     }
 
     // Inform the ResourceWatcherManager of the changed properties
@@ -443,6 +445,7 @@ bool Nepomuk2::ResourceMerger::merge(const Nepomuk2::Sync::ResourceHash& resHash
             const QList<Soprano::Node> removed = removedRes.values( propUri );
 
             m_rvm->changeProperty( res.uri(), propUri, added, removed );
+            m_model->labelCompletionIndex()->changeProperty( res.uri(), propUri, added, removed );
         }
     }
 
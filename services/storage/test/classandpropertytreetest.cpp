@@ -21,6 +21,7 @@
 
 #include "classandpropertytreetest.h"
 #include "../classandpropertytree.h"
+#include "ontologysnapshot_p.h"
 
 #include <QtTest>
 #include "qtest_kde.h"
@@ -252,6 +253,69 @@ void ClassAndPropertyTreeTest::testProperties()
     QCOMPARE(m_typeTree->maxCardinality(QUrl("prop:/D")), 1);
 }
 
+void ClassAndPropertyTreeTest::testOntologySnapshot()
+{
+    // a property which inherits its domain
+    QUrl graph("graph:/onto");
+    m_model->addStatement( QUrl("prop:/A"), Soprano::Vocabulary::RDFS::domain(), QUrl("onto:/A"), graph );
+    m_model->addStatement( QUrl("prop:/F"), Soprano::Vocabulary::RDF::type(), Soprano::Vocabulary::RDF::Property(), graph );
+    m_model->addStatement( QUrl("prop:/F"), Soprano::Vocabulary::RDFS::subPropertyOf(), QUrl("prop:/A"), graph );
+
+    const QString path = m_storageDir->name() + QLatin1String("ontologies.snapshot");
+    QVERIFY( Nepomuk2::Types::OntologySnapshot::create( m_model, path ) );
+
+    Nepomuk2::Types::OntologySnapshot snapshot;
+    QVERIFY( snapshot.open( path ) );
+
+    // the closure, loops included
+    Nepomuk2::Types::OntologySnapshot::Entry entry;
+    QVERIFY( snapshot.entry( QUrl("onto:/F"), entry ) );
+    QCOMPARE( entry.superEntities.count(), 7 );
+    QVERIFY( entry.superEntities.contains( QUrl("onto:/AA") ) );
+    QVERIFY( entry.superEntities.contains( QUrl("onto:/A") ) );
+    QVERIFY( entry.superEntities.contains( Soprano::Vocabulary::RDFS::Resource() ) );
+
+    QVERIFY( snapshot.entry( QUrl("onto:/X"), entry ) );
+    QCOMPARE( entry.superEntities.count(), 3 );
+
+    QVERIFY( snapshot.entry( QUrl("prop:/F"), entry ) );
+    QCOMPARE( entry.superEntities, QList<QUrl>() << QUrl("prop:/A") );
+
+    // the plain triples
+    QVERIFY( snapshot.entry( QUrl("onto:/B"), entry ) );
+    QVERIFY( entry.properties.contains( qMakePair( Soprano::Vocabulary::NAO::userVisible(), Soprano::Node( LiteralValue(false) ) ) ) );
+    QVERIFY( entry.properties.contains( qMakePair( Soprano::Vocabulary::RDFS::subClassOf(), Soprano::Node( QUrl("onto:/A") ) ) ) );
+
+    QVERIFY( snapshot.entry( QUrl("onto:/A"), entry ) );
+    QVERIFY( entry.ancestors.contains( qMakePair( QUrl("onto:/B"), Soprano::Vocabulary::RDFS::subClassOf() ) ) );
+    QCOMPARE( entry.rangeOf, QList<QUrl>() << QUrl("prop:/E") );
+    QCOMPARE( entry.domainOf.count(), 2 );
+    QVERIFY( entry.domainOf.contains( QUrl("prop:/A") ) );
+    QVERIFY( entry.domainOf.contains( QUrl("prop:/F") ) );
+
+    // classes without a super class are children of rdfs:Resource
+    QVERIFY( snapshot.entry( Soprano::Vocabulary::RDFS::Resource(), entry ) );
+    QVERIFY( entry.ancestors.contains( qMakePair( QUrl("onto:/A"), Soprano::Vocabulary::RDFS::subClassOf() ) ) );
+    QVERIFY( entry.ancestors.contains( qMakePair( QUrl("onto:/AA"), Soprano::Vocabulary::RDFS::subClassOf() ) ) );
+    QVERIFY( !entry.ancestors.contains( qMakePair( QUrl("onto:/B"), Soprano::Vocabulary::RDFS::subClassOf() ) ) );
+
+    // unknown entities are empty, just like the query result would be
+    QVERIFY( snapshot.entry( QUrl("onto:/unknown"), entry ) );
+    QVERIFY( entry.properties.isEmpty() );
+    QVERIFY( entry.ancestors.isEmpty() );
+
+    // a snapshot in another format version is ignored
+    QFile file( path );
+    QVERIFY( file.open( QIODevice::WriteOnly ) );
+    QDataStream stream( &file );
+    stream << quint32(0x4e4f5353) << quint32(0);
+    file.close();
+
+    QVERIFY( !snapshot.open( path ) );
+    QVERIFY( !snapshot.isValid() );
+    QVERIFY( !snapshot.entry( QUrl("onto:/F"), entry ) );
+}
+
 QTEST_KDEMAIN_CORE(ClassAndPropertyTreeTest)
 
 #include "classandpropertytreetest.moc"
@@ -44,6 +44,7 @@ private Q_SLOTS:
     void testVariantToNode_data();
     void testVariantToNode();
     void testProperties();
+    void testOntologySnapshot();
 
 private:
     KTempDir* m_storageDir;
@@ -24,6 +24,7 @@
 #include "../datamanagementadaptor.h"
 #include "../classandpropertytree.h"
 #include "simpleresource.h"
+#include "simpleresourcegraph.h"
 
 #include <QtTest>
 #include "qtest_kde.h"
@@ -34,7 +35,11 @@
 #define USING_SOPRANO_NRLMODEL_UNSTABLE_API
 #include <Soprano/NRLModel>
 
+#include <QtCore/QDataStream>
+#include <QtDBus/QDBusUnixFileDescriptor>
+
 #include <ktempdir.h>
+#include <ktemporaryfile.h>
 #include <KDebug>
 
 #include "nfo.h"
@@ -129,6 +134,59 @@ void DataManagementAdaptorTest::testNamespaceExpansion()
     QCOMPARE(m_dmAdaptor->decodeUri(QLatin1String("wbzo:T1"), true), QUrl("graph:/onto2#T1"));
 }
 
+void DataManagementAdaptorTest::testDecodeResourceGraph()
+{
+    SimpleResourceGraph graph;
+    for(int i = 0; i < 100; ++i) {
+        SimpleResource res;
+        res.addType(NFO::FileDataObject());
+        res.addProperty(NIE::url(), QUrl(QString::fromLatin1("file:///tmp/file%1").arg(i)));
+        res.addProperty(NAO::numericRating(), i);
+        res.addProperty(NIE::title(), QString::fromLatin1("title %1").arg(i));
+        graph << res;
+    }
+
+    KTemporaryFile file;
+    QVERIFY(file.open());
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_4_6);
+    stream << graph;
+    QVERIFY(file.flush());
+
+    SimpleResourceGraph decoded;
+    QVERIFY(DataManagementAdaptor::decodeResourceGraph(QDBusUnixFileDescriptor(file.handle()), decoded));
+    QCOMPARE(decoded, graph);
+}
+
+void DataManagementAdaptorTest::testDecodeResourceGraph_invalid()
+{
+    SimpleResource res;
+    res.addType(NFO::FileDataObject());
+    res.addProperty(NIE::url(), QUrl("file:///tmp/file"));
+
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_4_6);
+    stream << SimpleResourceGraph(res);
+
+    // a truncated graph must not be stored partially
+    KTemporaryFile file;
+    QVERIFY(file.open());
+    file.write(data.left(data.size() / 2));
+    QVERIFY(file.flush());
+
+    SimpleResourceGraph decoded;
+    QVERIFY(!DataManagementAdaptor::decodeResourceGraph(QDBusUnixFileDescriptor(file.handle()), decoded));
+    QVERIFY(decoded.isEmpty());
+
+    // an empty file is no valid graph either
+    KTemporaryFile emptyFile;
+    QVERIFY(emptyFile.open());
+    QVERIFY(!DataManagementAdaptor::decodeResourceGraph(QDBusUnixFileDescriptor(emptyFile.handle()), decoded));
+
+    QVERIFY(!DataManagementAdaptor::decodeResourceGraph(QDBusUnixFileDescriptor(), decoded));
+}
+
 
 QTEST_KDEMAIN_CORE(DataManagementAdaptorTest)
 
@@ -45,6 +45,8 @@ private Q_SLOTS:
     void init();
 
     void testNamespaceExpansion();
+    void testDecodeResourceGraph();
+    void testDecodeResourceGraph_invalid();
 
 private:
     void resetModel();
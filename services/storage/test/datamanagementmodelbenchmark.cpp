@@ -26,6 +26,7 @@
 #include "../virtuosoinferencemodel.h"
 #include "simpleresource.h"
 #include "simpleresourcegraph.h"
+#include "autotests/lib/allocationcounter.h"
 
 #include <QtTest>
 #include "qtest_kde.h"
@@ -53,7 +54,6 @@ using namespace Soprano::Vocabulary;
 using namespace Nepomuk2;
 using namespace Nepomuk2::Vocabulary;
 
-
 void DataManagementModelBenchmark::resetModel()
 {
     // remove all the junk from previous tests
@@ -300,6 +300,14 @@ void DataManagementModelBenchmark::storeResources_email()
 
     graph << res;
 
+    {
+        // includes the allocations of the Virtuoso client library
+        Test::AllocationCounter counter;
+        m_dmModel->storeResources( graph, "TestApp", Nepomuk2::IdentifyNone, Nepomuk2::NoStoreResourcesFlags );
+        QVERIFY( !m_dmModel->lastError() );
+        kDebug() << "Allocations for storing" << graph.count() << "resources:" << counter.count();
+    }
+
     QBENCHMARK {
         m_dmModel->storeResources( graph, "TestApp", Nepomuk2::IdentifyNone, Nepomuk2::NoStoreResourcesFlags );
     }
@@ -5416,6 +5416,89 @@ void DataManagementModelTest::checkDataMaintainedBy(const Soprano::Statement& st
     QCOMPARE( appUris, otherAppUris );
 }
 
+void DataManagementModelTest::testComplete()
+{
+    const QString app = QLatin1String("testapp");
+    const QUrl tag1 = m_dmModel->createResource(QList<QUrl>() << NAO::Tag(), QLatin1String("Holiday Pictures"), QString(), app);
+    const QUrl tag2 = m_dmModel->createResource(QList<QUrl>() << NAO::Tag(), QLatin1String("holidays"), QString(), app);
+    m_dmModel->createResource(QList<QUrl>() << NAO::Tag(), QLatin1String("Work"), QString(), app);
+    QVERIFY(!m_dmModel->lastError());
+
+    // the prefix is matched case-insensitively
+    QList<SimpleResource> result = m_dmModel->complete(NAO::Tag(), QLatin1String("HOL"), 10);
+    QVERIFY(!m_dmModel->lastError());
+    QCOMPARE(result.count(), 2);
+
+    // the start of each word is matched as well
+    result = m_dmModel->complete(NAO::Tag(), QLatin1String("pic"), 10);
+    QCOMPARE(result.count(), 1);
+    QCOMPARE(result.first().uri(), tag1);
+    QVERIFY(result.first().contains(RDF::type(), NAO::Tag()));
+    QVERIFY(result.first().contains(NAO::prefLabel(), QLatin1String("Holiday Pictures")));
+
+    // the limit is respected
+    result = m_dmModel->complete(NAO::Tag(), QLatin1String("hol"), 1);
+    QCOMPARE(result.count(), 1);
+
+    // changing the label updates the index
+    m_dmModel->setProperty(QList<QUrl>() << tag1, NAO::prefLabel(), QVariantList() << QLatin1String("Vacation"), app);
+    QVERIFY(!m_dmModel->lastError());
+    result = m_dmModel->complete(NAO::Tag(), QLatin1String("hol"), 10);
+    QCOMPARE(result.count(), 1);
+    QCOMPARE(result.first().uri(), tag2);
+    result = m_dmModel->complete(NAO::Tag(), QLatin1String("vac"), 10);
+    QCOMPARE(result.count(), 1);
+    QCOMPARE(result.first().uri(), tag1);
+
+    // tags created through storeResources are picked up
+    SimpleResource res;
+    res.addType(NAO::Tag());
+    res.addProperty(NAO::prefLabel(), QLatin1String("Holy"));
+    m_dmModel->storeResources(SimpleResourceGraph() << res, app);
+    QVERIFY(!m_dmModel->lastError());
+    result = m_dmModel->complete(NAO::Tag(), QLatin1String("hol"), 10);
+    QCOMPARE(result.count(), 2);
+
+    // removed tags are dropped
+    m_dmModel->removeResources(QList<QUrl>() << tag2, Nepomuk2::NoRemovalFlags, app);
+    QVERIFY(!m_dmModel->lastError());
+    result = m_dmModel->complete(NAO::Tag(), QLatin1String("hol"), 10);
+    QCOMPARE(result.count(), 1);
+    QVERIFY(result.first().contains(NAO::prefLabel(), QLatin1String("Holy")));
+}
+
+void DataManagementModelTest::testComplete_removeDataByApplication()
+{
+    const QUrl tag1 = m_dmModel->createResource(QList<QUrl>() << NAO::Tag(), QLatin1String("Holiday"), QString(), QLatin1String("A"));
+    const QUrl tag2 = m_dmModel->createResource(QList<QUrl>() << NAO::Tag(), QLatin1String("Home"), QString(), QLatin1String("B"));
+    m_dmModel->addProperty(QList<QUrl>() << tag2, NAO::identifier(), QVariantList() << QLatin1String("hotel"), QLatin1String("A"));
+    QVERIFY(!m_dmModel->lastError());
+
+    QCOMPARE(m_dmModel->complete(NAO::Tag(), QLatin1String("ho"), 10).count(), 2);
+
+    // the resource created by A is gone, the other one only loses the label of A
+    m_dmModel->removeDataByApplication(QList<QUrl>() << tag1 << tag2, Nepomuk2::NoRemovalFlags, QLatin1String("A"));
+    QVERIFY(!m_dmModel->lastError());
+    QVERIFY(m_dmModel->complete(NAO::Tag(), QLatin1String("holi"), 10).isEmpty());
+    QVERIFY(m_dmModel->complete(NAO::Tag(), QLatin1String("hot"), 10).isEmpty());
+    QList<SimpleResource> result = m_dmModel->complete(NAO::Tag(), QLatin1String("hom"), 10);
+    QCOMPARE(result.count(), 1);
+    QCOMPARE(result.first().uri(), tag2);
+
+    m_dmModel->removeDataByApplication(Nepomuk2::NoRemovalFlags, QLatin1String("B"));
+    QVERIFY(!m_dmModel->lastError());
+    QVERIFY(m_dmModel->complete(NAO::Tag(), QLatin1String("ho"), 10).isEmpty());
+}
+
+void DataManagementModelTest::testComplete_invalidType()
+{
+    m_dmModel->complete(QUrl(), QLatin1String("foo"), 10);
+    QVERIFY(m_dmModel->lastError());
+
+    m_dmModel->complete(NFO::FileDataObject(), QLatin1String("foo"), 10);
+    QVERIFY(m_dmModel->lastError());
+}
+
 QTEST_KDEMAIN_CORE(DataManagementModelTest)
 
 #include "datamanagementmodeltest.moc"
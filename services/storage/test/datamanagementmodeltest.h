@@ -167,6 +167,10 @@ private Q_SLOTS:
 
     void testImportResources();
 
+    void testComplete();
+    void testComplete_removeDataByApplication();
+    void testComplete_invalidType();
+
 private:
     KTempDir* createNieUrlTestData();
 